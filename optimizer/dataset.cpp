@@ -0,0 +1,114 @@
+/*
+ * MVL Stereo Optimizer: evaluation dataset
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dataset.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <limits>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Optimizer {
+
+
+Dataset::Dataset ()
+{
+}
+
+static cv::Mat readImage (const QDir &dir, const cv::FileNode &node, int flags)
+{
+    QString filename = dir.absoluteFilePath(QString::fromStdString((std::string)node));
+
+    cv::Mat image = cv::imread(filename.toStdString(), flags);
+    if (image.empty()) {
+        throw Pipeline::Exception(QStringLiteral("Failed to read image '%1'!").arg(filename));
+    }
+
+    return image;
+}
+
+void Dataset::load (const QString &filename)
+{
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("StereoDataset")) {
+        throw Pipeline::Exception(QStringLiteral("Invalid stereo dataset!"));
+    }
+
+    QDir dir = QFileInfo(filename).absoluteDir();
+
+    pairs.clear();
+
+    cv::FileNode nodes = storage["Pairs"];
+    for (cv::FileNodeIterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const cv::FileNode node = *it;
+
+        Pair pair;
+        pair.name = QString::fromStdString((std::string)node["Left"]);
+
+        pair.imageL = readImage(dir, node["Left"], cv::IMREAD_UNCHANGED);
+        pair.imageR = readImage(dir, node["Right"], cv::IMREAD_UNCHANGED);
+
+        if (pair.imageL.size() != pair.imageR.size() || pair.imageL.type() != pair.imageR.type()) {
+            throw Pipeline::Exception(QStringLiteral("Images of pair '%1' differ in size or type!").arg(pair.name));
+        }
+
+        // Ground truth; unknown disparities are marked with zero
+        double scale = node["Scale"].empty() ? 1.0 : (double)node["Scale"];
+
+        cv::Mat groundTruth = readImage(dir, node["GroundTruth"], cv::IMREAD_ANYDEPTH | cv::IMREAD_GRAYSCALE);
+        groundTruth.convertTo(pair.groundTruth, CV_32F, scale);
+        cv::patchNaNs(pair.groundTruth, 0.0);
+        pair.groundTruth.setTo(0.0f, pair.groundTruth == std::numeric_limits<float>::infinity());
+
+        if (pair.groundTruth.size() != pair.imageL.size()) {
+            throw Pipeline::Exception(QStringLiteral("Ground truth of pair '%1' differs in size from images!").arg(pair.name));
+        }
+
+        pairs.append(pair);
+    }
+
+    if (pairs.isEmpty()) {
+        throw Pipeline::Exception(QStringLiteral("Dataset contains no image pairs!"));
+    }
+}
+
+int Dataset::getNumPairs () const
+{
+    return pairs.size();
+}
+
+const Dataset::Pair &Dataset::getPair (int index) const
+{
+    return pairs[index];
+}
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,70 @@
+/*
+ * MVL Stereo Optimizer: evaluation dataset
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__OPTIMIZER__DATASET_H
+#define MVL_STEREO_TOOLBOX__OPTIMIZER__DATASET_H
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Optimizer {
+
+
+// Rectified image pairs with ground-truth disparity, described by a
+// file of the following form (paths are relative to the file):
+//
+// %YAML:1.0
+// DataType: "StereoDataset"
+// Pairs:
+//    - { Left: "im0.png", Right: "im1.png", GroundTruth: "disp0.png", Scale: 0.25 }
+//
+// Ground truth is read unchanged and multiplied by the optional scale;
+// zero and non-finite values denote unknown disparity
+class Dataset
+{
+public:
+    struct Pair {
+        QString name;
+
+        cv::Mat imageL;
+        cv::Mat imageR;
+        cv::Mat groundTruth; // CV_32F
+    };
+
+    Dataset ();
+
+    void load (const QString &filename);
+
+    int getNumPairs () const;
+    const Pair &getPair (int index) const;
+
+protected:
+    QVector<Pair> pairs;
+};
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
+
+
+#endif
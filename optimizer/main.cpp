@@ -0,0 +1,121 @@
+/*
+ * MVL Stereo Optimizer: main
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dataset.h"
+#include "optimizer.h"
+#include "parameter_space.h"
+
+#include <stereo-pipeline/plugin_factory.h>
+#include <stereo-pipeline/plugin_manager.h>
+
+#include <iostream>
+
+
+using namespace MVL::StereoToolbox;
+
+
+int main (int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationVersion(PROJECT_VERSION);
+
+    qInfo() << qPrintable(QString("MVL Stereo Optimizer v.%1").arg(PROJECT_VERSION));
+    qInfo() << qPrintable(QString("(C) 2017-%1 Rok Mandeljc <rok.mandeljc@gmail.com>\n").arg(QDate::currentDate().year()));
+
+    // Command-line options
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sweeps the parameter space of a stereo method on a dataset with ground truth, and outputs the Pareto front of runtime vs. error as method parameter files.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    parser.addPositionalArgument("method", "Short name of the stereo method plugin.");
+    parser.addPositionalArgument("space", "Parameter space file.");
+    parser.addPositionalArgument("dataset", "Dataset file.");
+    parser.addPositionalArgument("output", "Output directory.");
+
+    QCommandLineOption optionBase("base", "Parameter file with values of parameters that are not swept.", "file");
+    QCommandLineOption optionBudget("budget", "Time budget in seconds (0 = unlimited).", "seconds", "0");
+    QCommandLineOption optionWorkers("workers", "Number of worker threads.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption optionThreshold("threshold", "Disparity error threshold for bad pixels.", "pixels", "2.0");
+    QCommandLineOption optionMinPairs("min-pairs", "Number of pairs evaluated before a configuration can be pruned.", "count", "3");
+    QCommandLineOption optionMargin("prune-margin", "Factor by which a configuration must be worse in both runtime and error to be pruned.", "factor", "1.25");
+    QCommandLineOption optionSeed("seed", "Seed of random order of configurations.", "seed", "0");
+    parser.addOptions({ optionBase, optionBudget, optionWorkers, optionThreshold, optionMinPairs, optionMargin, optionSeed });
+
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 4) {
+        parser.showHelp(1);
+    }
+
+    // Find method plugin
+    Pipeline::PluginManager pluginManager;
+    const Pipeline::PluginFactory *factory = nullptr;
+
+    for (QObject *plugin : pluginManager.getAvailablePlugins()) {
+        Pipeline::PluginFactory *candidate = qobject_cast<Pipeline::PluginFactory *>(plugin);
+        if (candidate->getPluginType() == Pipeline::PluginFactory::PluginStereoMethod && candidate->getShortName() == arguments[0]) {
+            factory = candidate;
+            break;
+        }
+    }
+
+    if (!factory) {
+        std::cerr << "Stereo method '" << qPrintable(arguments[0]) << "' not found in plugin directory " << qPrintable(pluginManager.getPluginDirectory()) << "!" << std::endl;
+        return 1;
+    }
+
+    try {
+        Optimizer::ParameterSpace space;
+        space.load(arguments[1]);
+
+        Optimizer::Dataset dataset;
+        dataset.load(arguments[2]);
+
+        qInfo() << qPrintable(QString("Sweeping %1 configurations of '%2' on %3 image pair(s)").arg(space.getNumConfigurations()).arg(factory->getShortName()).arg(dataset.getNumPairs()));
+
+        Optimizer::Optimizer optimizer(factory, space, dataset);
+        if (parser.isSet(optionBase)) {
+            optimizer.setBaseParameters(parser.value(optionBase));
+        }
+        optimizer.setTimeBudget(parser.value(optionBudget).toInt());
+        optimizer.setNumWorkers(parser.value(optionWorkers).toInt());
+        optimizer.setErrorThreshold(parser.value(optionThreshold).toDouble());
+        optimizer.setMinPairs(parser.value(optionMinPairs).toInt());
+        optimizer.setPruneMargin(parser.value(optionMargin).toDouble());
+        optimizer.setSeed(parser.value(optionSeed).toUInt());
+
+        QVector<Optimizer::Optimizer::Result> results = optimizer.run();
+        optimizer.saveResults(results, arguments[3]);
+
+        // Summary
+        QVector<Optimizer::Optimizer::Result> front = Optimizer::Optimizer::getParetoFront(results);
+
+        qInfo() << qPrintable(QString("\nEvaluated %1 configurations; Pareto front:").arg(results.size()));
+        for (int i = 0; i < front.size(); i++) {
+            qInfo() << qPrintable(QString("  pareto-%1.yml: %2 ms, %3 % bad pixels").arg(i, 2, 10, QLatin1Char('0')).arg(front[i].time, 0, 'f', 2).arg(100*front[i].error, 0, 'f', 2));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,494 @@
+/*
+ * MVL Stereo Optimizer: parameter sweep
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "optimizer.h"
+
+#include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/plugin_factory.h>
+#include <stereo-pipeline/stereo_method.h>
+
+#include <QtConcurrent>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Optimizer {
+
+
+// *********************************************************************
+// *                      Configuration sampling                       *
+// *********************************************************************
+// Random order of configurations without repetition; small spaces are
+// shuffled explicitly, while large ones are sampled with rejection of
+// already drawn indices
+class ConfigurationSampler
+{
+public:
+    ConfigurationSampler (quint64 size, quint32 seed)
+        : size(size), generator(seed), position(0)
+    {
+        if (size <= MaxShuffledSize) {
+            order.resize(size);
+            for (quint64 i = 0; i < size; i++) {
+                order[i] = i;
+            }
+            std::shuffle(order.begin(), order.end(), generator);
+        }
+    }
+
+    bool next (quint64 &index)
+    {
+        if (size <= MaxShuffledSize) {
+            if (position >= order.size()) {
+                return false;
+            }
+            index = order[position++];
+            return true;
+        }
+
+        if (static_cast<quint64>(drawn.size()) >= size) {
+            return false;
+        }
+
+        // Rejection sampling; once the space is mostly drawn, fall back
+        // to the next free index after the last rejected one, so that
+        // the tail of the space does not take arbitrarily many draws
+        std::uniform_int_distribution<quint64> distribution(0, size - 1);
+        index = distribution(generator);
+        for (int attempt = 1; drawn.contains(index) && attempt < MaxRejections; attempt++) {
+            index = distribution(generator);
+        }
+        while (drawn.contains(index)) {
+            index = (index + 1) % size;
+        }
+        drawn.insert(index);
+
+        return true;
+    }
+
+protected:
+    static const quint64 MaxShuffledSize = 1 << 20;
+    static const int MaxRejections = 64;
+
+    quint64 size;
+    std::mt19937_64 generator;
+
+    std::vector<quint64> order;
+    size_t position;
+
+    QSet<quint64> drawn;
+};
+
+
+// Shared state of workers (under mutex)
+struct Optimizer::State
+{
+    State (quint64 size, quint32 seed)
+        : sampler(size, seed)
+    {
+    }
+
+    bool budgetExpired (int budget) const
+    {
+        return budget > 0 && timer.elapsed() >= 1000LL*budget;
+    }
+
+    QMutex mutex;
+    QElapsedTimer timer;
+
+    ConfigurationSampler sampler;
+
+    QVector<Result> results;
+    QVector<Result> front;
+};
+
+
+// *********************************************************************
+// *                             Optimizer                             *
+// *********************************************************************
+Optimizer::Optimizer (const Pipeline::PluginFactory *factory, const ParameterSpace &space, const Dataset &dataset)
+    : factory(factory),
+      space(space),
+      dataset(dataset),
+      timeBudget(0),
+      numWorkers(QThread::idealThreadCount()),
+      errorThreshold(2.0),
+      minPairs(3),
+      pruneMargin(1.25),
+      seed(0)
+{
+    if (!workDir.isValid()) {
+        throw Pipeline::Exception(QStringLiteral("Failed to create temporary directory!"));
+    }
+}
+
+Optimizer::~Optimizer ()
+{
+}
+
+
+void Optimizer::setBaseParameters (const QString &filename)
+{
+    baseParameters = filename;
+}
+
+void Optimizer::setTimeBudget (int seconds)
+{
+    timeBudget = qMax(seconds, 0);
+}
+
+void Optimizer::setNumWorkers (int workers)
+{
+    numWorkers = qMax(workers, 1);
+}
+
+void Optimizer::setErrorThreshold (double threshold)
+{
+    errorThreshold = threshold;
+}
+
+void Optimizer::setMinPairs (int pairs)
+{
+    minPairs = qMax(pairs, 1);
+}
+
+void Optimizer::setPruneMargin (double margin)
+{
+    pruneMargin = qMax(margin, 1.0);
+}
+
+void Optimizer::setSeed (quint32 seed)
+{
+    this->seed = seed;
+}
+
+
+QVector<Optimizer::Result> Optimizer::run ()
+{
+    // Base parameters; method's defaults unless provided
+    if (baseParameters.isEmpty()) {
+        QScopedPointer<QObject> methodObject(factory->createObject());
+        Pipeline::StereoMethod *method = qobject_cast<Pipeline::StereoMethod *>(methodObject.data());
+        if (!method) {
+            throw Pipeline::Exception(QStringLiteral("Plugin '%1' does not provide a stereo method!").arg(factory->getShortName()));
+        }
+
+        baseParameters = QDir(workDir.path()).filePath(QStringLiteral("base.yml"));
+        method->saveParameters(baseParameters);
+    }
+    space.validateBaseParameters(baseParameters);
+
+    // Runtimes of concurrent workers are only comparable if each of
+    // them is single-threaded
+    int previousNumThreads = cv::getNumThreads();
+    if (numWorkers > 1) {
+        cv::setNumThreads(1);
+    }
+
+    State state(space.getNumConfigurations(), seed);
+    state.timer.start();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numWorkers);
+
+    QVector<QFuture<void>> workers;
+    for (int i = 0; i < numWorkers; i++) {
+        workers.append(QtConcurrent::run(&pool, [this, &state] () {
+            evaluateConfigurations(state);
+        }));
+    }
+    for (QFuture<void> &worker : workers) {
+        worker.waitForFinished();
+    }
+
+    cv::setNumThreads(previousNumThreads);
+
+    return state.results;
+}
+
+void Optimizer::evaluateConfigurations (State &state) const
+{
+    // Method instance of this worker; created and destroyed in its thread
+    QScopedPointer<QObject> methodObject(factory->createObject());
+
+    forever {
+        quint64 index;
+
+        QMutexLocker locker(&state.mutex);
+        if (state.budgetExpired(timeBudget) || !state.sampler.next(index)) {
+            return;
+        }
+        locker.unlock();
+
+        QString parameterFile = QDir(workDir.path()).filePath(QStringLiteral("configuration-%1.yml").arg(index));
+
+        Result result;
+        try {
+            space.writeParameters(baseParameters, index, parameterFile);
+            result = evaluateConfiguration(state, methodObject.data(), index, parameterFile);
+        } catch (const std::exception &e) {
+            result = Result();
+            result.index = index;
+            result.configuration = space.getConfiguration(index);
+            result.time = 0;
+            result.error = 0;
+            result.numEvaluatedPairs = 0;
+            result.complete = false;
+            result.message = QString::fromStdString(e.what());
+        }
+
+        QFile::remove(parameterFile);
+
+        locker.relock();
+
+        state.results.append(result);
+        if (result.complete) {
+            state.front = getParetoFront(state.front + QVector<Result>{ result });
+        }
+
+        if (result.complete) {
+            qInfo().noquote() << QStringLiteral("#%1: configuration %2: %3 ms, %4 % bad pixels").arg(state.results.size()).arg(index).arg(result.time, 0, 'f', 2).arg(100*result.error, 0, 'f', 2);
+        } else {
+            qInfo().noquote() << QStringLiteral("#%1: configuration %2: %3").arg(state.results.size()).arg(index).arg(result.message);
+        }
+    }
+}
+
+static void convertInput (const cv::Mat &image, int type, cv::Mat &converted)
+{
+    // No preference or no conversion necessary
+    if (type < 0 || image.type() == type) {
+        converted = image;
+        return;
+    }
+
+    int channels = CV_MAT_CN(type);
+    int depth = CV_MAT_DEPTH(type);
+
+    // Only depth differs
+    if (image.channels() == channels) {
+        image.convertTo(converted, depth);
+        return;
+    }
+
+    // Color conversion
+    int code;
+    if (image.channels() == 3 && channels == 1) {
+        code = cv::COLOR_BGR2GRAY;
+    } else if (image.channels() == 4 && channels == 1) {
+        code = cv::COLOR_BGRA2GRAY;
+    } else if (image.channels() == 1 && channels == 3) {
+        code = cv::COLOR_GRAY2BGR;
+    } else if (image.channels() == 4 && channels == 3) {
+        code = cv::COLOR_BGRA2BGR;
+    } else {
+        throw Pipeline::Exception(QStringLiteral("Cannot convert %1-channel image to %2-channel image!").arg(image.channels()).arg(channels));
+    }
+
+    cv::Mat tmp;
+    cv::cvtColor(image, tmp, code);
+    tmp.convertTo(converted, depth);
+}
+
+Optimizer::Result Optimizer::evaluateConfiguration (State &state, QObject *methodObject, quint64 index, const QString &parameterFile) const
+{
+    Pipeline::StereoMethod *method = qobject_cast<Pipeline::StereoMethod *>(methodObject);
+    Pipeline::StereoMethod2 *method2 = qobject_cast<Pipeline::StereoMethod2 *>(methodObject);
+    if (!method) {
+        throw Pipeline::Exception(QStringLiteral("Plugin '%1' does not provide a stereo method!").arg(factory->getShortName()));
+    }
+
+    method->loadParameters(parameterFile);
+
+    Result result;
+    result.index = index;
+    result.configuration = space.getConfiguration(index);
+    result.time = 0;
+    result.error = 0;
+    result.numEvaluatedPairs = 0;
+    result.complete = false;
+
+    int inputType = method2 ? method2->getPreferredInputType() : -1;
+    cv::Size preparedSize;
+
+    cv::Mat imageL, imageR;
+    cv::Mat disparity, estimate;
+    Pipeline::DisparityFormat format;
+    int numDisparities;
+
+    double totalTime = 0;
+    qint64 numBad = 0, numKnown = 0;
+
+    QElapsedTimer timer;
+
+    const int numPairs = dataset.getNumPairs();
+    for (int i = 0; i < numPairs; i++) {
+        if (state.budgetExpired(timeBudget)) {
+            result.message = QStringLiteral("time budget expired");
+            return result;
+        }
+
+        const Dataset::Pair &pair = dataset.getPair(i);
+
+        // Input conversion and buffer allocation are not timed
+        convertInput(pair.imageL, inputType, imageL);
+        convertInput(pair.imageR, inputType, imageR);
+
+        if (method2 && preparedSize != imageL.size()) {
+            method2->prepare(imageL.size(), imageL.type());
+            preparedSize = imageL.size();
+        }
+
+        timer.start();
+        if (method2) {
+            method2->computeDisparity(imageL, imageR, disparity, numDisparities, format);
+        } else {
+            method->computeDisparity(imageL, imageR, disparity, numDisparities);
+            format = method->getDisparityFormat();
+        }
+        totalTime += timer.nsecsElapsed() / 1e6;
+
+        // Disparities that are invalid or too far off the known ground
+        // truth are bad
+        disparity.convertTo(estimate, CV_32F, format.scale, format.offset);
+
+        cv::Mat known = pair.groundTruth > 0;
+        cv::Mat bad = (estimate < 0) | (cv::abs(estimate - pair.groundTruth) > errorThreshold);
+
+        numBad += cv::countNonZero(bad & known);
+        numKnown += cv::countNonZero(known);
+
+        result.numEvaluatedPairs = i + 1;
+        result.time = totalTime / result.numEvaluatedPairs;
+        result.error = numKnown ? static_cast<double>(numBad) / numKnown : 0.0;
+
+        // Early stopping
+        if (result.numEvaluatedPairs >= minPairs && result.numEvaluatedPairs < numPairs) {
+            QMutexLocker locker(&state.mutex);
+            for (const Result &other : state.front) {
+                if (other.time * pruneMargin <= result.time && other.error * pruneMargin <= result.error) {
+                    result.message = QStringLiteral("pruned after %1 pairs (dominated by configuration %2)").arg(result.numEvaluatedPairs).arg(other.index);
+                    return result;
+                }
+            }
+        }
+    }
+
+    result.complete = true;
+    return result;
+}
+
+
+QVector<Optimizer::Result> Optimizer::getParetoFront (const QVector<Result> &results)
+{
+    QVector<Result> sorted;
+    for (const Result &result : results) {
+        if (result.complete) {
+            sorted.append(result);
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [] (const Result &a, const Result &b) {
+        return a.time < b.time || (a.time == b.time && a.error < b.error);
+    });
+
+    // Sweep by increasing runtime, keeping strictly decreasing error
+    QVector<Result> front;
+    for (const Result &result : sorted) {
+        if (front.isEmpty() || result.error < front.last().error) {
+            front.append(result);
+        }
+    }
+
+    return front;
+}
+
+
+// *********************************************************************
+// *                              Output                               *
+// *********************************************************************
+void Optimizer::saveResults (const QVector<Result> &results, const QString &directory) const
+{
+    QDir dir(directory);
+    if (!dir.mkpath(QStringLiteral("."))) {
+        throw Pipeline::Exception(QStringLiteral("Cannot create directory '%1'!").arg(directory));
+    }
+
+    QVector<Result> front = getParetoFront(results);
+
+    // Front as method parameter files, from fastest to most accurate
+    QStringList files;
+    for (int i = 0; i < front.size(); i++) {
+        QString filename = QStringLiteral("pareto-%1.yml").arg(i, 2, 10, QLatin1Char('0'));
+        space.writeParameters(baseParameters, front[i].index, dir.filePath(filename));
+        files.append(filename);
+    }
+
+    writeCsv(front, files, dir.filePath(QStringLiteral("pareto.csv")));
+    writeCsv(results, QStringList(), dir.filePath(QStringLiteral("results.csv")));
+}
+
+void Optimizer::writeCsv (const QVector<Result> &results, const QStringList &files, const QString &filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    QTextStream stream(&file);
+
+    // Header
+    stream << "Configuration";
+    for (const QString &name : space.getParameterNames()) {
+        stream << "," << name;
+    }
+    stream << ",TimeMs,Error,EvaluatedPairs,Status";
+    if (!files.isEmpty()) {
+        stream << ",ParameterFile";
+    }
+    stream << "\n";
+
+    // Results
+    for (int i = 0; i < results.size(); i++) {
+        const Result &result = results[i];
+
+        stream << result.index;
+        for (double value : result.configuration) {
+            stream << "," << value;
+        }
+        stream << "," << result.time << "," << result.error << "," << result.numEvaluatedPairs;
+        stream << ",\"" << (result.complete ? QStringLiteral("complete") : result.message) << "\"";
+        if (!files.isEmpty()) {
+            stream << "," << files[i];
+        }
+        stream << "\n";
+    }
+}
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,125 @@
+/*
+ * MVL Stereo Optimizer: parameter sweep
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__OPTIMIZER__OPTIMIZER_H
+#define MVL_STEREO_TOOLBOX__OPTIMIZER__OPTIMIZER_H
+
+#include "dataset.h"
+#include "parameter_space.h"
+
+#include <QtCore>
+
+
+namespace MVL {
+namespace StereoToolbox {
+
+namespace Pipeline {
+class PluginFactory;
+} // Pipeline
+
+namespace Optimizer {
+
+
+// Evaluates configurations from the parameter space on the dataset,
+// in random order, until the space is exhausted or the time budget
+// runs out. Each worker thread uses its own method instance. A
+// configuration is evaluated pair by pair, and its evaluation is
+// stopped early once its running runtime and error are both worse
+// than those of an already-evaluated configuration by given margin.
+// Error is the fraction of pixels with known ground truth whose
+// disparity is invalid or off by more than the threshold
+class Optimizer
+{
+public:
+    struct Result {
+        quint64 index;
+        QVector<double> configuration;
+
+        double time; // Mean processing time per pair, in milliseconds
+        double error;
+        int numEvaluatedPairs;
+
+        bool complete;
+        QString message; // Reason for incomplete evaluation
+    };
+
+    Optimizer (const Pipeline::PluginFactory *factory, const ParameterSpace &space, const Dataset &dataset);
+    ~Optimizer ();
+
+    // Parameter file that provides values of parameters that are not
+    // swept; if not set, method's defaults are used
+    void setBaseParameters (const QString &filename);
+
+    // Time budget in seconds; zero means no limit
+    void setTimeBudget (int seconds);
+
+    // Number of workers; when more than one, OpenCV's own threading is
+    // disabled, so that runtimes are single-threaded and comparable
+    void setNumWorkers (int workers);
+
+    void setErrorThreshold (double threshold);
+
+    // Early stopping: minimal number of evaluated pairs, and factor
+    // by which both runtime and error must be worse
+    void setMinPairs (int pairs);
+    void setPruneMargin (double margin);
+
+    void setSeed (quint32 seed);
+
+    QVector<Result> run ();
+
+    // Complete results that are not dominated in runtime and error,
+    // sorted by runtime
+    static QVector<Result> getParetoFront (const QVector<Result> &results);
+
+    // Writes the front as method parameter files, and both the front
+    // and all results as CSV files
+    void saveResults (const QVector<Result> &results, const QString &directory) const;
+
+protected:
+    struct State;
+
+    void evaluateConfigurations (State &state) const;
+    Result evaluateConfiguration (State &state, QObject *methodObject, quint64 index, const QString &parameterFile) const;
+
+    void writeCsv (const QVector<Result> &results, const QStringList &files, const QString &filename) const;
+
+protected:
+    const Pipeline::PluginFactory *factory;
+    const ParameterSpace &space;
+    const Dataset &dataset;
+
+    QTemporaryDir workDir;
+    QString baseParameters;
+
+    int timeBudget;
+    int numWorkers;
+    double errorThreshold;
+    int minPairs;
+    double pruneMargin;
+    quint32 seed;
+};
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
+
+
+#endif
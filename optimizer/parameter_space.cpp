@@ -0,0 +1,187 @@
+/*
+ * MVL Stereo Optimizer: parameter space
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "parameter_space.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/core.hpp>
+
+#include <cmath>
+#include <limits>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Optimizer {
+
+
+ParameterSpace::ParameterSpace ()
+{
+}
+
+void ParameterSpace::load (const QString &filename)
+{
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("ParameterSpace")) {
+        throw Pipeline::Exception(QStringLiteral("Invalid parameter space!"));
+    }
+
+    names.clear();
+    values.clear();
+
+    cv::FileNode nodes = storage["Parameters"];
+    for (cv::FileNodeIterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const cv::FileNode node = *it;
+
+        QString name = QString::fromStdString((std::string)node["Name"]);
+        if (name.isEmpty() || names.contains(name)) {
+            throw Pipeline::Exception(QStringLiteral("Missing or duplicate parameter name!"));
+        }
+
+        // Either explicit list of values, or a range
+        QVector<double> parameterValues;
+        if (!node["Values"].empty()) {
+            cv::FileNode valueNodes = node["Values"];
+            for (cv::FileNodeIterator vit = valueNodes.begin(); vit != valueNodes.end(); ++vit) {
+                parameterValues.append((double)*vit);
+            }
+        } else {
+            double min = node["Min"];
+            double max = node["Max"];
+            double step = node["Step"];
+
+            if (step <= 0 || max < min) {
+                throw Pipeline::Exception(QStringLiteral("Invalid range of parameter '%1'!").arg(name));
+            }
+
+            // Multiples of step avoid accumulation of rounding errors
+            int numSteps = static_cast<int>(std::floor((max - min) / step + 1e-6));
+            for (int i = 0; i <= numSteps; i++) {
+                parameterValues.append(min + i*step);
+            }
+        }
+
+        if (parameterValues.isEmpty()) {
+            throw Pipeline::Exception(QStringLiteral("Parameter '%1' has no values!").arg(name));
+        }
+
+        names.append(name);
+        values.append(parameterValues);
+    }
+
+    if (names.isEmpty()) {
+        throw Pipeline::Exception(QStringLiteral("Parameter space contains no parameters!"));
+    }
+
+    getNumConfigurations(); // Validate size
+}
+
+quint64 ParameterSpace::getNumConfigurations () const
+{
+    quint64 size = 1;
+    for (const QVector<double> &parameterValues : values) {
+        quint64 count = parameterValues.size();
+        if (size > std::numeric_limits<quint64>::max() / count) {
+            throw Pipeline::Exception(QStringLiteral("Parameter space is too large!"));
+        }
+        size *= count;
+    }
+    return size;
+}
+
+const QStringList &ParameterSpace::getParameterNames () const
+{
+    return names;
+}
+
+QVector<double> ParameterSpace::getConfiguration (quint64 index) const
+{
+    // Mixed-radix decomposition of index; first parameter varies fastest
+    QVector<double> configuration;
+    for (const QVector<double> &parameterValues : values) {
+        configuration.append(parameterValues[index % parameterValues.size()]);
+        index /= parameterValues.size();
+    }
+    return configuration;
+}
+
+void ParameterSpace::validateBaseParameters (const QString &baseFilename) const
+{
+    cv::FileStorage base(baseFilename.toStdString(), cv::FileStorage::READ);
+    if (!base.isOpened()) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(baseFilename));
+    }
+
+    for (const QString &name : names) {
+        const cv::FileNode node = base[name.toStdString()];
+        if (node.empty() || !(node.isInt() || node.isReal())) {
+            throw Pipeline::Exception(QStringLiteral("'%1' is not a numeric parameter of the method!").arg(name));
+        }
+    }
+}
+
+void ParameterSpace::writeParameters (const QString &baseFilename, quint64 index, const QString &filename) const
+{
+    cv::FileStorage base(baseFilename.toStdString(), cv::FileStorage::READ);
+    if (!base.isOpened()) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(baseFilename));
+    }
+
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw Pipeline::Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    QVector<double> configuration = getConfiguration(index);
+
+    // Copy the (flat) base parameter file, overriding swept parameters;
+    // integer parameters remain integers
+    const cv::FileNode root = base.root();
+    for (cv::FileNodeIterator it = root.begin(); it != root.end(); ++it) {
+        const cv::FileNode node = *it;
+        const std::string key = node.name();
+
+        int parameter = names.indexOf(QString::fromStdString(key));
+        if (parameter >= 0) {
+            if (node.isInt()) {
+                storage << key << cvRound(configuration[parameter]);
+            } else {
+                storage << key << configuration[parameter];
+            }
+        } else if (node.isInt()) {
+            storage << key << (int)node;
+        } else if (node.isReal()) {
+            storage << key << (double)node;
+        } else if (node.isString()) {
+            storage << key << (std::string)node;
+        }
+    }
+}
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
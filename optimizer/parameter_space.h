@@ -0,0 +1,74 @@
+/*
+ * MVL Stereo Optimizer: parameter space
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__OPTIMIZER__PARAMETER_SPACE_H
+#define MVL_STEREO_TOOLBOX__OPTIMIZER__PARAMETER_SPACE_H
+
+#include <QtCore>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Optimizer {
+
+
+// Grid of stereo method parameter values, described by a file of the
+// following form:
+//
+// %YAML:1.0
+// DataType: "ParameterSpace"
+// Parameters:
+//    - { Name: "NumDisparities", Min: 32, Max: 128, Step: 16 }
+//    - { Name: "SADWindowSize", Values: [ 5, 9, 15, 21 ] }
+//
+// Names are the keys of method's parameter file. Configurations are
+// addressed by their index in the grid; a configuration is realized
+// as a method parameter file by overriding the swept keys of a base
+// parameter file, so the result can be loaded by the method (and by
+// Pipeline::loadStereoMethodParameters()) as any other
+class ParameterSpace
+{
+public:
+    ParameterSpace ();
+
+    void load (const QString &filename);
+
+    // Number of configurations; throws if it cannot be represented
+    quint64 getNumConfigurations () const;
+
+    const QStringList &getParameterNames () const;
+    QVector<double> getConfiguration (quint64 index) const;
+
+    // Makes sure all swept parameters are present in base file
+    void validateBaseParameters (const QString &baseFilename) const;
+
+    void writeParameters (const QString &baseFilename, quint64 index, const QString &filename) const;
+
+protected:
+    QStringList names;
+    QVector<QVector<double>> values;
+};
+
+
+} // Optimizer
+} // StereoToolbox
+} // MVL
+
+
+#endif
@@ -0,0 +1,607 @@
+/*
+ * Stereo Pipeline: disparity post-filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "disparity_filter.h"
+#include "exception.h"
+
+#include "disparity_filter_p.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+// *********************************************************************
+// *                         Filtering helpers                         *
+// *********************************************************************
+// Snapshot of filter parameters, taken at the beginning of filtering
+// so that worker threads see a consistent set of values
+struct DisparityFilterSettings
+{
+    int filterMethod;
+
+    float lambda;
+    float sigmaColor;
+    int numIterations;
+
+    int radius;
+    float epsilon;
+
+    float minSupport;
+};
+
+// Width of column tiles in vertical passes of the fast global smoother
+static const int SmootherTileWidth = 64;
+
+
+// Fast global smoother, horizontal pass: each row of the two-channel
+// (weighted disparity, weight) image is an independent tridiagonal
+// system, solved in-place with the Thomas algorithm
+class SmootherRowBody : public cv::ParallelLoopBody
+{
+public:
+    SmootherRowBody (cv::Mat &data, const cv::Mat &weights, float lambda)
+        : data(data),
+          weights(weights),
+          lambda(lambda)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = data.cols;
+        std::vector<float> coeffs(width);
+
+        for (int y = range.start; y < range.end; y++) {
+            cv::Vec2f *u = data.ptr<cv::Vec2f>(y);
+            const float *w = weights.ptr<float>(y);
+
+            // Forward sweep
+            float wl = 0.0f;
+            float cp = 0.0f;
+            cv::Vec2f up(0.0f, 0.0f);
+            for (int x = 0; x < width; x++) {
+                const float a = -lambda*wl;
+                const float c = -lambda*w[x];
+                const float invDenom = 1.0f / (1.0f + lambda*(wl + w[x]) - a*cp);
+
+                cp = c*invDenom;
+                up = (u[x] - a*up) * invDenom;
+
+                coeffs[x] = cp;
+                u[x] = up;
+                wl = w[x];
+            }
+
+            // Back substitution
+            for (int x = width - 2; x >= 0; x--) {
+                u[x] -= coeffs[x]*u[x+1];
+            }
+        }
+    }
+
+protected:
+    cv::Mat &data;
+    const cv::Mat &weights;
+    float lambda;
+};
+
+// Fast global smoother, vertical pass: image is split into tiles of
+// columns, and columns of a tile are solved simultaneously, so that
+// memory is accessed row-wise
+class SmootherColumnBody : public cv::ParallelLoopBody
+{
+public:
+    SmootherColumnBody (cv::Mat &data, const cv::Mat &weights, float lambda)
+        : data(data),
+          weights(weights),
+          lambda(lambda)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int height = data.rows;
+        std::vector<float> coeffs(height * SmootherTileWidth);
+
+        for (int tile = range.start; tile < range.end; tile++) {
+            const int x0 = tile*SmootherTileWidth;
+            const int x1 = std::min(x0 + SmootherTileWidth, data.cols);
+            const int tileWidth = x1 - x0;
+
+            // Forward sweep
+            for (int y = 0; y < height; y++) {
+                cv::Vec2f *u = data.ptr<cv::Vec2f>(y) + x0;
+                const cv::Vec2f *up = (y > 0) ? data.ptr<cv::Vec2f>(y - 1) + x0 : nullptr;
+                const float *w = weights.ptr<float>(y) + x0;
+                const float *wu = (y > 0) ? weights.ptr<float>(y - 1) + x0 : nullptr;
+                float *cp = &coeffs[y*SmootherTileWidth];
+                const float *cpu = (y > 0) ? &coeffs[(y - 1)*SmootherTileWidth] : nullptr;
+
+                for (int i = 0; i < tileWidth; i++) {
+                    const float wl = wu ? wu[i] : 0.0f;
+                    const float a = -lambda*wl;
+                    const float c = -lambda*w[i];
+                    const float invDenom = 1.0f / (1.0f + lambda*(wl + w[i]) - (cpu ? a*cpu[i] : 0.0f));
+
+                    cp[i] = c*invDenom;
+                    u[i] = (up ? u[i] - a*up[i] : u[i]) * invDenom;
+                }
+            }
+
+            // Back substitution
+            for (int y = height - 2; y >= 0; y--) {
+                cv::Vec2f *u = data.ptr<cv::Vec2f>(y) + x0;
+                const cv::Vec2f *un = data.ptr<cv::Vec2f>(y + 1) + x0;
+                const float *cp = &coeffs[y*SmootherTileWidth];
+
+                for (int i = 0; i < tileWidth; i++) {
+                    u[i] -= cp[i]*un[i];
+                }
+            }
+        }
+    }
+
+protected:
+    cv::Mat &data;
+    const cv::Mat &weights;
+    float lambda;
+};
+
+// Fast global smoother (Min et al.): approximates the weighted least
+// squares solution with alternating 1-D passes, with smoothing strength
+// decreasing over the iterations
+static void applyFastGlobalSmoother (const cv::Mat &guide, cv::Mat &data, const DisparityFilterSettings &settings)
+{
+    const int numThreads = std::max(1, cv::getNumThreads());
+
+    // Edge-aware weights between neighbouring pixels; the weight of
+    // the last column (row) is zero, which terminates each system
+    const float scale = -1.0f / settings.sigmaColor;
+
+    cv::Mat weightsH(guide.size(), CV_32F, cv::Scalar(0));
+    if (guide.cols > 1) {
+        cv::Mat roi = weightsH.colRange(0, guide.cols - 1);
+        cv::absdiff(guide.colRange(1, guide.cols), guide.colRange(0, guide.cols - 1), roi);
+        roi *= scale;
+        cv::exp(roi, roi);
+    }
+
+    cv::Mat weightsV(guide.size(), CV_32F, cv::Scalar(0));
+    if (guide.rows > 1) {
+        cv::Mat roi = weightsV.rowRange(0, guide.rows - 1);
+        cv::absdiff(guide.rowRange(1, guide.rows), guide.rowRange(0, guide.rows - 1), roi);
+        roi *= scale;
+        cv::exp(roi, roi);
+    }
+
+    const int numTiles = (guide.cols + SmootherTileWidth - 1) / SmootherTileWidth;
+    const double normalization = std::pow(4.0, settings.numIterations) - 1.0;
+
+    for (int t = 0; t < settings.numIterations; t++) {
+        const float lambda = static_cast<float>(1.5 * settings.lambda * std::pow(4.0, settings.numIterations - t - 1) / normalization);
+
+        cv::parallel_for_(cv::Range(0, data.rows), SmootherRowBody(data, weightsH, lambda), numThreads * 4);
+        cv::parallel_for_(cv::Range(0, numTiles), SmootherColumnBody(data, weightsV, lambda));
+    }
+}
+
+
+// Guided filter (He et al.), applied to stripes of rows. Stripes are
+// extended by twice the radius, so that the two box filters produce
+// exact results in the stripe's own rows
+class GuidedFilterBody : public cv::ParallelLoopBody
+{
+public:
+    GuidedFilterBody (const cv::Mat &guide, const cv::Mat &data, cv::Mat &output, const DisparityFilterSettings &settings, int numStripes)
+        : guide(guide),
+          data(data),
+          output(output),
+          settings(settings),
+          numStripes(numStripes)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const cv::Size window(2*settings.radius + 1, 2*settings.radius + 1);
+        const int extent = 2*settings.radius;
+
+        for (int stripe = range.start; stripe < range.end; stripe++) {
+            const int y0 = (data.rows * stripe) / numStripes;
+            const int y1 = (data.rows * (stripe + 1)) / numStripes;
+            const int ey0 = std::max(y0 - extent, 0);
+            const int ey1 = std::min(y1 + extent, data.rows);
+
+            const cv::Mat I = guide.rowRange(ey0, ey1);
+            const cv::Mat p = data.rowRange(ey0, ey1);
+
+            cv::Mat meanI, meanII, meanP, meanIP;
+            cv::boxFilter(I, meanI, CV_32F, window);
+            cv::boxFilter(I.mul(I), meanII, CV_32F, window);
+            cv::boxFilter(p, meanP, CV_32F, window);
+
+            // Guide is single-channel, data two-channel
+            cv::Mat I2;
+            cv::merge(std::vector<cv::Mat>{ I, I }, I2);
+            cv::boxFilter(I2.mul(p), meanIP, CV_32F, window);
+
+            cv::Mat meanI2, varI2;
+            cv::Mat varI = meanII - meanI.mul(meanI) + settings.epsilon;
+            cv::merge(std::vector<cv::Mat>{ meanI, meanI }, meanI2);
+            cv::merge(std::vector<cv::Mat>{ varI, varI }, varI2);
+
+            cv::Mat a, b;
+            cv::divide(meanIP - meanI2.mul(meanP), varI2, a);
+            b = meanP - a.mul(meanI2);
+
+            cv::boxFilter(a, a, CV_32F, window);
+            cv::boxFilter(b, b, CV_32F, window);
+
+            cv::Mat q = a.mul(I2) + b;
+            q.rowRange(y0 - ey0, y1 - ey0).copyTo(output.rowRange(y0, y1));
+        }
+    }
+
+protected:
+    const cv::Mat &guide;
+    const cv::Mat &data;
+    cv::Mat &output;
+    const DisparityFilterSettings &settings;
+    int numStripes;
+};
+
+
+DisparityFilterPrivate::DisparityFilterPrivate (DisparityFilter *parent)
+    : q_ptr(parent),
+      filterMethod(DisparityFilter::FilterFastGlobalSmoother),
+      lambda(400.0),
+      sigmaColor(8.0),
+      numIterations(3),
+      radius(8),
+      epsilon(100.0),
+      minSupport(0.01)
+{
+}
+
+
+DisparityFilter::DisparityFilter (QObject *parent)
+    : QObject(parent), d_ptr(new DisparityFilterPrivate(this))
+{
+}
+
+DisparityFilter::~DisparityFilter ()
+{
+}
+
+
+// *********************************************************************
+// *                           Filter method                           *
+// *********************************************************************
+void DisparityFilter::setFilterMethod (int method)
+{
+    Q_D(DisparityFilter);
+
+    if (method == d->filterMethod) {
+        return;
+    }
+
+    // Validate
+    if (method < FilterFastGlobalSmoother || method > FilterGuided) {
+        d->filterMethod = FilterFastGlobalSmoother;
+        emit error(QString("Disparity filter method %1 not supported!").arg(method));
+    } else {
+        d->filterMethod = method;
+    }
+
+    emit parameterChanged();
+}
+
+int DisparityFilter::getFilterMethod () const
+{
+    Q_D(const DisparityFilter);
+    return d->filterMethod;
+}
+
+
+// *********************************************************************
+// *                        Fast global smoother                       *
+// *********************************************************************
+void DisparityFilter::setLambda (double lambda)
+{
+    Q_D(DisparityFilter);
+
+    d->lambda = std::max(lambda, 0.0);
+    emit parameterChanged();
+}
+
+double DisparityFilter::getLambda () const
+{
+    Q_D(const DisparityFilter);
+    return d->lambda;
+}
+
+
+void DisparityFilter::setSigmaColor (double sigma)
+{
+    Q_D(DisparityFilter);
+
+    if (sigma <= 0.0) {
+        emit error(QString("Invalid color sigma %1!").arg(sigma));
+        return;
+    }
+
+    d->sigmaColor = sigma;
+    emit parameterChanged();
+}
+
+double DisparityFilter::getSigmaColor () const
+{
+    Q_D(const DisparityFilter);
+    return d->sigmaColor;
+}
+
+
+void DisparityFilter::setNumIterations (int iterations)
+{
+    Q_D(DisparityFilter);
+
+    d->numIterations = std::max(iterations, 1);
+    emit parameterChanged();
+}
+
+int DisparityFilter::getNumIterations () const
+{
+    Q_D(const DisparityFilter);
+    return d->numIterations;
+}
+
+
+// *********************************************************************
+// *                           Guided filter                           *
+// *********************************************************************
+void DisparityFilter::setRadius (int radius)
+{
+    Q_D(DisparityFilter);
+
+    d->radius = std::max(radius, 1);
+    emit parameterChanged();
+}
+
+int DisparityFilter::getRadius () const
+{
+    Q_D(const DisparityFilter);
+    return d->radius;
+}
+
+
+void DisparityFilter::setEpsilon (double epsilon)
+{
+    Q_D(DisparityFilter);
+
+    if (epsilon <= 0.0) {
+        emit error(QString("Invalid regularization %1!").arg(epsilon));
+        return;
+    }
+
+    d->epsilon = epsilon;
+    emit parameterChanged();
+}
+
+double DisparityFilter::getEpsilon () const
+{
+    Q_D(const DisparityFilter);
+    return d->epsilon;
+}
+
+
+// *********************************************************************
+// *                          Minimum support                          *
+// *********************************************************************
+void DisparityFilter::setMinSupport (double support)
+{
+    Q_D(DisparityFilter);
+
+    d->minSupport = std::min(std::max(support, 0.0), 1.0);
+    emit parameterChanged();
+}
+
+double DisparityFilter::getMinSupport () const
+{
+    Q_D(const DisparityFilter);
+    return d->minSupport;
+}
+
+
+// *********************************************************************
+// *                     Parameter import/export                       *
+// *********************************************************************
+void DisparityFilter::loadParameters (const QString &filename)
+{
+    Q_D(DisparityFilter);
+
+    // Open storage
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("DisparityFilterParameters")) {
+        throw Exception(QStringLiteral("Invalid disparity filter parameters configuration!"));
+    }
+
+    // Load parameters
+    int method = (int)storage["FilterMethod"];
+    if (method < FilterFastGlobalSmoother || method > FilterGuided) {
+        throw Exception(QStringLiteral("Disparity filter method %1 not supported!").arg(method));
+    }
+    d->filterMethod = method;
+
+    d->lambda = std::max((double)storage["Lambda"], 0.0);
+    d->sigmaColor = std::max((double)storage["SigmaColor"], 1e-3);
+    d->numIterations = std::max((int)storage["NumIterations"], 1);
+
+    d->radius = std::max((int)storage["Radius"], 1);
+    d->epsilon = std::max((double)storage["Epsilon"], 1e-3);
+
+    d->minSupport = std::min(std::max((double)storage["MinSupport"], 0.0), 1.0);
+
+    emit parameterChanged();
+}
+
+void DisparityFilter::saveParameters (const QString &filename) const
+{
+    Q_D(const DisparityFilter);
+
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    // Data type
+    storage << "DataType" << "DisparityFilterParameters";
+
+    // Save parameters
+    storage << "FilterMethod" << d->filterMethod;
+
+    storage << "Lambda" << d->lambda;
+    storage << "SigmaColor" << d->sigmaColor;
+    storage << "NumIterations" << d->numIterations;
+
+    storage << "Radius" << d->radius;
+    storage << "Epsilon" << d->epsilon;
+
+    storage << "MinSupport" << d->minSupport;
+}
+
+
+// *********************************************************************
+// *                             Filtering                             *
+// *********************************************************************
+void DisparityFilter::filterDisparity (const cv::Mat &disparity, const DisparityFormat &format, const cv::Mat &guide, const cv::Mat &confidence, cv::Mat &filtered) const
+{
+    Q_D(const DisparityFilter);
+
+    if (disparity.empty()) {
+        filtered = cv::Mat();
+        return;
+    }
+
+    // Validate input
+    if (disparity.channels() != 1) {
+        throw Exception(QStringLiteral("Disparity filter requires single-channel disparity; unhandled format %1!").arg(disparity.type()));
+    }
+    if (guide.empty()) {
+        throw Exception(QStringLiteral("Disparity filter requires a guide image!"));
+    }
+    if (!confidence.empty() && (confidence.type() != CV_32F || confidence.size() != disparity.size())) {
+        throw Exception(QStringLiteral("Confidence map must be a CV_32F image of disparity's size!"));
+    }
+
+    // Snapshot of parameters
+    const DisparityFilterSettings settings = {
+        d->filterMethod,
+        static_cast<float>(d->lambda),
+        static_cast<float>(d->sigmaColor),
+        d->numIterations,
+        d->radius,
+        static_cast<float>(d->epsilon),
+        static_cast<float>(std::max(d->minSupport, 1e-6)), // Excludes zero-weight pixels
+    };
+
+    // Grayscale guide of disparity's size, in 8-bit intensity units
+    cv::Mat guideGray;
+    switch (guide.channels()) {
+        case 1: {
+            guideGray = guide;
+            break;
+        }
+        case 3: {
+            cv::cvtColor(guide, guideGray, cv::COLOR_BGR2GRAY);
+            break;
+        }
+        case 4: {
+            cv::cvtColor(guide, guideGray, cv::COLOR_BGRA2GRAY);
+            break;
+        }
+        default: {
+            throw Exception(QStringLiteral("Unhandled guide image format %1!").arg(guide.type()));
+        }
+    }
+    if (guideGray.size() != disparity.size()) {
+        cv::resize(guideGray, guideGray, disparity.size(), 0, 0, cv::INTER_AREA);
+    }
+
+    cv::Mat guideFloat;
+    guideGray.convertTo(guideFloat, CV_32F, guideGray.depth() == CV_16U ? 1.0/256 : 1.0);
+
+    // Weights: zero for invalid disparities, confidence (or one) for
+    // valid ones
+    cv::Mat disparityFloat;
+    disparity.convertTo(disparityFloat, CV_32F, format.scale, format.offset);
+
+    cv::Mat weights;
+    cv::Mat(disparityFloat >= 0).convertTo(weights, CV_32F, 1.0/255);
+    if (!confidence.empty()) {
+        weights = weights.mul(confidence);
+    }
+
+    // Two-channel image of weighted disparities and weights, so that
+    // both are filtered in a single pass
+    cv::Mat data;
+    cv::merge(std::vector<cv::Mat>{ disparityFloat.mul(weights), weights }, data);
+
+    switch (settings.filterMethod) {
+        case FilterFastGlobalSmoother: {
+            applyFastGlobalSmoother(guideFloat, data, settings);
+            break;
+        }
+        case FilterGuided: {
+            const int numThreads = std::max(1, cv::getNumThreads());
+            const int numStripes = std::max(1, std::min(numThreads, data.rows / (4*settings.radius)));
+
+            cv::Mat output(data.size(), data.type());
+            cv::parallel_for_(cv::Range(0, numStripes), GuidedFilterBody(guideFloat, data, output, settings, numStripes));
+            data = output;
+            break;
+        }
+    }
+
+    // Normalize by filtered weights; pixels with insufficient support
+    // are invalid
+    std::vector<cv::Mat> channels;
+    cv::split(data, channels);
+
+    cv::divide(channels[0], channels[1], filtered);
+    filtered.setTo(cv::Scalar(-1.0), channels[1] < settings.minSupport);
+}
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
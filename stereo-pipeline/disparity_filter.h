@@ -0,0 +1,109 @@
+/*
+ * Stereo Pipeline: disparity post-filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FILTER_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FILTER_H
+
+#include <stereo-pipeline/export.h>
+#include <stereo-pipeline/disparity_format.h>
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+class DisparityFilterPrivate;
+
+// Edge-aware disparity post-filter: smooths the disparity and fills in
+// its holes, using the (rectified) left image as guide, so that the
+// result follows the image edges. Invalid disparities have zero weight,
+// and valid ones are weighted by the optional confidence map (e.g., the
+// one from the left-right consistency check); the filtered disparity
+// is normalized by the equally filtered weights. Pixels with too little
+// support remain invalid. The output is always CV_32F disparity in
+// identity format
+class MVL_STEREO_PIPELINE_EXPORT DisparityFilter : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DisparityFilter)
+    Q_DECLARE_PRIVATE(DisparityFilter)
+    QScopedPointer<DisparityFilterPrivate> const d_ptr;
+
+public:
+    DisparityFilter (QObject *parent = nullptr);
+    ~DisparityFilter ();
+
+    enum {
+        FilterFastGlobalSmoother,
+        FilterGuided,
+    };
+
+    void setFilterMethod (int method);
+    int getFilterMethod () const;
+
+    // Fast global smoother: weighted-least-squares smoothing, solved
+    // by alternating horizontal and vertical 1-D passes. Lambda is the
+    // smoothing strength, sigma the guide's intensity difference at
+    // which smoothing across an edge is attenuated by 1/e
+    void setLambda (double lambda);
+    double getLambda () const;
+
+    void setSigmaColor (double sigma);
+    double getSigmaColor () const;
+
+    void setNumIterations (int iterations);
+    int getNumIterations () const;
+
+    // Guided filter: window radius, and regularization (in squared
+    // guide intensity units)
+    void setRadius (int radius);
+    int getRadius () const;
+
+    void setEpsilon (double epsilon);
+    double getEpsilon () const;
+
+    // Minimum normalized support of a filtered pixel (0-1)
+    void setMinSupport (double support);
+    double getMinSupport () const;
+
+    // Parameter import/export
+    void loadParameters (const QString &filename);
+    void saveParameters (const QString &filename) const;
+
+    // Filtering; guide is resized to disparity size if necessary, and
+    // confidence map (CV_32F, 0-1) may be empty
+    void filterDisparity (const cv::Mat &disparity, const DisparityFormat &format, const cv::Mat &guide, const cv::Mat &confidence, cv::Mat &filtered) const;
+
+signals:
+    void parameterChanged ();
+
+    void error (const QString &message);
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Stereo Pipeline: disparity post-filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FILTER_P_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FILTER_P_H
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+class DisparityFilterPrivate
+{
+    Q_DISABLE_COPY(DisparityFilterPrivate)
+    Q_DECLARE_PUBLIC(DisparityFilter)
+
+    DisparityFilter * const q_ptr;
+
+    DisparityFilterPrivate (DisparityFilter *parent);
+
+protected:
+    int filterMethod;
+
+    double lambda;
+    double sigmaColor;
+    int numIterations;
+
+    int radius;
+    double epsilon;
+
+    double minSupport;
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
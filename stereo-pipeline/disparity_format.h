@@ -0,0 +1,73 @@
+/*
+ * Stereo Pipeline: disparity format descriptor
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FORMAT_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_FORMAT_H
+
+#include <QtCore>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+// Describes the representation of disparity values in a disparity
+// image: the actual disparity is given by raw*scale + offset. This
+// allows disparity to flow through the pipeline in its native type
+// (e.g., CV_16S with four fractional bits, as produced by OpenCV
+// block matching, has scale of 1/16), and to be converted to float
+// only when explicitly requested. Raw values that map to negative
+// disparities denote invalid disparities
+struct DisparityFormat
+{
+    DisparityFormat (double scale = 1.0, double offset = 0.0)
+        : scale(scale), offset(offset)
+    {
+    }
+
+    bool isIdentity () const
+    {
+        return scale == 1.0 && offset == 0.0;
+    }
+
+    bool operator == (const DisparityFormat &other) const
+    {
+        return scale == other.scale && offset == other.offset;
+    }
+
+    bool operator != (const DisparityFormat &other) const
+    {
+        return !(*this == other);
+    }
+
+    double scale;
+    double offset;
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+Q_DECLARE_METATYPE(MVL::StereoToolbox::Pipeline::DisparityFormat)
+
+
+#endif
@@ -53,6 +53,14 @@ DisparityVisualizationPrivate::DisparityVisualizationPrivate (DisparityVisualiza
 
     // Default method: OpenCV CPU
     method = DisparityVisualization::MethodGrayscale;
+
+    // Default color map: hue (same as CUDA method)
+    colormap = DisparityVisualization::ColormapHue;
+
+    // Color table is built on first use
+    colorTableLevels = 0;
+    colorTableColormap = -1;
+    colorTableSteps = 0;
 }
 
 
@@ -103,28 +111,65 @@ const QList<int> &DisparityVisualization::getSupportedVisualizationMethods () co
 }
 
 
+// *********************************************************************
+// *                             Color map                             *
+// *********************************************************************
+void DisparityVisualization::setColormap (int colormap)
+{
+    Q_D(DisparityVisualization);
+
+    if (colormap == d->colormap) {
+        return;
+    }
+
+    // Validate
+    if (colormap < ColormapHue || colormap > ColormapParula) {
+        emit error(QString("Color map %1 not supported!").arg(colormap));
+    } else {
+        d->colormap = colormap;
+    }
+
+    // Emit in any case
+    emit colormapChanged(d->colormap);
+}
+
+int DisparityVisualization::getColormap () const
+{
+    Q_D(const DisparityVisualization);
+    return d->colormap;
+}
+
+
 // *********************************************************************
 // *                           Visualization                           *
 // *********************************************************************
-void DisparityVisualization::visualizeDisparity (const cv::Mat &disparity, int disparityLevels, cv::Mat &visualization) const
+void DisparityVisualization::visualizeDisparity (const cv::Mat &disparity, int disparityLevels, cv::Mat &visualization, const DisparityFormat &format) const
 {
     Q_D(const DisparityVisualization);
 
     switch (d->method) {
         case MethodGrayscale: {
             // Raw grayscale disparity
-            disparity.convertTo(visualization, CV_8U, 255.0/disparityLevels);
+            disparity.convertTo(visualization, CV_8U, 255.0*format.scale/disparityLevels, 255.0*format.offset/disparityLevels);
             break;
         }
 #ifdef HAVE_OPENCV_CUDASTEREO
         case MethodColorCuda: {
             try {
                 // Hue-color-coded disparity
-                cv::cuda::GpuMat gpu_disp(disparity);
+                // Formats with offset are not supported by the CUDA
+                // implementation, so convert those to float first
+                cv::Mat tmpDisparity = disparity;
+                double scale = format.scale;
+                if (format.offset != 0.0) {
+                    Utils::convertDisparityToFloat(disparity, format, tmpDisparity);
+                    scale = 1.0;
+                }
+
+                cv::cuda::GpuMat gpu_disp(tmpDisparity);
                 cv::cuda::GpuMat gpu_disp_color;
-                cv::Mat disp_color;
 
-                cv::cuda::drawColorDisp(gpu_disp, gpu_disp_color, disparityLevels);
+                cv::cuda::drawColorDisp(gpu_disp, gpu_disp_color, cvRound(disparityLevels/scale));
                 gpu_disp_color.download(visualization);
             } catch (...) {
                 // The above calls can fail
@@ -135,7 +180,14 @@ void DisparityVisualization::visualizeDisparity (const cv::Mat &disparity, int d
         }
 #endif
         case MethodColorCpu :{
-            Utils::createColorCodedDisparityCpu(disparity, visualization, disparityLevels);
+            // Rebuild color table if necessary
+            if (d->colorTable.empty() || d->colorTableLevels != disparityLevels || d->colorTableColormap != d->colormap) {
+                Utils::createDisparityColorTable(disparityLevels, d->colormap, d->colorTable, d->colorTableSteps);
+                d->colorTableLevels = disparityLevels;
+                d->colorTableColormap = d->colormap;
+            }
+
+            Utils::applyDisparityColorTable(disparity, format, d->colorTable, d->colorTableSteps, visualization);
             break;
         }
         default: {
@@ -21,6 +21,7 @@
 #define MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_VISUALIZATION_H
 
 #include <stereo-pipeline/export.h>
+#include <stereo-pipeline/disparity_format.h>
 
 #include <QtCore>
 #include <opencv2/core.hpp>
@@ -50,14 +51,31 @@ public:
         MethodColorCpu,
     };
 
+    // Color maps for CPU color visualization; ColormapHue is the
+    // HSV hue ramp (blue to red) used by the CUDA method, while the
+    // rest correspond to OpenCV's color maps
+    enum {
+        ColormapHue,
+        ColormapJet,
+        ColormapHot,
+        ColormapRainbow,
+        ColormapParula,
+    };
+
     void setVisualizationMethod (int method);
     int getVisualizationMethod () const;
     const QList<int> &getSupportedVisualizationMethods () const;
 
-    void visualizeDisparity (const cv::Mat &disparity, int disparityLevels, cv::Mat &visualization) const;
+    void setColormap (int colormap);
+    int getColormap () const;
+
+    // Disparity format allows direct visualization of fixed-point
+    // disparities (e.g., raw CV_16S output of OpenCV block matching)
+    void visualizeDisparity (const cv::Mat &disparity, int disparityLevels, cv::Mat &visualization, const DisparityFormat &format = DisparityFormat()) const;
 
 signals:
     void visualizationMethodChanged (int method);
+    void colormapChanged (int colormap);
 
     void error (const QString &message);
 };
@@ -17,8 +17,8 @@
  *
  */
 
-#ifndef MVL_STEREO_TOOLBOX__PIPELINE__REPROJECTION_P_H
-#define MVL_STEREO_TOOLBOX__PIPELINE__REPROJECTION_P_H
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_VISUALIZATION_P_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__DISPARITY_VISUALIZATION_P_H
 
 
 namespace MVL {
@@ -38,6 +38,15 @@ class DisparityVisualizationPrivate
 protected:
     QList<int> supportedMethods;
     int method;
+
+    int colormap;
+
+    // Cached color look-up table for CPU color visualization; rebuilt
+    // only when number of disparity levels or color map changes
+    mutable cv::Mat colorTable;
+    mutable int colorTableLevels;
+    mutable int colorTableColormap;
+    mutable int colorTableSteps;
 };
 
 
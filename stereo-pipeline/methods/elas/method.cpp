@@ -95,6 +95,54 @@ void Method::usePreset (int preset)
 // *                    Disparity image computation                    *
 // *********************************************************************
 void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    DisparityFormat format;
+    computeDisparity(img1, img2, disparity, numDisparities, format);
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    // ELAS is single-threaded, but independent instances can process
+    // image bands in parallel. The right disparity is a by-product only
+    // when the left one is the regular output
+    int capabilities = CapabilityRegionOfInterest | CapabilityBandParallel;
+    if (returnLeft) {
+        capabilities |= CapabilityRightDisparity;
+    }
+    return capabilities;
+}
+
+int Method::getPreferredInputType () const
+{
+    return CV_8UC1;
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    Q_UNUSED(imageType);
+
+    // ELAS allocates its buffers internally on each call; only the
+    // output buffer for the discarded image can be preallocated
+    cv::Size outputSize = param.subsampling ? cv::Size(imageSize.width/2, imageSize.height/2) : imageSize;
+    tmpDisp1.create(outputSize, CV_32FC1);
+    tmpDisp2.create(outputSize, CV_32FC1);
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    // The returned image is computed directly into caller's buffer
+    if (returnLeft) {
+        computeDisparityPair(img1, img2, disparity, tmpDisp2, numDisparities, format);
+    } else {
+        computeDisparityPair(img1, img2, tmpDisp1, disparity, numDisparities, format);
+    }
+}
+
+void Method::computeDisparityPair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparityLeft, cv::Mat &disparityRight, int &numDisparities, DisparityFormat &format)
 {
     // Convert to grayscale
     if (img1.channels() == 3) {
@@ -110,31 +158,37 @@ void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat
     }
 
 
-    // Allocate output
-    int32_t dims[3] = { tmpImg1.cols, tmpImg2.rows, tmpImg1.step };
+    // Allocate output (ELAS computes both images, in float format)
+    int32_t dims[3] = { tmpImg1.cols, tmpImg2.rows, (int32_t)tmpImg1.step };
 
     if (param.subsampling) {
-        tmpDisp1 = cv::Mat(tmpImg1.rows/2, tmpImg1.cols/2, CV_32FC1);
-        tmpDisp2 = cv::Mat(tmpImg2.rows/2, tmpImg2.cols/2, CV_32FC1);
+        disparityLeft.create(tmpImg1.rows/2, tmpImg1.cols/2, CV_32FC1);
+        disparityRight.create(tmpImg2.rows/2, tmpImg2.cols/2, CV_32FC1);
     } else {
-        tmpDisp1 = cv::Mat(tmpImg1.rows, tmpImg1.cols, CV_32FC1);
-        tmpDisp2 = cv::Mat(tmpImg2.rows, tmpImg2.cols, CV_32FC1);
+        disparityLeft.create(tmpImg1.rows, tmpImg1.cols, CV_32FC1);
+        disparityRight.create(tmpImg2.rows, tmpImg2.cols, CV_32FC1);
     }
 
     // Process
     QMutexLocker locker(&mutex);
-    elas.process(tmpImg1.ptr<uint8_t>(), tmpImg2.ptr<uint8_t>(), tmpDisp1.ptr<float>(), tmpDisp2.ptr<float>(), dims);
+    elas.process(tmpImg1.ptr<uint8_t>(), tmpImg2.ptr<uint8_t>(), disparityLeft.ptr<float>(), disparityRight.ptr<float>(), dims);
     locker.unlock();
 
-    // Copy corresponding output (already in float format)
-    if (returnLeft) {
-        tmpDisp1.copyTo(disparity);
-    } else {
-        tmpDisp2.copyTo(disparity);
-    }
-
     // Number of disparities
     numDisparities = getMaxDisparity() - getMinDisparity();
+    format = DisparityFormat();
+}
+
+QObject *Method::createInstance () const
+{
+    Method *instance = new Method();
+
+    QMutexLocker locker(&mutex);
+    instance->param = param;
+    instance->returnLeft = returnLeft;
+    instance->elas = Elas(param);
+
+    return instance;
 }
 
 // *********************************************************************
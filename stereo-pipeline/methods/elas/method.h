@@ -31,10 +31,10 @@ namespace Pipeline {
 namespace StereoMethodELAS {
 
 
-class Method : public QObject, public StereoMethod
+class Method : public QObject, public StereoMethod2
 {
     Q_OBJECT
-    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod)
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod MVL::StereoToolbox::Pipeline::StereoMethod2)
 
 public:
     Method (QObject *parent = nullptr);
@@ -46,6 +46,12 @@ public:
     virtual void loadParameters (const QString &filename) override;
     virtual void saveParameters (const QString &filename) const override;
 
+    virtual int getCapabilities () const override;
+    virtual int getPreferredInputType () const override;
+    virtual void prepare (const cv::Size &imageSize, int imageType) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) override;
+    virtual void computeDisparityPair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparityLeft, cv::Mat &disparityRight, int &numDisparities, DisparityFormat &format) override;
+    virtual QObject *createInstance () const override;
 
     // Parameters
     enum PresetType {
@@ -71,7 +77,7 @@ public:
     void setCandidateStepSize (int value);
     int getCandidateStepSize () const;
 
-    void setInconsistentWindowSize (in valuet);
+    void setInconsistentWindowSize (int value);
     int getInconsistentWindowSize () const;
 
     void setInconsistentThreshold (int value);
@@ -159,7 +165,7 @@ protected:
 
     bool returnLeft;
 
-    QMutex mutex;
+    mutable QMutex mutex;
 
     cv::Mat tmpImg1, tmpImg2, tmpDisp1, tmpDisp2;
 };
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodELAS {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodELASPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.ELAS")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.ELAS" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
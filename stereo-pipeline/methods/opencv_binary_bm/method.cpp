@@ -21,6 +21,7 @@
 #include "method_widget.h"
 
 #include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/utils.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -74,6 +75,9 @@ void Method::resetParameters ()
     // So, always make sure that scaling is disabled!
     bm->setScalleFactor(1);
 
+    speckleWindowSize = bm->getSpeckleWindowSize();
+    speckleRange = bm->getSpeckleRange();
+
     locker.unlock();
 
     emit parameterChanged();
@@ -103,24 +107,39 @@ void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat
     tmpDisparity.create(img1.rows, img1.cols, CV_8UC1);
 
     QMutexLocker locker(&mutex);
+
+    // Basic speckle removal is performed by the pipeline's parallel
+    // speckle filter, the averaging variant by the matcher itself
+    const bool delegateSpeckles = bm->getSpekleRemovalTechnique() != cv::stereo::CV_SPECKLE_REMOVAL_AVG_ALGORITHM;
+    bm->setSpeckleWindowSize(delegateSpeckles ? 0 : speckleWindowSize);
+    bm->setSpeckleRange(delegateSpeckles ? 0 : speckleRange);
+
     bm->compute(tmpImg1, tmpImg2, tmpDisparity);
+
+    const int minDisparity = bm->getMinDisparity();
+    const int windowSize = speckleWindowSize;
+    const int range = speckleRange;
+
     locker.unlock();
 
-    // Normalize to output float format
-    switch (tmpDisparity.type()) {
-        case CV_16SC1: {
-            tmpDisparity.convertTo(disparity, CV_32F, 1/16.0);
-            break;
-        }
-        default: {
-            tmpDisparity.convertTo(disparity, CV_32F);
-        }
+    if (delegateSpeckles && windowSize > 0 && range >= 0) {
+        Utils::filterSpeckles(tmpDisparity, minDisparity - 1, windowSize, range);
     }
 
+    // Output disparity in its native format; CV_16S disparity has
+    // four fractional bits
+    disparity = tmpDisparity;
+    disparityFormat = (tmpDisparity.type() == CV_16SC1) ? DisparityFormat(1/16.0) : DisparityFormat();
+
     // Number of disparities
     numDisparities = getNumDisparities();
 }
 
+DisparityFormat Method::getDisparityFormat () const
+{
+    return disparityFormat;
+}
+
 
 // *********************************************************************
 // *                     Parameter import/export                       *
@@ -151,8 +170,8 @@ void Method::loadParameters (const QString &filename)
     bm->setMinDisparity((int)storage["minDisparity"]);
     bm->setNumDisparities((int)storage["numDisparities"]);
     bm->setBlockSize((int)storage["blockSize"]);
-    bm->setSpeckleWindowSize((int)storage["speckleWindowSize"]);
-    bm->setSpeckleRange((int)storage["speckleRange"]);
+    speckleWindowSize = (int)storage["speckleWindowSize"];
+    speckleRange = (int)storage["speckleRange"];
     bm->setDisp12MaxDiff((int)storage["disp12MaxDiff"]);
 
     bm->setPreFilterType((int)storage["preFilterType"]);
@@ -188,8 +207,8 @@ void Method::saveParameters (const QString &filename) const
     storage << "minDisparity" << bm->getMinDisparity();
     storage << "numDisparities" << bm->getNumDisparities();
     storage << "blockSize" << bm->getBlockSize();
-    storage << "speckleWindowSize" << bm->getSpeckleWindowSize();
-    storage << "speckleRange" << bm->getSpeckleRange();
+    storage << "speckleWindowSize" << speckleWindowSize;
+    storage << "speckleRange" << speckleRange;
     storage << "disp12MaxDiff" << bm->getDisp12MaxDiff();
 
     storage << "preFilterType" << bm->getPreFilterType();
@@ -247,26 +266,34 @@ void Method::setBlockSize (int value)
 // Speckle window size
 int Method::getSpeckleWindowSize () const
 {
-    return bm->getSpeckleWindowSize();
+    return speckleWindowSize;
 }
 
 
 void Method::setSpeckleWindowSize (int value)
 {
-    setParameter(&cv::stereo::StereoBinaryBM::setSpeckleWindowSize, value);
+    QMutexLocker locker(&mutex);
+    speckleWindowSize = value;
+    locker.unlock();
+
+    emit parameterChanged();
 }
 
 
 // Speckle range
 int Method::getSpeckleRange () const
 {
-    return bm->getSpeckleRange();
+    return speckleRange;
 }
 
 
 void Method::setSpeckleRange (int value)
 {
-    setParameter(&cv::stereo::StereoBinaryBM::setSpeckleRange, value);
+    QMutexLocker locker(&mutex);
+    speckleRange = value;
+    locker.unlock();
+
+    emit parameterChanged();
 }
 
 
@@ -43,6 +43,7 @@ public:
     virtual QString getShortName () const override;
     virtual QWidget *createConfigWidget (QWidget *parent = nullptr) override;
     virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) override;
+    virtual DisparityFormat getDisparityFormat () const override;
     virtual void loadParameters (const QString &filename) override;
     virtual void saveParameters (const QString &filename) const override;
 
@@ -121,8 +122,15 @@ protected:
     cv::Ptr<cv::stereo::StereoBinaryBM> bm;
     QMutex mutex;
 
+    // Speckle filter parameters; basic speckle removal is delegated to
+    // the pipeline's parallel speckle filter, so these are passed to
+    // the matcher only for its averaging variant
+    int speckleWindowSize;
+    int speckleRange;
+
     cv::Mat tmpImg1, tmpImg2;
     cv::Mat tmpDisparity;
+    DisparityFormat disparityFormat;
 };
 
 
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvBinaryBm {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodOpenCvBinaryBmPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_Binary_BM")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_Binary_BM" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
@@ -21,6 +21,7 @@
 #include "method_widget.h"
 
 #include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/utils.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -32,10 +33,16 @@ namespace StereoMethodOpenCvBm {
 
 
 Method::Method (QObject *parent)
-    : QObject(parent), StereoMethod(),
+    : QObject(parent), StereoMethod2(),
       bm(cv::StereoBM::create()),
+      speckleWindowSize(0),
+      speckleRange(0),
+      rawOutput(false),
       imageWidth(640)
 {
+    bm->setSpeckleWindowSize(0);
+    bm->setSpeckleRange(0);
+
     usePreset(OpenCV);
 }
 
@@ -77,8 +84,8 @@ void Method::usePreset (int preset)
             bm->setNumDisparities(64);
             bm->setTextureThreshold(10);
             bm->setUniquenessRatio(15);
-            bm->setSpeckleWindowSize(0);
-            bm->setSpeckleRange(0);
+            speckleWindowSize = 0;
+            speckleRange = 0;
             bm->setDisp12MaxDiff(-1);
 
             break;
@@ -93,8 +100,8 @@ void Method::usePreset (int preset)
             bm->setNumDisparities(((imageWidth/8) + 15) & -16);
             bm->setTextureThreshold(10);
             bm->setUniquenessRatio(15);
-            bm->setSpeckleWindowSize(100);
-            bm->setSpeckleRange(32);
+            speckleWindowSize = 100;
+            speckleRange = 32;
             bm->setDisp12MaxDiff(1);
 
             break;
@@ -110,6 +117,13 @@ void Method::usePreset (int preset)
 // *                    Disparity image computation                    *
 // *********************************************************************
 void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    // Basic interface; disparity refers to our internal buffer
+    computeDisparity(img1, img2, tmpDisparity, numDisparities, disparityFormat);
+    disparity = tmpDisparity;
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
 {
     // Convert to grayscale
     if (img1.channels() == 3) {
@@ -127,28 +141,146 @@ void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat
     // Store in case user wants to compute optimal parameters
     imageWidth = img1.cols;
 
-    // Compute disparity image
-    tmpDisparity.create(img1.rows, img1.cols, CV_16SC1);
+    // Compute disparity image, directly into output buffer
+    disparity.create(img1.rows, img1.cols, CV_16SC1);
 
     QMutexLocker locker(&mutex);
-    bm->compute(tmpImg1, tmpImg2, tmpDisparity);
+    bm->compute(tmpImg1, tmpImg2, disparity);
+    const int minDisparity = bm->getMinDisparity();
+    const int windowSize = rawOutput ? 0 : speckleWindowSize;
+    const int range = speckleRange;
     locker.unlock();
 
-    // Normalize to output float format
-    switch (tmpDisparity.type()) {
-        case CV_16SC1: {
-            tmpDisparity.convertTo(disparity, CV_32F, 1/16.0);
-            break;
-        }
-        default: {
-            tmpDisparity.convertTo(disparity, CV_32F);
-        }
-    }
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+
+    // Output disparity in its native format; CV_16S disparity has
+    // four fractional bits
+    format = (disparity.type() == CV_16SC1) ? DisparityFormat(1/16.0) : DisparityFormat();
+    disparityFormat = format;
 
     // Number of disparities
     numDisparities = getNumDisparities();
 }
 
+DisparityFormat Method::getDisparityFormat () const
+{
+    return disparityFormat;
+}
+
+void Method::filterSpeckles (cv::Mat &disparity, int minDisparity, int windowSize, int range) const
+{
+    if (windowSize <= 0 || range < 0) {
+        return;
+    }
+
+    // Same invalid value and (fixed-point) range as block matcher's
+    // own speckle filter
+    Utils::filterSpeckles(disparity, (minDisparity - 1) * 16, windowSize, range);
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    return CapabilityRegionOfInterest | CapabilityPreallocation | CapabilityDisparityRange | CapabilityPostProcessing;
+}
+
+int Method::getPreferredInputType () const
+{
+    return CV_8UC1;
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    Q_UNUSED(imageType);
+
+    // Block matcher allocates its internal buffers on first use, so
+    // run it once on blank images of given size
+    tmpImg1 = cv::Mat::zeros(imageSize, CV_8UC1);
+    tmpImg2 = cv::Mat::zeros(imageSize, CV_8UC1);
+    tmpDisparity.create(imageSize, CV_16SC1);
+
+    QMutexLocker locker(&mutex);
+    bm->compute(tmpImg1, tmpImg2, tmpDisparity);
+    locker.unlock();
+
+    imageWidth = imageSize.width;
+}
+
+void Method::computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format)
+{
+    // Convert to grayscale
+    if (img1.channels() == 3) {
+        cv::cvtColor(img1, tmpImg1, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg1 = img1;
+    }
+
+    if (img2.channels() == 3) {
+        cv::cvtColor(img2, tmpImg2, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg2 = img2;
+    }
+
+    disparity.create(img1.rows, img1.cols, CV_16SC1);
+
+    // Temporarily override the search range; configured range is
+    // restored before the lock is released, even if matching fails
+    QMutexLocker locker(&mutex);
+
+    const int configuredMinDisparity = bm->getMinDisparity();
+    const int configuredNumDisparities = bm->getNumDisparities();
+
+    bm->setMinDisparity(minDisparity);
+    bm->setNumDisparities(numDisparities);
+    try {
+        bm->compute(tmpImg1, tmpImg2, disparity);
+    } catch (...) {
+        bm->setMinDisparity(configuredMinDisparity);
+        bm->setNumDisparities(configuredNumDisparities);
+        throw;
+    }
+    bm->setMinDisparity(configuredMinDisparity);
+    bm->setNumDisparities(configuredNumDisparities);
+
+    const int windowSize = rawOutput ? 0 : speckleWindowSize;
+    const int range = speckleRange;
+
+    locker.unlock();
+
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+
+    format = (disparity.type() == CV_16SC1) ? DisparityFormat(1/16.0) : DisparityFormat();
+}
+
+void Method::getDisparityRange (int &minDisparity, int &numDisparities) const
+{
+    minDisparity = bm->getMinDisparity();
+    numDisparities = bm->getNumDisparities();
+}
+
+void Method::setRawOutput (bool enable)
+{
+    QMutexLocker locker(&mutex);
+    rawOutput = enable;
+}
+
+void Method::postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity)
+{
+    Q_UNUSED(format);
+
+    QMutexLocker locker(&mutex);
+    const int minDisparity = bm->getMinDisparity();
+    const int windowSize = speckleWindowSize;
+    const int range = speckleRange;
+    locker.unlock();
+
+    rawDisparity.copyTo(disparity);
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+}
+
 
 // *********************************************************************
 // *                     Parameter import/export                       *
@@ -186,8 +318,8 @@ void Method::loadParameters (const QString &filename)
 
     bm->setTextureThreshold((int)storage["TextureThreshold"]);
     bm->setUniquenessRatio((int)storage["UniquenessRatio"]);
-    bm->setSpeckleWindowSize((int)storage["SpeckleWindowSize"]);
-    bm->setSpeckleRange((int)storage["SpeckleRange"]);
+    speckleWindowSize = (int)storage["SpeckleWindowSize"];
+    speckleRange = (int)storage["SpeckleRange"];
 
     bm->setDisp12MaxDiff((int)storage["Disp12MaxDiff"]);
 
@@ -220,8 +352,8 @@ void Method::saveParameters (const QString &filename) const
 
     storage << "TextureThreshold" << bm->getTextureThreshold();
     storage << "UniquenessRatio" << bm->getUniquenessRatio();
-    storage << "SpeckleWindowSize" << bm->getSpeckleWindowSize();
-    storage << "SpeckleRange" << bm->getSpeckleRange();
+    storage << "SpeckleWindowSize" << speckleWindowSize;
+    storage << "SpeckleRange" << speckleRange;
 
     storage << "Disp12MaxDiff" << bm->getDisp12MaxDiff();
 }
@@ -385,33 +517,43 @@ void Method::setUniquenessRatio (int value)
 // Disparity variantion window
 int Method::getSpeckleWindowSize () const
 {
-    return bm->getSpeckleWindowSize();
+    return speckleWindowSize;
 }
 
 void Method::setSpeckleWindowSize (int value)
 {
     // Set
     QMutexLocker locker(&mutex);
-    bm->setSpeckleWindowSize(value);
+    speckleWindowSize = value;
+    const bool postProcessingOnly = rawOutput;
     locker.unlock();
 
-    emit parameterChanged();
+    if (postProcessingOnly) {
+        emit postProcessingParameterChanged();
+    } else {
+        emit parameterChanged();
+    }
 }
 
 // Acceptable range of variation in window
 int Method::getSpeckleRange () const
 {
-    return bm->getSpeckleRange();
+    return speckleRange;
 }
 
 void Method::setSpeckleRange (int value)
 {
     // Set
     QMutexLocker locker(&mutex);
-    bm->setSpeckleRange(value);
+    speckleRange = value;
+    const bool postProcessingOnly = rawOutput;
     locker.unlock();
 
-    emit parameterChanged();
+    if (postProcessingOnly) {
+        emit postProcessingParameterChanged();
+    } else {
+        emit parameterChanged();
+    }
 }
 
 // Disp12MaxDiff
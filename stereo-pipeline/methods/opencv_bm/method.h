@@ -31,10 +31,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvBm {
 
 
-class Method : public QObject, public StereoMethod
+class Method : public QObject, public StereoMethod2
 {
     Q_OBJECT
-    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod)
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod MVL::StereoToolbox::Pipeline::StereoMethod2)
 
 public:
     Method (QObject *parent = nullptr);
@@ -43,9 +43,19 @@ public:
     virtual QString getShortName () const override;
     virtual QWidget *createConfigWidget (QWidget *parent = nullptr) override;
     virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) override;
+    virtual DisparityFormat getDisparityFormat () const override;
     virtual void loadParameters (const QString &filename) override;
     virtual void saveParameters (const QString &filename) const override;
 
+    virtual int getCapabilities () const override;
+    virtual int getPreferredInputType () const override;
+    virtual void prepare (const cv::Size &imageSize, int imageType) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) override;
+    virtual void computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format) override;
+    virtual void getDisparityRange (int &minDisparity, int &numDisparities) const override;
+    virtual void setRawOutput (bool enable) override;
+    virtual void postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity) override;
+
     // Parameters
     enum PresetType {
         OpenCV,
@@ -94,15 +104,30 @@ signals:
     // Signals from interface
     void parameterChanged () override;
 
+    // Speckle filter parameters changed while raw output is enabled
+    void postProcessingParameterChanged ();
+
 protected:
+    void filterSpeckles (cv::Mat &disparity, int minDisparity, int windowSize, int range) const;
+
     // Block matcher
     cv::Ptr<cv::StereoBM> bm;
     QMutex mutex;
 
+    // Speckle filter parameters; filtering is delegated to the
+    // pipeline's parallel speckle filter, and block matcher's own
+    // speckle filter remains disabled
+    int speckleWindowSize;
+    int speckleRange;
+
+    // Speckle filtering is left to postProcessDisparity()
+    bool rawOutput;
+
     int imageWidth;
 
     cv::Mat tmpImg1, tmpImg2;
     cv::Mat tmpDisparity;
+    DisparityFormat disparityFormat;
 };
 
 
@@ -32,6 +32,7 @@ MethodWidget::MethodWidget (Method *method, QWidget *parent)
       method(method)
 {
     connect(method, &Method::parameterChanged, this, &MethodWidget::updateParameters, Qt::QueuedConnection);
+    connect(method, &Method::postProcessingParameterChanged, this, &MethodWidget::updateParameters, Qt::QueuedConnection);
 
     // Build layout
     QVBoxLayout *baseLayout = new QVBoxLayout(this);
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvBm {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodOpenCvBmPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_BM")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_BM" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
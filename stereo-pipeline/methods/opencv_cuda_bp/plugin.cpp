@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvCudaBp {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodOpenCvCudaBpPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_CUDA_BP")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_CUDA_BP" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
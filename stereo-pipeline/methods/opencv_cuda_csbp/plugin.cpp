@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvCudaCsbp {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodOpenCvCudaCsbpPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_CUDA_CSBP")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_CUDA_CSBP" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
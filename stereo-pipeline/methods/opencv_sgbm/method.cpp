@@ -21,6 +21,7 @@
 #include "method_widget.h"
 
 #include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/utils.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -32,10 +33,16 @@ namespace StereoMethodOpenCvSgbm {
 
 
 Method::Method (QObject *parent)
-    : QObject(parent), StereoMethod(),
+    : QObject(parent), StereoMethod2(),
       sgbm(cv::StereoSGBM::create(0, 16, 3)),
+      speckleWindowSize(0),
+      speckleRange(0),
+      rawOutput(false),
       imageWidth(640), imageChannels(1)
 {
+    sgbm->setSpeckleWindowSize(0);
+    sgbm->setSpeckleRange(0);
+
     usePreset(OpenCV);
 }
 
@@ -77,8 +84,8 @@ void Method::usePreset (int type)
             sgbm->setMinDisparity(0);
             sgbm->setNumDisparities(64);
             sgbm->setUniquenessRatio(0);
-            sgbm->setSpeckleWindowSize(0);
-            sgbm->setSpeckleRange(0);
+            speckleWindowSize = 0;
+            speckleRange = 0;
             sgbm->setDisp12MaxDiff(-1);
             sgbm->setMode(cv::StereoSGBM::MODE_SGBM);
 
@@ -94,8 +101,8 @@ void Method::usePreset (int type)
             sgbm->setMinDisparity(0);
             sgbm->setNumDisparities(((imageWidth/8) + 15) & -16);
             sgbm->setUniquenessRatio(10);
-            sgbm->setSpeckleWindowSize(100);
-            sgbm->setSpeckleRange(32);
+            speckleWindowSize = 100;
+            speckleRange = 32;
             sgbm->setDisp12MaxDiff(1);
             sgbm->setMode(cv::StereoSGBM::MODE_SGBM);
 
@@ -112,33 +119,143 @@ void Method::usePreset (int type)
 // *                    Disparity image computation                    *
 // *********************************************************************
 void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    // Basic interface; disparity refers to our internal buffer
+    computeDisparity(img1, img2, tmpDisparity, numDisparities, disparityFormat);
+    disparity = tmpDisparity;
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
 {
     // Store in case user wants to compute optimal parameters
     imageWidth = img1.cols;
     imageChannels = img1.channels();
 
-    // Compute disparity image
-    tmpDisparity.create(img1.rows, img1.cols, CV_16SC1);
+    // Compute disparity image, directly into output buffer
+    disparity.create(img1.rows, img1.cols, CV_16SC1);
 
     QMutexLocker locker(&mutex);
-    sgbm->compute(img1, img2, tmpDisparity);
+    sgbm->compute(img1, img2, disparity);
+    const int minDisparity = sgbm->getMinDisparity();
+    const int windowSize = rawOutput ? 0 : speckleWindowSize;
+    const int range = speckleRange;
     locker.unlock();
 
-    // Normalize to output float format
-    switch (tmpDisparity.type()) {
-        case CV_16SC1: {
-            tmpDisparity.convertTo(disparity, CV_32F, 1/16.0);
-            break;
-        }
-        default: {
-            tmpDisparity.convertTo(disparity, CV_32F);
-        }
-    }
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+
+    // Output disparity in its native format; CV_16S disparity has
+    // four fractional bits
+    format = (disparity.type() == CV_16SC1) ? DisparityFormat(1/16.0) : DisparityFormat();
+    disparityFormat = format;
 
     // Number of disparities
     numDisparities = getNumDisparities();
 }
 
+DisparityFormat Method::getDisparityFormat () const
+{
+    return disparityFormat;
+}
+
+void Method::filterSpeckles (cv::Mat &disparity, int minDisparity, int windowSize, int range) const
+{
+    if (windowSize <= 0 || range < 0) {
+        return;
+    }
+
+    // Same invalid value as semi-global matcher's own speckle filter;
+    // range is given in pixels, and disparity has four fractional bits
+    Utils::filterSpeckles(disparity, (minDisparity - 1) * 16, windowSize, range * 16);
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    return CapabilityRegionOfInterest | CapabilityPreallocation | CapabilityDisparityRange | CapabilityPostProcessing;
+}
+
+int Method::getPreferredInputType () const
+{
+    return -1; // Handles both grayscale and color images
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    // Semi-global matcher allocates its internal buffers on first use,
+    // so run it once on blank images of given size and type
+    cv::Mat blank = cv::Mat::zeros(imageSize, imageType);
+    tmpDisparity.create(imageSize, CV_16SC1);
+
+    QMutexLocker locker(&mutex);
+    sgbm->compute(blank, blank, tmpDisparity);
+    locker.unlock();
+
+    imageWidth = imageSize.width;
+    imageChannels = CV_MAT_CN(imageType);
+}
+
+void Method::computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format)
+{
+    disparity.create(img1.rows, img1.cols, CV_16SC1);
+
+    // Temporarily override the search range; configured range is
+    // restored before the lock is released, even if matching fails
+    QMutexLocker locker(&mutex);
+
+    const int configuredMinDisparity = sgbm->getMinDisparity();
+    const int configuredNumDisparities = sgbm->getNumDisparities();
+
+    sgbm->setMinDisparity(minDisparity);
+    sgbm->setNumDisparities(numDisparities);
+    try {
+        sgbm->compute(img1, img2, disparity);
+    } catch (...) {
+        sgbm->setMinDisparity(configuredMinDisparity);
+        sgbm->setNumDisparities(configuredNumDisparities);
+        throw;
+    }
+    sgbm->setMinDisparity(configuredMinDisparity);
+    sgbm->setNumDisparities(configuredNumDisparities);
+
+    const int windowSize = rawOutput ? 0 : speckleWindowSize;
+    const int range = speckleRange;
+
+    locker.unlock();
+
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+
+    format = (disparity.type() == CV_16SC1) ? DisparityFormat(1/16.0) : DisparityFormat();
+}
+
+void Method::getDisparityRange (int &minDisparity, int &numDisparities) const
+{
+    minDisparity = sgbm->getMinDisparity();
+    numDisparities = sgbm->getNumDisparities();
+}
+
+void Method::setRawOutput (bool enable)
+{
+    QMutexLocker locker(&mutex);
+    rawOutput = enable;
+}
+
+void Method::postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity)
+{
+    Q_UNUSED(format);
+
+    QMutexLocker locker(&mutex);
+    const int minDisparity = sgbm->getMinDisparity();
+    const int windowSize = speckleWindowSize;
+    const int range = speckleRange;
+    locker.unlock();
+
+    rawDisparity.copyTo(disparity);
+    filterSpeckles(disparity, minDisparity, windowSize, range);
+}
+
 
 // *********************************************************************
 // *                     Parameter import/export                       *
@@ -176,8 +293,8 @@ void Method::loadParameters (const QString &filename)
     sgbm->setP1((int)storage["P1"]);
     sgbm->setP2((int)storage["P2"]);
 
-    sgbm->setSpeckleWindowSize((int)storage["SpeckleWindowSize"]);
-    sgbm->setSpeckleRange((int)storage["SpeckleRange"]);
+    speckleWindowSize = (int)storage["SpeckleWindowSize"];
+    speckleRange = (int)storage["SpeckleRange"];
 
     sgbm->setDisp12MaxDiff((int)storage["Disp12MaxDiff"]);
 
@@ -210,8 +327,8 @@ void Method::saveParameters (const QString &filename) const
     storage << "P1" << sgbm->getP1();
     storage << "P2" << sgbm->getP2();
 
-    storage << "SpeckleWindowSize" << sgbm->getSpeckleWindowSize();
-    storage << "SpeckleRange" << sgbm->getSpeckleRange();
+    storage << "SpeckleWindowSize" << speckleWindowSize;
+    storage << "SpeckleRange" << speckleRange;
 
     storage << "Disp12MaxDiff" << sgbm->getDisp12MaxDiff();
 
@@ -344,33 +461,43 @@ void Method::setP2 (int value)
 // Disparity variantion window
 int Method::getSpeckleWindowSize () const
 {
-    return sgbm->getSpeckleWindowSize();
+    return speckleWindowSize;
 }
 
 void Method::setSpeckleWindowSize (int value)
 {
     // Set
     QMutexLocker locker(&mutex);
-    sgbm->setSpeckleWindowSize(value);
+    speckleWindowSize = value;
+    const bool postProcessingOnly = rawOutput;
     locker.unlock();
 
-    emit parameterChanged();
+    if (postProcessingOnly) {
+        emit postProcessingParameterChanged();
+    } else {
+        emit parameterChanged();
+    }
 }
 
 // Acceptable range of variation in window
 int Method::getSpeckleRange () const
 {
-    return sgbm->getSpeckleRange();
+    return speckleRange;
 }
 
 void Method::setSpeckleRange (int value)
 {
     // Set
     QMutexLocker locker(&mutex);
-    sgbm->setSpeckleRange(value);
+    speckleRange = value;
+    const bool postProcessingOnly = rawOutput;
     locker.unlock();
 
-    emit parameterChanged();
+    if (postProcessingOnly) {
+        emit postProcessingParameterChanged();
+    } else {
+        emit parameterChanged();
+    }
 }
 
 // Disp12MaxDiff
@@ -32,10 +32,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvSgbm {
 
 
-class Method : public QObject, public StereoMethod
+class Method : public QObject, public StereoMethod2
 {
     Q_OBJECT
-    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod)
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod MVL::StereoToolbox::Pipeline::StereoMethod2)
 
 public:
     Method (QObject *parent = nullptr);
@@ -44,9 +44,19 @@ public:
     virtual QString getShortName () const override;
     virtual QWidget *createConfigWidget (QWidget *parent = nullptr) override;
     virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) override;
+    virtual DisparityFormat getDisparityFormat () const override;
     virtual void loadParameters (const QString &filename) override;
     virtual void saveParameters (const QString &filename) const override;
 
+    virtual int getCapabilities () const override;
+    virtual int getPreferredInputType () const override;
+    virtual void prepare (const cv::Size &imageSize, int imageType) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) override;
+    virtual void computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format) override;
+    virtual void getDisparityRange (int &minDisparity, int &numDisparities) const override;
+    virtual void setRawOutput (bool enable) override;
+    virtual void postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity) override;
+
     // Parameters
     enum PresetType {
         OpenCV,
@@ -97,15 +107,30 @@ signals:
     // Signals from interface
     void parameterChanged () override;
 
+    // Speckle filter parameters changed while raw output is enabled
+    void postProcessingParameterChanged ();
+
 protected:
+    void filterSpeckles (cv::Mat &disparity, int minDisparity, int windowSize, int range) const;
+
     // Method implementation
     cv::Ptr<cv::StereoSGBM> sgbm;
     QMutex mutex;
 
+    // Speckle filter parameters; filtering is delegated to the
+    // pipeline's parallel speckle filter, and matcher's own speckle
+    // filter remains disabled
+    int speckleWindowSize;
+    int speckleRange;
+
+    // Speckle filtering is left to postProcessDisparity()
+    bool rawOutput;
+
     int imageWidth;
     int imageChannels;
 
     cv::Mat tmpDisparity;
+    DisparityFormat disparityFormat;
 };
 
 
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace StereoMethodOpenCvSgbm {
 
 
-class Plugin : public QObject, PluginFactory
+class StereoMethodOpenCvSgbmPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_SGBM")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.StereoMethod.OpenCV_SGBM" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
@@ -0,0 +1,506 @@
+/*
+ * Toolbox Census Block Matching: matching engine
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "census_matcher.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCensusBm {
+
+
+// Block sums are accumulated in 16-bit integers; the largest block,
+// combined with the largest census window (62 bits), still fits
+static const int MaxBlockSize = 31;
+
+
+// *********************************************************************
+// *                         Census transform                          *
+// *********************************************************************
+// Census transform with compile-time window size; operates on border-
+// replicated image, so no boundary checks are needed in the inner loop
+template <int HalfWidth, int HalfHeight>
+class CensusBody : public cv::ParallelLoopBody
+{
+public:
+    CensusBody (const cv::Mat &padded, int width, quint64 *census)
+        : padded(padded),
+          width(width),
+          census(census)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        for (int y = range.start; y < range.end; y++) {
+            const uchar *rows[2*HalfHeight + 1];
+            for (int i = 0; i < 2*HalfHeight + 1; i++) {
+                rows[i] = padded.ptr<uchar>(y + i) + HalfWidth;
+            }
+
+            quint64 *censusRow = census + y*width;
+
+            for (int x = 0; x < width; x++) {
+                const uchar center = rows[HalfHeight][x];
+                quint64 descriptor = 0;
+
+                for (int i = 0; i < 2*HalfHeight + 1; i++) {
+                    for (int j = -HalfWidth; j <= HalfWidth; j++) {
+                        if (i == HalfHeight && j == 0) {
+                            continue; // Skip center
+                        }
+                        descriptor = (descriptor << 1) | (rows[i][x + j] < center);
+                    }
+                }
+
+                censusRow[x] = descriptor;
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &padded;
+    int width;
+    quint64 *census;
+};
+
+
+// *********************************************************************
+// *                             Matching                              *
+// *********************************************************************
+// Block matching over a band of rows. Pixel-wise Hamming costs of the
+// rows covered by the block are kept in a ring buffer with one spare
+// row, so the column sums can be updated by subtracting the row that
+// leaves the block and adding the one that enters it. Block sums are
+// then differences of the row integral of column sums; all 16-bit
+// arithmetic wraps around, which yields correct differences as long as
+// the block sums themselves fit. The number of disparities is a
+// template parameter for the common cases (zero selects the generic
+// kernel), so that the per-pixel loops are fully unrolled
+template <int FixedDisparities>
+class MatchingBody : public cv::ParallelLoopBody
+{
+public:
+    MatchingBody (const quint64 *census1, const quint64 *census2, const cv::Size &imageSize, int invalidCost, int blockSize, int minDisparity, int numDisparities, int uniquenessRatio, int numBands, CensusMatcherBandBuffers *bandBuffers, cv::Mat &disparity)
+        : census1(census1),
+          census2(census2),
+          width(imageSize.width),
+          height(imageSize.height),
+          invalidCost(invalidCost),
+          blockSize(blockSize),
+          minDisparity(minDisparity),
+          dynamicDisparities(numDisparities),
+          uniquenessRatio(uniquenessRatio),
+          numBands(numBands),
+          bandBuffers(bandBuffers),
+          disparity(disparity)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override;
+
+protected:
+    inline int getNumDisparities () const
+    {
+        return FixedDisparities > 0 ? FixedDisparities : dynamicDisparities;
+    }
+
+    void computeCostRow (int y, uchar *costs) const;
+    void selectRow (const ushort *integral, ushort *sums, short *disparityRow) const;
+
+protected:
+    const quint64 *census1;
+    const quint64 *census2;
+    int width;
+    int height;
+    int invalidCost;
+    int blockSize;
+    int minDisparity;
+    int dynamicDisparities;
+    int uniquenessRatio;
+    int numBands;
+    CensusMatcherBandBuffers *bandBuffers;
+    cv::Mat &disparity;
+};
+
+
+// Pixel-wise Hamming costs for a row; disparities for which the
+// matching pixel lies outside the right image get the invalid cost
+template <int FixedDisparities>
+void MatchingBody<FixedDisparities>::computeCostRow (int y, uchar *costs) const
+{
+    const int numDisparities = getNumDisparities();
+    const quint64 *census1Row = census1 + y*width;
+    const quint64 *census2Row = census2 + y*width;
+
+    for (int x = 0; x < width; x++) {
+        uchar *cost = costs + x*numDisparities;
+
+        const int dLo = std::max(0, x - minDisparity - width + 1);
+        const int dHi = std::min(numDisparities - 1, x - minDisparity);
+
+        const quint64 descriptor = census1Row[x];
+        const quint64 *match = census2Row + x - minDisparity;
+
+        int d = 0;
+        for (; d < std::min(dLo, numDisparities); d++) {
+            cost[d] = static_cast<uchar>(invalidCost);
+        }
+        for (; d <= dHi; d++) {
+            cost[d] = static_cast<uchar>(qPopulationCount(descriptor ^ match[-d]));
+        }
+        for (; d < numDisparities; d++) {
+            cost[d] = static_cast<uchar>(invalidCost);
+        }
+    }
+}
+
+// Winner-takes-all selection for a row, with uniqueness check and
+// parabolic sub-pixel refinement
+template <int FixedDisparities>
+void MatchingBody<FixedDisparities>::selectRow (const ushort *integral, ushort *sums, short *disparityRow) const
+{
+    const int numDisparities = getNumDisparities();
+    const int radius = blockSize / 2;
+    const short invalid = static_cast<short>((minDisparity - 1)*16);
+
+    for (int x = 0; x < width; x++) {
+        // Block sums; the block is truncated at left and right border
+        const ushort *integralHi = integral + std::min(x + radius + 1, width)*numDisparities;
+        const ushort *integralLo = integral + std::max(x - radius, 0)*numDisparities;
+
+        int bestSum = USHRT_MAX;
+#if CV_SIMD128
+        cv::v_uint16x8 minimum = cv::v_setall_u16(USHRT_MAX);
+        for (int d = 0; d < numDisparities; d += 8) {
+            const cv::v_uint16x8 sum = cv::v_sub_wrap(cv::v_load(integralHi + d), cv::v_load(integralLo + d));
+            minimum = cv::v_min(minimum, sum);
+            cv::v_store(sums + d, sum);
+        }
+        bestSum = cv::v_reduce_min(minimum);
+#else
+        for (int d = 0; d < numDisparities; d++) {
+            sums[d] = static_cast<ushort>(integralHi[d] - integralLo[d]);
+            bestSum = std::min(bestSum, static_cast<int>(sums[d]));
+        }
+#endif
+
+        int bestD = 0;
+        while (sums[bestD] != bestSum) {
+            bestD++;
+        }
+
+        // Uniqueness check: minimum must win over all costs that are
+        // not its immediate neighbours
+        bool unique = true;
+        if (uniquenessRatio > 0) {
+            for (int d = 0; d < numDisparities; d++) {
+                if (sums[d]*(100 - uniquenessRatio) < bestSum*100 && std::abs(d - bestD) > 1) {
+                    unique = false;
+                    break;
+                }
+            }
+        }
+
+        if (!unique) {
+            disparityRow[x] = invalid;
+            continue;
+        }
+
+        // Sub-pixel refinement
+        int value = bestD*16;
+        if (bestD > 0 && bestD < numDisparities - 1) {
+            const int denom2 = std::max(sums[bestD - 1] + sums[bestD + 1] - 2*bestSum, 1);
+            value += ((sums[bestD - 1] - sums[bestD + 1])*16 + denom2) / (denom2*2);
+        }
+
+        disparityRow[x] = static_cast<short>(minDisparity*16 + value);
+    }
+}
+
+template <int FixedDisparities>
+void MatchingBody<FixedDisparities>::operator() (const cv::Range &range) const
+{
+    const int numDisparities = getNumDisparities();
+    const int rowSize = width*numDisparities; // Divisible by 16
+    const int radius = blockSize / 2;
+    const int ringSize = blockSize + 1;
+
+    for (int band = range.start; band < range.end; band++) {
+        CensusMatcherBandBuffers &buffers = bandBuffers[band];
+        uchar *costRows = buffers.costRows.data();
+        ushort *columnSums = buffers.columnSums.data();
+        ushort *integral = buffers.rowIntegral.data();
+        ushort *sums = buffers.blockSums.data();
+
+        const int y0 = band*height / numBands;
+        const int y1 = (band + 1)*height / numBands;
+
+        // Initial block; ring slot k holds row y0 - radius + k, with
+        // border rows replicated
+        std::fill(columnSums, columnSums + rowSize, 0);
+        for (int k = 0; k < blockSize; k++) {
+            uchar *costs = costRows + k*rowSize;
+            computeCostRow(std::min(std::max(y0 - radius + k, 0), height - 1), costs);
+            for (int i = 0; i < rowSize; i++) {
+                columnSums[i] += costs[i];
+            }
+        }
+
+        for (int y = y0; y < y1; y++) {
+            // Slide the block: replace the oldest row with the new one
+            if (y > y0) {
+                const uchar *oldCosts = costRows + ((y - y0 - 1) % ringSize)*rowSize;
+                uchar *newCosts = costRows + ((y - y0 + blockSize - 1) % ringSize)*rowSize;
+
+                computeCostRow(std::min(y + radius, height - 1), newCosts);
+
+                int i = 0;
+#if CV_SIMD128
+                for (; i < rowSize; i += 16) {
+                    cv::v_uint16x8 old0, old1, new0, new1;
+                    cv::v_expand(cv::v_load(oldCosts + i), old0, old1);
+                    cv::v_expand(cv::v_load(newCosts + i), new0, new1);
+                    cv::v_store(columnSums + i, cv::v_add_wrap(cv::v_sub_wrap(cv::v_load(columnSums + i), old0), new0));
+                    cv::v_store(columnSums + i + 8, cv::v_add_wrap(cv::v_sub_wrap(cv::v_load(columnSums + i + 8), old1), new1));
+                }
+#endif
+                for (; i < rowSize; i++) {
+                    columnSums[i] = static_cast<ushort>(columnSums[i] - oldCosts[i] + newCosts[i]);
+                }
+            }
+
+            // Row integral of column sums
+            std::fill(integral, integral + numDisparities, 0);
+            int i = 0;
+#if CV_SIMD128
+            for (; i < rowSize; i += 8) {
+                cv::v_store(integral + numDisparities + i, cv::v_add_wrap(cv::v_load(integral + i), cv::v_load(columnSums + i)));
+            }
+#endif
+            for (; i < rowSize; i++) {
+                integral[numDisparities + i] = static_cast<ushort>(integral[i] + columnSums[i]);
+            }
+
+            selectRow(integral, sums, disparity.ptr<short>(y));
+        }
+    }
+}
+
+
+template <int FixedDisparities>
+static void runMatching (const quint64 *census1, const quint64 *census2, const cv::Size &imageSize, int invalidCost, int blockSize, int minDisparity, int numDisparities, int uniquenessRatio, int numBands, CensusMatcherBandBuffers *bandBuffers, cv::Mat &disparity)
+{
+    cv::parallel_for_(cv::Range(0, numBands), MatchingBody<FixedDisparities>(census1, census2, imageSize, invalidCost, blockSize, minDisparity, numDisparities, uniquenessRatio, numBands, bandBuffers, disparity), numBands);
+}
+
+
+// *********************************************************************
+// *                              Matcher                              *
+// *********************************************************************
+CensusMatcher::CensusMatcher ()
+    : censusWindow(CensusWindow9x7),
+      blockSize(9),
+      minDisparity(0),
+      numDisparities(64),
+      uniquenessRatio(15),
+      numBands(0)
+{
+}
+
+
+// Census window
+void CensusMatcher::setCensusWindow (int window)
+{
+    if (window != CensusWindow5x5 && window != CensusWindow7x9 && window != CensusWindow9x7) {
+        window = CensusWindow9x7;
+    }
+    censusWindow = window;
+}
+
+int CensusMatcher::getCensusWindow () const
+{
+    return censusWindow;
+}
+
+// Block size: odd, between 1 and 31
+void CensusMatcher::setBlockSize (int value)
+{
+    value = std::min(std::max(value, 1), MaxBlockSize);
+    blockSize = value | 1;
+}
+
+int CensusMatcher::getBlockSize () const
+{
+    return blockSize;
+}
+
+// Minimum disparity
+void CensusMatcher::setMinDisparity (int value)
+{
+    minDisparity = value;
+}
+
+int CensusMatcher::getMinDisparity () const
+{
+    return minDisparity;
+}
+
+// Number of disparities; must be divisible by 16
+void CensusMatcher::setNumDisparities (int value)
+{
+    numDisparities = std::max(16, (value + 8) & -16);
+}
+
+int CensusMatcher::getNumDisparities () const
+{
+    return numDisparities;
+}
+
+// Uniqueness ratio
+void CensusMatcher::setUniquenessRatio (int value)
+{
+    uniquenessRatio = std::min(std::max(value, 0), 100);
+}
+
+int CensusMatcher::getUniquenessRatio () const
+{
+    return uniquenessRatio;
+}
+
+
+// *********************************************************************
+// *                            Processing                             *
+// *********************************************************************
+void CensusMatcher::prepare (const cv::Size &imageSize)
+{
+    allocateBuffers(imageSize, numDisparities);
+}
+
+void CensusMatcher::allocateBuffers (const cv::Size &imageSize, int numDisparities)
+{
+    const int width = imageSize.width;
+    const int height = imageSize.height;
+    const int rowSize = width*numDisparities;
+
+    census1.resize(width*height);
+    census2.resize(width*height);
+
+    // One band per thread, but keep bands considerably taller than the
+    // block, as each band has to initialize its own block
+    numBands = std::max(1, std::min(cv::getNumThreads(), height / (4*blockSize)));
+
+    // Buffers; no-op if already of correct size
+    bandBuffers.resize(numBands);
+    for (CensusMatcherBandBuffers &buffers : bandBuffers) {
+        buffers.costRows.resize((blockSize + 1)*rowSize);
+        buffers.columnSums.resize(rowSize);
+        buffers.rowIntegral.resize(rowSize + numDisparities);
+        buffers.blockSums.resize(numDisparities);
+    }
+}
+
+void CensusMatcher::compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity)
+{
+    compute(img1, img2, disparity, minDisparity, numDisparities);
+}
+
+void CensusMatcher::compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities)
+{
+    numDisparities = std::max(16, (numDisparities + 8) & -16);
+
+    if (img1.type() != CV_8UC1 || img2.type() != CV_8UC1) {
+        throw Exception(QStringLiteral("Input images must be 8-bit grayscale!"));
+    }
+    if (img1.size() != img2.size()) {
+        throw Exception(QStringLiteral("Input images must be of same size!"));
+    }
+
+    allocateBuffers(img1.size(), numDisparities);
+
+    computeCensus(img1, padded1, census1);
+    computeCensus(img2, padded2, census2);
+
+    disparity.create(img1.size(), CV_16SC1);
+    computeDisparities(img1.size(), minDisparity, numDisparities, disparity);
+}
+
+void CensusMatcher::computeCensus (const cv::Mat &image, cv::Mat &padded, std::vector<quint64> &census) const
+{
+    const cv::Range rows(0, image.rows);
+
+    switch (censusWindow) {
+        case CensusWindow5x5: {
+            cv::copyMakeBorder(image, padded, 2, 2, 2, 2, cv::BORDER_REPLICATE);
+            cv::parallel_for_(rows, CensusBody<2, 2>(padded, image.cols, census.data()));
+            break;
+        }
+        case CensusWindow7x9: {
+            cv::copyMakeBorder(image, padded, 4, 4, 3, 3, cv::BORDER_REPLICATE);
+            cv::parallel_for_(rows, CensusBody<3, 4>(padded, image.cols, census.data()));
+            break;
+        }
+        case CensusWindow9x7:
+        default: {
+            cv::copyMakeBorder(image, padded, 3, 3, 4, 4, cv::BORDER_REPLICATE);
+            cv::parallel_for_(rows, CensusBody<4, 3>(padded, image.cols, census.data()));
+            break;
+        }
+    }
+}
+
+void CensusMatcher::computeDisparities (const cv::Size &imageSize, int minDisparity, int numDisparities, cv::Mat &disparity)
+{
+    // Number of bits in census descriptor
+    const int invalidCost = (censusWindow == CensusWindow5x5) ? 24 : 62;
+
+    switch (numDisparities) {
+        case 64: {
+            runMatching<64>(census1.data(), census2.data(), imageSize, invalidCost, blockSize, minDisparity, numDisparities, uniquenessRatio, numBands, bandBuffers.data(), disparity);
+            break;
+        }
+        case 128: {
+            runMatching<128>(census1.data(), census2.data(), imageSize, invalidCost, blockSize, minDisparity, numDisparities, uniquenessRatio, numBands, bandBuffers.data(), disparity);
+            break;
+        }
+        case 256: {
+            runMatching<256>(census1.data(), census2.data(), imageSize, invalidCost, blockSize, minDisparity, numDisparities, uniquenessRatio, numBands, bandBuffers.data(), disparity);
+            break;
+        }
+        default: {
+            runMatching<0>(census1.data(), census2.data(), imageSize, invalidCost, blockSize, minDisparity, numDisparities, uniquenessRatio, numBands, bandBuffers.data(), disparity);
+            break;
+        }
+    }
+}
+
+
+} // StereoMethodToolboxCensusBm
+} // Pipeline
+} // StereoToolbox
+} // MVL
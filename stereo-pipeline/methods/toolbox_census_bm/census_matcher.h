@@ -0,0 +1,131 @@
+/*
+ * Toolbox Census Block Matching: matching engine
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_CENSUS_BM__CENSUS_MATCHER_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_CENSUS_BM__CENSUS_MATCHER_H
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCensusBm {
+
+
+// Work buffers of a band of rows: ring of pixel-wise cost rows,
+// running column sums, row integral of column sums and block sums
+struct CensusMatcherBandBuffers
+{
+    std::vector<uchar> costRows;
+    std::vector<ushort> columnSums;
+    std::vector<ushort> rowIntegral;
+    std::vector<ushort> blockSums;
+};
+
+
+// Census-transform block matcher: pixel-wise matching cost is the
+// Hamming distance between census descriptors, aggregated over square
+// blocks, followed by winner-takes-all selection with uniqueness check
+// and sub-pixel refinement. The image is processed in parallel row
+// bands; within a band, block sums are obtained from running column
+// sums and per-row integrals, so the cost of aggregation does not
+// depend on block size. Kernels are specialized at compile time for
+// common numbers of disparities (64, 128 and 256), with a generic
+// fallback for others. Output disparity is CV_16S with four fractional
+// bits, with invalid disparities set to (minDisparity - 1)*16
+class CensusMatcher
+{
+public:
+    CensusMatcher ();
+
+    // Census window (width x height)
+    enum CensusWindow {
+        CensusWindow5x5,
+        CensusWindow7x9,
+        CensusWindow9x7,
+    };
+
+    void setCensusWindow (int window);
+    int getCensusWindow () const;
+
+    // Block size: odd, between 1 and 31
+    void setBlockSize (int value);
+    int getBlockSize () const;
+
+    void setMinDisparity (int value);
+    int getMinDisparity () const;
+
+    // Number of disparities; must be divisible by 16
+    void setNumDisparities (int value);
+    int getNumDisparities () const;
+
+    void setUniquenessRatio (int value);
+    int getUniquenessRatio () const;
+
+    // Allocates all buffers for images of given size
+    void prepare (const cv::Size &imageSize);
+
+    // Inputs must be CV_8UC1 images of same size
+    void compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity);
+
+    // Same as above, but with the given search range instead of the
+    // configured one (number of disparities is rounded to multiple of
+    // 16); the configuration is left unchanged
+    void compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities);
+
+protected:
+    void allocateBuffers (const cv::Size &imageSize, int numDisparities);
+
+    void computeCensus (const cv::Mat &image, cv::Mat &padded, std::vector<quint64> &census) const;
+    void computeDisparities (const cv::Size &imageSize, int minDisparity, int numDisparities, cv::Mat &disparity);
+
+protected:
+    // Parameters
+    int censusWindow;
+    int blockSize;
+    int minDisparity;
+    int numDisparities;
+    int uniquenessRatio;
+
+    // Census transforms; 32-bit descriptors are stored in the lower
+    // half of 64-bit elements
+    std::vector<quint64> census1;
+    std::vector<quint64> census2;
+
+    // Border-replicated input images
+    cv::Mat padded1;
+    cv::Mat padded2;
+
+    // Per-band work buffers
+    int numBands;
+    std::vector<CensusMatcherBandBuffers> bandBuffers;
+};
+
+
+} // StereoMethodToolboxCensusBm
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
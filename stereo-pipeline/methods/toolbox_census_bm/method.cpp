@@ -0,0 +1,304 @@
+/*
+ * Toolbox Census Block Matching: method
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method.h"
+#include "method_widget.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/imgproc.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCensusBm {
+
+
+Method::Method (QObject *parent)
+    : QObject(parent), StereoMethod2()
+{
+}
+
+Method::~Method ()
+{
+}
+
+
+// *********************************************************************
+// *                       StereoMethod interface                      *
+// *********************************************************************
+QString Method::getShortName () const
+{
+    return "Census BM";
+}
+
+QWidget *Method::createConfigWidget (QWidget *parent)
+{
+    return new MethodWidget(this, parent);
+}
+
+
+// *********************************************************************
+// *                    Disparity image computation                    *
+// *********************************************************************
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    // Basic interface; disparity refers to our internal buffer
+    DisparityFormat format;
+    computeDisparity(img1, img2, tmpDisparity, numDisparities, format);
+    disparity = tmpDisparity;
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    // Convert to grayscale
+    if (img1.channels() == 3) {
+        cv::cvtColor(img1, tmpImg1, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg1 = img1;
+    }
+
+    if (img2.channels() == 3) {
+        cv::cvtColor(img2, tmpImg2, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg2 = img2;
+    }
+
+    // Compute disparity image, directly into output buffer
+    QMutexLocker locker(&mutex);
+    matcher.compute(tmpImg1, tmpImg2, disparity);
+    numDisparities = matcher.getNumDisparities();
+    locker.unlock();
+
+    // CV_16S disparity with four fractional bits
+    format = DisparityFormat(1/16.0);
+}
+
+DisparityFormat Method::getDisparityFormat () const
+{
+    return DisparityFormat(1/16.0);
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    return CapabilityRegionOfInterest | CapabilityPreallocation | CapabilityDisparityRange;
+}
+
+int Method::getPreferredInputType () const
+{
+    return CV_8UC1;
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    Q_UNUSED(imageType);
+
+    QMutexLocker locker(&mutex);
+    matcher.prepare(imageSize);
+}
+
+void Method::computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format)
+{
+    // Convert to grayscale
+    if (img1.channels() == 3) {
+        cv::cvtColor(img1, tmpImg1, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg1 = img1;
+    }
+
+    if (img2.channels() == 3) {
+        cv::cvtColor(img2, tmpImg2, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg2 = img2;
+    }
+
+    // The range is passed to the matcher, so the configured range is
+    // left untouched
+    QMutexLocker locker(&mutex);
+    matcher.compute(tmpImg1, tmpImg2, disparity, minDisparity, numDisparities);
+    locker.unlock();
+
+    // CV_16S disparity with four fractional bits
+    format = DisparityFormat(1/16.0);
+}
+
+void Method::getDisparityRange (int &minDisparity, int &numDisparities) const
+{
+    minDisparity = matcher.getMinDisparity();
+    numDisparities = matcher.getNumDisparities();
+}
+
+
+// *********************************************************************
+// *                     Parameter import/export                       *
+// *********************************************************************
+void Method::loadParameters (const QString &filename)
+{
+    // Open storage
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("StereoMethodParameters")) {
+        throw Exception(QStringLiteral("Invalid stereo method parameters configuration!"));
+    }
+
+    // Validate method name
+    QString storedName = QString::fromStdString(storage["MethodName"]);
+    if (storedName.compare(getShortName())) {
+        throw Exception(QStringLiteral("Invalid configuration for method '%1'!").arg(getShortName()));
+    }
+
+    // Load parameters
+    QMutexLocker locker(&mutex);
+
+    matcher.setCensusWindow((int)storage["CensusWindow"]);
+    matcher.setBlockSize((int)storage["BlockSize"]);
+
+    matcher.setMinDisparity((int)storage["MinDisparity"]);
+    matcher.setNumDisparities((int)storage["NumDisparities"]);
+
+    matcher.setUniquenessRatio((int)storage["UniquenessRatio"]);
+
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+void Method::saveParameters (const QString &filename) const
+{
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    // Data type
+    storage << "DataType" << "StereoMethodParameters";
+
+    // Store method name, so it can be validate upon loading
+    storage << "MethodName" << getShortName().toStdString();
+
+    // Save parameters
+    storage << "CensusWindow" << matcher.getCensusWindow();
+    storage << "BlockSize" << matcher.getBlockSize();
+
+    storage << "MinDisparity" << matcher.getMinDisparity();
+    storage << "NumDisparities" << matcher.getNumDisparities();
+
+    storage << "UniquenessRatio" << matcher.getUniquenessRatio();
+}
+
+
+// *********************************************************************
+// *                         Method parameters                         *
+// *********************************************************************
+// Census window (5x5, 7x9 or 9x7)
+int Method::getCensusWindow () const
+{
+    return matcher.getCensusWindow();
+}
+
+void Method::setCensusWindow (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    matcher.setCensusWindow(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Aggregation block size; odd, between 1 and 31
+int Method::getBlockSize () const
+{
+    return matcher.getBlockSize();
+}
+
+void Method::setBlockSize (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    matcher.setBlockSize(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Minimum disparity
+int Method::getMinDisparity () const
+{
+    return matcher.getMinDisparity();
+}
+
+void Method::setMinDisparity (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    matcher.setMinDisparity(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Number of disparity levels; must be divisible by 16. 64, 128 and
+// 256 levels use specialized matching kernels
+int Method::getNumDisparities () const
+{
+    return matcher.getNumDisparities();
+}
+
+void Method::setNumDisparities (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    matcher.setNumDisparities(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Uniqueness ratio
+int Method::getUniquenessRatio () const
+{
+    return matcher.getUniquenessRatio();
+}
+
+void Method::setUniquenessRatio (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    matcher.setUniquenessRatio(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+
+} // StereoMethodToolboxCensusBm
+} // Pipeline
+} // StereoToolbox
+} // MVL
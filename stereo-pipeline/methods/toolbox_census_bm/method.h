@@ -0,0 +1,93 @@
+/*
+ * Toolbox Census Block Matching: method
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_CENSUS_BM__METHOD_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_CENSUS_BM__METHOD_H
+
+#include <stereo-pipeline/stereo_method.h>
+
+#include "census_matcher.h"
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCensusBm {
+
+
+class Method : public QObject, public StereoMethod2
+{
+    Q_OBJECT
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod MVL::StereoToolbox::Pipeline::StereoMethod2)
+
+public:
+    Method (QObject *parent = nullptr);
+    virtual ~Method ();
+
+    virtual QString getShortName () const override;
+    virtual QWidget *createConfigWidget (QWidget *parent = nullptr) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) override;
+    virtual DisparityFormat getDisparityFormat () const override;
+    virtual void loadParameters (const QString &filename) override;
+    virtual void saveParameters (const QString &filename) const override;
+
+    virtual int getCapabilities () const override;
+    virtual int getPreferredInputType () const override;
+    virtual void prepare (const cv::Size &imageSize, int imageType) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) override;
+    virtual void computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format) override;
+    virtual void getDisparityRange (int &minDisparity, int &numDisparities) const override;
+
+    // Parameters
+    void setCensusWindow (int value);
+    int getCensusWindow () const;
+
+    void setBlockSize (int value);
+    int getBlockSize () const;
+
+    void setMinDisparity (int value);
+    int getMinDisparity () const;
+
+    void setNumDisparities (int value);
+    int getNumDisparities () const;
+
+    void setUniquenessRatio (int value);
+    int getUniquenessRatio () const;
+
+signals:
+    // Signals from interface
+    void parameterChanged () override;
+
+protected:
+    // Method implementation
+    CensusMatcher matcher;
+    QMutex mutex;
+
+    cv::Mat tmpImg1, tmpImg2;
+    cv::Mat tmpDisparity;
+};
+
+
+} // StereoMethodToolboxCensusBm
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
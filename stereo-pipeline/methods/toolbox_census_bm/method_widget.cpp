@@ -0,0 +1,205 @@
+/*
+ * Toolbox Census Block Matching: method widget
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method_widget.h"
+#include "method.h"
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCensusBm {
+
+
+MethodWidget::MethodWidget (Method *method, QWidget *parent)
+    : QWidget(parent),
+      method(method)
+{
+    connect(method, &Method::parameterChanged, this, &MethodWidget::updateParameters, Qt::QueuedConnection);
+
+    // Build layout
+    QVBoxLayout *baseLayout = new QVBoxLayout(this);
+
+    QLabel *label;
+    QComboBox *comboBox;
+    QSpinBox *spinBox;
+    QFrame *line;
+    QString tooltip;
+
+    // Name
+    label = new QLabel("<b><u>Toolbox census block matching</u></b>", this);
+    label->setAlignment(Qt::AlignHCenter);
+
+    baseLayout->addWidget(label);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    baseLayout->addWidget(line);
+
+    // Scrollable area with layout
+    QScrollArea *scrollArea = new QScrollArea(this);
+    scrollArea->setWidgetResizable(true);
+    scrollArea->setWidget(new QWidget(this));
+
+    baseLayout->addWidget(scrollArea);
+
+    QFormLayout *layout = new QFormLayout(scrollArea->widget());
+
+
+    // Census window
+    tooltip = "Size of the census transform window (width x height). Larger windows yield more distinctive \n"
+              "descriptors at the cost of computation time.";
+
+    label = new QLabel("Census window", this);
+    label->setToolTip(tooltip);
+
+    comboBox = new QComboBox(this);
+    comboBox->addItem("5x5", CensusMatcher::CensusWindow5x5);
+    comboBox->setItemData(0, "24-bit descriptors.", Qt::ToolTipRole);
+    comboBox->addItem("7x9", CensusMatcher::CensusWindow7x9);
+    comboBox->setItemData(1, "62-bit descriptors.", Qt::ToolTipRole);
+    comboBox->addItem("9x7", CensusMatcher::CensusWindow9x7);
+    comboBox->setItemData(2, "62-bit descriptors.", Qt::ToolTipRole);
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), method, [method, comboBox] (int index) {
+        method->setCensusWindow(comboBox->itemData(index).toInt());
+    }, Qt::QueuedConnection);
+
+    comboBoxCensusWindow = comboBox;
+
+    layout->addRow(label, comboBox);
+
+    // Block size
+    tooltip = "Size of the block over which the Hamming distances are aggregated. Must be an odd number \n"
+              "between 1 and 31. The processing time does not depend on block size.";
+
+    label = new QLabel("Block size", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(1, 31);
+    spinBox->setSingleStep(2); // Always odd values
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setBlockSize, Qt::QueuedConnection);
+    spinBoxBlockSize = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
+    // Min. disparity
+    tooltip = "Minimum possible disparity value. Normally, it is zero but sometimes rectification algorithms \n"
+              "can shift images, so this parameter needs to be adjusted accordingly.";
+
+    label = new QLabel("Min. disparity", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(-9999, 9999);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setMinDisparity, Qt::QueuedConnection);
+    spinBoxMinDisparity = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Num. disparities
+    tooltip = "Maximum disparity minus minimum disparity. The value must be divisible by 16. 64, 128 and 256 \n"
+              "levels use specialized (faster) matching kernels.";
+
+    label = new QLabel("Num. disparities", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(16, 16*1000);
+    spinBox->setSingleStep(16); // Must be divisible by 16
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setNumDisparities, Qt::QueuedConnection);
+    spinBoxNumDisparities = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
+    // Uniqueness ratio
+    tooltip = "Margin in percentage by which the best (minimum) block cost should \"win\" the second best \n"
+              "value to consider the found match correct. Set to 0 to disable the check.";
+
+    label = new QLabel("Uniqueness ratio", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 100);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setUniquenessRatio, Qt::QueuedConnection);
+    spinBoxUniquenessRatio = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Update parameters
+    updateParameters();
+}
+
+MethodWidget::~MethodWidget ()
+{
+}
+
+
+void MethodWidget::updateParameters ()
+{
+    // Census window
+    comboBoxCensusWindow->blockSignals(true);
+    comboBoxCensusWindow->setCurrentIndex(comboBoxCensusWindow->findData(method->getCensusWindow()));
+    comboBoxCensusWindow->blockSignals(false);
+
+    // Block size
+    spinBoxBlockSize->blockSignals(true);
+    spinBoxBlockSize->setValue(method->getBlockSize());
+    spinBoxBlockSize->blockSignals(false);
+
+    // Min. disparity
+    spinBoxMinDisparity->blockSignals(true);
+    spinBoxMinDisparity->setValue(method->getMinDisparity());
+    spinBoxMinDisparity->blockSignals(false);
+
+    // Num. disparities
+    spinBoxNumDisparities->blockSignals(true);
+    spinBoxNumDisparities->setValue(method->getNumDisparities());
+    spinBoxNumDisparities->blockSignals(false);
+
+    // Uniqueness ratio
+    spinBoxUniquenessRatio->blockSignals(true);
+    spinBoxUniquenessRatio->setValue(method->getUniquenessRatio());
+    spinBoxUniquenessRatio->blockSignals(false);
+}
+
+
+} // StereoMethodToolboxCensusBm
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,426 @@
+/*
+ * Toolbox Coarse-to-Fine Matching: method
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method.h"
+#include "method_widget.h"
+
+#include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/utils.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCoarseToFine {
+
+
+// Tiles are matched with this much of context around them, so that the
+// inner method's support windows are not truncated at tile borders
+static const int TileBorder = 16;
+
+// Tiles in which less than this fraction of coarse disparities is
+// valid are searched over the full range
+static const double MinValidFraction = 0.1;
+
+
+Method::Method (QObject *parent)
+    : QObject(parent), StereoMethod2(),
+      innerMethod(nullptr),
+      pyramidLevels(2),
+      minDisparity(0),
+      numDisparities(128),
+      tileSize(64),
+      margin(4),
+      processingTime(0),
+      searchFraction(1.0),
+      referenceProcessingTime(-1),
+      referenceRequested(0)
+{
+}
+
+Method::~Method ()
+{
+}
+
+
+// *********************************************************************
+// *                       StereoMethod interface                      *
+// *********************************************************************
+QString Method::getShortName () const
+{
+    return "Coarse-to-fine";
+}
+
+QWidget *Method::createConfigWidget (QWidget *parent)
+{
+    return new MethodWidget(this, parent);
+}
+
+
+// *********************************************************************
+// *                    Disparity image computation                    *
+// *********************************************************************
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    // Basic interface; disparity refers to our internal buffer
+    computeDisparity(img1, img2, tmpDisparity, numDisparities, disparityFormat);
+    disparity = tmpDisparity;
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    QMutexLocker locker(&mutex);
+
+    StereoMethod2 *inner = qobject_cast<StereoMethod2 *>(innerMethod);
+    if (!inner) {
+        throw Exception(QStringLiteral("Inner stereo method not set!"));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Coarse level: inner method over the correspondingly scaled range
+    const int factor = 1 << pyramidLevels;
+
+    cv::resize(img1, coarseImg1, cv::Size(), 1.0/factor, 1.0/factor, cv::INTER_AREA);
+    cv::resize(img2, coarseImg2, cv::Size(), 1.0/factor, 1.0/factor, cv::INTER_AREA);
+
+    const int coarseMin = static_cast<int>(std::floor(minDisparity / static_cast<double>(factor)));
+    const int coarseMax = static_cast<int>(std::ceil((minDisparity + this->numDisparities) / static_cast<double>(factor)));
+    const int coarseNum = std::max((coarseMax - coarseMin + 15) & -16, 16);
+
+    DisparityFormat coarseFormat;
+    inner->computeDisparityInRange(coarseImg1, coarseImg2, coarseDisparity, coarseMin, coarseNum, coarseFormat);
+
+    // Coarse estimate in units of full-resolution disparity
+    Utils::convertDisparityToFloat(coarseDisparity, DisparityFormat(coarseFormat.scale*factor, coarseFormat.offset*factor), coarseEstimate);
+
+    // Full resolution: restricted search in tiles. In addition to the
+    // margin, the ranges must cover the quantization of coarse level
+    Utils::computeTileDisparityRanges(coarseEstimate, img1.size(), tileSize, margin + factor, MinValidFraction, minDisparity, this->numDisparities, tileRanges);
+    Utils::computeDisparityInTiles(inner, img1, img2, tileRanges, tileSize, TileBorder, minDisparity, disparity, format);
+
+    numDisparities = this->numDisparities;
+    disparityFormat = format;
+
+    // Statistics
+    processingTime = timer.nsecsElapsed() / 1e6;
+    searchFraction = Utils::getTileSearchFraction(tileRanges, img1.size(), tileSize, TileBorder, this->numDisparities);
+
+    // Reference measurement, if requested; the result of the wrapped
+    // computation is already stored, so the reference disparity goes to
+    // a separate buffer
+    if (referenceRequested.testAndSetOrdered(1, 0)) {
+        cv::Mat referenceDisparity;
+        DisparityFormat referenceFormat;
+
+        timer.start();
+        inner->computeDisparityInRange(img1, img2, referenceDisparity, minDisparity, this->numDisparities, referenceFormat);
+        referenceProcessingTime = timer.nsecsElapsed() / 1e6;
+    }
+
+    locker.unlock();
+
+    emit statisticsChanged();
+}
+
+DisparityFormat Method::getDisparityFormat () const
+{
+    return disparityFormat;
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    // Tiles are matched as sub-regions anyway
+    return CapabilityRegionOfInterest;
+}
+
+int Method::getPreferredInputType () const
+{
+    StereoMethod2 *inner = qobject_cast<StereoMethod2 *>(innerMethod);
+    return inner ? inner->getPreferredInputType() : -1;
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    // Inner method is run on images of varying size; nothing to
+    // prepare
+    Q_UNUSED(imageSize);
+    Q_UNUSED(imageType);
+}
+
+
+// *********************************************************************
+// *                   StereoMethodWrapper interface                   *
+// *********************************************************************
+void Method::setAvailableMethods (const QList<QObject *> &methods)
+{
+    // Only methods that honor search range override can be wrapped
+    availableMethods.clear();
+    for (QObject *method : methods) {
+        StereoMethod2 *iface = qobject_cast<StereoMethod2 *>(method);
+        if (iface && (iface->getCapabilities() & CapabilityDisparityRange)) {
+            availableMethods.append(method);
+        }
+    }
+
+    if (!availableMethods.contains(innerMethod)) {
+        setInnerMethod(availableMethods.isEmpty() ? nullptr : availableMethods.first());
+    }
+}
+
+const QList<QObject *> &Method::getAvailableMethods () const
+{
+    return availableMethods;
+}
+
+void Method::setInnerMethod (QObject *method)
+{
+    QMutexLocker locker(&mutex);
+
+    if (method == innerMethod) {
+        return;
+    }
+
+    disconnect(innerConnection);
+
+    innerMethod = method;
+    referenceProcessingTime = -1;
+
+    // Changes of inner method's parameters are our changes as well
+    // NOTE: we need to use the old syntax because signal is defined in interface!
+    if (innerMethod) {
+        innerConnection = connect(innerMethod, SIGNAL(parameterChanged()), this, SIGNAL(parameterChanged()));
+    }
+
+    locker.unlock();
+
+    emit innerMethodChanged();
+    emit parameterChanged();
+}
+
+QObject *Method::getInnerMethod () const
+{
+    return innerMethod;
+}
+
+
+// *********************************************************************
+// *                     Parameter import/export                       *
+// *********************************************************************
+void Method::loadParameters (const QString &filename)
+{
+    // Open storage
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("StereoMethodParameters")) {
+        throw Exception(QStringLiteral("Invalid stereo method parameters configuration!"));
+    }
+
+    // Validate method name
+    QString storedName = QString::fromStdString(storage["MethodName"]);
+    if (storedName.compare(getShortName())) {
+        throw Exception(QStringLiteral("Invalid configuration for method '%1'!").arg(getShortName()));
+    }
+
+    // Inner method is looked up by its name; its own parameters are
+    // stored separately
+    QString innerName = QString::fromStdString(storage["InnerMethod"]);
+    for (QObject *method : availableMethods) {
+        if (qobject_cast<StereoMethod *>(method)->getShortName() == innerName) {
+            setInnerMethod(method);
+            break;
+        }
+    }
+
+    // Load parameters
+    QMutexLocker locker(&mutex);
+
+    pyramidLevels = std::min(std::max((int)storage["PyramidLevels"], 1), 4);
+    minDisparity = (int)storage["MinDisparity"];
+    numDisparities = std::max(16, ((int)storage["NumDisparities"] + 8) & -16);
+    tileSize = std::min(std::max((int)storage["TileSize"], 16), 512);
+    margin = std::min(std::max((int)storage["Margin"], 0), 64);
+
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+void Method::saveParameters (const QString &filename) const
+{
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    // Data type
+    storage << "DataType" << "StereoMethodParameters";
+
+    // Store method name, so it can be validate upon loading
+    storage << "MethodName" << getShortName().toStdString();
+
+    // Save parameters
+    StereoMethod *inner = qobject_cast<StereoMethod *>(innerMethod);
+    storage << "InnerMethod" << (inner ? inner->getShortName().toStdString() : std::string());
+
+    storage << "PyramidLevels" << pyramidLevels;
+    storage << "MinDisparity" << minDisparity;
+    storage << "NumDisparities" << numDisparities;
+    storage << "TileSize" << tileSize;
+    storage << "Margin" << margin;
+}
+
+
+// *********************************************************************
+// *                         Method parameters                         *
+// *********************************************************************
+// Number of pyramid levels; the coarse level is downscaled by a factor
+// of 2^levels
+int Method::getPyramidLevels () const
+{
+    return pyramidLevels;
+}
+
+void Method::setPyramidLevels (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    pyramidLevels = std::min(std::max(value, 1), 4);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Minimum disparity at full resolution
+int Method::getMinDisparity () const
+{
+    return minDisparity;
+}
+
+void Method::setMinDisparity (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    minDisparity = value;
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Number of disparity levels at full resolution; must be divisible
+// by 16
+int Method::getNumDisparities () const
+{
+    return numDisparities;
+}
+
+void Method::setNumDisparities (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    numDisparities = std::max(16, (value + 8) & -16);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Size of tiles with individual search ranges
+int Method::getTileSize () const
+{
+    return tileSize;
+}
+
+void Method::setTileSize (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    tileSize = std::min(std::max(value, 16), 512);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Margin added to the per-tile disparity range
+int Method::getMargin () const
+{
+    return margin;
+}
+
+void Method::setMargin (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    margin = std::min(std::max(value, 0), 64);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+
+// *********************************************************************
+// *                            Statistics                             *
+// *********************************************************************
+// Processing time of last frame, in milliseconds
+double Method::getProcessingTime () const
+{
+    return processingTime;
+}
+
+// Work performed at full resolution in last frame, relative to the
+// full-range search (see Utils::getTileSearchFraction())
+double Method::getSearchFraction () const
+{
+    return searchFraction;
+}
+
+// Processing time of plain inner method, in milliseconds; negative if
+// not measured
+double Method::getReferenceProcessingTime () const
+{
+    return referenceProcessingTime;
+}
+
+void Method::measureReferenceTime ()
+{
+    // Called from the GUI thread; the measurement itself is done by the
+    // worker, which is holding the mutex while computing
+    referenceRequested.storeRelease(1);
+
+    emit parameterChanged();
+}
+
+
+} // StereoMethodToolboxCoarseToFine
+} // Pipeline
+} // StereoToolbox
+} // MVL
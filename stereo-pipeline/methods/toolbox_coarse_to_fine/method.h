@@ -0,0 +1,139 @@
+/*
+ * Toolbox Coarse-to-Fine Matching: method
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_COARSE_TO_FINE__METHOD_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_COARSE_TO_FINE__METHOD_H
+
+#include <stereo-pipeline/stereo_method.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCoarseToFine {
+
+
+// Coarse-to-fine wrapper: runs the inner method on a downscaled pyramid
+// level over the correspondingly scaled disparity range, and uses the
+// upsampled result to restrict the search range of the inner method at
+// full resolution, tile by tile. Only methods that honor the search
+// range override (StereoMethod2::CapabilityDisparityRange) can be
+// wrapped
+class Method : public QObject, public StereoMethod2, public StereoMethodWrapper
+{
+    Q_OBJECT
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::StereoMethod MVL::StereoToolbox::Pipeline::StereoMethod2 MVL::StereoToolbox::Pipeline::StereoMethodWrapper)
+
+public:
+    Method (QObject *parent = nullptr);
+    virtual ~Method ();
+
+    virtual QString getShortName () const override;
+    virtual QWidget *createConfigWidget (QWidget *parent = nullptr) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) override;
+    virtual DisparityFormat getDisparityFormat () const override;
+    virtual void loadParameters (const QString &filename) override;
+    virtual void saveParameters (const QString &filename) const override;
+
+    virtual int getCapabilities () const override;
+    virtual int getPreferredInputType () const override;
+    virtual void prepare (const cv::Size &imageSize, int imageType) override;
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) override;
+
+    virtual void setAvailableMethods (const QList<QObject *> &methods) override;
+
+    // Inner method
+    const QList<QObject *> &getAvailableMethods () const;
+
+    void setInnerMethod (QObject *method);
+    QObject *getInnerMethod () const;
+
+    // Parameters
+    void setPyramidLevels (int value);
+    int getPyramidLevels () const;
+
+    void setMinDisparity (int value);
+    int getMinDisparity () const;
+
+    void setNumDisparities (int value);
+    int getNumDisparities () const;
+
+    void setTileSize (int value);
+    int getTileSize () const;
+
+    void setMargin (int value);
+    int getMargin () const;
+
+    // Statistics
+    double getProcessingTime () const;
+    double getSearchFraction () const;
+    double getReferenceProcessingTime () const;
+
+    // Requests a run of the inner method over the full range at full
+    // resolution, to measure the speed-up. The measurement is done in
+    // the worker thread, on the next input pair (the computation is
+    // re-triggered via parameterChanged()); its failure is reported as
+    // failure of that computation
+    void measureReferenceTime ();
+
+signals:
+    // Signals from interface
+    void parameterChanged () override;
+
+    void innerMethodChanged ();
+    void statisticsChanged ();
+
+protected:
+    QList<QObject *> availableMethods;
+    QObject *innerMethod;
+    QMetaObject::Connection innerConnection;
+
+    // Parameters
+    int pyramidLevels;
+    int minDisparity;
+    int numDisparities;
+    int tileSize;
+    int margin;
+
+    // Statistics
+    double processingTime;
+    double searchFraction;
+    double referenceProcessingTime;
+    QAtomicInt referenceRequested;
+
+    QMutex mutex;
+
+    DisparityFormat disparityFormat;
+
+    cv::Mat coarseImg1, coarseImg2;
+    cv::Mat coarseDisparity;
+    cv::Mat coarseEstimate;
+    cv::Mat tileRanges;
+
+    cv::Mat tmpDisparity;
+};
+
+
+} // StereoMethodToolboxCoarseToFine
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
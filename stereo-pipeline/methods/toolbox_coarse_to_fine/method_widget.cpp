@@ -0,0 +1,282 @@
+/*
+ * Toolbox Coarse-to-Fine Matching: method widget
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method_widget.h"
+#include "method.h"
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCoarseToFine {
+
+
+MethodWidget::MethodWidget (Method *method, QWidget *parent)
+    : QWidget(parent),
+      method(method),
+      innerMethodWidget(nullptr)
+{
+    connect(method, &Method::parameterChanged, this, &MethodWidget::updateParameters, Qt::QueuedConnection);
+    connect(method, &Method::innerMethodChanged, this, &MethodWidget::updateInnerMethod, Qt::QueuedConnection);
+    connect(method, &Method::statisticsChanged, this, &MethodWidget::updateStatistics, Qt::QueuedConnection);
+
+    // Build layout
+    QVBoxLayout *baseLayout = new QVBoxLayout(this);
+
+    QLabel *label;
+    QComboBox *comboBox;
+    QSpinBox *spinBox;
+    QPushButton *pushButton;
+    QFrame *line;
+    QString tooltip;
+
+    // Name
+    label = new QLabel("<b><u>Toolbox coarse-to-fine matching</u></b>", this);
+    label->setAlignment(Qt::AlignHCenter);
+
+    baseLayout->addWidget(label);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    baseLayout->addWidget(line);
+
+    // Scrollable area with layout
+    QScrollArea *scrollArea = new QScrollArea(this);
+    scrollArea->setWidgetResizable(true);
+    scrollArea->setWidget(new QWidget(this));
+
+    baseLayout->addWidget(scrollArea);
+
+    QFormLayout *layout = new QFormLayout(scrollArea->widget());
+
+
+    // Inner method
+    tooltip = "Wrapped stereo method. Only methods that support restricted disparity search range can be wrapped.";
+
+    label = new QLabel("Inner method", this);
+    label->setToolTip(tooltip);
+
+    comboBox = new QComboBox(this);
+    for (QObject *object : method->getAvailableMethods()) {
+        comboBox->addItem(qobject_cast<StereoMethod *>(object)->getShortName(), QVariant::fromValue(object));
+    }
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), method, [method, comboBox] (int index) {
+        method->setInnerMethod(comboBox->itemData(index).value<QObject *>());
+    });
+
+    comboBoxInnerMethod = comboBox;
+
+    layout->addRow(label, comboBox);
+
+    // Pyramid levels
+    tooltip = "Number of pyramid levels; the inner method is first run on images downscaled by a factor of 2^levels.";
+
+    label = new QLabel("Pyramid levels", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(1, 4);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setPyramidLevels, Qt::QueuedConnection);
+    spinBoxPyramidLevels = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Min. disparity
+    tooltip = "Minimum possible disparity value at full resolution. The inner method's own disparity range is ignored.";
+
+    label = new QLabel("Min. disparity", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(-9999, 9999);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setMinDisparity, Qt::QueuedConnection);
+    spinBoxMinDisparity = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Num. disparities
+    tooltip = "Maximum disparity minus minimum disparity at full resolution. The value must be divisible by 16.";
+
+    label = new QLabel("Num. disparities", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(16, 16*1000);
+    spinBox->setSingleStep(16); // Must be divisible by 16
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setNumDisparities, Qt::QueuedConnection);
+    spinBoxNumDisparities = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Tile size
+    tooltip = "Size of full-resolution tiles; each tile is searched over the disparity range found in \n"
+              "the corresponding part of the coarse disparity image.";
+
+    label = new QLabel("Tile size", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(16, 512);
+    spinBox->setSingleStep(16);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setTileSize, Qt::QueuedConnection);
+    spinBoxTileSize = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Margin
+    tooltip = "Margin added to both ends of each tile's disparity range.";
+
+    label = new QLabel("Margin", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 64);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setMargin, Qt::QueuedConnection);
+    spinBoxMargin = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
+    // Statistics
+    label = new QLabel("Processing time", this);
+    label->setToolTip("Processing time of last frame.");
+
+    labelProcessingTime = new QLabel(this);
+
+    layout->addRow(label, labelProcessingTime);
+
+    label = new QLabel("Search fraction", this);
+    label->setToolTip("Work performed at full resolution in last frame (pixels times disparities, including the context of matched tiles), relative to the full-range search.");
+
+    labelSearchFraction = new QLabel(this);
+
+    layout->addRow(label, labelSearchFraction);
+
+    label = new QLabel("Speed-up", this);
+    label->setToolTip("Speed-up relative to the plain inner method, run over the full disparity range.");
+
+    labelSpeedup = new QLabel(this);
+
+    layout->addRow(label, labelSpeedup);
+
+    pushButton = new QPushButton("Measure speed-up", this);
+    pushButton->setToolTip("Run the plain inner method on the last image pair to measure the speed-up.");
+    connect(pushButton, &QPushButton::clicked, method, &Method::measureReferenceTime);
+
+    layout->addRow(pushButton);
+
+    // Inner method's configuration
+    groupBoxInnerMethod = new QGroupBox("Inner method parameters", this);
+    new QVBoxLayout(groupBoxInnerMethod);
+
+    baseLayout->addWidget(groupBoxInnerMethod);
+
+    // Update parameters
+    updateInnerMethod();
+    updateParameters();
+    updateStatistics();
+}
+
+MethodWidget::~MethodWidget ()
+{
+}
+
+
+void MethodWidget::updateInnerMethod ()
+{
+    QObject *innerMethod = method->getInnerMethod();
+
+    // Inner method
+    comboBoxInnerMethod->blockSignals(true);
+    comboBoxInnerMethod->setCurrentIndex(comboBoxInnerMethod->findData(QVariant::fromValue(innerMethod)));
+    comboBoxInnerMethod->blockSignals(false);
+
+    // Replace inner method's config widget
+    delete innerMethodWidget;
+    innerMethodWidget = nullptr;
+
+    StereoMethod *iface = qobject_cast<StereoMethod *>(innerMethod);
+    if (iface) {
+        innerMethodWidget = iface->createConfigWidget(groupBoxInnerMethod);
+        groupBoxInnerMethod->layout()->addWidget(innerMethodWidget);
+    }
+    groupBoxInnerMethod->setVisible(innerMethodWidget != nullptr);
+}
+
+void MethodWidget::updateParameters ()
+{
+    // Pyramid levels
+    spinBoxPyramidLevels->blockSignals(true);
+    spinBoxPyramidLevels->setValue(method->getPyramidLevels());
+    spinBoxPyramidLevels->blockSignals(false);
+
+    // Min. disparity
+    spinBoxMinDisparity->blockSignals(true);
+    spinBoxMinDisparity->setValue(method->getMinDisparity());
+    spinBoxMinDisparity->blockSignals(false);
+
+    // Num. disparities
+    spinBoxNumDisparities->blockSignals(true);
+    spinBoxNumDisparities->setValue(method->getNumDisparities());
+    spinBoxNumDisparities->blockSignals(false);
+
+    // Tile size
+    spinBoxTileSize->blockSignals(true);
+    spinBoxTileSize->setValue(method->getTileSize());
+    spinBoxTileSize->blockSignals(false);
+
+    // Margin
+    spinBoxMargin->blockSignals(true);
+    spinBoxMargin->setValue(method->getMargin());
+    spinBoxMargin->blockSignals(false);
+}
+
+void MethodWidget::updateStatistics ()
+{
+    const double time = method->getProcessingTime();
+    const double referenceTime = method->getReferenceProcessingTime();
+
+    labelProcessingTime->setText(QStringLiteral("%1 ms").arg(time, 0, 'f', 1));
+    labelSearchFraction->setText(QStringLiteral("%1 %").arg(100*method->getSearchFraction(), 0, 'f', 1));
+
+    if (referenceTime > 0 && time > 0) {
+        labelSpeedup->setText(QStringLiteral("%1x (plain: %2 ms)").arg(referenceTime / time, 0, 'f', 2).arg(referenceTime, 0, 'f', 1));
+    } else {
+        labelSpeedup->setText("n/a");
+    }
+}
+
+
+} // StereoMethodToolboxCoarseToFine
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,71 @@
+/*
+ * Toolbox Coarse-to-Fine Matching: method widget
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_COARSE_TO_FINE__METHOD_WIDGET_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_COARSE_TO_FINE__METHOD_WIDGET_H
+
+#include <QtWidgets>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxCoarseToFine {
+
+
+class Method;
+
+class MethodWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    MethodWidget (Method *method, QWidget *parent = nullptr);
+    virtual ~MethodWidget ();
+
+protected:
+    void updateInnerMethod ();
+    void updateParameters ();
+    void updateStatistics ();
+
+protected:
+    Method *method;
+
+    QComboBox *comboBoxInnerMethod;
+    QSpinBox *spinBoxPyramidLevels;
+    QSpinBox *spinBoxMinDisparity;
+    QSpinBox *spinBoxNumDisparities;
+    QSpinBox *spinBoxTileSize;
+    QSpinBox *spinBoxMargin;
+
+    QLabel *labelProcessingTime;
+    QLabel *labelSearchFraction;
+    QLabel *labelSpeedup;
+
+    QGroupBox *groupBoxInnerMethod;
+    QWidget *innerMethodWidget;
+};
+
+
+} // StereoMethodToolboxCoarseToFine
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+#endif
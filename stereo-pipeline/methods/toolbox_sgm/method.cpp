@@ -0,0 +1,343 @@
+/*
+ * Toolbox Semi-Global Matching: method
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method.h"
+#include "method_widget.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/imgproc.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+Method::Method (QObject *parent)
+    : QObject(parent), StereoMethod2()
+{
+}
+
+Method::~Method ()
+{
+}
+
+
+// *********************************************************************
+// *                       StereoMethod interface                      *
+// *********************************************************************
+QString Method::getShortName () const
+{
+    return "SGM";
+}
+
+QWidget *Method::createConfigWidget (QWidget *parent)
+{
+    return new MethodWidget(this, parent);
+}
+
+
+// *********************************************************************
+// *                    Disparity image computation                    *
+// *********************************************************************
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities)
+{
+    // Basic interface; disparity refers to our internal buffer
+    DisparityFormat format;
+    computeDisparity(img1, img2, tmpDisparity, numDisparities, format);
+    disparity = tmpDisparity;
+}
+
+void Method::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    // Convert to grayscale
+    if (img1.channels() == 3) {
+        cv::cvtColor(img1, tmpImg1, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg1 = img1;
+    }
+
+    if (img2.channels() == 3) {
+        cv::cvtColor(img2, tmpImg2, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg2 = img2;
+    }
+
+    // Compute disparity image, directly into output buffer
+    QMutexLocker locker(&mutex);
+    sgm.compute(tmpImg1, tmpImg2, disparity);
+    numDisparities = sgm.getNumDisparities();
+    locker.unlock();
+
+    // CV_16S disparity with four fractional bits
+    format = DisparityFormat(1/16.0);
+}
+
+DisparityFormat Method::getDisparityFormat () const
+{
+    return DisparityFormat(1/16.0);
+}
+
+
+// *********************************************************************
+// *                      StereoMethod2 interface                      *
+// *********************************************************************
+int Method::getCapabilities () const
+{
+    return CapabilityRegionOfInterest | CapabilityPreallocation | CapabilityDisparityRange;
+}
+
+int Method::getPreferredInputType () const
+{
+    return CV_8UC1;
+}
+
+void Method::prepare (const cv::Size &imageSize, int imageType)
+{
+    Q_UNUSED(imageType);
+
+    QMutexLocker locker(&mutex);
+    sgm.prepare(imageSize);
+}
+
+void Method::computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format)
+{
+    // Convert to grayscale
+    if (img1.channels() == 3) {
+        cv::cvtColor(img1, tmpImg1, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg1 = img1;
+    }
+
+    if (img2.channels() == 3) {
+        cv::cvtColor(img2, tmpImg2, cv::COLOR_BGR2GRAY);
+    } else {
+        tmpImg2 = img2;
+    }
+
+    // The range is passed to the engine, so the configured range is
+    // left untouched and the cost volume can be re-used for the same
+    // range
+    QMutexLocker locker(&mutex);
+    sgm.compute(tmpImg1, tmpImg2, disparity, minDisparity, numDisparities);
+    locker.unlock();
+
+    // CV_16S disparity with four fractional bits
+    format = DisparityFormat(1/16.0);
+}
+
+void Method::getDisparityRange (int &minDisparity, int &numDisparities) const
+{
+    minDisparity = sgm.getMinDisparity();
+    numDisparities = sgm.getNumDisparities();
+}
+
+
+// *********************************************************************
+// *                     Parameter import/export                       *
+// *********************************************************************
+void Method::loadParameters (const QString &filename)
+{
+    // Open storage
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for reading!").arg(filename));
+    }
+
+    // Validate data type
+    QString dataType = QString::fromStdString(storage["DataType"]);
+    if (dataType.compare("StereoMethodParameters")) {
+        throw Exception(QStringLiteral("Invalid stereo method parameters configuration!"));
+    }
+
+    // Validate method name
+    QString storedName = QString::fromStdString(storage["MethodName"]);
+    if (storedName.compare(getShortName())) {
+        throw Exception(QStringLiteral("Invalid configuration for method '%1'!").arg(getShortName()));
+    }
+
+    // Load parameters
+    QMutexLocker locker(&mutex);
+
+    sgm.setCostType((int)storage["CostType"]);
+    sgm.setMinDisparity((int)storage["MinDisparity"]);
+    sgm.setNumDisparities((int)storage["NumDisparities"]);
+
+    sgm.setP1((int)storage["P1"]);
+    sgm.setP2((int)storage["P2"]);
+    sgm.setNumPaths((int)storage["NumPaths"]);
+
+    sgm.setUniquenessRatio((int)storage["UniquenessRatio"]);
+
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+void Method::saveParameters (const QString &filename) const
+{
+    cv::FileStorage storage(filename.toStdString(), cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw Exception(QStringLiteral("Cannot open file '%1' for writing!").arg(filename));
+    }
+
+    // Data type
+    storage << "DataType" << "StereoMethodParameters";
+
+    // Store method name, so it can be validate upon loading
+    storage << "MethodName" << getShortName().toStdString();
+
+    // Save parameters
+    storage << "CostType" << sgm.getCostType();
+    storage << "MinDisparity" << sgm.getMinDisparity();
+    storage << "NumDisparities" << sgm.getNumDisparities();
+
+    storage << "P1" << sgm.getP1();
+    storage << "P2" << sgm.getP2();
+    storage << "NumPaths" << sgm.getNumPaths();
+
+    storage << "UniquenessRatio" << sgm.getUniquenessRatio();
+}
+
+
+// *********************************************************************
+// *                         Method parameters                         *
+// *********************************************************************
+// Matching cost type; changing it invalidates the cost volume
+int Method::getCostType () const
+{
+    return sgm.getCostType();
+}
+
+void Method::setCostType (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setCostType(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Minimum disparity; changing it invalidates the cost volume
+int Method::getMinDisparity () const
+{
+    return sgm.getMinDisparity();
+}
+
+void Method::setMinDisparity (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setMinDisparity(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Number of disparity levels; must be divisible by 16. Changing it
+// invalidates the cost volume
+int Method::getNumDisparities () const
+{
+    return sgm.getNumDisparities();
+}
+
+void Method::setNumDisparities (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setNumDisparities(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// P1; penalty for disparity change by one. Changing it re-runs only
+// the aggregation
+int Method::getP1 () const
+{
+    return sgm.getP1();
+}
+
+void Method::setP1 (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setP1(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// P2; penalty for disparity change by more than one. Changing it
+// re-runs only the aggregation
+int Method::getP2 () const
+{
+    return sgm.getP2();
+}
+
+void Method::setP2 (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setP2(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Number of aggregation paths (4 or 8)
+int Method::getNumPaths () const
+{
+    return sgm.getNumPaths();
+}
+
+void Method::setNumPaths (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setNumPaths(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+// Uniqueness ratio; changing it re-runs only the selection
+int Method::getUniquenessRatio () const
+{
+    return sgm.getUniquenessRatio();
+}
+
+void Method::setUniquenessRatio (int value)
+{
+    // Set
+    QMutexLocker locker(&mutex);
+    sgm.setUniquenessRatio(value);
+    locker.unlock();
+
+    emit parameterChanged();
+}
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
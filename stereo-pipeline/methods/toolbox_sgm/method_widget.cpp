@@ -0,0 +1,246 @@
+/*
+ * Toolbox Semi-Global Matching: method widget
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method_widget.h"
+#include "method.h"
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+MethodWidget::MethodWidget (Method *method, QWidget *parent)
+    : QWidget(parent),
+      method(method)
+{
+    connect(method, &Method::parameterChanged, this, &MethodWidget::updateParameters, Qt::QueuedConnection);
+
+    // Build layout
+    QVBoxLayout *baseLayout = new QVBoxLayout(this);
+
+    QLabel *label;
+    QComboBox *comboBox;
+    QSpinBox *spinBox;
+    QFrame *line;
+    QString tooltip;
+
+    // Name
+    label = new QLabel("<b><u>Toolbox semi-global matching</u></b>", this);
+    label->setAlignment(Qt::AlignHCenter);
+
+    baseLayout->addWidget(label);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    baseLayout->addWidget(line);
+
+    // Scrollable area with layout
+    QScrollArea *scrollArea = new QScrollArea(this);
+    scrollArea->setWidgetResizable(true);
+    scrollArea->setWidget(new QWidget(this));
+
+    baseLayout->addWidget(scrollArea);
+
+    QFormLayout *layout = new QFormLayout(scrollArea->widget());
+
+
+    // Cost type
+    tooltip = "Pixel-wise matching cost. The cost volume is cached, and is recomputed only when input images \n"
+              "or matching parameters (cost type and disparity range) change.";
+
+    label = new QLabel("Matching cost", this);
+    label->setToolTip(tooltip);
+
+    comboBox = new QComboBox(this);
+    comboBox->addItem("Census", SgmEngine::CostCensus);
+    comboBox->setItemData(0, "Hamming distance between 9x7 census transforms; robust to radiometric differences.", Qt::ToolTipRole);
+    comboBox->addItem("Birchfield-Tomasi", SgmEngine::CostBirchfieldTomasi);
+    comboBox->setItemData(1, "Sampling-insensitive absolute intensity difference.", Qt::ToolTipRole);
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), method, [method, comboBox] (int index) {
+        method->setCostType(comboBox->itemData(index).toInt());
+    }, Qt::QueuedConnection);
+
+    comboBoxCostType = comboBox;
+
+    layout->addRow(label, comboBox);
+
+    // Min. disparity
+    tooltip = "Minimum possible disparity value. Normally, it is zero but sometimes rectification algorithms \n"
+              "can shift images, so this parameter needs to be adjusted accordingly.";
+
+    label = new QLabel("Min. disparity", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(-9999, 9999);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setMinDisparity, Qt::QueuedConnection);
+    spinBoxMinDisparity = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Num. disparities
+    tooltip = "Maximum disparity minus minimum disparity. The value must be divisible by 16.";
+
+    label = new QLabel("Num. disparities", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(16, 16*1000);
+    spinBox->setSingleStep(16); // Must be divisible by 16
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setNumDisparities, Qt::QueuedConnection);
+    spinBoxNumDisparities = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
+    // P1
+    tooltip = "Penalty on the disparity change by plus or minus 1 between neighbor pixels. The algorithm \n"
+              "requires P2 > P1. Changing the penalties re-runs only the cost aggregation.";
+
+    label = new QLabel("P1", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 65535);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setP1, Qt::QueuedConnection);
+    spinBoxP1 = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // P2
+    tooltip = "Penalty on the disparity change by more than 1 between neighbor pixels. The algorithm \n"
+              "requires P2 > P1. Changing the penalties re-runs only the cost aggregation.";
+
+    label = new QLabel("P2", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 65535);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setP2, Qt::QueuedConnection);
+    spinBoxP2 = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Number of paths
+    tooltip = "Number of directions along which the costs are aggregated.";
+
+    label = new QLabel("Paths", this);
+    label->setToolTip(tooltip);
+
+    comboBox = new QComboBox(this);
+    comboBox->addItem("4", 4);
+    comboBox->setItemData(0, "Horizontal and vertical paths.", Qt::ToolTipRole);
+    comboBox->addItem("8", 8);
+    comboBox->setItemData(1, "Horizontal, vertical and diagonal paths.", Qt::ToolTipRole);
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), method, [method, comboBox] (int index) {
+        method->setNumPaths(comboBox->itemData(index).toInt());
+    }, Qt::QueuedConnection);
+
+    comboBoxNumPaths = comboBox;
+
+    layout->addRow(label, comboBox);
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
+    // Uniqueness ratio
+    tooltip = "Margin in percentage by which the best (minimum) aggregated cost should \"win\" the second best \n"
+              "value to consider the found match correct. Set to 0 to disable the check.";
+
+    label = new QLabel("Uniqueness ratio", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 100);
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), method, &Method::setUniquenessRatio, Qt::QueuedConnection);
+    spinBoxUniquenessRatio = spinBox;
+
+    layout->addRow(label, spinBox);
+
+    // Update parameters
+    updateParameters();
+}
+
+MethodWidget::~MethodWidget ()
+{
+}
+
+
+void MethodWidget::updateParameters ()
+{
+    // Cost type
+    comboBoxCostType->blockSignals(true);
+    comboBoxCostType->setCurrentIndex(comboBoxCostType->findData(method->getCostType()));
+    comboBoxCostType->blockSignals(false);
+
+    // Min. disparity
+    spinBoxMinDisparity->blockSignals(true);
+    spinBoxMinDisparity->setValue(method->getMinDisparity());
+    spinBoxMinDisparity->blockSignals(false);
+
+    // Num. disparities
+    spinBoxNumDisparities->blockSignals(true);
+    spinBoxNumDisparities->setValue(method->getNumDisparities());
+    spinBoxNumDisparities->blockSignals(false);
+
+    // P1
+    spinBoxP1->blockSignals(true);
+    spinBoxP1->setValue(method->getP1());
+    spinBoxP1->blockSignals(false);
+
+    // P2
+    spinBoxP2->blockSignals(true);
+    spinBoxP2->setValue(method->getP2());
+    spinBoxP2->blockSignals(false);
+
+    // Number of paths
+    comboBoxNumPaths->blockSignals(true);
+    comboBoxNumPaths->setCurrentIndex(comboBoxNumPaths->findData(method->getNumPaths()));
+    comboBoxNumPaths->blockSignals(false);
+
+    // Uniqueness ratio
+    spinBoxUniquenessRatio->blockSignals(true);
+    spinBoxUniquenessRatio->setValue(method->getUniquenessRatio());
+    spinBoxUniquenessRatio->blockSignals(false);
+}
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
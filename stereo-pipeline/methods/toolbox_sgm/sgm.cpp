@@ -0,0 +1,850 @@
+/*
+ * Toolbox Semi-Global Matching: matching engine
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sgm.h"
+#include "sgm_avx2.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+// Path cost buffers hold one sentinel (maximum value) element in front
+// of and behind the actual data, so that neighbouring-disparity terms
+// can be loaded without boundary checks; the data is offset by eight
+// elements to keep it aligned
+static const int PathBufferOffset = 8;
+static const int PathBufferPadding = 16;
+
+// Census window (9x7) yields 62-bit descriptors; invalid matches (i.e.,
+// outside the right image) are assigned maximum cost of corresponding
+// cost type
+static const int CensusWindowHalfWidth = 4;
+static const int CensusWindowHalfHeight = 3;
+static const uchar CensusInvalidCost = 62;
+static const uchar BirchfieldTomasiInvalidCost = UCHAR_MAX;
+
+
+// *********************************************************************
+// *                          Matching costs                           *
+// *********************************************************************
+// 9x7 census transform; the border is replicated
+class CensusBody : public cv::ParallelLoopBody
+{
+public:
+    CensusBody (const cv::Mat &image, quint64 *census)
+        : image(image),
+          census(census)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = image.cols;
+        const int height = image.rows;
+
+        for (int y = range.start; y < range.end; y++) {
+            // Row pointers with replicated border
+            const uchar *rows[2*CensusWindowHalfHeight + 1];
+            for (int i = -CensusWindowHalfHeight; i <= CensusWindowHalfHeight; i++) {
+                rows[i + CensusWindowHalfHeight] = image.ptr<uchar>(std::min(std::max(y + i, 0), height - 1));
+            }
+
+            quint64 *censusRow = census + y*width;
+
+            for (int x = 0; x < width; x++) {
+                const uchar center = rows[CensusWindowHalfHeight][x];
+                quint64 descriptor = 0;
+
+                for (int i = 0; i < 2*CensusWindowHalfHeight + 1; i++) {
+                    for (int j = -CensusWindowHalfWidth; j <= CensusWindowHalfWidth; j++) {
+                        if (i == CensusWindowHalfHeight && j == 0) {
+                            continue; // Skip center
+                        }
+                        const int xx = std::min(std::max(x + j, 0), width - 1);
+                        descriptor = (descriptor << 1) | (rows[i][xx] < center);
+                    }
+                }
+
+                censusRow[x] = descriptor;
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &image;
+    quint64 *census;
+};
+
+
+// Range of disparity indices for which the matching pixel x - minD - d
+// lies within the right image
+static inline void getValidDisparityRange (int x, int width, int minDisparity, int numDisparities, int &dLo, int &dHi)
+{
+    dLo = std::max(0, x - minDisparity - width + 1);
+    dHi = std::min(numDisparities - 1, x - minDisparity);
+}
+
+
+// Hamming distance between census descriptors
+class CensusCostBody : public cv::ParallelLoopBody
+{
+public:
+    CensusCostBody (const quint64 *census1, const quint64 *census2, int width, int minDisparity, int numDisparities, cv::Mat &costVolume)
+        : census1(census1),
+          census2(census2),
+          width(width),
+          minDisparity(minDisparity),
+          numDisparities(numDisparities),
+          costVolume(costVolume)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        for (int y = range.start; y < range.end; y++) {
+            const quint64 *census1Row = census1 + y*width;
+            const quint64 *census2Row = census2 + y*width;
+            uchar *costRow = costVolume.ptr<uchar>(y);
+
+            for (int x = 0; x < width; x++) {
+                uchar *cost = costRow + x*numDisparities;
+                int dLo, dHi;
+                getValidDisparityRange(x, width, minDisparity, numDisparities, dLo, dHi);
+
+                if (dLo > dHi) {
+                    std::fill(cost, cost + numDisparities, CensusInvalidCost);
+                    continue;
+                }
+
+                std::fill(cost, cost + dLo, CensusInvalidCost);
+
+                const quint64 descriptor = census1Row[x];
+                const quint64 *match = census2Row + x - minDisparity; // Disparity zero
+                for (int d = dLo; d <= dHi; d++) {
+                    cost[d] = static_cast<uchar>(qPopulationCount(descriptor ^ match[-d]));
+                }
+
+                std::fill(cost + dHi + 1, cost + numDisparities, CensusInvalidCost);
+            }
+        }
+    }
+
+protected:
+    const quint64 *census1;
+    const quint64 *census2;
+    int width;
+    int minDisparity;
+    int numDisparities;
+    cv::Mat &costVolume;
+};
+
+
+// Birchfield-Tomasi sampling-insensitive dissimilarity. The right-image
+// row and its half-sample extrema are stored in reversed order, so
+// that consecutive disparities map to consecutive elements, which
+// allows processing of sixteen disparities at once
+class BirchfieldTomasiCostBody : public cv::ParallelLoopBody
+{
+public:
+    BirchfieldTomasiCostBody (const cv::Mat &image1, const cv::Mat &image2, int minDisparity, int numDisparities, cv::Mat &costVolume)
+        : image1(image1),
+          image2(image2),
+          minDisparity(minDisparity),
+          numDisparities(numDisparities),
+          costVolume(costVolume)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = image1.cols;
+
+        std::vector<uchar> buffer(6*width);
+        uchar *value1 = &buffer[0];
+        uchar *min1 = &buffer[width];
+        uchar *max1 = &buffer[2*width];
+        uchar *value2 = &buffer[3*width]; // Reversed
+        uchar *min2 = &buffer[4*width]; // Reversed
+        uchar *max2 = &buffer[5*width]; // Reversed
+
+        for (int y = range.start; y < range.end; y++) {
+            computeExtrema(image1.ptr<uchar>(y), width, value1, min1, max1, false);
+            computeExtrema(image2.ptr<uchar>(y), width, value2, min2, max2, true);
+
+            uchar *costRow = costVolume.ptr<uchar>(y);
+
+            for (int x = 0; x < width; x++) {
+                uchar *cost = costRow + x*numDisparities;
+                int dLo, dHi;
+                getValidDisparityRange(x, width, minDisparity, numDisparities, dLo, dHi);
+
+                if (dLo > dHi) {
+                    std::fill(cost, cost + numDisparities, BirchfieldTomasiInvalidCost);
+                    continue;
+                }
+
+                std::fill(cost, cost + dLo, BirchfieldTomasiInvalidCost);
+
+                // Index of matching pixel x - minD - d in reversed arrays
+                const int offset = width - 1 - x + minDisparity;
+                const uchar v1 = value1[x];
+                const uchar lo1 = min1[x];
+                const uchar hi1 = max1[x];
+
+                int d = dLo;
+#if CV_SIMD128
+                const cv::v_uint8x16 vValue1 = cv::v_setall_u8(v1);
+                const cv::v_uint8x16 vMin1 = cv::v_setall_u8(lo1);
+                const cv::v_uint8x16 vMax1 = cv::v_setall_u8(hi1);
+
+                for (; d <= dHi - 15; d += 16) {
+                    const cv::v_uint8x16 vValue2 = cv::v_load(value2 + offset + d);
+                    const cv::v_uint8x16 vMin2 = cv::v_load(min2 + offset + d);
+                    const cv::v_uint8x16 vMax2 = cv::v_load(max2 + offset + d);
+
+                    // Saturating subtraction clamps negative terms to zero
+                    const cv::v_uint8x16 c1 = cv::v_max(vValue1 - vMax2, vMin2 - vValue1);
+                    const cv::v_uint8x16 c2 = cv::v_max(vValue2 - vMax1, vMin1 - vValue2);
+
+                    cv::v_store(cost + d, cv::v_min(c1, c2));
+                }
+#endif
+                for (; d <= dHi; d++) {
+                    const int v2 = value2[offset + d];
+                    const int c1 = std::max(std::max(0, v1 - max2[offset + d]), min2[offset + d] - v1);
+                    const int c2 = std::max(std::max(0, v2 - hi1), lo1 - v2);
+                    cost[d] = static_cast<uchar>(std::min(c1, c2));
+                }
+
+                std::fill(cost + dHi + 1, cost + numDisparities, BirchfieldTomasiInvalidCost);
+            }
+        }
+    }
+
+protected:
+    // Computes minimum and maximum of half-sample interpolated values
+    // around each pixel, optionally storing the row in reversed order
+    static void computeExtrema (const uchar *row, int width, uchar *value, uchar *minimum, uchar *maximum, bool reverse)
+    {
+        for (int x = 0; x < width; x++) {
+            const int v = row[x];
+            const int left = (v + row[std::max(x - 1, 0)]) >> 1;
+            const int right = (v + row[std::min(x + 1, width - 1)]) >> 1;
+
+            const int i = reverse ? width - 1 - x : x;
+            value[i] = static_cast<uchar>(v);
+            minimum[i] = static_cast<uchar>(std::min(v, std::min(left, right)));
+            maximum[i] = static_cast<uchar>(std::max(v, std::max(left, right)));
+        }
+    }
+
+protected:
+    const cv::Mat &image1;
+    const cv::Mat &image2;
+    int minDisparity;
+    int numDisparities;
+    cv::Mat &costVolume;
+};
+
+
+// *********************************************************************
+// *                          Cost aggregation                         *
+// *********************************************************************
+// Single step along the path:
+//  L(d) = C(d) + min(Lp(d), Lp(d-1) + P1, Lp(d+1) + P1, min(Lp) + P2) - min(Lp)
+// The result is stored in current path buffer and (saturated-)added
+// to the sum; returns minimum of L. Number of disparities must be
+// multiple of 16
+static inline ushort aggregatePixel (const uchar *cost, const ushort *prev, ushort prevMin, ushort *current, ushort *sum,
+                                     int numDisparities, ushort P1, ushort P2)
+{
+    const ushort prevMinP2 = cv::saturate_cast<ushort>(prevMin + P2);
+
+#if CV_SIMD128
+    const cv::v_uint16x8 vP1 = cv::v_setall_u16(P1);
+    const cv::v_uint16x8 vPrevMinP2 = cv::v_setall_u16(prevMinP2);
+    const cv::v_uint16x8 vPrevMin = cv::v_setall_u16(prevMin);
+    cv::v_uint16x8 vMin = cv::v_setall_u16(USHRT_MAX);
+
+    // 16-bit operations saturate
+    for (int d = 0; d < numDisparities; d += 8) {
+        const cv::v_uint16x8 c = cv::v_load_expand(cost + d);
+
+        const cv::v_uint16x8 t = cv::v_min(cv::v_min(cv::v_load(prev + d), vPrevMinP2),
+                                           cv::v_min(cv::v_load(prev + d - 1) + vP1, cv::v_load(prev + d + 1) + vP1));
+        const cv::v_uint16x8 l = c + (t - vPrevMin);
+
+        cv::v_store(current + d, l);
+        cv::v_store(sum + d, cv::v_load(sum + d) + l);
+
+        vMin = cv::v_min(vMin, l);
+    }
+
+    return cv::v_reduce_min(vMin);
+#else
+    ushort minimum = USHRT_MAX;
+
+    for (int d = 0; d < numDisparities; d++) {
+        int t = std::min(std::min<int>(prev[d], prevMinP2), std::min(prev[d - 1] + P1, prev[d + 1] + P1));
+        ushort l = cv::saturate_cast<ushort>(cost[d] + t - prevMin);
+
+        current[d] = l;
+        sum[d] = cv::saturate_cast<ushort>(sum[d] + l);
+
+        minimum = std::min(minimum, l);
+    }
+
+    return minimum;
+#endif
+}
+
+
+// Aggregation step implementation; 128-bit universal intrinsics above,
+// or AVX2, which is chosen at run time if supported by the CPU
+typedef ushort (*AggregatePixelFunction) (const uchar *cost, const ushort *prev, ushort prevMin, ushort *current, ushort *sum,
+                                          int numDisparities, ushort P1, ushort P2);
+
+static AggregatePixelFunction getAggregatePixelFunction ()
+{
+#ifdef HAVE_SGM_AVX2
+    if (cv::checkHardwareSupport(CV_CPU_AVX2)) {
+        return &aggregatePixelAvx2;
+    }
+#endif
+    return &aggregatePixel;
+}
+
+
+// Horizontal paths (left-to-right and right-to-left); rows are
+// independent, so the pass is parallelized over row bands. This is
+// the first pass, so it also initializes the sum volume
+class HorizontalPassBody : public cv::ParallelLoopBody
+{
+public:
+    HorizontalPassBody (const cv::Mat &costVolume, cv::Mat &sumVolume, const ushort *start, int numDisparities, int P1, int P2, AggregatePixelFunction aggregate)
+        : costVolume(costVolume),
+          sumVolume(sumVolume),
+          start(start),
+          numDisparities(numDisparities),
+          P1(P1),
+          P2(P2),
+          aggregate(aggregate)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = costVolume.cols / numDisparities;
+        const int stride = numDisparities + PathBufferPadding;
+
+        // Ping-pong path buffers, with sentinels
+        std::vector<ushort> buffers(2*stride, USHRT_MAX);
+        ushort *buffer[2] = { &buffers[PathBufferOffset], &buffers[stride + PathBufferOffset] };
+
+        for (int y = range.start; y < range.end; y++) {
+            const uchar *costRow = costVolume.ptr<uchar>(y);
+            ushort *sumRow = sumVolume.ptr<ushort>(y);
+
+            std::fill(sumRow, sumRow + width*numDisparities, 0);
+
+            // Left to right
+            const ushort *prev = start;
+            ushort prevMin = 0;
+            for (int x = 0; x < width; x++) {
+                ushort *current = buffer[x & 1];
+                prevMin = aggregate(costRow + x*numDisparities, prev, prevMin, current, sumRow + x*numDisparities, numDisparities, P1, P2);
+                prev = current;
+            }
+
+            // Right to left
+            prev = start;
+            prevMin = 0;
+            for (int x = width - 1; x >= 0; x--) {
+                ushort *current = buffer[x & 1];
+                prevMin = aggregate(costRow + x*numDisparities, prev, prevMin, current, sumRow + x*numDisparities, numDisparities, P1, P2);
+                prev = current;
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &costVolume;
+    cv::Mat &sumVolume;
+    const ushort *start;
+    int numDisparities;
+    ushort P1;
+    ushort P2;
+    AggregatePixelFunction aggregate;
+};
+
+
+// Single row of a vertical sweep (top-down or bottom-up), covering the
+// vertical and (optionally) both diagonal paths. Within the row, each
+// pixel depends only on the previous row, so the row is parallelized
+// over column bands
+class SweepRowBody : public cv::ParallelLoopBody
+{
+public:
+    SweepRowBody (const uchar *costRow, ushort *sumRow,
+                  const ushort *prevBuffers, const ushort *prevMinimums, ushort *currentBuffers, ushort *currentMinimums,
+                  int numSweepPaths, bool firstRow, int width, const ushort *start, int numDisparities, int P1, int P2, AggregatePixelFunction aggregate)
+        : costRow(costRow),
+          sumRow(sumRow),
+          prevBuffers(prevBuffers),
+          prevMinimums(prevMinimums),
+          currentBuffers(currentBuffers),
+          currentMinimums(currentMinimums),
+          numSweepPaths(numSweepPaths),
+          firstRow(firstRow),
+          width(width),
+          start(start),
+          numDisparities(numDisparities),
+          P1(P1),
+          P2(P2),
+          aggregate(aggregate)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        // Horizontal offsets of the previous pixel: vertical path and
+        // both diagonals
+        static const int offsets[3] = { 0, 1, -1 };
+        const int stride = numDisparities + PathBufferPadding;
+
+        for (int x = range.start; x < range.end; x++) {
+            for (int p = 0; p < numSweepPaths; p++) {
+                const int px = x - offsets[p];
+
+                const ushort *prev;
+                ushort prevMin;
+                if (firstRow || px < 0 || px >= width) {
+                    prev = start;
+                    prevMin = 0;
+                } else {
+                    prev = prevBuffers + (p*width + px)*stride;
+                    prevMin = prevMinimums[p*width + px];
+                }
+
+                currentMinimums[p*width + x] = aggregate(costRow + x*numDisparities, prev, prevMin, currentBuffers + (p*width + x)*stride,
+                                                         sumRow + x*numDisparities, numDisparities, P1, P2);
+            }
+        }
+    }
+
+protected:
+    const uchar *costRow;
+    ushort *sumRow;
+    const ushort *prevBuffers;
+    const ushort *prevMinimums;
+    ushort *currentBuffers;
+    ushort *currentMinimums;
+    int numSweepPaths;
+    bool firstRow;
+    int width;
+    const ushort *start;
+    int numDisparities;
+    ushort P1;
+    ushort P2;
+    AggregatePixelFunction aggregate;
+};
+
+
+// *********************************************************************
+// *                        Disparity selection                        *
+// *********************************************************************
+// Winner-takes-all with uniqueness check and parabolic sub-pixel
+// refinement; output is in 1/16 pixel units
+class SelectionBody : public cv::ParallelLoopBody
+{
+public:
+    SelectionBody (const cv::Mat &sumVolume, int minDisparity, int numDisparities, int uniquenessRatio, cv::Mat &disparity)
+        : sumVolume(sumVolume),
+          minDisparity(minDisparity),
+          numDisparities(numDisparities),
+          uniquenessRatio(uniquenessRatio),
+          disparity(disparity)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const short invalid = static_cast<short>((minDisparity - 1)*16);
+
+        for (int y = range.start; y < range.end; y++) {
+            const ushort *sumRow = sumVolume.ptr<ushort>(y);
+            short *disparityRow = disparity.ptr<short>(y);
+
+            for (int x = 0; x < disparity.cols; x++) {
+                const ushort *sum = sumRow + x*numDisparities;
+
+                // Minimum
+                int bestD = 0;
+                int bestSum = sum[0];
+                for (int d = 1; d < numDisparities; d++) {
+                    if (sum[d] < bestSum) {
+                        bestSum = sum[d];
+                        bestD = d;
+                    }
+                }
+
+                // Uniqueness check: minimum must win over all costs that
+                // are not its immediate neighbours
+                bool unique = true;
+                if (uniquenessRatio > 0) {
+                    for (int d = 0; d < numDisparities; d++) {
+                        if (sum[d]*(100 - uniquenessRatio) < bestSum*100 && std::abs(d - bestD) > 1) {
+                            unique = false;
+                            break;
+                        }
+                    }
+                }
+
+                if (!unique) {
+                    disparityRow[x] = invalid;
+                    continue;
+                }
+
+                // Sub-pixel refinement
+                int value = bestD*16;
+                if (bestD > 0 && bestD < numDisparities - 1) {
+                    const int denom2 = std::max(sum[bestD - 1] + sum[bestD + 1] - 2*bestSum, 1);
+                    value += ((sum[bestD - 1] - sum[bestD + 1])*16 + denom2) / (denom2*2);
+                }
+
+                disparityRow[x] = static_cast<short>(minDisparity*16 + value);
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &sumVolume;
+    int minDisparity;
+    int numDisparities;
+    int uniquenessRatio;
+    cv::Mat &disparity;
+};
+
+
+// *********************************************************************
+// *                              Engine                               *
+// *********************************************************************
+SgmEngine::SgmEngine ()
+    : costType(CostCensus),
+      minDisparity(0),
+      numDisparities(64),
+      P1(10),
+      P2(120),
+      numPaths(8),
+      uniquenessRatio(10),
+      costVolumeValid(false),
+      aggregationValid(false),
+      volumeMinDisparity(0),
+      volumeNumDisparities(0)
+{
+}
+
+
+// Cost type
+void SgmEngine::setCostType (int type)
+{
+    if (type != CostCensus && type != CostBirchfieldTomasi) {
+        type = CostCensus;
+    }
+
+    if (type != costType) {
+        costType = type;
+        costVolumeValid = false;
+    }
+}
+
+int SgmEngine::getCostType () const
+{
+    return costType;
+}
+
+// Minimum disparity; the cost volume is invalidated on next compute(),
+// if it was computed for a different range
+void SgmEngine::setMinDisparity (int value)
+{
+    minDisparity = value;
+}
+
+int SgmEngine::getMinDisparity () const
+{
+    return minDisparity;
+}
+
+// Number of disparities; must be divisible by 16
+void SgmEngine::setNumDisparities (int value)
+{
+    numDisparities = std::max(16, (value + 8) & -16);
+}
+
+int SgmEngine::getNumDisparities () const
+{
+    return numDisparities;
+}
+
+// Penalty for disparity change by one
+void SgmEngine::setP1 (int value)
+{
+    value = std::min(std::max(value, 0), static_cast<int>(USHRT_MAX));
+
+    if (value != P1) {
+        P1 = value;
+        aggregationValid = false;
+    }
+}
+
+int SgmEngine::getP1 () const
+{
+    return P1;
+}
+
+// Penalty for disparity change by more than one
+void SgmEngine::setP2 (int value)
+{
+    value = std::min(std::max(value, 0), static_cast<int>(USHRT_MAX));
+
+    if (value != P2) {
+        P2 = value;
+        aggregationValid = false;
+    }
+}
+
+int SgmEngine::getP2 () const
+{
+    return P2;
+}
+
+// Number of aggregation paths: 4 or 8
+void SgmEngine::setNumPaths (int value)
+{
+    if (value != 4 && value != 8) {
+        value = 8;
+    }
+
+    if (value != numPaths) {
+        numPaths = value;
+        aggregationValid = false;
+    }
+}
+
+int SgmEngine::getNumPaths () const
+{
+    return numPaths;
+}
+
+// Uniqueness ratio; affects only the selection
+void SgmEngine::setUniquenessRatio (int value)
+{
+    uniquenessRatio = std::min(std::max(value, 0), 100);
+}
+
+int SgmEngine::getUniquenessRatio () const
+{
+    return uniquenessRatio;
+}
+
+
+// *********************************************************************
+// *                            Processing                             *
+// *********************************************************************
+void SgmEngine::prepare (const cv::Size &imageSize)
+{
+    allocateBuffers(imageSize, numDisparities);
+}
+
+void SgmEngine::allocateBuffers (const cv::Size &imageSize, int numDisparities)
+{
+    const int width = imageSize.width;
+    const int height = imageSize.height;
+    const int stride = numDisparities + PathBufferPadding;
+
+    // Volumes; storage is enlarged only if necessary. The cost volume
+    // is invalidated if its view changes
+    const size_t volumeSize = static_cast<size_t>(height)*width*numDisparities;
+    const bool storageChanged = costStorage.size() < volumeSize;
+    if (storageChanged) {
+        costStorage.resize(volumeSize);
+        sumStorage.resize(volumeSize);
+    }
+
+    if (storageChanged || costVolume.rows != height || costVolume.cols != width*numDisparities) {
+        costVolume = cv::Mat(height, width*numDisparities, CV_8U, costStorage.data());
+        sumVolume = cv::Mat(height, width*numDisparities, CV_16U, sumStorage.data());
+        costVolumeValid = false;
+    }
+
+    census1.resize(width*height);
+    census2.resize(width*height);
+
+    // Path start: zero costs. Its size also tracks the buffer stride
+    const bool strideChanged = startBuffer.size() != static_cast<size_t>(stride);
+    if (strideChanged) {
+        startBuffer.assign(stride, USHRT_MAX);
+        std::fill(startBuffer.begin() + PathBufferOffset, startBuffer.begin() + PathBufferOffset + numDisparities, 0);
+    }
+
+    // Sweep buffers: current and previous row for each of up to three
+    // paths; filled with sentinel values, which remain in place as
+    // only the data part is overwritten
+    const size_t sweepSize = 2*3*width*stride;
+    if (strideChanged || sweepBuffers.size() != sweepSize) {
+        sweepBuffers.assign(sweepSize, USHRT_MAX); // Re-uses capacity
+        sweepMinimums.assign(2*3*width, 0);
+    }
+}
+
+bool SgmEngine::inputChanged (const cv::Mat &img1, const cv::Mat &img2) const
+{
+    if (img1.size() != lastImg1.size() || img2.size() != lastImg2.size()) {
+        return true;
+    }
+
+    // Byte-wise comparison is considerably cheaper than matching
+    const size_t rowSize = img1.cols*img1.elemSize();
+    for (int y = 0; y < img1.rows; y++) {
+        if (std::memcmp(img1.ptr(y), lastImg1.ptr(y), rowSize) || std::memcmp(img2.ptr(y), lastImg2.ptr(y), rowSize)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SgmEngine::compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity)
+{
+    compute(img1, img2, disparity, minDisparity, numDisparities);
+}
+
+void SgmEngine::compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities)
+{
+    numDisparities = std::max(16, (numDisparities + 8) & -16);
+
+    if (img1.type() != CV_8UC1 || img2.type() != CV_8UC1) {
+        throw Exception(QStringLiteral("Input images must be 8-bit grayscale!"));
+    }
+    if (img1.size() != img2.size()) {
+        throw Exception(QStringLiteral("Input images must be of same size!"));
+    }
+
+    allocateBuffers(img1.size(), numDisparities);
+
+    // Matching; only if images, search range or matching parameters
+    // changed
+    if (!costVolumeValid || minDisparity != volumeMinDisparity || numDisparities != volumeNumDisparities || inputChanged(img1, img2)) {
+        costVolumeValid = false; // In case of exception
+
+        computeCostVolume(img1, img2, minDisparity, numDisparities);
+
+        img1.copyTo(lastImg1);
+        img2.copyTo(lastImg2);
+        volumeMinDisparity = minDisparity;
+        volumeNumDisparities = numDisparities;
+
+        costVolumeValid = true;
+        aggregationValid = false;
+    }
+
+    // Aggregation; only if cost volume or penalties changed
+    if (!aggregationValid) {
+        aggregateCosts(numDisparities);
+        aggregationValid = true;
+    }
+
+    // Selection
+    disparity.create(img1.size(), CV_16SC1);
+    selectDisparities(disparity, minDisparity, numDisparities);
+}
+
+void SgmEngine::computeCostVolume (const cv::Mat &img1, const cv::Mat &img2, int minDisparity, int numDisparities)
+{
+    const cv::Range rows(0, img1.rows);
+
+    switch (costType) {
+        case CostCensus: {
+            cv::parallel_for_(rows, CensusBody(img1, census1.data()));
+            cv::parallel_for_(rows, CensusBody(img2, census2.data()));
+            cv::parallel_for_(rows, CensusCostBody(census1.data(), census2.data(), img1.cols, minDisparity, numDisparities, costVolume));
+            break;
+        }
+        case CostBirchfieldTomasi: {
+            cv::parallel_for_(rows, BirchfieldTomasiCostBody(img1, img2, minDisparity, numDisparities, costVolume));
+            break;
+        }
+    }
+}
+
+void SgmEngine::aggregateCosts (int numDisparities)
+{
+    const int width = costVolume.cols / numDisparities;
+    const int height = costVolume.rows;
+    const int stride = numDisparities + PathBufferPadding;
+    const AggregatePixelFunction aggregate = getAggregatePixelFunction();
+
+    // Horizontal paths; parallel over row bands
+    cv::parallel_for_(cv::Range(0, height), HorizontalPassBody(costVolume, sumVolume, startBuffer.data() + PathBufferOffset, numDisparities, P1, P2, aggregate));
+
+    // Vertical and diagonal paths; top-down and bottom-up sweeps, each
+    // row parallelized over column bands
+    const int numSweepPaths = (numPaths == 8) ? 3 : 1;
+    const double numStripes = std::max(1, std::min(cv::getNumThreads(), width / 64));
+
+    ushort *buffers[2] = { sweepBuffers.data() + PathBufferOffset, sweepBuffers.data() + 3*width*stride + PathBufferOffset };
+    ushort *minimums[2] = { sweepMinimums.data(), sweepMinimums.data() + 3*width };
+
+    for (int sweep = 0; sweep < 2; sweep++) {
+        for (int i = 0; i < height; i++) {
+            const int y = (sweep == 0) ? i : height - 1 - i;
+
+            cv::parallel_for_(cv::Range(0, width), SweepRowBody(costVolume.ptr<uchar>(y), sumVolume.ptr<ushort>(y),
+                                                               buffers[0], minimums[0], buffers[1], minimums[1],
+                                                               numSweepPaths, i == 0, width, startBuffer.data() + PathBufferOffset,
+                                                               numDisparities, P1, P2, aggregate), numStripes);
+
+            std::swap(buffers[0], buffers[1]);
+            std::swap(minimums[0], minimums[1]);
+        }
+    }
+}
+
+void SgmEngine::selectDisparities (cv::Mat &disparity, int minDisparity, int numDisparities) const
+{
+    cv::parallel_for_(cv::Range(0, disparity.rows), SelectionBody(sumVolume, minDisparity, numDisparities, uniquenessRatio, disparity));
+}
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,148 @@
+/*
+ * Toolbox Semi-Global Matching: matching engine
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_SGM__SGM_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_SGM__SGM_H
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+// Semi-global matching engine. Processing is split into three stages,
+// each of which is re-run only if its inputs changed:
+//  1. matching: computation of 8-bit matching cost volume (census
+//     transform with Hamming distance, or Birchfield-Tomasi
+//     dissimilarity); re-run only if input images or matching
+//     parameters change
+//  2. aggregation: aggregation of costs along 4 or 8 paths into 16-bit
+//     saturated sum volume; re-run if matching was re-run, or if
+//     penalties or number of paths change
+//  3. selection: winner-takes-all with uniqueness check and sub-pixel
+//     refinement; always re-run
+// Interactive changes of penalties therefore do not trigger the
+// (costly) matching. The search range can be given per call, without
+// modifying the configured one; the cost volume is re-used as long as
+// the images and the range are the same. Output disparity is CV_16S
+// with four fractional bits, with invalid disparities set to
+// (minDisparity - 1)*16
+class SgmEngine
+{
+public:
+    SgmEngine ();
+
+    enum CostType {
+        CostCensus,
+        CostBirchfieldTomasi,
+    };
+
+    void setCostType (int type);
+    int getCostType () const;
+
+    void setMinDisparity (int value);
+    int getMinDisparity () const;
+
+    void setNumDisparities (int value);
+    int getNumDisparities () const;
+
+    void setP1 (int value);
+    int getP1 () const;
+
+    void setP2 (int value);
+    int getP2 () const;
+
+    void setNumPaths (int value);
+    int getNumPaths () const;
+
+    void setUniquenessRatio (int value);
+    int getUniquenessRatio () const;
+
+    // Allocates all buffers for images of given size
+    void prepare (const cv::Size &imageSize);
+
+    // Inputs must be CV_8UC1 images of same size
+    void compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity);
+
+    // Same as above, but with the given search range instead of the
+    // configured one (number of disparities is rounded to multiple of
+    // 16); the configuration is left unchanged
+    void compute (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities);
+
+protected:
+    void allocateBuffers (const cv::Size &imageSize, int numDisparities);
+    bool inputChanged (const cv::Mat &img1, const cv::Mat &img2) const;
+
+    void computeCostVolume (const cv::Mat &img1, const cv::Mat &img2, int minDisparity, int numDisparities);
+    void aggregateCosts (int numDisparities);
+    void selectDisparities (cv::Mat &disparity, int minDisparity, int numDisparities) const;
+
+protected:
+    // Parameters
+    int costType;
+    int minDisparity;
+    int numDisparities;
+    int P1;
+    int P2;
+    int numPaths;
+    int uniquenessRatio;
+
+    // Stage validity
+    bool costVolumeValid;
+    bool aggregationValid;
+
+    // Copies of last input images, and the search range of the volumes
+    cv::Mat lastImg1;
+    cv::Mat lastImg2;
+    int volumeMinDisparity;
+    int volumeNumDisparities;
+
+    // Census transforms
+    std::vector<quint64> census1;
+    std::vector<quint64> census2;
+
+    // Matching cost volume (H x W*D, CV_8U) and aggregated cost volume
+    // (H x W*D, CV_16U); the volumes are views of storage that only
+    // grows, so changes of image size or search range (e.g., between
+    // tiles) do not reallocate
+    std::vector<uchar> costStorage;
+    std::vector<ushort> sumStorage;
+    cv::Mat costVolume;
+    cv::Mat sumVolume;
+
+    // Path cost buffers for vertical/diagonal sweeps; one row per path
+    std::vector<ushort> sweepBuffers;
+    std::vector<ushort> sweepMinimums;
+    std::vector<ushort> startBuffer;
+};
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
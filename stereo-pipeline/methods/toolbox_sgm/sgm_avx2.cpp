@@ -0,0 +1,69 @@
+/*
+ * Toolbox Semi-Global Matching: AVX2 cost aggregation
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sgm_avx2.h"
+
+#include <immintrin.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+// L(d) = C(d) + min(Lp(d), Lp(d-1) + P1, Lp(d+1) + P1, min(Lp) + P2) - min(Lp);
+// all 16-bit operations saturate. Number of disparities must be
+// multiple of 16
+ushort aggregatePixelAvx2 (const uchar *cost, const ushort *prev, ushort prevMin, ushort *current, ushort *sum,
+                           int numDisparities, ushort P1, ushort P2)
+{
+    const __m256i vP1 = _mm256_set1_epi16(static_cast<short>(P1));
+    const __m256i vPrevMinP2 = _mm256_adds_epu16(_mm256_set1_epi16(static_cast<short>(prevMin)), _mm256_set1_epi16(static_cast<short>(P2)));
+    const __m256i vPrevMin = _mm256_set1_epi16(static_cast<short>(prevMin));
+    __m256i vMin = _mm256_set1_epi16(-1);
+
+    for (int d = 0; d < numDisparities; d += 16) {
+        const __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cost + d)));
+
+        const __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + d));
+        const __m256i pm = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + d - 1));
+        const __m256i pp = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + d + 1));
+
+        const __m256i t = _mm256_min_epu16(_mm256_min_epu16(p0, vPrevMinP2),
+                                           _mm256_min_epu16(_mm256_adds_epu16(pm, vP1), _mm256_adds_epu16(pp, vP1)));
+        const __m256i l = _mm256_adds_epu16(c, _mm256_subs_epu16(t, vPrevMin));
+
+        __m256i *sumPtr = reinterpret_cast<__m256i *>(sum + d);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(current + d), l);
+        _mm256_storeu_si256(sumPtr, _mm256_adds_epu16(_mm256_loadu_si256(sumPtr), l));
+
+        vMin = _mm256_min_epu16(vMin, l);
+    }
+
+    // Horizontal minimum
+    const __m128i halfMin = _mm_min_epu16(_mm256_castsi256_si128(vMin), _mm256_extracti128_si256(vMin, 1));
+    return static_cast<ushort>(_mm_cvtsi128_si32(_mm_minpos_epu16(halfMin)) & 0xFFFF);
+}
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,47 @@
+/*
+ * Toolbox Semi-Global Matching: AVX2 cost aggregation
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_SGM__SGM_AVX2_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__METHODS__TOOLBOX_SGM__SGM_AVX2_H
+
+#include <QtGlobal>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace StereoMethodToolboxSgm {
+
+
+// Single aggregation step along the path, processing sixteen
+// disparities at once; same semantics as the generic implementation in
+// sgm.cpp. Compiled with AVX2 code generation (only if supported by the
+// compiler, in which case HAVE_SGM_AVX2 is defined), and hence must be
+// called only if the CPU supports AVX2
+ushort aggregatePixelAvx2 (const uchar *cost, const ushort *prev, ushort prevMin, ushort *current, ushort *sum,
+                           int numDisparities, ushort P1, ushort P2);
+
+
+} // StereoMethodToolboxSgm
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
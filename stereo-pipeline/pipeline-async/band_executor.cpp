@@ -0,0 +1,242 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: band-parallel method executor
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "band_executor.h"
+
+#include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/stereo_method.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+const int BandExecutor::DefaultOverlap = 32;
+
+
+// Band layout: core rows are assigned to the band, extended rows are
+// the ones passed to the method
+struct BandLayout
+{
+    int start;
+    int end;
+    int extendedStart;
+    int extendedEnd;
+};
+
+static std::vector<BandLayout> computeBandLayout (int rows, int numBands, int overlap)
+{
+    std::vector<BandLayout> bands(numBands);
+    for (int i = 0; i < numBands; i++) {
+        BandLayout &band = bands[i];
+        band.start = rows * i / numBands;
+        band.end = rows * (i + 1) / numBands;
+        band.extendedStart = std::max(band.start - overlap, 0);
+        band.extendedEnd = std::min(band.end + overlap, rows);
+    }
+    return bands;
+}
+
+
+// Processing of individual bands; each band uses its own method
+// instance, so bands can be processed concurrently. Exceptions are
+// caught and stored, as they cannot cross the parallel loop
+class BandBody : public cv::ParallelLoopBody
+{
+public:
+    BandBody (const cv::Mat &img1, const cv::Mat &img2, const std::vector<BandLayout> &bands, const QList<StereoMethod2 *> &instances, std::vector<cv::Mat> &disparities, std::vector<int> &numDisparities, std::vector<DisparityFormat> &formats, std::vector<QString> &errors)
+        : img1(img1),
+          img2(img2),
+          bands(bands),
+          instances(instances),
+          disparities(disparities),
+          numDisparities(numDisparities),
+          formats(formats),
+          errors(errors)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        for (int i = range.start; i < range.end; i++) {
+            const cv::Range rows(bands[i].extendedStart, bands[i].extendedEnd);
+            try {
+                instances[i]->computeDisparity(img1.rowRange(rows), img2.rowRange(rows), disparities[i], numDisparities[i], formats[i]);
+            } catch (const std::exception &e) {
+                errors[i] = QString::fromStdString(e.what());
+            } catch (...) {
+                errors[i] = QStringLiteral("Unhandled exception type!");
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &img1;
+    const cv::Mat &img2;
+    const std::vector<BandLayout> &bands;
+    const QList<StereoMethod2 *> &instances;
+
+    std::vector<cv::Mat> &disparities;
+    std::vector<int> &numDisparities;
+    std::vector<DisparityFormat> &formats;
+    std::vector<QString> &errors;
+};
+
+
+BandExecutor::BandExecutor ()
+    : method(nullptr)
+{
+}
+
+BandExecutor::~BandExecutor ()
+{
+    resetInstances();
+}
+
+
+void BandExecutor::setMethod (StereoMethod2 *method)
+{
+    resetInstances();
+    this->method = method;
+}
+
+void BandExecutor::resetInstances ()
+{
+    qDeleteAll(instanceObjects);
+    instanceObjects.clear();
+    instances.clear();
+
+    bandDisparities.clear();
+}
+
+
+void BandExecutor::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, int numBands, int overlap, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    if (!method || !(method->getCapabilities() & StereoMethod2::CapabilityBandParallel)) {
+        throw Exception(QStringLiteral("Method does not support band-parallel execution!"));
+    }
+
+    // Number of bands; each band should have at least as many core
+    // rows as there are rows in the overlaps
+    overlap = std::max(overlap, 0);
+    if (numBands <= 0) {
+        numBands = QThread::idealThreadCount();
+    }
+    numBands = std::max(std::min(numBands, img1.rows / std::max(2*overlap, 1)), 1);
+
+    // Create missing instances
+    while (instances.size() < numBands) {
+        QObject *object = method->createInstance();
+        StereoMethod2 *instance = qobject_cast<StereoMethod2 *>(object);
+        if (!instance) {
+            delete object;
+            throw Exception(QStringLiteral("Failed to create method instance for band-parallel execution!"));
+        }
+        instanceObjects.append(object);
+        instances.append(instance);
+    }
+
+    bandDisparities.resize(numBands);
+    bandNumDisparities.assign(numBands, 0);
+    bandFormats.assign(numBands, DisparityFormat());
+    bandErrors.assign(numBands, QString());
+
+    // Process bands in parallel
+    const std::vector<BandLayout> bands = computeBandLayout(img1.rows, numBands, overlap);
+    cv::parallel_for_(cv::Range(0, numBands), BandBody(img1, img2, bands, instances, bandDisparities, bandNumDisparities, bandFormats, bandErrors), numBands);
+
+    for (const QString &error : bandErrors) {
+        if (!error.isEmpty()) {
+            throw Exception(error);
+        }
+    }
+
+    for (int i = 0; i < numBands; i++) {
+        if (bandDisparities[i].cols != img1.cols || bandDisparities[i].rows != bands[i].extendedEnd - bands[i].extendedStart) {
+            throw Exception(QStringLiteral("Band-parallel execution requires full-resolution disparity output!"));
+        }
+    }
+
+    numDisparities = bandNumDisparities[0];
+    format = bandFormats[0];
+
+    // Assemble core rows of all bands
+    disparity.create(img1.size(), bandDisparities[0].type());
+    for (int i = 0; i < numBands; i++) {
+        const BandLayout &band = bands[i];
+        bandDisparities[i].rowRange(band.start - band.extendedStart, band.end - band.extendedStart).copyTo(disparity.rowRange(band.start, band.end));
+    }
+
+    // Blend disparities of adjacent bands across each seam; weights
+    // change linearly over the central half of the overlap, and invalid
+    // disparities are replaced by the other band's ones
+    const int halfBlend = overlap / 2;
+    if (!halfBlend) {
+        return;
+    }
+
+    // Disparities below the search range are invalid; this includes
+    // both the method's own invalid value and the one that maps to -1
+    // (see DisparityFormat). Methods without configurable range search
+    // from zero, so for them, any negative disparity is invalid
+    int minDisparity = 0;
+    if (method->getCapabilities() & StereoMethod2::CapabilityDisparityRange) {
+        int rangeNumDisparities;
+        instances[0]->getDisparityRange(minDisparity, rangeNumDisparities);
+    }
+    const float invalidThreshold = static_cast<float>(minDisparity);
+
+    for (int i = 0; i + 1 < numBands; i++) {
+        const BandLayout &upper = bands[i];
+        const BandLayout &lower = bands[i + 1];
+
+        const int seam = lower.start;
+        const int start = std::max(seam - halfBlend, upper.start);
+        const int end = std::min(seam + halfBlend, lower.end);
+
+        bandDisparities[i].rowRange(start - upper.extendedStart, end - upper.extendedStart).convertTo(blendBuffer1, CV_32F, format.scale, format.offset);
+        bandDisparities[i + 1].rowRange(start - lower.extendedStart, end - lower.extendedStart).convertTo(blendBuffer2, CV_32F, format.scale, format.offset);
+
+        for (int y = start; y < end; y++) {
+            const float weight = (seam + halfBlend - y - 0.5f) / (2*halfBlend);
+            float *value1 = blendBuffer1.ptr<float>(y - start);
+            const float *value2 = blendBuffer2.ptr<float>(y - start);
+
+            for (int x = 0; x < blendBuffer1.cols; x++) {
+                if (value1[x] < invalidThreshold) {
+                    value1[x] = value2[x];
+                } else if (value2[x] >= invalidThreshold) {
+                    value1[x] = weight*value1[x] + (1.0f - weight)*value2[x];
+                }
+            }
+        }
+
+        // Back to native format
+        cv::Mat target = disparity.rowRange(start, end);
+        blendBuffer1.convertTo(target, target.type(), 1.0/format.scale, -format.offset/format.scale);
+    }
+}
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,83 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: band-parallel method executor
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__BAND_EXECUTOR_H
+#define MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__BAND_EXECUTOR_H
+
+
+#include <stereo-pipeline/disparity_format.h>
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+class StereoMethod2;
+
+namespace AsyncPipeline {
+
+
+// Band-parallel execution of single-threaded methods: the image pair
+// is split into horizontal bands that overlap by given number of rows,
+// and each band is processed in parallel by its own instance of the
+// method (see StereoMethod2::createInstance()). Within the overlaps,
+// disparities of adjacent bands are blended linearly. Instances are
+// created on demand, and must be reset whenever method's parameters
+// change. Accessed from a single (worker) thread only
+class BandExecutor
+{
+public:
+    BandExecutor ();
+    ~BandExecutor ();
+
+    void setMethod (StereoMethod2 *method);
+    void resetInstances ();
+
+    // Number of bands of zero selects the ideal thread count
+    void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, int numBands, int overlap, cv::Mat &disparity, int &numDisparities, DisparityFormat &format);
+
+    static const int DefaultOverlap;
+
+protected:
+    StereoMethod2 *method;
+
+    QList<QObject *> instanceObjects;
+    QList<StereoMethod2 *> instances;
+
+    // Per-band buffers
+    std::vector<cv::Mat> bandDisparities;
+    std::vector<int> bandNumDisparities;
+    std::vector<DisparityFormat> bandFormats;
+    std::vector<QString> bandErrors;
+
+    cv::Mat blendBuffer1;
+    cv::Mat blendBuffer2;
+};
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
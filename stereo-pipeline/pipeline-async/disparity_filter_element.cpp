@@ -0,0 +1,160 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: disparity post-filter element
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "disparity_filter_element.h"
+
+#include <stereo-pipeline/disparity_filter.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+DisparityFilterElement::DisparityFilterElement (QObject *parent)
+    : Element("DisparityFilter", parent),
+      filter(new DisparityFilter()),
+      numDisparityLevels(0)
+{
+    // Update time and FPS statistics (local loop)
+    connect(this, &DisparityFilterElement::disparityChanged, this, &DisparityFilterElement::incrementUpdateCount);
+
+    // Move filter object to worker thread
+    filter->moveToThread(thread);
+
+    // Ejection of filter object from the element; this pushes the
+    // filter object to the main thread, and schedules it for deletion.
+    // Must be connected with blocking queued connection!
+    connect(this, &DisparityFilterElement::eject, filter, [this] () {
+        // Push to main thread
+        filter->moveToThread(QCoreApplication::instance()->thread());
+
+        // Schedule for deletion
+        filter->deleteLater();
+
+        // Clear pointer
+        filter = nullptr;
+    }, Qt::BlockingQueuedConnection); // Connection must block!
+
+    // Main worker function - executed in filter object's context,
+    // and hence in the worker thread
+    connect(this, &DisparityFilterElement::filterRequest, filter, [this] (const cv::Mat disparity, int numDisparityLevels, const DisparityFormat format, int offsetX, int offsetY, const cv::Mat guide, const cv::Mat confidence) {
+        QMutexLocker mutexLocker(&mutex);
+
+        threadData.timer.start();
+        try {
+            filter->filterDisparity(disparity, format, guide, confidence, threadData.disparity);
+        } catch (const std::exception &e) {
+            emit error(QString::fromStdString(e.what()));
+            return;
+        } catch (...) {
+            emit error("Unhandled exception type!");
+            return;
+        }
+
+        threadData.processingTime = threadData.timer.elapsed();
+
+        // Store results
+        QWriteLocker locker(&lock);
+
+        cv::swap(threadData.disparity, this->disparity); // Swap buffers instead of copying
+        this->numDisparityLevels = numDisparityLevels;
+        disparityOffset = cv::Point(offsetX, offsetY);
+        lastOperationTime = threadData.processingTime;
+        droppedCounter = 0; // Reset dropped-frame counter
+
+        locker.unlock();
+
+        // Signal change
+        emit disparityChanged();
+    }, Qt::QueuedConnection);
+}
+
+DisparityFilterElement::~DisparityFilterElement ()
+{
+    emit eject(); // Eject filter object
+}
+
+
+DisparityFilter *DisparityFilterElement::getDisparityFilter ()
+{
+    return filter;
+}
+
+
+void DisparityFilterElement::filterDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format, const cv::Point &offset, const cv::Mat &guide, const cv::Mat &confidence)
+{
+    // No-op if inactive
+    if (!getState()) {
+        return;
+    }
+
+    // No-op if disparity or guide are empty
+    if (disparity.empty() || guide.empty()) {
+        return;
+    }
+
+    // Try acquiring mutex to see if worker thread is busy processing
+    if (mutex.tryLock()) {
+        // Submit the task
+        emit filterRequest(disparity, numDisparityLevels, format, offset.x, offset.y, guide, confidence);
+        mutex.unlock();
+    } else {
+        // Drop the frame
+        dropFrame();
+    }
+}
+
+
+cv::Mat DisparityFilterElement::getDisparity () const
+{
+    QReadLocker locker(&lock);
+    return disparity.clone();
+}
+
+void DisparityFilterElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+}
+
+void DisparityFilterElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+    format = DisparityFormat();
+}
+
+void DisparityFilterElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+    format = DisparityFormat();
+    offset = disparityOffset;
+}
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,93 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: disparity post-filter element
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__DISPARITY_FILTER_ELEMENT_H
+#define MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__DISPARITY_FILTER_ELEMENT_H
+
+
+#include "element.h"
+
+#include <stereo-pipeline/disparity_format.h>
+
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+class DisparityFilter;
+
+namespace AsyncPipeline {
+
+
+class DisparityFilterElement : public Element
+{
+    Q_OBJECT
+
+public:
+    DisparityFilterElement (QObject *parent = nullptr);
+    virtual ~DisparityFilterElement ();
+
+    DisparityFilter *getDisparityFilter ();
+
+    // Guide is the left image from which disparity was computed;
+    // confidence map may be empty
+    void filterDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format, const cv::Point &offset, const cv::Mat &guide, const cv::Mat &confidence);
+
+    // Filtered disparity is always CV_32F, in identity format
+    cv::Mat getDisparity () const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels) const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const;
+
+signals:
+    void eject ();
+    void filterRequest (const cv::Mat disparity, int numDisparityLevels, const DisparityFormat format, int offsetX, int offsetY, const cv::Mat guide, const cv::Mat confidence);
+
+    void disparityChanged ();
+
+protected:
+    // Filter object
+    DisparityFilter *filter;
+
+    mutable QMutex mutex; // Method mutex
+
+
+    // Cached disparity (under parent's lock!)
+    cv::Mat disparity;
+    int numDisparityLevels;
+    cv::Point disparityOffset;
+
+    // Worker thread's local variables
+    struct {
+        QElapsedTimer timer;
+        cv::Mat disparity;
+        int processingTime;
+    } threadData;
+};
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
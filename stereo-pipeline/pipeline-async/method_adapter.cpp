@@ -0,0 +1,317 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: stereo method adapter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "method_adapter.h"
+
+#include <stereo-pipeline/exception.h>
+#include <stereo-pipeline/stereo_method.h>
+#include <stereo-pipeline/utils.h>
+
+#include <opencv2/imgproc.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+MethodAdapter::MethodAdapter ()
+    : methodIface(nullptr),
+      methodIface2(nullptr),
+      rightInstanceObject(nullptr),
+      rightInstance(nullptr)
+{
+}
+
+MethodAdapter::~MethodAdapter ()
+{
+    resetInstances();
+}
+
+
+bool MethodAdapter::setMethod (QObject *method)
+{
+    // Previous method is returned to normal operation
+    if (methodIface2 && (methodIface2->getCapabilities() & StereoMethod2::CapabilityPostProcessing)) {
+        methodIface2->setRawOutput(false);
+    }
+
+    methodIface = qobject_cast<StereoMethod *>(method);
+    methodIface2 = qobject_cast<StereoMethod2 *>(method);
+
+    // Post-processing is applied by the pipeline
+    if (methodIface2 && (methodIface2->getCapabilities() & StereoMethod2::CapabilityPostProcessing)) {
+        methodIface2->setRawOutput(true);
+    }
+
+    // Release buffers of previous method
+    input1 = cv::Mat();
+    input2 = cv::Mat();
+    legacyDisparity = cv::Mat();
+    flipped1 = cv::Mat();
+    flipped2 = cv::Mat();
+    flippedInput1 = cv::Mat();
+    flippedInput2 = cv::Mat();
+    flippedDisparity = cv::Mat();
+
+    resetInstances();
+    bandExecutor.setMethod(methodIface2);
+
+    return methodIface != nullptr;
+}
+
+StereoMethod *MethodAdapter::getMethod () const
+{
+    return methodIface;
+}
+
+bool MethodAdapter::isNative () const
+{
+    return methodIface2 != nullptr;
+}
+
+
+// *********************************************************************
+// *                           Capabilities                            *
+// *********************************************************************
+int MethodAdapter::getCapabilities () const
+{
+    return methodIface2 ? methodIface2->getCapabilities() : 0;
+}
+
+int MethodAdapter::getPreferredInputType () const
+{
+    return methodIface2 ? methodIface2->getPreferredInputType() : -1;
+}
+
+
+// *********************************************************************
+// *                            Processing                             *
+// *********************************************************************
+void MethodAdapter::prepare (const cv::Size &imageSize, int imageType)
+{
+    if (!methodIface2) {
+        return; // Not supported by basic interface
+    }
+
+    // Method sees images of its preferred type
+    int preferredType = methodIface2->getPreferredInputType();
+    methodIface2->prepare(imageSize, preferredType >= 0 ? preferredType : imageType);
+}
+
+void MethodAdapter::computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    if (!methodIface) {
+        throw Exception(QStringLiteral("Method not set!"));
+    }
+
+    if (methodIface2) {
+        convertInput(img1, input1);
+        convertInput(img2, input2);
+
+        methodIface2->computeDisparity(input1, input2, disparity, numDisparities, format);
+    } else {
+        methodIface->computeDisparity(img1, img2, legacyDisparity, numDisparities);
+        format = methodIface->getDisparityFormat();
+
+        legacyDisparity.copyTo(disparity);
+    }
+}
+
+void MethodAdapter::postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity)
+{
+    if (!methodIface2) {
+        throw Exception(QStringLiteral("Method does not support separate post-processing!"));
+    }
+
+    methodIface2->postProcessDisparity(rawDisparity, format, disparity);
+}
+
+void MethodAdapter::getDisparityRange (int &minDisparity, int &numDisparities) const
+{
+    if (!methodIface2) {
+        throw Exception(QStringLiteral("Method does not support restricted-range matching!"));
+    }
+
+    methodIface2->getDisparityRange(minDisparity, numDisparities);
+}
+
+void MethodAdapter::computeDisparityInTiles (const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    if (!methodIface2) {
+        throw Exception(QStringLiteral("Method does not support restricted-range matching!"));
+    }
+
+    convertInput(img1, input1);
+    convertInput(img2, input2);
+
+    int minDisparity;
+    methodIface2->getDisparityRange(minDisparity, numDisparities);
+
+    Utils::computeDisparityInTiles(methodIface2, input1, input2, ranges, tileSize, tileBorder, minDisparity, disparity, format);
+}
+
+void MethodAdapter::computeDisparityInBands (const cv::Mat &img1, const cv::Mat &img2, int numBands, int overlap, cv::Mat &disparity, int &numDisparities, DisparityFormat &format)
+{
+    if (!methodIface2) {
+        throw Exception(QStringLiteral("Method does not support band-parallel execution!"));
+    }
+
+    convertInput(img1, input1);
+    convertInput(img2, input2);
+
+    bandExecutor.computeDisparity(input1, input2, numBands, overlap, disparity, numDisparities, format);
+}
+
+void MethodAdapter::computeDisparityPair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparityLeft, cv::Mat &disparityRight, int &numDisparities, DisparityFormat &format)
+{
+    if (!methodIface2) {
+        computeDisparity(img1, img2, disparityLeft, numDisparities, format);
+        disparityRight.release();
+        return;
+    }
+
+    convertInput(img1, input1);
+    convertInput(img2, input2);
+
+    methodIface2->computeDisparityPair(input1, input2, disparityLeft, disparityRight, numDisparities, format);
+}
+
+bool MethodAdapter::canComputeRightDisparityConcurrently () const
+{
+    return getCapabilities() & (StereoMethod2::CapabilityBandParallel | StereoMethod2::CapabilityThreadSafe);
+}
+
+void MethodAdapter::computeRightDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, DisparityFormat &format)
+{
+    if (!methodIface) {
+        throw Exception(QStringLiteral("Method not set!"));
+    }
+
+    // Mirrored right image becomes the left image of the flipped pair,
+    // so its disparity, mirrored back, is the right-image disparity
+    cv::flip(img2, flipped1, 1);
+    cv::flip(img1, flipped2, 1);
+
+    int numDisparities;
+    if (methodIface2) {
+        StereoMethod2 *method = methodIface2;
+
+        if (methodIface2->getCapabilities() & StereoMethod2::CapabilityBandParallel) {
+            if (!rightInstance) {
+                rightInstanceObject = methodIface2->createInstance();
+                rightInstance = qobject_cast<StereoMethod2 *>(rightInstanceObject);
+                if (!rightInstance) {
+                    resetInstances();
+                    throw Exception(QStringLiteral("Failed to create method instance for right disparity computation!"));
+                }
+            }
+            method = rightInstance;
+        }
+
+        convertInput(flipped1, flippedInput1);
+        convertInput(flipped2, flippedInput2);
+
+        method->computeDisparity(flippedInput1, flippedInput2, flippedDisparity, numDisparities, format);
+    } else {
+        methodIface->computeDisparity(flipped1, flipped2, flippedDisparity, numDisparities);
+        format = methodIface->getDisparityFormat();
+    }
+
+    cv::flip(flippedDisparity, disparity, 1);
+}
+
+void MethodAdapter::computeRightDisparityInTiles (const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, cv::Mat &disparity, DisparityFormat &format)
+{
+    if (!methodIface2) {
+        throw Exception(QStringLiteral("Method does not support restricted-range matching!"));
+    }
+
+    cv::flip(img2, flipped1, 1);
+    cv::flip(img1, flipped2, 1);
+
+    convertInput(flipped1, flippedInput1);
+    convertInput(flipped2, flippedInput2);
+
+    int minDisparity, numDisparities;
+    methodIface2->getDisparityRange(minDisparity, numDisparities);
+
+    Utils::computeMirroredTileDisparityRanges(ranges, img1.size(), tileSize, minDisparity, numDisparities, flippedRanges);
+    Utils::computeDisparityInTiles(methodIface2, flippedInput1, flippedInput2, flippedRanges, tileSize, tileBorder, minDisparity, flippedDisparity, format);
+
+    cv::flip(flippedDisparity, disparity, 1);
+}
+
+void MethodAdapter::resetInstances ()
+{
+    bandExecutor.resetInstances();
+
+    delete rightInstanceObject;
+    rightInstanceObject = nullptr;
+    rightInstance = nullptr;
+}
+
+void MethodAdapter::convertInput (const cv::Mat &image, cv::Mat &converted) const
+{
+    int type = methodIface2->getPreferredInputType();
+
+    // No preference or no conversion necessary
+    if (type < 0 || image.type() == type) {
+        converted = image;
+        return;
+    }
+
+    int channels = CV_MAT_CN(type);
+    int depth = CV_MAT_DEPTH(type);
+
+    // Only depth differs
+    if (image.channels() == channels) {
+        image.convertTo(converted, depth);
+        return;
+    }
+
+    // Color conversion
+    int code;
+    if (image.channels() == 3 && channels == 1) {
+        code = cv::COLOR_BGR2GRAY;
+    } else if (image.channels() == 4 && channels == 1) {
+        code = cv::COLOR_BGRA2GRAY;
+    } else if (image.channels() == 1 && channels == 3) {
+        code = cv::COLOR_GRAY2BGR;
+    } else if (image.channels() == 4 && channels == 3) {
+        code = cv::COLOR_BGRA2BGR;
+    } else {
+        throw Exception(QStringLiteral("Cannot convert %1-channel image to %2-channel image!").arg(image.channels()).arg(channels));
+    }
+
+    if (image.depth() == depth) {
+        cv::cvtColor(image, converted, code);
+    } else {
+        cv::Mat tmp;
+        cv::cvtColor(image, tmp, code);
+        tmp.convertTo(converted, depth);
+    }
+}
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,133 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: stereo method adapter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__METHOD_ADAPTER_H
+#define MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__METHOD_ADAPTER_H
+
+
+#include "band_executor.h"
+
+#include <stereo-pipeline/disparity_format.h>
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+class StereoMethod;
+class StereoMethod2;
+
+namespace AsyncPipeline {
+
+
+// Provides uniform access to stereo methods implementing either
+// version of StereoMethod interface. Methods implementing only the
+// basic interface report no capabilities, and their output is copied
+// into the caller-provided buffer (as they may return references to
+// their internal buffers). Input images are converted to method's
+// preferred type, using buffers that are reused between frames
+class MethodAdapter
+{
+public:
+    MethodAdapter ();
+    ~MethodAdapter ();
+
+    bool setMethod (QObject *method);
+
+    StereoMethod *getMethod () const;
+    bool isNative () const;
+
+    int getCapabilities () const;
+    int getPreferredInputType () const;
+
+    void prepare (const cv::Size &imageSize, int imageType);
+    void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format);
+
+    // Restricted-range matching; only for methods with
+    // StereoMethod2::CapabilityDisparityRange
+    void getDisparityRange (int &minDisparity, int &numDisparities) const;
+    void computeDisparityInTiles (const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, cv::Mat &disparity, int &numDisparities, DisparityFormat &format);
+
+    // Band-parallel execution; only for methods with
+    // StereoMethod2::CapabilityBandParallel
+    void computeDisparityInBands (const cv::Mat &img1, const cv::Mat &img2, int numBands, int overlap, cv::Mat &disparity, int &numDisparities, DisparityFormat &format);
+
+    // Right-image disparity for left-right consistency check (in right
+    // image coordinates). computeDisparityPair() uses the one provided
+    // by the method (StereoMethod2::CapabilityRightDisparity), if any;
+    // otherwise, computeRightDisparity() matches the horizontally
+    // flipped and swapped pair. The latter uses its own buffers and,
+    // for methods with StereoMethod2::CapabilityBandParallel, its own
+    // method instance, so it can run concurrently with computeDisparity()
+    // if canComputeRightDisparityConcurrently() returns true
+    void computeDisparityPair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparityLeft, cv::Mat &disparityRight, int &numDisparities, DisparityFormat &format);
+    bool canComputeRightDisparityConcurrently () const;
+    void computeRightDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, DisparityFormat &format);
+
+    // Right-image disparity of the flipped pair, matched in tiles with
+    // ranges mirrored from the given left-image ones (see
+    // Utils::computeMirroredTileDisparityRanges()); uses the method
+    // itself, so it must not run concurrently with other computations
+    void computeRightDisparityInTiles (const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, cv::Mat &disparity, DisparityFormat &format);
+
+    // Separate post-processing; only for methods with
+    // StereoMethod2::CapabilityPostProcessing, for which the adapter
+    // enables raw output while the method is set
+    void postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity);
+
+    // Additional method instances (band-parallel execution, right
+    // disparity) must be reset whenever method's parameters change
+    void resetInstances ();
+
+protected:
+    void convertInput (const cv::Mat &image, cv::Mat &converted) const;
+
+protected:
+    StereoMethod *methodIface;
+    StereoMethod2 *methodIface2;
+
+    cv::Mat input1;
+    cv::Mat input2;
+    cv::Mat legacyDisparity;
+
+    BandExecutor bandExecutor;
+
+    // Right disparity computation
+    QObject *rightInstanceObject;
+    StereoMethod2 *rightInstance;
+
+    cv::Mat flipped1;
+    cv::Mat flipped2;
+    cv::Mat flippedInput1;
+    cv::Mat flippedInput2;
+    cv::Mat flippedDisparity;
+    cv::Mat flippedRanges;
+};
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
@@ -21,6 +21,9 @@
 
 #include <stereo-pipeline/exception.h>
 #include <stereo-pipeline/stereo_method.h>
+#include <stereo-pipeline/utils.h>
+
+#include <QtConcurrent>
 
 
 namespace MVL {
@@ -29,14 +32,59 @@ namespace Pipeline {
 namespace AsyncPipeline {
 
 
+// Waits for the future to finish when going out of scope, so that a
+// concurrent task cannot outlive the data it refers to, regardless of
+// how the scope is exited
+namespace {
+class FutureWaiter
+{
+public:
+    FutureWaiter (QFuture<void> &future)
+        : future(future)
+    {
+    }
+
+    ~FutureWaiter ()
+    {
+        future.waitForFinished();
+    }
+
+private:
+    QFuture<void> &future;
+};
+} // anonymous namespace
+
+
 MethodElement::MethodElement (QObject *parent)
     : Element("StereoMethod", parent),
       methodObject(nullptr),
       methodParent(nullptr),
-      methodIface(nullptr)
+      methodIface(nullptr),
+      inputType(-1),
+      temporalPrediction(false),
+      temporalMargin(4),
+      keyframeInterval(30),
+      bandParallel(false),
+      numBands(0),
+      bandOverlap(BandExecutor::DefaultOverlap),
+      consistencyCheck(false),
+      consistencyThreshold(1.0f),
+      instancesStale(0),
+      postProcessingPending(0),
+      numDisparityLevels(0),
+      searchFraction(1.0f),
+      maxDisparity(-1)
 {
     // Update time and FPS statistics (local loop)
     connect(this, &MethodElement::disparityChanged, this, &MethodElement::incrementUpdateCount);
+
+    // Additional method instances carry a copy of method's parameters
+    connect(this, &MethodElement::parameterChanged, this, [this] () {
+        instancesStale.storeRelease(1);
+    });
+
+    // Changes of post-processing parameters do not require matching
+    connect(this, &MethodElement::postProcessingParameterChanged, this, &MethodElement::postProcessDisparity);
 }
 
 MethodElement::~MethodElement ()
@@ -62,6 +110,7 @@ void MethodElement::setStereoMethod (QObject *newMethod)
     // Insert new method
     methodObject = newMethod;
     methodIface = newMethodIface;
+    methodAdapter.setMethod(newMethod);
 
     methodParent = methodObject->parent(); // Store parent
     methodObject->setParent(nullptr);
@@ -97,11 +146,22 @@ void MethodElement::setStereoMethod (QObject *newMethod)
         methodObject = nullptr;
         methodParent = nullptr;
         methodIface = nullptr;
+        methodAdapter.setMethod(nullptr);
+        threadData.predictor.reset();
+        threadData.rawDisparity = cv::Mat();
+        threadData.rightDisparity = cv::Mat();
 
         // Clear cached image
         QWriteLocker locker(&lock);
         disparity = cv::Mat();
         numDisparityLevels = 0;
+        disparityFormat = DisparityFormat();
+        disparityOffset = cv::Point();
+        searchFraction = 1.0f;
+        maxDisparity = -1;
+        invalidMask = cv::Mat();
+        confidence = cv::Mat();
+        referenceImage = cv::Mat();
         locker.unlock();
 
         emit disparityChanged();
@@ -109,14 +169,160 @@ void MethodElement::setStereoMethod (QObject *newMethod)
     signalConnections.append(tmpConnection);
 
 
+    // Preparation of the method for given image size and type, so that
+    // its internal buffers are allocated ahead of the first frame
+    tmpConnection = connect(this, &MethodElement::prepareRequest, methodObject, [this] (int width, int height, int type) {
+        QMutexLocker mutexLocker(&mutex);
+
+        try {
+            methodAdapter.prepare(cv::Size(width, height), type);
+        } catch (const std::exception &e) {
+            emit error(QString::fromStdString(e.what()));
+        } catch (...) {
+            emit error("Unhandled exception type!");
+        }
+    }, Qt::QueuedConnection);
+    signalConnections.append(tmpConnection);
+
+
     // Main worker function - executed in method object's context, and
     // hence in the worker thread
-    tmpConnection = connect(this, &MethodElement::disparityComputationRequest, methodObject, [this] (const cv::Mat imageL, const cv::Mat imageR) {
+    tmpConnection = connect(this, &MethodElement::disparityComputationRequest, methodObject, [this] (const cv::Mat imageL, const cv::Mat imageR, int offsetX, int offsetY, const std::vector<cv::Rect> regions) {
         QMutexLocker mutexLocker(&mutex);
 
+        // Multiple regions of interest are matched separately, provided
+        // that the method can be applied to image sub-regions
+        const bool perRegion = regions.size() > 1 && (methodAdapter.getCapabilities() & StereoMethod2::CapabilityRegionOfInterest);
+
+        // Temporal prediction, band-parallel and consistency check settings
+        QReadLocker settingsLocker(&lock);
+        const bool temporal = !perRegion && temporalPrediction && (methodAdapter.getCapabilities() & StereoMethod2::CapabilityDisparityRange);
+        const int margin = temporalMargin;
+        const int interval = keyframeInterval;
+        const bool bands = bandParallel && (methodAdapter.getCapabilities() & StereoMethod2::CapabilityBandParallel);
+        const int bandCount = numBands;
+        const int overlap = bandOverlap;
+        const bool consistency = consistencyCheck;
+        const float maxDifference = consistencyThreshold;
+        settingsLocker.unlock();
+
+        if (instancesStale.testAndSetOrdered(1, 0)) {
+            methodAdapter.resetInstances();
+        }
+
         threadData.timer.start();
         try {
-            methodIface->computeDisparity(imageL, imageR, threadData.disparity, threadData.numDisparityLevels);
+            // Computed directly into thread-local buffer; with temporal
+            // prediction, only within ranges predicted from previous
+            // frame, unless full search is required
+            bool predicted = false;
+            threadData.searchFraction = 1.0f;
+
+            int minDisparity = 0, numDisparities = 0;
+            if (temporal) {
+                methodAdapter.getDisparityRange(minDisparity, numDisparities);
+
+                predicted = threadData.predictor.predict(imageL, minDisparity, numDisparities, margin, interval, threadData.tileRanges);
+            }
+
+            // Right disparity for consistency check is either provided
+            // by the method along with the left one (full-frame matching
+            // only), or computed from the flipped pair; the latter runs
+            // concurrently with left disparity computation, if possible.
+            // With temporal prediction, the flipped pair is matched in
+            // tiles as well, after the left image
+            const bool methodRight = consistency && !perRegion && !predicted && !bands && (methodAdapter.getCapabilities() & StereoMethod2::CapabilityRightDisparity);
+            const bool concurrentRight = consistency && !methodRight && !predicted && methodAdapter.canComputeRightDisparityConcurrently();
+
+            QFuture<void> rightFuture;
+            QString rightError;
+            FutureWaiter rightWaiter(rightFuture); // Joins the task on every exit path
+            threadData.rightDisparity.release();
+
+            if (concurrentRight) {
+                rightFuture = QtConcurrent::run([this, &imageL, &imageR, &rightError] () {
+                    try {
+                        methodAdapter.computeRightDisparity(imageL, imageR, threadData.rightDisparity, threadData.rightFormat);
+                    } catch (const std::exception &e) {
+                        rightError = QString::fromStdString(e.what());
+                    } catch (...) {
+                        rightError = QStringLiteral("Unhandled exception type!");
+                    }
+                });
+            }
+
+            if (predicted) {
+                methodAdapter.computeDisparityInTiles(imageL, imageR, threadData.tileRanges, TemporalPredictor::TileSize, TemporalPredictor::TileBorder, threadData.disparity, threadData.numDisparityLevels, threadData.disparityFormat);
+                threadData.searchFraction = Utils::getTileSearchFraction(threadData.tileRanges, imageL.size(), TemporalPredictor::TileSize, TemporalPredictor::TileBorder, numDisparities);
+            } else if (perRegion) {
+                bool first = true;
+                for (const cv::Rect &region : regions) {
+                    methodAdapter.computeDisparity(imageL(region), imageR(region), threadData.regionDisparity, threadData.numDisparityLevels, threadData.disparityFormat);
+
+                    // Pixels outside regions are marked invalid (value
+                    // that maps to negative disparity)
+                    if (first) {
+                        threadData.disparity.create(imageL.size(), threadData.regionDisparity.type());
+                        threadData.disparity.setTo(cv::Scalar((-1.0 - threadData.disparityFormat.offset) / threadData.disparityFormat.scale));
+                        first = false;
+                    }
+                    threadData.regionDisparity.copyTo(threadData.disparity(region));
+                }
+            } else if (bands) {
+                methodAdapter.computeDisparityInBands(imageL, imageR, bandCount, overlap, threadData.disparity, threadData.numDisparityLevels, threadData.disparityFormat);
+            } else if (methodRight) {
+                methodAdapter.computeDisparityPair(imageL, imageR, threadData.disparity, threadData.rightDisparity, threadData.numDisparityLevels, threadData.disparityFormat);
+                threadData.rightFormat = threadData.disparityFormat;
+            } else {
+                methodAdapter.computeDisparity(imageL, imageR, threadData.disparity, threadData.numDisparityLevels, threadData.disparityFormat);
+            }
+
+            // Separate post-processing; raw disparity is kept, so that
+            // post-processing can be re-applied without matching
+            if (methodAdapter.getCapabilities() & StereoMethod2::CapabilityPostProcessing) {
+                cv::swap(threadData.disparity, threadData.rawDisparity);
+                methodAdapter.postProcessDisparity(threadData.rawDisparity, threadData.disparityFormat, threadData.disparity);
+            } else {
+                threadData.rawDisparity.release();
+            }
+
+            // Left-right consistency check; inconsistent pixels are
+            // invalidated
+            if (consistency) {
+                if (concurrentRight) {
+                    rightFuture.waitForFinished();
+                    if (!rightError.isEmpty()) {
+                        throw Exception(rightError);
+                    }
+                } else if (predicted) {
+                    methodAdapter.computeRightDisparityInTiles(imageL, imageR, threadData.tileRanges, TemporalPredictor::TileSize, TemporalPredictor::TileBorder, threadData.rightDisparity, threadData.rightFormat);
+                } else if (threadData.rightDisparity.empty()) {
+                    methodAdapter.computeRightDisparity(imageL, imageR, threadData.rightDisparity, threadData.rightFormat);
+                }
+
+                if (threadData.rightFormat != threadData.disparityFormat) {
+                    threadData.rightDisparity.convertTo(threadData.rightDisparity, threadData.disparity.type(), threadData.rightFormat.scale / threadData.disparityFormat.scale, (threadData.rightFormat.offset - threadData.disparityFormat.offset) / threadData.disparityFormat.scale);
+                    threadData.rightFormat = threadData.disparityFormat;
+                }
+
+                applyConsistencyCheck(maxDifference);
+            } else {
+                threadData.invalidMask.release();
+                threadData.confidence.release();
+            }
+
+            // Largest searched disparity
+            threadData.maxDisparity = threadData.numDisparityLevels;
+            if (methodAdapter.getCapabilities() & StereoMethod2::CapabilityDisparityRange) {
+                methodAdapter.getDisparityRange(minDisparity, numDisparities);
+                threadData.maxDisparity = minDisparity + numDisparities;
+            }
+
+            if (temporal) {
+                threadData.predictor.update(threadData.disparity, threadData.disparityFormat);
+            } else {
+                threadData.predictor.reset();
+            }
         } catch (const std::exception &e) {
             emit error(QString::fromStdString(e.what()));
             return;
@@ -130,8 +336,15 @@ void MethodElement::setStereoMethod (QObject *newMethod)
         // Store results
         QWriteLocker locker(&lock);
 
-        threadData.disparity.copyTo(disparity);
+        cv::swap(threadData.disparity, disparity); // Swap buffers instead of copying
         numDisparityLevels = threadData.numDisparityLevels;
+        disparityFormat = threadData.disparityFormat;
+        disparityOffset = cv::Point(offsetX, offsetY);
+        searchFraction = threadData.searchFraction;
+        maxDisparity = threadData.maxDisparity;
+        cv::swap(threadData.invalidMask, invalidMask);
+        cv::swap(threadData.confidence, confidence);
+        referenceImage = imageL;
         lastOperationTime = threadData.processingTime;
         droppedCounter = 0; // Reset dropped-frame counter
 
@@ -143,11 +356,72 @@ void MethodElement::setStereoMethod (QObject *newMethod)
     signalConnections.append(tmpConnection);
 
 
+    // Re-application of post-processing to the raw disparity of last
+    // frame - executed in worker thread
+    tmpConnection = connect(this, &MethodElement::postProcessingRequest, methodObject, [this] () {
+        QMutexLocker mutexLocker(&mutex);
+        postProcessingPending.storeRelease(0);
+
+        // No-op until a frame has been matched
+        if (threadData.rawDisparity.empty()) {
+            return;
+        }
+
+        // Right disparity of last frame is available if it was checked
+        QReadLocker settingsLocker(&lock);
+        const bool consistency = consistencyCheck && !threadData.rightDisparity.empty();
+        const float maxDifference = consistencyThreshold;
+        settingsLocker.unlock();
+
+        threadData.timer.start();
+        try {
+            methodAdapter.postProcessDisparity(threadData.rawDisparity, threadData.disparityFormat, threadData.disparity);
+            if (consistency) {
+                applyConsistencyCheck(maxDifference);
+            }
+        } catch (const std::exception &e) {
+            emit error(QString::fromStdString(e.what()));
+            return;
+        } catch (...) {
+            emit error("Unhandled exception type!");
+            return;
+        }
+
+        threadData.processingTime = threadData.timer.elapsed();
+
+        // Store results; other properties of the frame are unchanged
+        QWriteLocker locker(&lock);
+
+        cv::swap(threadData.disparity, disparity); // Swap buffers instead of copying
+        if (consistency) {
+            cv::swap(threadData.invalidMask, invalidMask);
+            cv::swap(threadData.confidence, confidence);
+        }
+        lastOperationTime = threadData.processingTime;
+
+        locker.unlock();
+
+        // Signal change
+        emit disparityChanged();
+    }, Qt::QueuedConnection);
+    signalConnections.append(tmpConnection);
+
+
     // Signal the change of method's parameters
     // NOTE: we need to use the old syntax because signal is defined in interface!
     tmpConnection = connect(methodObject, SIGNAL(parameterChanged()), this, SIGNAL(parameterChanged()), Qt::QueuedConnection);
     signalConnections.append(tmpConnection);
 
+    if (methodAdapter.getCapabilities() & StereoMethod2::CapabilityPostProcessing) {
+        tmpConnection = connect(methodObject, SIGNAL(postProcessingParameterChanged()), this, SIGNAL(postProcessingParameterChanged()), Qt::QueuedConnection);
+        signalConnections.append(tmpConnection);
+    }
+
+    // If input size is already known, prepare the method right away
+    if (!inputSize.empty()) {
+        emit prepareRequest(inputSize.width, inputSize.height, inputType);
+    }
+
     emit methodChanged();
 }
 
@@ -177,7 +451,173 @@ void MethodElement::saveParameters (const QString &filename) const
     methodIface->saveParameters(filename);
 }
 
-void MethodElement::computeDisparity (const cv::Mat &imageL, const cv::Mat &imageR)
+int MethodElement::getCapabilities () const
+{
+    // Capabilities are static properties of the method, so they can be
+    // queried without holding the method mutex
+    StereoMethod2 *methodIface2 = qobject_cast<StereoMethod2 *>(methodObject);
+    return methodIface2 ? methodIface2->getCapabilities() : 0;
+}
+
+// Temporal prediction
+void MethodElement::setTemporalPrediction (bool enable)
+{
+    QWriteLocker locker(&lock);
+    if (enable == temporalPrediction) {
+        return;
+    }
+    temporalPrediction = enable;
+    locker.unlock();
+
+    emit temporalPredictionChanged(enable);
+}
+
+bool MethodElement::getTemporalPrediction () const
+{
+    QReadLocker locker(&lock);
+    return temporalPrediction;
+}
+
+void MethodElement::setTemporalMargin (int margin)
+{
+    QWriteLocker locker(&lock);
+    temporalMargin = qMax(margin, 0);
+}
+
+int MethodElement::getTemporalMargin () const
+{
+    QReadLocker locker(&lock);
+    return temporalMargin;
+}
+
+// Interval (in frames) between forced full searches; zero disables
+// periodic full searches
+void MethodElement::setKeyframeInterval (int interval)
+{
+    QWriteLocker locker(&lock);
+    keyframeInterval = qMax(interval, 0);
+}
+
+int MethodElement::getKeyframeInterval () const
+{
+    QReadLocker locker(&lock);
+    return keyframeInterval;
+}
+
+// Fraction of the full search space that was evaluated in last frame
+float MethodElement::getSearchFraction () const
+{
+    QReadLocker locker(&lock);
+    return searchFraction;
+}
+
+
+// Band-parallel execution
+void MethodElement::setBandParallel (bool enable)
+{
+    QWriteLocker locker(&lock);
+    if (enable == bandParallel) {
+        return;
+    }
+    bandParallel = enable;
+    locker.unlock();
+
+    emit bandParallelChanged(enable);
+}
+
+bool MethodElement::getBandParallel () const
+{
+    QReadLocker locker(&lock);
+    return bandParallel;
+}
+
+void MethodElement::setNumberOfBands (int numBands)
+{
+    QWriteLocker locker(&lock);
+    numBands = qMax(numBands, 0);
+    if (numBands == this->numBands) {
+        return;
+    }
+    this->numBands = numBands;
+    const bool enabled = bandParallel;
+    locker.unlock();
+
+    // Band layout changes the result only in band-parallel mode
+    if (enabled) {
+        emit bandParallelChanged(enabled);
+    }
+}
+
+int MethodElement::getNumberOfBands () const
+{
+    QReadLocker locker(&lock);
+    return numBands;
+}
+
+// Number of rows by which adjacent bands overlap
+void MethodElement::setBandOverlap (int overlap)
+{
+    QWriteLocker locker(&lock);
+    overlap = qMax(overlap, 0);
+    if (overlap == bandOverlap) {
+        return;
+    }
+    bandOverlap = overlap;
+    const bool enabled = bandParallel;
+    locker.unlock();
+
+    if (enabled) {
+        emit bandParallelChanged(enabled);
+    }
+}
+
+int MethodElement::getBandOverlap () const
+{
+    QReadLocker locker(&lock);
+    return bandOverlap;
+}
+
+
+// Left-right consistency check
+void MethodElement::setConsistencyCheck (bool enable)
+{
+    QWriteLocker locker(&lock);
+    if (enable == consistencyCheck) {
+        return;
+    }
+    consistencyCheck = enable;
+    locker.unlock();
+
+    emit consistencyCheckChanged(enable);
+}
+
+bool MethodElement::getConsistencyCheck () const
+{
+    QReadLocker locker(&lock);
+    return consistencyCheck;
+}
+
+void MethodElement::setConsistencyThreshold (float threshold)
+{
+    QWriteLocker locker(&lock);
+    consistencyThreshold = qMax(threshold, 0.0f);
+}
+
+float MethodElement::getConsistencyThreshold () const
+{
+    QReadLocker locker(&lock);
+    return consistencyThreshold;
+}
+
+void MethodElement::getConsistencyMaps (cv::Mat &invalidMask, cv::Mat &confidence) const
+{
+    QReadLocker locker(&lock);
+    this->invalidMask.copyTo(invalidMask);
+    this->confidence.copyTo(confidence);
+}
+
+
+void MethodElement::computeDisparity (const cv::Mat &imageL, const cv::Mat &imageR, const cv::Rect &bounds, const std::vector<cv::Rect> &regions)
 {
     // No-op if inactive
     if (!getState()) {
@@ -189,10 +629,22 @@ void MethodElement::computeDisparity (const cv::Mat &imageL, const cv::Mat &imag
         return;
     }
 
+    // (Re)prepare the method if input size or type changed; the request
+    // is queued ahead of the computation request, and is submitted even
+    // if the frame ends up being dropped
+    if (imageL.size() != inputSize || imageL.type() != inputType) {
+        inputSize = imageL.size();
+        inputType = imageL.type();
+
+        if (methodObject) {
+            emit prepareRequest(inputSize.width, inputSize.height, inputType);
+        }
+    }
+
     // Try acquiring mutex to see if worker thread is busy processing
     if (mutex.tryLock()) {
         // Submit the task
-        emit disparityComputationRequest(imageL.clone(), imageR.clone());
+        emit disparityComputationRequest(imageL.clone(), imageR.clone(), bounds.x, bounds.y, regions);
         mutex.unlock();
     } else {
         // Drop the frame
@@ -200,6 +652,27 @@ void MethodElement::computeDisparity (const cv::Mat &imageL, const cv::Mat &imag
     }
 }
 
+void MethodElement::postProcessDisparity ()
+{
+    // No-op if inactive
+    if (!getState()) {
+        return;
+    }
+
+    // Coalesce requests; the pending one will use latest parameters
+    if (postProcessingPending.testAndSetOrdered(0, 1)) {
+        emit postProcessingRequest();
+    }
+}
+
+// Invalidates pixels of thread-local disparity that fail the check
+// against thread-local right disparity (both in the same format)
+void MethodElement::applyConsistencyCheck (float maxDifference)
+{
+    Utils::checkLeftRightConsistency(threadData.disparity, threadData.rightDisparity, threadData.disparityFormat, maxDifference, threadData.invalidMask, threadData.confidence);
+    threadData.disparity.setTo(cv::Scalar((-1.0 - threadData.disparityFormat.offset) / threadData.disparityFormat.scale), threadData.invalidMask);
+}
+
 cv::Mat MethodElement::getDisparity () const
 {
     QReadLocker locker(&lock);
@@ -213,6 +686,40 @@ void MethodElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels) c
     numDisparityLevels = this->numDisparityLevels;
 }
 
+void MethodElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+    format = this->disparityFormat;
+}
+
+void MethodElement::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+    format = this->disparityFormat;
+    offset = disparityOffset;
+}
+
+void MethodElement::getPostFilterInput (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset, cv::Mat &image, cv::Mat &confidence) const
+{
+    QReadLocker locker(&lock);
+    this->disparity.copyTo(disparity);
+    numDisparityLevels = this->numDisparityLevels;
+    format = disparityFormat;
+    offset = disparityOffset;
+    image = referenceImage;
+    this->confidence.copyTo(confidence);
+}
+
+int MethodElement::getMaxDisparity () const
+{
+    QReadLocker locker(&lock);
+    return maxDisparity;
+}
+
 
 } // AsyncPipeline
 } // Pipeline
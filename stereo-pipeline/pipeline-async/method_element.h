@@ -22,6 +22,10 @@
 
 
 #include "element.h"
+#include "method_adapter.h"
+#include "temporal_predictor.h"
+
+#include <stereo-pipeline/disparity_format.h>
 
 #include <opencv2/core.hpp>
 
@@ -49,39 +53,160 @@ public:
     void loadParameters (const QString &filename);
     void saveParameters (const QString &filename) const;
 
-    void computeDisparity (const cv::Mat &imageL, const cv::Mat &imageR);
+    int getCapabilities () const;
+
+    // Temporal prediction; requires method with
+    // StereoMethod2::CapabilityDisparityRange
+    void setTemporalPrediction (bool enable);
+    bool getTemporalPrediction () const;
+
+    void setTemporalMargin (int margin);
+    int getTemporalMargin () const;
+
+    void setKeyframeInterval (int interval);
+    int getKeyframeInterval () const;
+
+    float getSearchFraction () const;
+
+    // Band-parallel execution; requires method with
+    // StereoMethod2::CapabilityBandParallel. Zero bands selects the
+    // ideal thread count
+    void setBandParallel (bool enable);
+    bool getBandParallel () const;
+
+    void setNumberOfBands (int numBands);
+    int getNumberOfBands () const;
+
+    void setBandOverlap (int overlap);
+    int getBandOverlap () const;
+
+    // Left-right consistency check; pixels whose left and right
+    // disparities differ by more than the threshold are invalidated.
+    // Invalidation mask and confidence map of last frame are empty if
+    // the check is disabled
+    void setConsistencyCheck (bool enable);
+    bool getConsistencyCheck () const;
+
+    void setConsistencyThreshold (float threshold);
+    float getConsistencyThreshold () const;
+
+    void getConsistencyMaps (cv::Mat &invalidMask, cv::Mat &confidence) const;
+
+    // Input images may cover only part of the rectified image (see
+    // RectificationElement::setRegionsOfInterest()); in that case,
+    // bounds give their position and regions the processed areas
+    // within them. Methods with StereoMethod2::CapabilityRegionOfInterest
+    // are applied to each region separately
+    void computeDisparity (const cv::Mat &imageL, const cv::Mat &imageR, const cv::Rect &bounds = cv::Rect(), const std::vector<cv::Rect> &regions = std::vector<cv::Rect>());
+
+    // Re-applies post-processing to the raw disparity of last frame;
+    // only for methods with StereoMethod2::CapabilityPostProcessing.
+    // Invoked automatically when method's post-processing parameters
+    // change, so that matching need not be repeated
+    void postProcessDisparity ();
 
     cv::Mat getDisparity () const;
     void getDisparity (cv::Mat &disparity, int &numDisparityLevels) const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const;
+
+    // Disparity of last frame, along with the left image it was
+    // computed from and its consistency-check confidence map (empty
+    // if the check is disabled); input of the disparity post-filter
+    void getPostFilterInput (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset, cv::Mat &image, cv::Mat &confidence) const;
+
+    // Largest disparity searched by the method in last frame; used to
+    // determine the margin of regions of interest
+    int getMaxDisparity () const;
 
 signals:
     void eject ();
     void methodChanged ();
     void parameterChanged ();
-
-    void disparityComputationRequest (const cv::Mat imageL, const cv::Mat imageR);
+    void postProcessingParameterChanged ();
+    void temporalPredictionChanged (bool enabled);
+    // Also emitted when number of bands or overlap changes while
+    // band-parallel execution is enabled
+    void bandParallelChanged (bool enabled);
+    void consistencyCheckChanged (bool enabled);
+
+    void prepareRequest (int width, int height, int type);
+    void disparityComputationRequest (const cv::Mat imageL, const cv::Mat imageR, int offsetX, int offsetY, const std::vector<cv::Rect> regions);
+    void postProcessingRequest ();
     void disparityChanged ();
 
+protected:
+    void applyConsistencyCheck (float maxDifference);
+
 protected:
     // Stereo method object
     QObject *methodObject;
     QObject *methodParent;
     StereoMethod *methodIface;
+    MethodAdapter methodAdapter; // Accessed from worker thread only
 
     QList<QMetaObject::Connection> signalConnections;
 
     mutable QMutex mutex; // Method mutex
 
+    // Size and type of last submitted input images; used to
+    // (re)prepare the method ahead of processing
+    cv::Size inputSize;
+    int inputType;
+
+    // Temporal prediction settings (under parent's lock!)
+    bool temporalPrediction;
+    int temporalMargin;
+    int keyframeInterval;
+
+    // Band-parallel execution settings (under parent's lock!)
+    bool bandParallel;
+    int numBands;
+    int bandOverlap;
+
+    // Consistency check settings (under parent's lock!)
+    bool consistencyCheck;
+    float consistencyThreshold;
+
+    // Set when method's parameters change, so that additional method
+    // instances are re-created by the worker thread
+    QAtomicInt instancesStale;
+
+    // Set while a post-processing request is queued, so that rapid
+    // parameter changes do not pile up requests
+    QAtomicInt postProcessingPending;
+
     // Cached disparity (under parent's lock!)
     cv::Mat disparity;
     int numDisparityLevels;
+    DisparityFormat disparityFormat;
+    cv::Point disparityOffset;
+    float searchFraction;
+    int maxDisparity;
+    cv::Mat invalidMask;
+    cv::Mat confidence;
+    cv::Mat referenceImage; // Shared with the input; never modified
 
     // Worker thread's local variables
     struct {
         QElapsedTimer timer;
         cv::Mat disparity;
         int numDisparityLevels;
+        DisparityFormat disparityFormat;
         int processingTime;
+        int maxDisparity;
+
+        cv::Mat regionDisparity;
+        cv::Mat rawDisparity; // Kept until next frame
+
+        cv::Mat rightDisparity; // Kept until next frame
+        DisparityFormat rightFormat;
+        cv::Mat invalidMask;
+        cv::Mat confidence;
+
+        TemporalPredictor predictor;
+        cv::Mat tileRanges;
+        float searchFraction;
     } threadData;
 };
 
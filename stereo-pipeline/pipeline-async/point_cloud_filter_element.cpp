@@ -0,0 +1,147 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: point-cloud filter element
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "point_cloud_filter_element.h"
+
+#include <stereo-pipeline/point_cloud_filter.h>
+#include <stereo-pipeline/reprojection.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+PointCloudFilterElement::PointCloudFilterElement (QObject *parent)
+    : Element("PointCloudFilter", parent),
+      filter(new PointCloudFilter())
+{
+    // Update time and FPS statistics (local loop)
+    connect(this, &PointCloudFilterElement::pointCloudChanged, this, &PointCloudFilterElement::incrementUpdateCount);
+
+    // Move filter object to worker thread
+    filter->moveToThread(thread);
+
+    // Ejection of filter object from the element; this pushes the
+    // filter object to the main thread, and schedules it for deletion.
+    // Must be connected with blocking queued connection!
+    connect(this, &PointCloudFilterElement::eject, filter, [this] () {
+        // Push to main thread
+        filter->moveToThread(QCoreApplication::instance()->thread());
+
+        // Schedule for deletion
+        filter->deleteLater();
+
+        // Clear pointer
+        filter = nullptr;
+    }, Qt::BlockingQueuedConnection); // Connection must block!
+
+    // Main worker function - executed in filter object's context,
+    // and hence in the worker thread
+    connect(this, &PointCloudFilterElement::filterRequest, filter, [this] (const cv::Mat points, const cv::Mat reprojectionMatrix, int offsetX, int offsetY) {
+        QMutexLocker mutexLocker(&mutex);
+
+        threadData.timer.start();
+        try {
+            // Expand depth-only outputs; other formats are handled by
+            // the filter itself
+            if (points.type() == CV_32FC1 || points.type() == CV_16UC1) {
+                Reprojection::convertToPoints(points, reprojectionMatrix, threadData.points, offsetX, offsetY);
+                filter->filterPoints(threadData.points, threadData.cloud);
+            } else {
+                filter->filterPoints(points, threadData.cloud);
+            }
+        } catch (const std::exception &e) {
+            emit error(QString::fromStdString(e.what()));
+            return;
+        } catch (...) {
+            emit error("Unhandled exception type!");
+            return;
+        }
+
+        threadData.processingTime = threadData.timer.elapsed();
+
+        // Store results
+        QWriteLocker locker(&lock);
+
+        cv::swap(threadData.cloud, cloud); // Swap buffers instead of copying
+        lastOperationTime = threadData.processingTime;
+        droppedCounter = 0; // Reset dropped-frame counter
+
+        locker.unlock();
+
+        // Signal change
+        emit pointCloudChanged();
+    }, Qt::QueuedConnection);
+}
+
+PointCloudFilterElement::~PointCloudFilterElement ()
+{
+    emit eject(); // Eject filter object
+}
+
+
+PointCloudFilter *PointCloudFilterElement::getPointCloudFilter ()
+{
+    return filter;
+}
+
+
+cv::Mat PointCloudFilterElement::getPointCloud () const
+{
+    QReadLocker locker(&lock);
+    return cloud.clone();
+}
+
+void PointCloudFilterElement::getPointCloud (cv::Mat &cloud) const
+{
+    QReadLocker locker(&lock);
+    this->cloud.copyTo(cloud);
+}
+
+
+void PointCloudFilterElement::filterPoints (const cv::Mat &points, const cv::Mat &reprojectionMatrix, const cv::Point &offset)
+{
+    // No-op if inactive
+    if (!getState()) {
+        return;
+    }
+
+    // No-op if points are empty
+    if (points.empty()) {
+        return;
+    }
+
+    // Try acquiring mutex to see if worker thread is busy processing
+    if (mutex.tryLock()) {
+        // Submit the task
+        emit filterRequest(points, reprojectionMatrix, offset.x, offset.y);
+        mutex.unlock();
+    } else {
+        // Drop the frame
+        dropFrame();
+    }
+}
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,88 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: point-cloud filter element
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__POINT_CLOUD_FILTER_ELEMENT_H
+#define MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__POINT_CLOUD_FILTER_ELEMENT_H
+
+
+#include "element.h"
+
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+class PointCloudFilter;
+
+namespace AsyncPipeline {
+
+
+class PointCloudFilterElement : public Element
+{
+    Q_OBJECT
+
+public:
+    PointCloudFilterElement (QObject *parent = nullptr);
+    virtual ~PointCloudFilterElement ();
+
+    PointCloudFilter *getPointCloudFilter ();
+
+    // Depth-only outputs are expanded to points before filtering, which
+    // requires the reprojection matrix and the position of the disparity
+    // image within the rectified image
+    void filterPoints (const cv::Mat &points, const cv::Mat &reprojectionMatrix = cv::Mat(), const cv::Point &offset = cv::Point());
+
+    cv::Mat getPointCloud () const;
+    void getPointCloud (cv::Mat &cloud) const;
+
+signals:
+    void eject ();
+    void filterRequest (const cv::Mat points, const cv::Mat reprojectionMatrix, int offsetX, int offsetY);
+
+    void pointCloudChanged ();
+
+protected:
+    // Filter object
+    PointCloudFilter *filter;
+
+    mutable QMutex mutex; // Method mutex
+
+
+    // Cached point cloud
+    cv::Mat cloud;
+
+    // Worker thread's local variables
+    struct {
+        QElapsedTimer timer;
+        cv::Mat points;
+        cv::Mat cloud;
+        int processingTime;
+    } threadData;
+};
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
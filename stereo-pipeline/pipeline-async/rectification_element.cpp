@@ -30,7 +30,8 @@ namespace AsyncPipeline {
 
 RectificationElement::RectificationElement (QObject *parent)
     : Element("Rectification", parent),
-      rectification(new Rectification())
+      rectification(new Rectification()),
+      regionMargin(0)
 {
     // Update time and FPS statistics (local loop)
     connect(this, &RectificationElement::imagesChanged, this, &RectificationElement::incrementUpdateCount);
@@ -59,9 +60,33 @@ RectificationElement::RectificationElement (QObject *parent)
     connect(this, &RectificationElement::imageRectificationRequest, rectification, [this] (const cv::Mat imageLeft, const cv::Mat imageRight) {
         QMutexLocker mutexLocker(&mutex);
 
+        // Regions of interest, extended by disparity margin
+        QReadLocker settingsLocker(&lock);
+        threadData.regions.clear();
+        for (const cv::Rect &region : regionsOfInterest) {
+            threadData.regions.push_back(cv::Rect(region.x - regionMargin, region.y, region.width + regionMargin, region.height));
+        }
+        settingsLocker.unlock();
+
         threadData.timer.start();
         try {
-            rectification->rectifyImagePair(imageLeft, imageRight, threadData.imageL, threadData.imageR);
+            if (threadData.regions.empty()) {
+                rectification->rectifyImagePair(imageLeft, imageRight, threadData.imageL, threadData.imageR);
+                threadData.bounds = cv::Rect(0, 0, threadData.imageL.cols, threadData.imageL.rows);
+            } else {
+                rectification->rectifyImagePair(imageLeft, imageRight, threadData.regions, threadData.imageL, threadData.imageR, threadData.bounds);
+
+                // Processed regions, relative to the bounding box
+                const cv::Rect imageArea(0, 0, imageLeft.cols, imageLeft.rows);
+                std::vector<cv::Rect> relativeRegions;
+                for (const cv::Rect &region : threadData.regions) {
+                    const cv::Rect clipped = region & imageArea;
+                    if (!clipped.empty()) {
+                        relativeRegions.push_back(clipped - threadData.bounds.tl());
+                    }
+                }
+                threadData.regions.swap(relativeRegions);
+            }
         } catch (const std::exception &e) {
             emit error(QString::fromStdString(e.what()));
             return;
@@ -77,6 +102,8 @@ RectificationElement::RectificationElement (QObject *parent)
 
         threadData.imageL.copyTo(imageL);
         threadData.imageR.copyTo(imageR);
+        bounds = threadData.bounds;
+        processedRegions = threadData.regions;
         lastOperationTime = threadData.processingTime;
         droppedCounter = 0; // Reset dropped-frame counter
 
@@ -121,6 +148,55 @@ void RectificationElement::getImages (cv::Mat &imageLeft, cv::Mat &imageRight) c
     imageR.copyTo(imageRight);
 }
 
+void RectificationElement::getImages (cv::Mat &imageLeft, cv::Mat &imageRight, cv::Rect &bounds, std::vector<cv::Rect> &regions) const
+{
+    QReadLocker locker(&lock);
+    imageL.copyTo(imageLeft);
+    imageR.copyTo(imageRight);
+    bounds = this->bounds;
+    regions = processedRegions;
+}
+
+cv::Rect RectificationElement::getBounds () const
+{
+    QReadLocker locker(&lock);
+    return bounds;
+}
+
+
+// Regions of interest
+void RectificationElement::setRegionsOfInterest (const std::vector<cv::Rect> &regions)
+{
+    QWriteLocker locker(&lock);
+    regionsOfInterest.clear();
+    for (const cv::Rect &region : regions) {
+        if (!region.empty()) {
+            regionsOfInterest.push_back(region);
+        }
+    }
+    locker.unlock();
+
+    emit regionsOfInterestChanged();
+}
+
+std::vector<cv::Rect> RectificationElement::getRegionsOfInterest () const
+{
+    QReadLocker locker(&lock);
+    return regionsOfInterest;
+}
+
+void RectificationElement::setRegionMargin (int margin)
+{
+    QWriteLocker locker(&lock);
+    regionMargin = qMax(margin, 0);
+}
+
+int RectificationElement::getRegionMargin () const
+{
+    QReadLocker locker(&lock);
+    return regionMargin;
+}
+
 
 cv::Mat RectificationElement::getReprojectionMatrix () const
 {
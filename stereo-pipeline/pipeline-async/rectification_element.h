@@ -52,6 +52,23 @@ public:
 
     void getImages (cv::Mat &imageLeft, cv::Mat &imageRight) const;
 
+    // Images with the position of their area within the rectified
+    // image (bounding box of processed regions), and the processed
+    // regions relative to that area
+    void getImages (cv::Mat &imageLeft, cv::Mat &imageRight, cv::Rect &bounds, std::vector<cv::Rect> &regions) const;
+
+    // Regions of interest, in rectified image coordinates; an empty
+    // list means the whole image is processed. Each region is extended
+    // to the left by the disparity margin, so that matches of its
+    // pixels lie within the processed area of the right image
+    void setRegionsOfInterest (const std::vector<cv::Rect> &regions);
+    std::vector<cv::Rect> getRegionsOfInterest () const;
+
+    void setRegionMargin (int margin);
+    int getRegionMargin () const;
+
+    cv::Rect getBounds () const;
+
     cv::Mat getReprojectionMatrix () const;
 
 signals:
@@ -59,6 +76,7 @@ signals:
     void imageRectificationRequest (const cv::Mat imageL, const cv::Mat imageR);
 
     void imagesChanged ();
+    void regionsOfInterestChanged ();
 
     void calibrationChanged (bool valid);
     void performRectificationChanged (bool enabled);
@@ -75,12 +93,20 @@ protected:
 
     cv::Mat imageL;
     cv::Mat imageR;
+    cv::Rect bounds;
+    std::vector<cv::Rect> processedRegions;
+
+    // Regions of interest (under lock)
+    std::vector<cv::Rect> regionsOfInterest;
+    int regionMargin;
 
     // Worker thread's local variables
     struct {
         QElapsedTimer timer;
         cv::Mat imageL;
         cv::Mat imageR;
+        cv::Rect bounds;
+        std::vector<cv::Rect> regions;
         int processingTime;
     } threadData;
 };
@@ -56,12 +56,12 @@ ReprojectionElement::ReprojectionElement (QObject *parent)
 
     // Main worker function - executed in reprojection object's context,
     // and hence in the worker thread
-    connect(this, &ReprojectionElement::reprojectionRequest, reprojection, [this] (const cv::Mat disparity) {
+    connect(this, &ReprojectionElement::reprojectionRequest, reprojection, [this] (const cv::Mat disparity, const DisparityFormat format, int offsetX, int offsetY) {
         QMutexLocker mutexLocker(&mutex);
 
         threadData.timer.start();
         try {
-            reprojection->reprojectDisparity(disparity, threadData.points);
+            reprojection->reprojectDisparity(disparity, format, threadData.points, offsetX, offsetY);
         } catch (const std::exception &e) {
             emit error(QString::fromStdString(e.what()));
             return;
@@ -75,7 +75,8 @@ ReprojectionElement::ReprojectionElement (QObject *parent)
         // Store results
         QWriteLocker locker(&lock);
 
-        threadData.points.copyTo(points);
+        cv::swap(threadData.points, points); // Swap buffers instead of copying
+        pointsOffset = cv::Point(offsetX, offsetY);
         lastOperationTime = threadData.processingTime;
         droppedCounter = 0; // Reset dropped-frame counter
 
@@ -111,8 +112,15 @@ void ReprojectionElement::getPoints (cv::Mat &points) const
     this->points.copyTo(points);
 }
 
+void ReprojectionElement::getPoints (cv::Mat &points, cv::Point &offset) const
+{
+    QReadLocker locker(&lock);
+    this->points.copyTo(points);
+    offset = pointsOffset;
+}
+
 
-void ReprojectionElement::reprojectDisparity (const cv::Mat &disparity, int numDisparityLevels)
+void ReprojectionElement::reprojectDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format, const cv::Point &offset)
 {
     // No-op if inactive
     if (!getState()) {
@@ -127,7 +135,7 @@ void ReprojectionElement::reprojectDisparity (const cv::Mat &disparity, int numD
     // Try acquiring mutex to see if worker thread is busy processing
     if (mutex.tryLock()) {
         // Submit the task
-        emit reprojectionRequest(disparity.clone());
+        emit reprojectionRequest(disparity.clone(), format, offset.x, offset.y);
         mutex.unlock();
     } else {
         // Drop the frame
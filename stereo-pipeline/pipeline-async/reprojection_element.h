@@ -23,6 +23,8 @@
 
 #include "element.h"
 
+#include <stereo-pipeline/disparity_format.h>
+
 #include <opencv2/core.hpp>
 
 
@@ -45,14 +47,17 @@ public:
 
     Reprojection *getReprojection ();
 
-    void reprojectDisparity (const cv::Mat &disparity, int numDisparityLevels);
+    // Offset denotes the position of disparity image within the
+    // rectified image (e.g., when processing regions of interest)
+    void reprojectDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format = DisparityFormat(), const cv::Point &offset = cv::Point());
 
     cv::Mat getPoints () const;
     void getPoints (cv::Mat &points) const;
+    void getPoints (cv::Mat &points, cv::Point &offset) const;
 
 signals:
     void eject ();
-    void reprojectionRequest (const cv::Mat disparity);
+    void reprojectionRequest (const cv::Mat disparity, const DisparityFormat format, int offsetX, int offsetY);
 
     void pointsChanged ();
 
@@ -67,6 +72,7 @@ protected:
     mutable QReadWriteLock lock;
 
     cv::Mat points;
+    cv::Point pointsOffset;
 
     // Worker thread's local variables
     struct {
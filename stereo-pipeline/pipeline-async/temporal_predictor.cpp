@@ -0,0 +1,138 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: temporal disparity predictor
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "temporal_predictor.h"
+
+#include <stereo-pipeline/utils.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+const int TemporalPredictor::TileSize = 64;
+const int TemporalPredictor::TileBorder = 16;
+
+// Tiles in which less than this fraction of previous disparities is
+// valid are searched over the full range
+static const double MinValidFraction = 0.25;
+
+// Scene cut: mean absolute difference between consecutive thumbnails
+// exceeds this fraction of mean intensity
+static const double SceneCutThreshold = 0.2;
+
+// Thumbnails are downscaled by this factor
+static const int ThumbnailFactor = 8;
+
+
+TemporalPredictor::TemporalPredictor ()
+    : minDisparity(0),
+      numDisparities(0),
+      framesSinceKeyframe(0)
+{
+}
+
+
+void TemporalPredictor::reset ()
+{
+    thumbnail = cv::Mat();
+    previousThumbnail = cv::Mat();
+    previousDisparity = cv::Mat();
+
+    minDisparity = 0;
+    numDisparities = 0;
+    framesSinceKeyframe = 0;
+}
+
+bool TemporalPredictor::isSceneCut (const cv::Mat &image)
+{
+    // Grayscale, floating-point thumbnail
+    cv::Mat gray;
+    if (image.channels() == 3) {
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    } else if (image.channels() == 4) {
+        cv::cvtColor(image, gray, cv::COLOR_BGRA2GRAY);
+    } else {
+        gray = image;
+    }
+
+    cv::resize(gray, thumbnail, cv::Size(), 1.0/ThumbnailFactor, 1.0/ThumbnailFactor, cv::INTER_AREA);
+    thumbnail.convertTo(thumbnail, CV_32F);
+
+    bool cut = true;
+    if (previousThumbnail.size() == thumbnail.size()) {
+        const double difference = cv::norm(thumbnail, previousThumbnail, cv::NORM_L1) / thumbnail.total();
+        const double intensity = cv::mean(previousThumbnail)[0];
+
+        cut = difference > SceneCutThreshold*std::max(intensity, 1.0);
+    }
+
+    cv::swap(thumbnail, previousThumbnail);
+
+    return cut;
+}
+
+bool TemporalPredictor::predict (const cv::Mat &image, int minDisparity, int numDisparities, int margin, int keyframeInterval, cv::Mat &ranges)
+{
+    // Scene-cut detection must see every frame
+    const bool sceneCut = isSceneCut(image);
+
+    bool fullSearch = sceneCut;
+    fullSearch |= previousDisparity.size() != image.size();
+    fullSearch |= minDisparity != this->minDisparity || numDisparities != this->numDisparities;
+    fullSearch |= keyframeInterval > 0 && framesSinceKeyframe >= keyframeInterval;
+
+    this->minDisparity = minDisparity;
+    this->numDisparities = numDisparities;
+
+    if (fullSearch) {
+        framesSinceKeyframe = 0;
+        return false;
+    }
+
+    Utils::computeTileDisparityRanges(previousDisparity, image.size(), TileSize, margin, MinValidFraction, minDisparity, numDisparities, ranges);
+
+    // Tiles are matched with context, so restricted search may end up
+    // doing more work than the full one; in that case, search in full
+    if (Utils::getTileSearchFraction(ranges, image.size(), TileSize, TileBorder, numDisparities) >= 1.0) {
+        framesSinceKeyframe = 0;
+        return false;
+    }
+
+    framesSinceKeyframe++;
+
+    return true;
+}
+
+void TemporalPredictor::update (const cv::Mat &disparity, const DisparityFormat &format)
+{
+    Utils::convertDisparityToFloat(disparity, format, previousDisparity);
+}
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,83 @@
+/*
+ * Stereo Pipeline: asynchronous pipeline: temporal disparity predictor
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__TEMPORAL_PREDICTOR_H
+#define MVL_STEREO_TOOLBOX__PIPELINE_ASYNC__TEMPORAL_PREDICTOR_H
+
+
+#include <stereo-pipeline/disparity_format.h>
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace AsyncPipeline {
+
+
+// Temporal disparity prediction for video streams: derives per-tile
+// disparity search ranges from previous frame's disparity, so that the
+// method needs to search only around the previous solution. Full search
+// is requested on the first frame, on scene cuts (detected from the
+// change of a downscaled left image), periodically on key frames, and
+// whenever method's disparity range or input size changes, as well as
+// when the predicted ranges would not reduce the work (see
+// Utils::getTileSearchFraction()). Tiles with too few valid previous
+// disparities (low confidence) are searched over the full range
+class TemporalPredictor
+{
+public:
+    TemporalPredictor ();
+
+    void reset ();
+
+    // Returns false if full search is required for given frame;
+    // otherwise, fills in per-tile ranges (in the format used by
+    // Utils::computeTileDisparityRanges())
+    bool predict (const cv::Mat &image, int minDisparity, int numDisparities, int margin, int keyframeInterval, cv::Mat &ranges);
+
+    // Stores disparity of the current frame
+    void update (const cv::Mat &disparity, const DisparityFormat &format);
+
+    static const int TileSize;
+    static const int TileBorder;
+
+protected:
+    bool isSceneCut (const cv::Mat &image);
+
+protected:
+    cv::Mat thumbnail;
+    cv::Mat previousThumbnail;
+    cv::Mat previousDisparity;
+
+    int minDisparity;
+    int numDisparities;
+    int framesSinceKeyframe;
+};
+
+
+} // AsyncPipeline
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
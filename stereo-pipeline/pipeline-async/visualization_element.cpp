@@ -34,6 +34,7 @@ VisualizationElement::VisualizationElement (QObject *parent)
 {
     // Propagate the method change signal
     connect(visualization, &DisparityVisualization::visualizationMethodChanged, this, &VisualizationElement::visualizationMethodChanged);
+    connect(visualization, &DisparityVisualization::colormapChanged, this, &VisualizationElement::visualizationMethodChanged);
 
     // Update time and FPS statistics (local loop)
     connect(this, &VisualizationElement::imageChanged, this, &VisualizationElement::incrementUpdateCount);
@@ -59,12 +60,12 @@ VisualizationElement::VisualizationElement (QObject *parent)
 
     // Main worker function - executed in visualization object's context,
     // and hence in the worker thread
-    connect(this, &VisualizationElement::disparityVisualizationRequest, visualization, [this] (const cv::Mat disparity, int numDisparityLevels) {
+    connect(this, &VisualizationElement::disparityVisualizationRequest, visualization, [this] (const cv::Mat disparity, int numDisparityLevels, const DisparityFormat format) {
         QMutexLocker mutexLocker(&mutex);
 
         threadData.timer.start();
         try {
-            visualization->visualizeDisparity(disparity, numDisparityLevels, threadData.image);
+            visualization->visualizeDisparity(disparity, numDisparityLevels, threadData.image, format);
         } catch (const std::exception &e) {
             emit error(QString::fromStdString(e.what()));
             return;
@@ -114,7 +115,7 @@ void VisualizationElement::getImage (cv::Mat &image) const
 }
 
 
-void VisualizationElement::visualizeDisparity (const cv::Mat &disparity, int numDisparityLevels)
+void VisualizationElement::visualizeDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format)
 {
     // No-op if inactive
     if (!getState()) {
@@ -129,7 +130,7 @@ void VisualizationElement::visualizeDisparity (const cv::Mat &disparity, int num
     // Try acquiring mutex to see if worker thread is busy processing
     if (mutex.tryLock()) {
         // Submit the task
-        emit disparityVisualizationRequest(disparity.clone(), numDisparityLevels);
+        emit disparityVisualizationRequest(disparity.clone(), numDisparityLevels, format);
         mutex.unlock();
     } else {
         // Drop the frame
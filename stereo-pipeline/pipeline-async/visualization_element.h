@@ -23,6 +23,8 @@
 
 #include "element.h"
 
+#include <stereo-pipeline/disparity_format.h>
+
 #include <opencv2/core.hpp>
 
 
@@ -45,14 +47,14 @@ public:
 
     DisparityVisualization *getVisualization ();
 
-    void visualizeDisparity (const cv::Mat &disparity, int numDisparityLevels);
+    void visualizeDisparity (const cv::Mat &disparity, int numDisparityLevels, const DisparityFormat &format = DisparityFormat());
 
     cv::Mat getImage () const;
     void getImage (cv::Mat &image) const;
 
 signals:
     void eject ();
-    void disparityVisualizationRequest (const cv::Mat disparity, int numDisparityLevels);
+    void disparityVisualizationRequest (const cv::Mat disparity, int numDisparityLevels, const DisparityFormat format);
 
     void visualizationMethodChanged ();
     void imageChanged ();
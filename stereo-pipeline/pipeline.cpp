@@ -19,9 +19,11 @@
 
 #include "pipeline.h"
 
+#include "disparity_filter.h"
 #include "disparity_visualization.h"
 #include "image_pair_source.h"
 #include "plugin_factory.h"
+#include "point_cloud_filter.h"
 #include "rectification.h"
 #include "reprojection.h"
 #include "stereo_method.h"
@@ -42,7 +44,9 @@
 #include "pipeline-async/source_element.h"
 #include "pipeline-async/rectification_element.h"
 #include "pipeline-async/method_element.h"
+#include "pipeline-async/disparity_filter_element.h"
 #include "pipeline-async/reprojection_element.h"
+#include "pipeline-async/point_cloud_filter_element.h"
 #include "pipeline-async/visualization_element.h"
 
 
@@ -51,13 +55,20 @@ namespace StereoToolbox {
 namespace Pipeline {
 
 
+// Automatic region-of-interest margin, used until the disparity range
+// of the stereo method is known
+static const int DefaultRegionOfInterestMargin = 128;
+
 
 PipelinePrivate::PipelinePrivate (Pipeline *parent)
-    : q_ptr(parent)
+    : q_ptr(parent),
+      regionOfInterestMargin(-1)
 {
     Q_Q(Pipeline);
 
     qRegisterMetaType< cv::Mat >();
+    qRegisterMetaType< DisparityFormat >();
+    qRegisterMetaType< std::vector<cv::Rect> >();
 
     // Name the main thread, for easier debugging
     QCoreApplication::instance()->thread()->setObjectName("MainThread");
@@ -66,9 +77,16 @@ PipelinePrivate::PipelinePrivate (Pipeline *parent)
     source = new AsyncPipeline::SourceElement(q);
     rectification = new AsyncPipeline::RectificationElement(q);
     stereoMethod = new AsyncPipeline::MethodElement(q);
+    disparityFilter = new AsyncPipeline::DisparityFilterElement(q);
     reprojection = new AsyncPipeline::ReprojectionElement(q);
+    pointCloudFilter = new AsyncPipeline::PointCloudFilterElement(q);
     visualization = new AsyncPipeline::VisualizationElement(q);
 
+    // Disparity and point-cloud filters are optional, and disabled
+    // by default
+    disparityFilter->setState(false);
+    pointCloudFilter->setState(false);
+
     // Automatically propagate reprojection matrix from rectification
     // object to reprojection object
     q->connect(rectification->getRectification(), &Rectification::calibrationChanged, q, [this] (bool valid) {
@@ -85,9 +103,15 @@ PipelinePrivate::PipelinePrivate (Pipeline *parent)
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::error, q, [this, q] (const QString message) {
         emit q->error(Pipeline::ErrorStereoMethod, message);
     });
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::error, q, [this, q] (const QString message) {
+        emit q->error(Pipeline::ErrorDisparityFilter, message);
+    });
     q->connect(reprojection, &AsyncPipeline::ReprojectionElement::error, q, [this, q] (const QString message) {
         emit q->error(Pipeline::ErrorReprojection, message);
     });
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::error, q, [this, q] (const QString message) {
+        emit q->error(Pipeline::ErrorPointCloudFilter, message);
+    });
     q->connect(visualization, &AsyncPipeline::VisualizationElement::error, q, [this, q] (const QString message) {
         emit q->error(Pipeline::ErrorVisualization, message);
     });
@@ -96,9 +120,18 @@ PipelinePrivate::PipelinePrivate (Pipeline *parent)
     q->connect(source, &AsyncPipeline::SourceElement::stateChanged, q, &Pipeline::imagePairSourceStateChanged);
     q->connect(rectification, &AsyncPipeline::RectificationElement::stateChanged, q, &Pipeline::rectificationStateChanged);
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::stateChanged, q, &Pipeline::stereoMethodStateChanged);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::stateChanged, q, &Pipeline::disparityFilterStateChanged);
     q->connect(reprojection, &AsyncPipeline::ReprojectionElement::stateChanged, q, &Pipeline::reprojectionStateChanged);
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::stateChanged, q, &Pipeline::pointCloudFilterStateChanged);
     q->connect(visualization, &AsyncPipeline::VisualizationElement::stateChanged, q, &Pipeline::visualizationStateChanged);
 
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::temporalPredictionChanged, q, &Pipeline::stereoMethodTemporalPredictionChanged);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::temporalPredictionChanged, q, &Pipeline::computeDisparity);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::bandParallelChanged, q, &Pipeline::stereoMethodBandParallelChanged);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::bandParallelChanged, q, &Pipeline::computeDisparity);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::consistencyCheckChanged, q, &Pipeline::stereoMethodConsistencyCheckChanged);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::consistencyCheckChanged, q, &Pipeline::computeDisparity);
+
     // Setup processing chain
     q->connect(source, &AsyncPipeline::SourceElement::framerateLimitChanged, q, &Pipeline::imageCaptureFramerateLimitChanged);
     q->connect(source, &AsyncPipeline::SourceElement::imagesChanged, q, &Pipeline::inputImagesChanged);
@@ -112,15 +145,25 @@ PipelinePrivate::PipelinePrivate (Pipeline *parent)
     q->connect(rectification, &AsyncPipeline::RectificationElement::frameRateReport, q, &Pipeline::rectificationFramerateUpdated);
 
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::disparityChanged, q, &Pipeline::disparityChanged);
-    q->connect(stereoMethod, &AsyncPipeline::MethodElement::disparityChanged, q, &Pipeline::reprojectPoints);
-    q->connect(stereoMethod, &AsyncPipeline::MethodElement::disparityChanged, q, &Pipeline::visualizeDisparity);
+    q->connect(stereoMethod, &AsyncPipeline::MethodElement::disparityChanged, q, &Pipeline::filterDisparity);
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::frameDropped, q, &Pipeline::stereoMethodFrameDropped);
     q->connect(rectification, &AsyncPipeline::MethodElement::frameRateReport, q, &Pipeline::stereoMethodFramerateUpdated);
 
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::disparityChanged, q, &Pipeline::filteredDisparityChanged);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::disparityChanged, q, &Pipeline::reprojectPoints);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::disparityChanged, q, &Pipeline::visualizeDisparity);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::frameDropped, q, &Pipeline::disparityFilterFrameDropped);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::frameRateReport, q, &Pipeline::disparityFilterFramerateUpdated);
+
     q->connect(reprojection, &AsyncPipeline::ReprojectionElement::pointsChanged, q, &Pipeline::pointsChanged);
     q->connect(reprojection, &AsyncPipeline::ReprojectionElement::frameDropped, q, &Pipeline::reprojectionFrameDropped);
+    q->connect(reprojection, &AsyncPipeline::ReprojectionElement::pointsChanged, q, &Pipeline::filterPoints);
     q->connect(rectification, &AsyncPipeline::ReprojectionElement::frameRateReport, q, &Pipeline::reprojectionFramerateUpdated);
 
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::pointCloudChanged, q, &Pipeline::pointCloudChanged);
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::frameDropped, q, &Pipeline::pointCloudFilterFrameDropped);
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::frameRateReport, q, &Pipeline::pointCloudFilterFramerateUpdated);
+
     q->connect(visualization, &AsyncPipeline::VisualizationElement::imageChanged, q, &Pipeline::visualizationChanged);
     q->connect(visualization, &AsyncPipeline::VisualizationElement::frameDropped, q, &Pipeline::visualizationFrameDropped);
     q->connect(visualization, &AsyncPipeline::ReprojectionElement::frameRateReport, q, &Pipeline::visualizationFramerateUpdated);
@@ -128,9 +171,25 @@ PipelinePrivate::PipelinePrivate (Pipeline *parent)
     // Re-computation of individual steps upon relevant changes in components
     q->connect(rectification, &AsyncPipeline::RectificationElement::calibrationChanged, q, &Pipeline::rectifyImages);
     q->connect(rectification, &AsyncPipeline::RectificationElement::performRectificationChanged, q, &Pipeline::rectifyImages);
+    q->connect(rectification, &AsyncPipeline::RectificationElement::regionsOfInterestChanged, q, &Pipeline::regionsOfInterestChanged);
+    q->connect(rectification, &AsyncPipeline::RectificationElement::regionsOfInterestChanged, q, &Pipeline::rectifyImages);
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::methodChanged, q, &Pipeline::computeDisparity);
     q->connect(stereoMethod, &AsyncPipeline::MethodElement::parameterChanged, q, &Pipeline::computeDisparity);
+    q->connect(disparityFilter->getDisparityFilter(), &DisparityFilter::parameterChanged, q, &Pipeline::filterDisparity);
+    q->connect(disparityFilter, &AsyncPipeline::DisparityFilterElement::stateChanged, q, &Pipeline::filterDisparity);
     q->connect(visualization, &AsyncPipeline::VisualizationElement::visualizationMethodChanged, q, &Pipeline::visualizeDisparity);
+    q->connect(pointCloudFilter->getPointCloudFilter(), &PointCloudFilter::parameterChanged, q, &Pipeline::filterPoints);
+    q->connect(pointCloudFilter, &AsyncPipeline::PointCloudFilterElement::stateChanged, q, &Pipeline::filterPoints);
+}
+
+
+void PipelinePrivate::getOutputDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const
+{
+    if (disparityFilter->getState()) {
+        disparityFilter->getDisparity(disparity, numDisparityLevels, format, offset);
+    } else {
+        stereoMethod->getDisparity(disparity, numDisparityLevels, format, offset);
+    }
 }
 
 
@@ -151,6 +210,13 @@ void Pipeline::rectifyImages ()
 {
     Q_D(Pipeline);
 
+    // Automatic region-of-interest margin follows the disparity range
+    // of the stereo method
+    if (d->regionOfInterestMargin < 0) {
+        int maxDisparity = d->stereoMethod->getMaxDisparity();
+        d->rectification->setRegionMargin(maxDisparity >= 0 ? maxDisparity : DefaultRegionOfInterestMargin);
+    }
+
     cv::Mat imageL, imageR;
     d->source->getImages(imageL, imageR);
     d->rectification->rectifyImages(imageL, imageR);
@@ -161,8 +227,29 @@ void Pipeline::computeDisparity ()
     Q_D(Pipeline);
 
     cv::Mat imageL, imageR;
-    d->rectification->getImages(imageL, imageR);
-    d->stereoMethod->computeDisparity(imageL, imageR);
+    cv::Rect bounds;
+    std::vector<cv::Rect> regions;
+    d->rectification->getImages(imageL, imageR, bounds, regions);
+    d->stereoMethod->computeDisparity(imageL, imageR, bounds, regions);
+}
+
+void Pipeline::filterDisparity ()
+{
+    Q_D(Pipeline);
+
+    // Without the post-filter, method's disparity is final
+    if (!d->disparityFilter->getState()) {
+        reprojectPoints();
+        visualizeDisparity();
+        return;
+    }
+
+    cv::Mat disparity, image, confidence;
+    int numLevels;
+    DisparityFormat format;
+    cv::Point offset;
+    d->stereoMethod->getPostFilterInput(disparity, numLevels, format, offset, image, confidence);
+    d->disparityFilter->filterDisparity(disparity, numLevels, format, offset, image, confidence);
 }
 
 void Pipeline::reprojectPoints ()
@@ -171,8 +258,20 @@ void Pipeline::reprojectPoints ()
 
     cv::Mat disparity;
     int numLevels;
-    d->stereoMethod->getDisparity(disparity, numLevels);
-    d->reprojection->reprojectDisparity(disparity, numLevels);
+    DisparityFormat format;
+    cv::Point offset;
+    d->getOutputDisparity(disparity, numLevels, format, offset);
+    d->reprojection->reprojectDisparity(disparity, numLevels, format, offset);
+}
+
+void Pipeline::filterPoints ()
+{
+    Q_D(Pipeline);
+
+    cv::Mat points;
+    cv::Point offset;
+    d->reprojection->getPoints(points, offset);
+    d->pointCloudFilter->filterPoints(points, d->reprojection->getReprojection()->getReprojectionMatrix(), offset);
 }
 
 void Pipeline::visualizeDisparity ()
@@ -181,8 +280,10 @@ void Pipeline::visualizeDisparity ()
 
     cv::Mat disparity;
     int numLevels;
-    d->stereoMethod->getDisparity(disparity, numLevels);
-    d->visualization->visualizeDisparity(disparity, numLevels);
+    DisparityFormat format;
+    cv::Point offset;
+    d->getOutputDisparity(disparity, numLevels, format, offset);
+    d->visualization->visualizeDisparity(disparity, numLevels, format);
 }
 
 
@@ -333,6 +434,47 @@ void Pipeline::getRectifiedImages (cv::Mat &imageLeft, cv::Mat &imageRight) cons
     return d->rectification->getImages(imageLeft, imageRight);
 }
 
+// Regions of interest
+void Pipeline::setRegionsOfInterest (const std::vector<cv::Rect> &regions)
+{
+    Q_D(Pipeline);
+    d->rectification->setRegionsOfInterest(regions);
+}
+
+std::vector<cv::Rect> Pipeline::getRegionsOfInterest () const
+{
+    Q_D(const Pipeline);
+    return d->rectification->getRegionsOfInterest();
+}
+
+void Pipeline::clearRegionsOfInterest ()
+{
+    Q_D(Pipeline);
+    d->rectification->setRegionsOfInterest(std::vector<cv::Rect>());
+}
+
+void Pipeline::setRegionOfInterestMargin (int margin)
+{
+    Q_D(Pipeline);
+    d->regionOfInterestMargin = margin;
+    if (margin >= 0) {
+        d->rectification->setRegionMargin(margin);
+    }
+    rectifyImages();
+}
+
+int Pipeline::getRegionOfInterestMargin () const
+{
+    Q_D(const Pipeline);
+    return d->regionOfInterestMargin;
+}
+
+cv::Rect Pipeline::getRectifiedImageBounds () const
+{
+    Q_D(const Pipeline);
+    return d->rectification->getBounds();
+}
+
 // Timings
 int Pipeline::getRectificationTime () const
 {
@@ -383,6 +525,126 @@ bool Pipeline::getStereoMethodState () const
     return d->stereoMethod->getState();
 }
 
+int Pipeline::getStereoMethodCapabilities () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getCapabilities();
+}
+
+
+// Temporal prediction
+void Pipeline::setStereoMethodTemporalPrediction (bool enable)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setTemporalPrediction(enable);
+}
+
+bool Pipeline::getStereoMethodTemporalPrediction () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getTemporalPrediction();
+}
+
+void Pipeline::setStereoMethodTemporalMargin (int margin)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setTemporalMargin(margin);
+}
+
+int Pipeline::getStereoMethodTemporalMargin () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getTemporalMargin();
+}
+
+void Pipeline::setStereoMethodKeyframeInterval (int interval)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setKeyframeInterval(interval);
+}
+
+int Pipeline::getStereoMethodKeyframeInterval () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getKeyframeInterval();
+}
+
+float Pipeline::getStereoMethodSearchFraction () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getSearchFraction();
+}
+
+
+// Band-parallel execution
+void Pipeline::setStereoMethodBandParallel (bool enable)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setBandParallel(enable);
+}
+
+bool Pipeline::getStereoMethodBandParallel () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getBandParallel();
+}
+
+void Pipeline::setStereoMethodNumberOfBands (int numBands)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setNumberOfBands(numBands);
+}
+
+int Pipeline::getStereoMethodNumberOfBands () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getNumberOfBands();
+}
+
+void Pipeline::setStereoMethodBandOverlap (int overlap)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setBandOverlap(overlap);
+}
+
+int Pipeline::getStereoMethodBandOverlap () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getBandOverlap();
+}
+
+
+// Left-right consistency check
+void Pipeline::setStereoMethodConsistencyCheck (bool enable)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setConsistencyCheck(enable);
+}
+
+bool Pipeline::getStereoMethodConsistencyCheck () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getConsistencyCheck();
+}
+
+void Pipeline::setStereoMethodConsistencyThreshold (float threshold)
+{
+    Q_D(Pipeline);
+    d->stereoMethod->setConsistencyThreshold(threshold);
+}
+
+float Pipeline::getStereoMethodConsistencyThreshold () const
+{
+    Q_D(const Pipeline);
+    return d->stereoMethod->getConsistencyThreshold();
+}
+
+void Pipeline::getStereoMethodConsistencyMaps (cv::Mat &invalidMask, cv::Mat &confidence) const
+{
+    Q_D(const Pipeline);
+    d->stereoMethod->getConsistencyMaps(invalidMask, confidence);
+}
+
 
 // Parameters import/export
 void Pipeline::loadStereoMethodParameters (const QString &filename)
@@ -418,6 +680,30 @@ void Pipeline::getDisparity (cv::Mat &disparity, int &numDisparityLevels) const
     d->stereoMethod->getDisparity(disparity, numDisparityLevels);
 }
 
+void Pipeline::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const
+{
+    Q_D(const Pipeline);
+    d->stereoMethod->getDisparity(disparity, numDisparityLevels, format);
+}
+
+void Pipeline::getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const
+{
+    Q_D(const Pipeline);
+    d->stereoMethod->getDisparity(disparity, numDisparityLevels, format, offset);
+}
+
+void Pipeline::getFloatDisparity (cv::Mat &disparity) const
+{
+    Q_D(const Pipeline);
+
+    cv::Mat rawDisparity;
+    int numDisparityLevels;
+    DisparityFormat format;
+    d->stereoMethod->getDisparity(rawDisparity, numDisparityLevels, format);
+
+    Utils::convertDisparityToFloat(rawDisparity, format, disparity);
+}
+
 
 // Timings
 int Pipeline::getStereoMethodTime () const
@@ -440,6 +726,77 @@ float Pipeline::getStereoMethodFramerate () const
 }
 
 
+// *********************************************************************
+// *                      Disparity post-filter                        *
+// *********************************************************************
+DisparityFilter *Pipeline::getDisparityFilter ()
+{
+    Q_D(Pipeline);
+    return d->disparityFilter->getDisparityFilter();
+}
+
+
+// Filter state
+void Pipeline::setDisparityFilterState (bool active)
+{
+    Q_D(Pipeline);
+    d->disparityFilter->setState(active);
+}
+
+bool Pipeline::getDisparityFilterState () const
+{
+    Q_D(const Pipeline);
+    return d->disparityFilter->getState();
+}
+
+
+cv::Mat Pipeline::getFilteredDisparity () const
+{
+    Q_D(const Pipeline);
+    return d->disparityFilter->getDisparity();
+}
+
+void Pipeline::getFilteredDisparity (cv::Mat &disparity) const
+{
+    Q_D(const Pipeline);
+    int numDisparityLevels;
+    d->disparityFilter->getDisparity(disparity, numDisparityLevels);
+}
+
+void Pipeline::getFilteredDisparity (cv::Mat &disparity, int &numDisparityLevels) const
+{
+    Q_D(const Pipeline);
+    d->disparityFilter->getDisparity(disparity, numDisparityLevels);
+}
+
+void Pipeline::getFilteredDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const
+{
+    Q_D(const Pipeline);
+    d->disparityFilter->getDisparity(disparity, numDisparityLevels, format, offset);
+}
+
+
+// Timings
+int Pipeline::getDisparityFilterTime () const
+{
+    Q_D(const Pipeline);
+    return d->disparityFilter->getLastOperationTime();
+}
+
+
+int Pipeline::getDisparityFilterDroppedFrames () const
+{
+    Q_D(const Pipeline);
+    return d->disparityFilter->getNumberOfDroppedFrames();
+}
+
+float Pipeline::getDisparityFilterFramerate () const
+{
+    Q_D(const Pipeline);
+    return d->disparityFilter->getFramesPerSecond();
+}
+
+
 
 // *********************************************************************
 // *                      Disparity visualization                      *
@@ -536,6 +893,12 @@ void Pipeline::getPoints (cv::Mat &points) const
     d->reprojection->getPoints(points);
 }
 
+void Pipeline::getPoints (cv::Mat &points, cv::Point &offset) const
+{
+    Q_D(const Pipeline);
+    d->reprojection->getPoints(points, offset);
+}
+
 
 // Timings
 int Pipeline::getReprojectionTime () const
@@ -558,6 +921,64 @@ float Pipeline::getReprojectionFramerate () const
 }
 
 
+// *********************************************************************
+// *                        Point-cloud filter                         *
+// *********************************************************************
+PointCloudFilter *Pipeline::getPointCloudFilter ()
+{
+    Q_D(Pipeline);
+    return d->pointCloudFilter->getPointCloudFilter();
+}
+
+
+// Filter state
+void Pipeline::setPointCloudFilterState (bool active)
+{
+    Q_D(Pipeline);
+    d->pointCloudFilter->setState(active);
+}
+
+bool Pipeline::getPointCloudFilterState () const
+{
+    Q_D(const Pipeline);
+    return d->pointCloudFilter->getState();
+}
+
+
+cv::Mat Pipeline::getPointCloud () const
+{
+    Q_D(const Pipeline);
+    return d->pointCloudFilter->getPointCloud();
+}
+
+void Pipeline::getPointCloud (cv::Mat &cloud) const
+{
+    Q_D(const Pipeline);
+    d->pointCloudFilter->getPointCloud(cloud);
+}
+
+
+// Timings
+int Pipeline::getPointCloudFilterTime () const
+{
+    Q_D(const Pipeline);
+    return d->pointCloudFilter->getLastOperationTime();
+}
+
+
+int Pipeline::getPointCloudFilterDroppedFrames () const
+{
+    Q_D(const Pipeline);
+    return d->pointCloudFilter->getNumberOfDroppedFrames();
+}
+
+float Pipeline::getPointCloudFilterFramerate () const
+{
+    Q_D(const Pipeline);
+    return d->pointCloudFilter->getFramesPerSecond();
+}
+
+
 } // Pipeline
 } // StereoToolbox
 } // MVL
@@ -21,6 +21,7 @@
 #define MVL_STEREO_TOOLBOX__PIPELINE__PIPELINE_H
 
 #include <stereo-pipeline/export.h>
+#include <stereo-pipeline/disparity_format.h>
 
 #include <QtCore>
 #include <opencv2/core.hpp>
@@ -34,8 +35,10 @@ namespace Pipeline {
 class ImagePairSource;
 class Rectification;
 class StereoMethod;
+class DisparityFilter;
 class DisparityVisualization;
 class Reprojection;
+class PointCloudFilter;
 
 class PipelinePrivate;
 
@@ -85,6 +88,22 @@ public:
     cv::Mat getRightRectifiedImage () const;
     void getRectifiedImages (cv::Mat &imageLeft, cv::Mat &imageRight) const;
 
+    // Regions of interest (in rectified image coordinates): only these
+    // are rectified and passed on to the stereo method, so processing
+    // cost scales with their area. Each region is extended to the left
+    // by the disparity margin (negative margin selects the method's
+    // disparity range). Rectified images, disparity and points then
+    // cover only the bounding box of processed regions, whose position
+    // within the rectified image is given by getRectifiedImageBounds()
+    void setRegionsOfInterest (const std::vector<cv::Rect> &regions);
+    std::vector<cv::Rect> getRegionsOfInterest () const;
+    void clearRegionsOfInterest ();
+
+    void setRegionOfInterestMargin (int margin);
+    int getRegionOfInterestMargin () const;
+
+    cv::Rect getRectifiedImageBounds () const;
+
     int getRectificationTime () const;
     int getRectificationDroppedFrames () const;
     float getRectificationFramerate () const;
@@ -100,14 +119,90 @@ public:
     void setStereoMethodState (bool active);
     bool getStereoMethodState () const;
 
+    // Capabilities of current stereo method (StereoMethod2::Capability
+    // flags); methods implementing only basic interface report none
+    int getStereoMethodCapabilities () const;
+
+    // Temporal prediction for video streams: disparity search is
+    // restricted to per-tile ranges predicted from previous frame's
+    // disparity (extended by margin), with full search on scene cuts,
+    // on key frames and in low-confidence tiles. Requires method with
+    // StereoMethod2::CapabilityDisparityRange
+    void setStereoMethodTemporalPrediction (bool enable);
+    bool getStereoMethodTemporalPrediction () const;
+
+    void setStereoMethodTemporalMargin (int margin);
+    int getStereoMethodTemporalMargin () const;
+
+    void setStereoMethodKeyframeInterval (int interval);
+    int getStereoMethodKeyframeInterval () const;
+
+    // Fraction of the full search space evaluated in last frame
+    float getStereoMethodSearchFraction () const;
+
+    // Band-parallel execution: image pair is split into overlapping
+    // horizontal bands, which are processed in parallel by separate
+    // method instances and blended across the overlaps. Requires
+    // method with StereoMethod2::CapabilityBandParallel; zero bands
+    // selects the ideal thread count
+    void setStereoMethodBandParallel (bool enable);
+    bool getStereoMethodBandParallel () const;
+
+    void setStereoMethodNumberOfBands (int numBands);
+    int getStereoMethodNumberOfBands () const;
+
+    void setStereoMethodBandOverlap (int overlap);
+    int getStereoMethodBandOverlap () const;
+
+    // Left-right consistency check: right-image disparity is provided by
+    // the method or computed from the flipped image pair (concurrently,
+    // if the method allows it), and pixels whose disparities differ by
+    // more than the threshold are invalidated. The invalidation mask
+    // (CV_8U, 255 for invalid pixels) and confidence map (CV_32F, 0-1)
+    // of last frame are empty when the check is disabled
+    void setStereoMethodConsistencyCheck (bool enable);
+    bool getStereoMethodConsistencyCheck () const;
+
+    void setStereoMethodConsistencyThreshold (float threshold);
+    float getStereoMethodConsistencyThreshold () const;
+
+    void getStereoMethodConsistencyMaps (cv::Mat &invalidMask, cv::Mat &confidence) const;
+
     cv::Mat getDisparity () const;
     void getDisparity (cv::Mat &disparity) const;
     void getDisparity (cv::Mat &disparity, int &numDisparityLevels) const;
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format) const;
+    // Offset is the position of disparity image within the rectified
+    // image (non-zero when processing regions of interest)
+    void getDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const;
+
+    // Disparity is stored in method's native format (see getDisparity
+    // overload with format descriptor); this one explicitly converts it
+    // to CV_32F
+    void getFloatDisparity (cv::Mat &disparity) const;
 
     int getStereoMethodTime () const;
     int getStereoMethodDroppedFrames () const;
     float getStereoMethodFramerate () const;
 
+    // Disparity post-filter (disabled by default): edge-aware filtering
+    // of method's disparity, guided by the left rectified image. When
+    // active, its output (CV_32F, identity format) is used for
+    // visualization and reprojection instead of method's disparity
+    DisparityFilter *getDisparityFilter ();
+
+    void setDisparityFilterState (bool active);
+    bool getDisparityFilterState () const;
+
+    cv::Mat getFilteredDisparity () const;
+    void getFilteredDisparity (cv::Mat &disparity) const;
+    void getFilteredDisparity (cv::Mat &disparity, int &numDisparityLevels) const;
+    void getFilteredDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const;
+
+    int getDisparityFilterTime () const;
+    int getDisparityFilterDroppedFrames () const;
+    float getDisparityFilterFramerate () const;
+
     // Disparity visualization
     DisparityVisualization *getVisualization ();
 
@@ -130,10 +225,27 @@ public:
     cv::Mat getPoints () const;
     void getPoints (cv::Mat &points) const;
 
+    // Points along with the position of their disparity image within
+    // the rectified image, as required by Reprojection::convertToPoints()
+    void getPoints (cv::Mat &points, cv::Point &offset) const;
+
     int getReprojectionTime () const;
     int getReprojectionDroppedFrames () const;
     float getReprojectionFramerate () const;
 
+    // Point-cloud filter (disabled by default)
+    PointCloudFilter *getPointCloudFilter ();
+
+    void setPointCloudFilterState (bool active);
+    bool getPointCloudFilterState () const;
+
+    cv::Mat getPointCloud () const;
+    void getPointCloud (cv::Mat &cloud) const;
+
+    int getPointCloudFilterTime () const;
+    int getPointCloudFilterDroppedFrames () const;
+    float getPointCloudFilterFramerate () const;
+
 
     // Error types
     enum ErrorType {
@@ -143,20 +255,26 @@ public:
         ErrorStereoMethod,
         ErrorVisualization,
         ErrorReprojection,
+        ErrorPointCloudFilter,
+        ErrorDisparityFilter,
     };
 
 protected:
     // Processing steps
     void rectifyImages ();
     void computeDisparity ();
+    void filterDisparity ();
     void reprojectPoints ();
+    void filterPoints ();
     void visualizeDisparity ();
 
 signals:
     void inputImagesChanged ();
     void rectifiedImagesChanged ();
     void disparityChanged ();
+    void filteredDisparityChanged ();
     void pointsChanged ();
+    void pointCloudChanged ();
     void visualizationChanged ();
 
     void imageCaptureFramerateLimitChanged (double limit);
@@ -164,14 +282,18 @@ signals:
     void imageCaptureFrameDropped (int count);
     void rectificationFrameDropped (int count);
     void stereoMethodFrameDropped (int count);
+    void disparityFilterFrameDropped (int count);
     void visualizationFrameDropped (int count);
     void reprojectionFrameDropped (int count);
+    void pointCloudFilterFrameDropped (int count);
 
     void imageCaptureFramerateUpdated (float fps);
     void rectificationFramerateUpdated (float fps);
     void stereoMethodFramerateUpdated (float fps);
+    void disparityFilterFramerateUpdated (float fps);
     void visualizationFramerateUpdated (float fps);
     void reprojectionFramerateUpdated (float fps);
+    void pointCloudFilterFramerateUpdated (float fps);
 
 signals:
     void error (int domain, const QString &message);
@@ -181,8 +303,16 @@ signals:
     void imagePairSourceStateChanged (bool active);
     void rectificationStateChanged (bool active);
     void stereoMethodStateChanged (bool active);
+    void disparityFilterStateChanged (bool active);
     void visualizationStateChanged (bool active);
     void reprojectionStateChanged (bool active);
+    void pointCloudFilterStateChanged (bool active);
+
+    void stereoMethodTemporalPredictionChanged (bool enabled);
+    void stereoMethodBandParallelChanged (bool enabled);
+    void stereoMethodConsistencyCheckChanged (bool enabled);
+
+    void regionsOfInterestChanged ();
 };
 
 
@@ -28,6 +28,7 @@
 
 
 Q_DECLARE_METATYPE(cv::Mat);
+Q_DECLARE_METATYPE(std::vector<cv::Rect>);
 
 
 namespace MVL {
@@ -38,7 +39,9 @@ namespace AsyncPipeline {
     class SourceElement;
     class RectificationElement;
     class MethodElement;
+    class DisparityFilterElement;
     class ReprojectionElement;
+    class PointCloudFilterElement;
     class VisualizationElement;
 }
 
@@ -56,8 +59,17 @@ protected:
     AsyncPipeline::SourceElement *source;
     AsyncPipeline::RectificationElement *rectification;
     AsyncPipeline::MethodElement *stereoMethod;
+    AsyncPipeline::DisparityFilterElement *disparityFilter;
     AsyncPipeline::ReprojectionElement *reprojection;
+    AsyncPipeline::PointCloudFilterElement *pointCloudFilter;
     AsyncPipeline::VisualizationElement *visualization;
+
+    // Final disparity: output of disparity post-filter if active,
+    // otherwise stereo method's disparity
+    void getOutputDisparity (cv::Mat &disparity, int &numDisparityLevels, DisparityFormat &format, cv::Point &offset) const;
+
+    // Disparity margin of regions of interest; negative for automatic
+    int regionOfInterestMargin;
 };
 
 
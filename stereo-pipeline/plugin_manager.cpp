@@ -19,6 +19,7 @@
 
 #include "plugin_manager.h"
 #include "plugin_factory.h"
+#include "plugin_proxy.h"
 
 
 #include "plugin_manager_p.h"
@@ -63,13 +64,49 @@ static void recursiveDirectoryScan (QDir dir, QStringList &files)
     }
 }
 
+// Plugin index cache: metadata of plugin libraries, keyed by their
+// absolute path and validated by file size and modification time, so
+// that unchanged libraries need not be scanned again
+static QString getIndexFileName ()
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheDir.isEmpty()) {
+        return QString();
+    }
+    return QDir(cacheDir).filePath(QStringLiteral("mvl-stereo-pipeline-plugins.json"));
+}
+
+static QJsonObject loadIndex (const QString &indexFileName)
+{
+    QFile file(indexFileName);
+    if (indexFileName.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+static void saveIndex (const QString &indexFileName, const QJsonObject &index)
+{
+    if (indexFileName.isEmpty() || !QDir().mkpath(QFileInfo(indexFileName).absolutePath())) {
+        return;
+    }
+
+    QSaveFile file(indexFileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
 void PluginManager::setPluginDirectory (const QString &path)
 {
     Q_D(PluginManager);
 
-    // Clear old plugins
+    // Clear old plugins; instances of static plugins are owned by Qt
     for (QObject *plugin : d->plugins) {
-        delete plugin;
+        if (plugin->parent() == this) {
+            delete plugin;
+        }
     }
     d->plugins.clear();
 
@@ -86,26 +123,98 @@ void PluginManager::setPluginDirectory (const QString &path)
         }
     }
 
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    // Statically-linked plugins take precedence over dynamic plugins
+    // of the same type and name
+    QSet<QString> staticPlugins;
+    for (const QStaticPlugin &staticPlugin : QPluginLoader::staticPlugins()) {
+        PluginFactory::PluginType type;
+        QString shortName, description;
+        if (!PluginProxy::parseMetaData(staticPlugin.metaData(), type, shortName, description)) {
+            continue; // Not ours (e.g., Qt's own static plugins)
+        }
+
+        PluginFactory *factory = qobject_cast<PluginFactory *>(staticPlugin.instance());
+        if (factory) {
+            d->plugins.append(staticPlugin.instance());
+            staticPlugins.insert(QStringLiteral("%1/%2").arg(type).arg(shortName));
+
+            qInfo() << qPrintable(QStringLiteral("Plugin '%1' is statically linked").arg(shortName));
+        }
+    }
+
     // Recursively scan for plugins
     QStringList files;
     recursiveDirectoryScan(d->pluginDirectory.absolutePath(), files);
 
+    const QString indexFileName = getIndexFileName();
+    const QJsonObject oldIndex = loadIndex(indexFileName);
+    QJsonObject index;
+
     for (const QString &fileName : files) {
         // Make sure it is a library
         if (!QLibrary::isLibrary(fileName)) {
             continue;
         }
 
-        // Load plugin
+        QElapsedTimer timer;
+        timer.start();
+
+        // Metadata; from index, if library has not changed since
+        const QFileInfo fileInfo(fileName);
+        const QJsonObject entry = oldIndex.value(fileName).toObject();
+
+        QJsonObject metaData;
+        bool cached = false;
+        if (entry.value(QStringLiteral("size")).toDouble() == fileInfo.size() && entry.value(QStringLiteral("modified")).toDouble() == fileInfo.lastModified().toMSecsSinceEpoch()) {
+            metaData = entry.value(QStringLiteral("metaData")).toObject();
+            cached = true;
+        } else {
+            // Reads the metadata section without loading the library
+            metaData = QPluginLoader(fileName).metaData();
+        }
+
+        QJsonObject newEntry;
+        newEntry.insert(QStringLiteral("size"), static_cast<double>(fileInfo.size()));
+        newEntry.insert(QStringLiteral("modified"), static_cast<double>(fileInfo.lastModified().toMSecsSinceEpoch()));
+        newEntry.insert(QStringLiteral("metaData"), metaData);
+        index.insert(fileName, newEntry);
+
+        // Not a Qt plugin (e.g., a support library)
+        if (metaData.isEmpty()) {
+            continue;
+        }
+
+        // Plugins that describe themselves are loaded on demand; others
+        // are loaded immediately
+        PluginFactory::PluginType type;
+        QString shortName, description;
+        if (PluginProxy::parseMetaData(metaData, type, shortName, description)) {
+            if (staticPlugins.contains(QStringLiteral("%1/%2").arg(type).arg(shortName))) {
+                continue;
+            }
+
+            d->plugins.append(new PluginProxy(fileName, type, shortName, description, this));
+
+            qInfo() << qPrintable(QStringLiteral("Plugin '%1' indexed in %2 ms%3").arg(shortName).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 2).arg(cached ? QStringLiteral(" (cached)") : QString()));
+            continue;
+        }
+
         QPluginLoader loader(fileName);
         loader.setLoadHints(QLibrary::ResolveAllSymbolsHint);
 
         QObject *plugin = loader.instance();
         if (plugin) {
             PluginFactory *factory = qobject_cast<PluginFactory *>(plugin);
-            if (factory) {
+            if (factory && staticPlugins.contains(QStringLiteral("%1/%2").arg(factory->getPluginType()).arg(factory->getShortName()))) {
+                delete plugin;
+            } else if (factory) {
                 plugin->setParent(this);
                 d->plugins.append(plugin);
+
+                qInfo() << qPrintable(QStringLiteral("Plugin '%1' loaded in %2 ms (no metadata)").arg(factory->getShortName()).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 2));
             } else {
                 qWarning() << "Failed to cast plugged object to PluginFactory!";
                 delete plugin;
@@ -114,6 +223,12 @@ void PluginManager::setPluginDirectory (const QString &path)
             qWarning() << "Failed to load plugin:" << loader.errorString();
         }
     }
+
+    if (index != oldIndex) {
+        saveIndex(indexFileName, index);
+    }
+
+    qInfo() << qPrintable(QStringLiteral("Found %1 plugin(s) in %2 ms").arg(d->plugins.size()).arg(totalTimer.elapsed()));
 }
 
 QString PluginManager::getPluginDirectory () const
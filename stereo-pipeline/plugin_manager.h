@@ -32,6 +32,12 @@ namespace Pipeline {
 
 class PluginManagerPrivate;
 
+// Lists plugins in the plugin directory. Plugins that provide metadata
+// (type, short name and description) are listed without loading them;
+// their libraries are loaded when the first object is created via the
+// PluginFactory interface. Metadata of plugin libraries is cached.
+// Statically-linked plugins (WITH_STATIC_PLUGINS builds) are listed
+// as well, and take precedence over dynamic ones with the same name
 class MVL_STEREO_PIPELINE_EXPORT PluginManager : public QObject
 {
     Q_OBJECT
@@ -0,0 +1,145 @@
+/*
+ * Stereo Pipeline: lazily-loaded plugin
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "plugin_proxy.h"
+#include "exception.h"
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+PluginProxy::PluginProxy (const QString &fileName, PluginType type, const QString &shortName, const QString &description, QObject *parent)
+    : QObject(parent),
+      fileName(fileName),
+      type(type),
+      shortName(shortName),
+      description(description),
+      loader(nullptr),
+      factory(nullptr),
+      loadTime(-1)
+{
+}
+
+PluginProxy::~PluginProxy ()
+{
+    // Library remains loaded; objects created by the plugin may
+    // outlive the proxy
+    delete loader;
+}
+
+
+bool PluginProxy::parseMetaData (const QJsonObject &metaData, PluginType &type, QString &shortName, QString &description)
+{
+    // Plugin's own metadata is stored under "MetaData" key
+    const QJsonObject data = metaData.value(QStringLiteral("MetaData")).toObject();
+
+    const QString typeName = data.value(QStringLiteral("type")).toString();
+    if (typeName == QLatin1String("StereoMethod")) {
+        type = PluginStereoMethod;
+    } else if (typeName == QLatin1String("ImagePairSource")) {
+        type = PluginImagePairSource;
+    } else {
+        return false;
+    }
+
+    shortName = data.value(QStringLiteral("shortName")).toString();
+    description = data.value(QStringLiteral("description")).toString();
+
+    return !shortName.isEmpty();
+}
+
+
+PluginFactory::PluginType PluginProxy::getPluginType () const
+{
+    return type;
+}
+
+QString PluginProxy::getShortName () const
+{
+    return shortName;
+}
+
+QString PluginProxy::getDescription () const
+{
+    return description;
+}
+
+QObject *PluginProxy::createObject (QObject *parent) const
+{
+    return getFactory()->createObject(parent);
+}
+
+
+QString PluginProxy::getFileName () const
+{
+    return fileName;
+}
+
+bool PluginProxy::isLoaded () const
+{
+    QMutexLocker locker(&mutex);
+    return factory != nullptr;
+}
+
+qint64 PluginProxy::getLoadTime () const
+{
+    QMutexLocker locker(&mutex);
+    return loadTime;
+}
+
+
+PluginFactory *PluginProxy::getFactory () const
+{
+    QMutexLocker locker(&mutex);
+
+    if (factory) {
+        return factory;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!loader) {
+        loader = new QPluginLoader(fileName);
+        loader->setLoadHints(QLibrary::ResolveAllSymbolsHint);
+    }
+
+    // Plugin's root object is owned by the loader
+    QObject *plugin = loader->instance();
+    if (!plugin) {
+        throw Exception(QStringLiteral("Failed to load plugin '%1': %2").arg(shortName).arg(loader->errorString()));
+    }
+
+    factory = qobject_cast<PluginFactory *>(plugin);
+    if (!factory) {
+        throw Exception(QStringLiteral("Failed to cast plugin '%1' to PluginFactory!").arg(shortName));
+    }
+
+    loadTime = timer.elapsed();
+    qInfo() << qPrintable(QStringLiteral("Plugin '%1' loaded in %2 ms").arg(shortName).arg(loadTime));
+
+    return factory;
+}
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,83 @@
+/*
+ * Stereo Pipeline: lazily-loaded plugin
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__PLUGIN_PROXY_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__PLUGIN_PROXY_H
+
+#include <stereo-pipeline/plugin_factory.h>
+
+#include <QtCore>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+// Stands in for a plugin's factory, based on plugin's metadata (the
+// JSON file given to Q_PLUGIN_METADATA); the plugin library, along
+// with its dependencies, is loaded only when the first object is
+// created. Thread-safe
+class PluginProxy : public QObject, public PluginFactory
+{
+    Q_OBJECT
+    Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
+
+public:
+    PluginProxy (const QString &fileName, PluginType type, const QString &shortName, const QString &description, QObject *parent = nullptr);
+    virtual ~PluginProxy ();
+
+    // Parses plugin metadata; returns false if it does not describe
+    // the plugin
+    static bool parseMetaData (const QJsonObject &metaData, PluginType &type, QString &shortName, QString &description);
+
+    virtual PluginType getPluginType () const override;
+    virtual QString getShortName () const override;
+    virtual QString getDescription () const override;
+
+    // Loads the library on first call; throws on failure
+    virtual QObject *createObject (QObject *parent = nullptr) const override;
+
+    QString getFileName () const;
+
+    bool isLoaded () const;
+    qint64 getLoadTime () const; // In milliseconds; -1 if not loaded
+
+protected:
+    PluginFactory *getFactory () const;
+
+protected:
+    QString fileName;
+    PluginType type;
+    QString shortName;
+    QString description;
+
+    mutable QMutex mutex;
+    mutable QPluginLoader *loader;
+    mutable PluginFactory *factory;
+    mutable qint64 loadTime;
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
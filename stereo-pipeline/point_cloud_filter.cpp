@@ -0,0 +1,551 @@
+/*
+ * Stereo Pipeline: point-cloud filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "point_cloud_filter.h"
+#include "exception.h"
+#include "reprojection.h"
+
+#include "point_cloud_filter_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+// *********************************************************************
+// *                         Filtering helpers                         *
+// *********************************************************************
+// Snapshot of filter parameters, taken at the beginning of filtering
+// so that worker threads see a consistent set of values
+struct FilterSettings
+{
+    float nearDistance;
+    float farDistance;
+
+    bool boxCropping;
+    cv::Vec3f boxMinCorner;
+    cv::Vec3f boxMaxCorner;
+
+    int decimationMethod;
+    int stride;
+    float voxelSize;
+};
+
+typedef std::pair<quint64, cv::Vec4f> VoxelEntry;
+
+
+static inline bool acceptPoint (const FilterSettings &settings, const cv::Vec4f &point)
+{
+    // Invalid points
+    if (!std::isfinite(point[0]) || !std::isfinite(point[1]) || !std::isfinite(point[2])) {
+        return false;
+    }
+
+    // Depth range
+    if (point[2] < settings.nearDistance) {
+        return false;
+    }
+    if (settings.farDistance > 0 && point[2] > settings.farDistance) {
+        return false;
+    }
+
+    // Bounding box
+    if (settings.boxCropping) {
+        for (int i = 0; i < 3; i++) {
+            if (point[i] < settings.boxMinCorner[i] || point[i] > settings.boxMaxCorner[i]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Packs integer voxel coordinates (21 bits per axis) into a single
+// 64-bit key
+static inline quint64 computeVoxelKey (const cv::Vec4f &point, float invVoxelSize)
+{
+    const quint64 mask = 0x1FFFFF;
+
+    quint64 ix = static_cast<quint64>(static_cast<qint64>(std::floor(point[0]*invVoxelSize))) & mask;
+    quint64 iy = static_cast<quint64>(static_cast<qint64>(std::floor(point[1]*invVoxelSize))) & mask;
+    quint64 iz = static_cast<quint64>(static_cast<qint64>(std::floor(point[2]*invVoxelSize))) & mask;
+
+    return (ix << 42) | (iy << 21) | iz;
+}
+
+static inline int computeVoxelPartition (quint64 key, int numPartitions)
+{
+    // Mix the bits, so that neighbouring voxels end up in different
+    // partitions
+    key ^= key >> 29;
+    key *= 0x9E3779B97F4A7C15ULL;
+    key ^= key >> 32;
+
+    return static_cast<int>(key % numPartitions);
+}
+
+
+// First pass: cropping and stride decimation. Input is split into
+// stripes of rows; each stripe produces its own list of points (or,
+// in case of voxel-grid decimation, its own set of per-partition
+// lists of voxel entries)
+class CropBody : public cv::ParallelLoopBody
+{
+public:
+    CropBody (const cv::Mat &points, const FilterSettings &settings, int numStripes,
+              std::vector< std::vector<cv::Vec4f> > &stripeLists,
+              int numPartitions, std::vector< std::vector<VoxelEntry> > &partitionLists)
+        : points(points),
+          settings(settings),
+          numStripes(numStripes),
+          stripeLists(stripeLists),
+          numPartitions(numPartitions),
+          partitionLists(partitionLists)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const bool pointList = (points.type() == CV_32FC4);
+        const bool useStride = (settings.decimationMethod == PointCloudFilter::DecimationStride && settings.stride > 1);
+        const bool useVoxels = (settings.decimationMethod == PointCloudFilter::DecimationVoxelGrid);
+        const float invVoxelSize = 1.0f / settings.voxelSize;
+
+        for (int stripe = range.start; stripe < range.end; stripe++) {
+            int y0 = (points.rows * stripe) / numStripes;
+            int y1 = (points.rows * (stripe + 1)) / numStripes;
+
+            for (int y = y0; y < y1; y++) {
+                // Row-wise stride decimation for dense points
+                if (!pointList && useStride && (y % settings.stride)) {
+                    continue;
+                }
+
+                for (int x = 0; x < points.cols; x++) {
+                    cv::Vec4f point;
+
+                    if (pointList) {
+                        // For point lists, stride decimation keeps every
+                        // stride^2-th point, to match the reduction
+                        // factor of dense points
+                        if (useStride && ((y*points.cols + x) % (settings.stride*settings.stride))) {
+                            continue;
+                        }
+                        point = points.at<cv::Vec4f>(y, x);
+                    } else {
+                        if (useStride && (x % settings.stride)) {
+                            continue;
+                        }
+                        const cv::Vec3f &xyz = points.at<cv::Vec3f>(y, x);
+                        point = Reprojection::makeListPoint(xyz[0], xyz[1], xyz[2], y*points.cols + x);
+                    }
+
+                    if (!acceptPoint(settings, point)) {
+                        continue;
+                    }
+
+                    if (useVoxels) {
+                        quint64 key = computeVoxelKey(point, invVoxelSize);
+                        int partition = computeVoxelPartition(key, numPartitions);
+                        partitionLists[stripe*numPartitions + partition].push_back(VoxelEntry(key, point));
+                    } else {
+                        stripeLists[stripe].push_back(point);
+                    }
+                }
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &points;
+    const FilterSettings &settings;
+
+    int numStripes;
+    std::vector< std::vector<cv::Vec4f> > &stripeLists;
+
+    int numPartitions;
+    std::vector< std::vector<VoxelEntry> > &partitionLists;
+};
+
+
+// Second pass for voxel-grid decimation: each partition of the key
+// space is processed by a single thread, which accumulates entries
+// from all stripes into its own hash map. Hence, no merging of hash
+// maps is required. Each voxel is represented by the centroid of its
+// points, and by the lowest pixel index among them
+class VoxelBody : public cv::ParallelLoopBody
+{
+public:
+    VoxelBody (int numStripes, int numPartitions,
+               const std::vector< std::vector<VoxelEntry> > &partitionLists,
+               std::vector< std::vector<cv::Vec4f> > &outputLists)
+        : numStripes(numStripes),
+          numPartitions(numPartitions),
+          partitionLists(partitionLists),
+          outputLists(outputLists)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        struct Accumulator {
+            double x;
+            double y;
+            double z;
+            int count;
+            int index;
+        };
+
+        for (int partition = range.start; partition < range.end; partition++) {
+            size_t numEntries = 0;
+            for (int stripe = 0; stripe < numStripes; stripe++) {
+                numEntries += partitionLists[stripe*numPartitions + partition].size();
+            }
+
+            std::unordered_map<quint64, Accumulator> voxels;
+            voxels.reserve(numEntries);
+
+            for (int stripe = 0; stripe < numStripes; stripe++) {
+                for (const VoxelEntry &entry : partitionLists[stripe*numPartitions + partition]) {
+                    const cv::Vec4f &point = entry.second;
+
+                    auto it = voxels.find(entry.first);
+                    if (it == voxels.end()) {
+                        voxels.insert(std::make_pair(entry.first, Accumulator{ point[0], point[1], point[2], 1, Reprojection::getListPointIndex(point) }));
+                    } else {
+                        Accumulator &voxel = it->second;
+                        voxel.x += point[0];
+                        voxel.y += point[1];
+                        voxel.z += point[2];
+                        voxel.count++;
+                        voxel.index = std::min(voxel.index, Reprojection::getListPointIndex(point));
+                    }
+                }
+            }
+
+            std::vector<cv::Vec4f> &output = outputLists[partition];
+            output.clear();
+            output.reserve(voxels.size());
+
+            for (const auto &voxel : voxels) {
+                const Accumulator &accumulator = voxel.second;
+                output.push_back(Reprojection::makeListPoint(accumulator.x / accumulator.count, accumulator.y / accumulator.count, accumulator.z / accumulator.count, accumulator.index));
+            }
+        }
+    }
+
+protected:
+    int numStripes;
+    int numPartitions;
+    const std::vector< std::vector<VoxelEntry> > &partitionLists;
+    std::vector< std::vector<cv::Vec4f> > &outputLists;
+};
+
+
+PointCloudFilterPrivate::PointCloudFilterPrivate (PointCloudFilter *parent)
+    : q_ptr(parent),
+      nearDistance(0.0f),
+      farDistance(0.0f),
+      boxCropping(false),
+      boxMinCorner(-5000.0f, -5000.0f, 0.0f),
+      boxMaxCorner(5000.0f, 5000.0f, 10000.0f),
+      decimationMethod(PointCloudFilter::DecimationVoxelGrid),
+      stride(2),
+      voxelSize(10.0f),
+      maxPoints(250000)
+{
+}
+
+
+PointCloudFilter::PointCloudFilter (QObject *parent)
+    : QObject(parent), d_ptr(new PointCloudFilterPrivate(this))
+{
+}
+
+PointCloudFilter::~PointCloudFilter ()
+{
+}
+
+
+// *********************************************************************
+// *                            Depth range                            *
+// *********************************************************************
+void PointCloudFilter::setNearDistance (float distance)
+{
+    Q_D(PointCloudFilter);
+
+    d->nearDistance = std::max(distance, 0.0f);
+    emit parameterChanged();
+}
+
+float PointCloudFilter::getNearDistance () const
+{
+    Q_D(const PointCloudFilter);
+    return d->nearDistance;
+}
+
+
+void PointCloudFilter::setFarDistance (float distance)
+{
+    Q_D(PointCloudFilter);
+
+    d->farDistance = std::max(distance, 0.0f);
+    emit parameterChanged();
+}
+
+float PointCloudFilter::getFarDistance () const
+{
+    Q_D(const PointCloudFilter);
+    return d->farDistance;
+}
+
+
+// *********************************************************************
+// *                           Bounding box                            *
+// *********************************************************************
+void PointCloudFilter::setBoxCropping (bool enable)
+{
+    Q_D(PointCloudFilter);
+
+    d->boxCropping = enable;
+    emit parameterChanged();
+}
+
+bool PointCloudFilter::getBoxCropping () const
+{
+    Q_D(const PointCloudFilter);
+    return d->boxCropping;
+}
+
+
+void PointCloudFilter::setBox (const cv::Vec3f &minCorner, const cv::Vec3f &maxCorner)
+{
+    Q_D(PointCloudFilter);
+
+    // Make sure the corners are properly ordered
+    for (int i = 0; i < 3; i++) {
+        d->boxMinCorner[i] = std::min(minCorner[i], maxCorner[i]);
+        d->boxMaxCorner[i] = std::max(minCorner[i], maxCorner[i]);
+    }
+
+    emit parameterChanged();
+}
+
+cv::Vec3f PointCloudFilter::getBoxMinCorner () const
+{
+    Q_D(const PointCloudFilter);
+    return d->boxMinCorner;
+}
+
+cv::Vec3f PointCloudFilter::getBoxMaxCorner () const
+{
+    Q_D(const PointCloudFilter);
+    return d->boxMaxCorner;
+}
+
+
+// *********************************************************************
+// *                            Decimation                             *
+// *********************************************************************
+void PointCloudFilter::setDecimationMethod (int method)
+{
+    Q_D(PointCloudFilter);
+
+    if (method == d->decimationMethod) {
+        return;
+    }
+
+    // Validate
+    if (method < DecimationNone || method > DecimationVoxelGrid) {
+        d->decimationMethod = DecimationNone;
+        emit error(QString("Decimation method %1 not supported!").arg(method));
+    } else {
+        d->decimationMethod = method;
+    }
+
+    emit parameterChanged();
+}
+
+int PointCloudFilter::getDecimationMethod () const
+{
+    Q_D(const PointCloudFilter);
+    return d->decimationMethod;
+}
+
+
+void PointCloudFilter::setStride (int stride)
+{
+    Q_D(PointCloudFilter);
+
+    d->stride = std::max(stride, 1);
+    emit parameterChanged();
+}
+
+int PointCloudFilter::getStride () const
+{
+    Q_D(const PointCloudFilter);
+    return d->stride;
+}
+
+
+void PointCloudFilter::setVoxelSize (float size)
+{
+    Q_D(PointCloudFilter);
+
+    if (size <= 0.0f) {
+        emit error(QString("Invalid voxel size %1!").arg(size));
+        return;
+    }
+
+    d->voxelSize = size;
+    emit parameterChanged();
+}
+
+float PointCloudFilter::getVoxelSize () const
+{
+    Q_D(const PointCloudFilter);
+    return d->voxelSize;
+}
+
+
+void PointCloudFilter::setMaxPoints (int numPoints)
+{
+    Q_D(PointCloudFilter);
+
+    d->maxPoints = std::max(numPoints, 0);
+    emit parameterChanged();
+}
+
+int PointCloudFilter::getMaxPoints () const
+{
+    Q_D(const PointCloudFilter);
+    return d->maxPoints;
+}
+
+
+// *********************************************************************
+// *                             Filtering                             *
+// *********************************************************************
+void PointCloudFilter::filterPoints (const cv::Mat &points, cv::Mat &cloud) const
+{
+    Q_D(const PointCloudFilter);
+
+    // Validate input
+    cv::Mat input;
+    switch (points.type()) {
+        case CV_32FC3:
+        case CV_32FC4: {
+            input = points;
+            break;
+        }
+        case CV_16SC3: {
+            // Half-precision points
+            cv::convertFp16(points, input);
+            break;
+        }
+        default: {
+            throw Exception(QStringLiteral("Point-cloud filter requires 3-D points; unhandled format %1!").arg(points.type()));
+        }
+    }
+
+    if (input.empty()) {
+        cloud = cv::Mat();
+        return;
+    }
+
+    // Snapshot of parameters
+    const FilterSettings settings = {
+        d->nearDistance,
+        d->farDistance,
+        d->boxCropping,
+        d->boxMinCorner,
+        d->boxMaxCorner,
+        d->decimationMethod,
+        d->stride,
+        d->voxelSize,
+    };
+    const int maxPoints = d->maxPoints;
+
+    const int numThreads = std::max(1, cv::getNumThreads());
+    const int numStripes = std::min(input.rows, numThreads * 4);
+    const int numPartitions = (settings.decimationMethod == DecimationVoxelGrid) ? numThreads * 4 : 0;
+
+    std::vector< std::vector<cv::Vec4f> > stripeLists(numStripes);
+    std::vector< std::vector<VoxelEntry> > partitionLists(numStripes * numPartitions);
+
+    // First pass: cropping and stride decimation
+    cv::parallel_for_(cv::Range(0, numStripes), CropBody(input, settings, numStripes, stripeLists, numPartitions, partitionLists));
+
+    // Second pass: voxel grid
+    std::vector< std::vector<cv::Vec4f> > *lists = &stripeLists;
+    std::vector< std::vector<cv::Vec4f> > voxelLists(numPartitions);
+    if (settings.decimationMethod == DecimationVoxelGrid) {
+        cv::parallel_for_(cv::Range(0, numPartitions), VoxelBody(numStripes, numPartitions, partitionLists, voxelLists));
+        lists = &voxelLists;
+    }
+
+    // Concatenate
+    std::vector<cv::Vec4f> result;
+
+    size_t numPoints = 0;
+    for (const std::vector<cv::Vec4f> &list : *lists) {
+        numPoints += list.size();
+    }
+    result.reserve(numPoints);
+
+    for (const std::vector<cv::Vec4f> &list : *lists) {
+        result.insert(result.end(), list.begin(), list.end());
+    }
+
+    // Voxels come out of hash maps in arbitrary order; restore the
+    // pixel-index ordering
+    if (settings.decimationMethod == DecimationVoxelGrid) {
+        std::sort(result.begin(), result.end(), [] (const cv::Vec4f &a, const cv::Vec4f &b) {
+            return Reprojection::getListPointIndex(a) < Reprojection::getListPointIndex(b);
+        });
+    }
+
+    // Enforce the upper bound on number of points by uniform subsampling
+    if (maxPoints > 0 && static_cast<int>(result.size()) > maxPoints) {
+        const size_t total = result.size();
+        for (int i = 0; i < maxPoints; i++) {
+            result[i] = result[(i * total) / maxPoints];
+        }
+        result.resize(maxPoints);
+    }
+
+    // Output
+    cloud.create(static_cast<int>(result.size()), 1, CV_32FC4);
+    if (!result.empty()) {
+        std::copy(result.begin(), result.end(), cloud.ptr<cv::Vec4f>());
+    }
+}
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
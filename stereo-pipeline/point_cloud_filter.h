@@ -0,0 +1,104 @@
+/*
+ * Stereo Pipeline: point-cloud filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__POINT_CLOUD_FILTER_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__POINT_CLOUD_FILTER_H
+
+#include <stereo-pipeline/export.h>
+
+#include <QtCore>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+class PointCloudFilterPrivate;
+
+// Point-cloud filter: crops the reprojected points to the given depth
+// range and (optionally) bounding box, and decimates them. The output
+// is always a compact Nx1 CV_32FC4 list of points, in the same format
+// as Reprojection::OutputPointList (i.e., the fourth channel holds
+// the linear index of the corresponding pixel, as an integer), ordered
+// by pixel index. The number of output points is bounded by the maximum
+// number of points, regardless of input resolution
+class MVL_STEREO_PIPELINE_EXPORT PointCloudFilter : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PointCloudFilter)
+    Q_DECLARE_PRIVATE(PointCloudFilter)
+    QScopedPointer<PointCloudFilterPrivate> const d_ptr;
+
+public:
+    PointCloudFilter (QObject *parent = nullptr);
+    ~PointCloudFilter ();
+
+    enum {
+        DecimationNone,
+        DecimationStride,
+        DecimationVoxelGrid,
+    };
+
+    // Depth range; far distance of 0 disables the far limit
+    void setNearDistance (float distance);
+    float getNearDistance () const;
+
+    void setFarDistance (float distance);
+    float getFarDistance () const;
+
+    // Bounding box
+    void setBoxCropping (bool enable);
+    bool getBoxCropping () const;
+
+    void setBox (const cv::Vec3f &minCorner, const cv::Vec3f &maxCorner);
+    cv::Vec3f getBoxMinCorner () const;
+    cv::Vec3f getBoxMaxCorner () const;
+
+    // Decimation
+    void setDecimationMethod (int method);
+    int getDecimationMethod () const;
+
+    void setStride (int stride);
+    int getStride () const;
+
+    void setVoxelSize (float size);
+    float getVoxelSize () const;
+
+    void setMaxPoints (int numPoints);
+    int getMaxPoints () const;
+
+    // Filtering; accepts dense CV_32FC3 or CV_16SC3 points, or CV_32FC4
+    // point lists
+    void filterPoints (const cv::Mat &points, cv::Mat &cloud) const;
+
+signals:
+    void parameterChanged ();
+
+    void error (const QString &message);
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
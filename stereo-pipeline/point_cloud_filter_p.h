@@ -0,0 +1,59 @@
+/*
+ * Stereo Pipeline: point-cloud filter
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__POINT_CLOUD_FILTER_P_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__POINT_CLOUD_FILTER_P_H
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+
+
+class PointCloudFilterPrivate
+{
+    Q_DISABLE_COPY(PointCloudFilterPrivate)
+    Q_DECLARE_PUBLIC(PointCloudFilter)
+
+    PointCloudFilter * const q_ptr;
+
+    PointCloudFilterPrivate (PointCloudFilter *parent);
+
+protected:
+    float nearDistance;
+    float farDistance;
+
+    bool boxCropping;
+    cv::Vec3f boxMinCorner;
+    cv::Vec3f boxMaxCorner;
+
+    int decimationMethod;
+    int stride;
+    float voxelSize;
+
+    int maxPoints;
+};
+
+
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
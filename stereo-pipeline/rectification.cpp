@@ -254,6 +254,70 @@ void Rectification::rectifyImagePair (const cv::Mat &img1, const cv::Mat &img2,
     }
 }
 
+void Rectification::rectifyImagePair (const cv::Mat &img1, const cv::Mat &img2, const std::vector<cv::Rect> &regions, cv::Mat &img1r, cv::Mat &img2r, cv::Rect &bounds) const
+{
+    Q_D(const Rectification);
+
+    // Make sure images are valid
+    if (img1.empty() || img2.empty()) {
+        return;
+    }
+
+    // Clip regions to image area, and compute their bounding box
+    const cv::Rect imageArea(0, 0, img1.cols, img1.rows);
+    std::vector<cv::Rect> clippedRegions;
+    bounds = cv::Rect();
+
+    for (const cv::Rect &region : regions) {
+        cv::Rect clipped = region & imageArea;
+        if (clipped.empty()) {
+            continue;
+        }
+        bounds = bounds.empty() ? clipped : (bounds | clipped);
+        clippedRegions.push_back(clipped);
+    }
+
+    if (clippedRegions.empty()) {
+        bounds = imageArea;
+        rectifyImagePair(img1, img2, img1r, img2r);
+        return;
+    }
+
+    const bool passThrough = !d->isValid || !d->performRectification;
+
+    if (!passThrough && (img1.cols != d->imageSize.width || img1.rows != d->imageSize.height || img2.cols != d->imageSize.width || img2.rows != d->imageSize.height)) {
+        img1r = cv::Mat();
+        img2r = cv::Mat();
+        emit error("Input image size does not match calibrated image size!");
+        return;
+    }
+
+    // Single region covering its whole bounding box does not need
+    // zero-initialization of the output
+    img1r.create(bounds.size(), img1.type());
+    img2r.create(bounds.size(), img2.type());
+    if (clippedRegions.size() > 1) {
+        img1r.setTo(cv::Scalar::all(0));
+        img2r.setTo(cv::Scalar::all(0));
+    }
+
+    for (const cv::Rect &region : clippedRegions) {
+        const cv::Rect target = region - bounds.tl();
+        cv::Mat region1r = img1r(target);
+        cv::Mat region2r = img2r(target);
+
+        if (passThrough) {
+            img1(region).copyTo(region1r);
+            img2(region).copyTo(region2r);
+        } else {
+            // Look-up tables are indexed by rectified pixel coordinates,
+            // so their sub-regions remap only the pixels of interest
+            cv::remap(img1, region1r, d->map11(region), d->map12(region), cv::INTER_LINEAR);
+            cv::remap(img2, region2r, d->map21(region), d->map22(region), cv::INTER_LINEAR);
+        }
+    }
+}
+
 
 // *********************************************************************
 // *                      Rectification parameters                     *
@@ -64,6 +64,13 @@ public:
 
     void rectifyImagePair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &img1r, cv::Mat &img2r) const;
 
+    // Region-of-interest rectification: only given regions (in
+    // rectified image coordinates) are remapped, into images that
+    // cover their bounding box (returned in bounds); pixels outside
+    // the regions are set to zero. Regions are clipped to the image
+    // area; if none remain, the whole image pair is rectified
+    void rectifyImagePair (const cv::Mat &img1, const cv::Mat &img2, const std::vector<cv::Rect> &regions, cv::Mat &img1r, cv::Mat &img2r, cv::Rect &bounds) const;
+
     bool isCalibrationValid () const;
 
     // Individual calibration parameters
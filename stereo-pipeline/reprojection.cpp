@@ -18,9 +18,12 @@
  */
 
 #include "reprojection.h"
+#include "exception.h"
+#include "utils.h"
 
 #include <opencv2/opencv_modules.hpp>
 #include <opencv2/calib3d.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 
 #ifdef HAVE_OPENCV_CUDASTEREO
 #include <opencv2/cudastereo.hpp>
@@ -29,17 +32,375 @@
 
 #include "reprojection_p.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 
 namespace MVL {
 namespace StereoToolbox {
 namespace Pipeline {
 
 
+// *********************************************************************
+// *                Toolbox CPU reprojection: row kernel               *
+// *********************************************************************
+// Loads four disparities and converts them to float
+#if CV_SIMD128
+static inline cv::v_float32x4 loadDisparity4 (const float *ptr)
+{
+    return cv::v_load(ptr);
+}
+
+static inline cv::v_float32x4 loadDisparity4 (const short *ptr)
+{
+    return cv::v_cvt_f32(cv::v_load_expand(ptr));
+}
+
+static inline cv::v_float32x4 loadDisparity4 (const unsigned char *ptr)
+{
+    return cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(ptr)));
+}
+#endif
+
+// Reprojects a single row of disparities into interleaved XYZ output.
+// Filtering (raw disparities not above the threshold are invalid),
+// reprojection and validity masking (invalid points are set to NaN)
+// are all done in a single pass. The column tables are already offset
+// to the first pixel of the row; rowTerms contain per-row terms for
+// X, Y, Z and W. Disparity format is folded into the disparity and
+// row terms, so raw (e.g., fixed-point) disparities are used directly
+template <typename TYPE>
+static void reprojectRow (const TYPE *disparity, float *points, int cols,
+                          const float *columnX, const float *columnY, const float *columnZ, const float *columnW,
+                          const float rowTerms[4], const float disparityTerms[4], float threshold)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    int x = 0;
+
+#if CV_SIMD128
+    const cv::v_float32x4 vThreshold = cv::v_setall_f32(threshold);
+    const cv::v_float32x4 vOne = cv::v_setall_f32(1.0f);
+    const cv::v_float32x4 vNaN = cv::v_setall_f32(nan);
+
+    const cv::v_float32x4 vRowX = cv::v_setall_f32(rowTerms[0]);
+    const cv::v_float32x4 vRowY = cv::v_setall_f32(rowTerms[1]);
+    const cv::v_float32x4 vRowZ = cv::v_setall_f32(rowTerms[2]);
+    const cv::v_float32x4 vRowW = cv::v_setall_f32(rowTerms[3]);
+
+    const cv::v_float32x4 vDispX = cv::v_setall_f32(disparityTerms[0]);
+    const cv::v_float32x4 vDispY = cv::v_setall_f32(disparityTerms[1]);
+    const cv::v_float32x4 vDispZ = cv::v_setall_f32(disparityTerms[2]);
+    const cv::v_float32x4 vDispW = cv::v_setall_f32(disparityTerms[3]);
+
+    for (; x <= cols - 4; x += 4) {
+        cv::v_float32x4 d = loadDisparity4(disparity + x);
+        cv::v_float32x4 valid = d > vThreshold;
+
+        cv::v_float32x4 X = cv::v_load(columnX + x) + vRowX + vDispX*d;
+        cv::v_float32x4 Y = cv::v_load(columnY + x) + vRowY + vDispY*d;
+        cv::v_float32x4 Z = cv::v_load(columnZ + x) + vRowZ + vDispZ*d;
+        cv::v_float32x4 W = cv::v_load(columnW + x) + vRowW + vDispW*d;
+
+        cv::v_float32x4 invW = vOne / W;
+
+        X = cv::v_select(valid, X*invW, vNaN);
+        Y = cv::v_select(valid, Y*invW, vNaN);
+        Z = cv::v_select(valid, Z*invW, vNaN);
+
+        cv::v_store_interleave(points + 3*x, X, Y, Z);
+    }
+#endif
+
+    for (; x < cols; x++) {
+        float d = static_cast<float>(disparity[x]);
+        float *point = points + 3*x;
+
+        if (d > threshold) {
+            float invW = 1.0f / (columnW[x] + rowTerms[3] + disparityTerms[3]*d);
+            point[0] = (columnX[x] + rowTerms[0] + disparityTerms[0]*d) * invW;
+            point[1] = (columnY[x] + rowTerms[1] + disparityTerms[1]*d) * invW;
+            point[2] = (columnZ[x] + rowTerms[2] + disparityTerms[2]*d) * invW;
+        } else {
+            point[0] = point[1] = point[2] = nan;
+        }
+    }
+}
+
+
+// Depth-only variant of the above; only Z and W are computed, and
+// invalid depths are set to NaN
+template <typename TYPE>
+static void reprojectDepthRow (const TYPE *disparity, float *depth, int cols,
+                               const float *columnZ, const float *columnW,
+                               const float rowTerms[4], const float disparityTerms[4], float threshold)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    int x = 0;
+
+#if CV_SIMD128
+    const cv::v_float32x4 vThreshold = cv::v_setall_f32(threshold);
+    const cv::v_float32x4 vNaN = cv::v_setall_f32(nan);
+
+    const cv::v_float32x4 vRowZ = cv::v_setall_f32(rowTerms[2]);
+    const cv::v_float32x4 vRowW = cv::v_setall_f32(rowTerms[3]);
+
+    const cv::v_float32x4 vDispZ = cv::v_setall_f32(disparityTerms[2]);
+    const cv::v_float32x4 vDispW = cv::v_setall_f32(disparityTerms[3]);
+
+    for (; x <= cols - 4; x += 4) {
+        cv::v_float32x4 d = loadDisparity4(disparity + x);
+        cv::v_float32x4 valid = d > vThreshold;
+
+        cv::v_float32x4 Z = cv::v_load(columnZ + x) + vRowZ + vDispZ*d;
+        cv::v_float32x4 W = cv::v_load(columnW + x) + vRowW + vDispW*d;
+
+        cv::v_store(depth + x, cv::v_select(valid, Z / W, vNaN));
+    }
+#endif
+
+    for (; x < cols; x++) {
+        float d = static_cast<float>(disparity[x]);
+
+        if (d > threshold) {
+            depth[x] = (columnZ[x] + rowTerms[2] + disparityTerms[2]*d) / (columnW[x] + rowTerms[3] + disparityTerms[3]*d);
+        } else {
+            depth[x] = nan;
+        }
+    }
+}
+
+// Converts a row of float depths (assumed to be in millimeters) to
+// 16-bit unsigned integers; invalid and out-of-range values are set
+// to 0
+static void convertDepthRowToMillimeters (const float *depth, unsigned short *output, int cols)
+{
+    for (int x = 0; x < cols; x++) {
+        float z = depth[x];
+        output[x] = (z > 0.0f && z < 65535.0f) ? static_cast<unsigned short>(z + 0.5f) : 0; // Also handles NaN
+    }
+}
+
+
+// Parallel body for dense (image) and compact (list) output. In
+// the latter case, each stripe of rows produces its own list, and
+// lists are concatenated once all stripes are processed. Dense
+// output can be either points or depth, in full or reduced precision
+class ReprojectionBody : public cv::ParallelLoopBody
+{
+public:
+    ReprojectionBody (const cv::Mat &disparity, const DisparityFormat &format, const cv::Mat &columnTable, const cv::Mat &rowTable, const cv::Mat &Q, int offsetX, int offsetY)
+        : disparity(disparity),
+          columnTable(columnTable),
+          rowTable(rowTable),
+          offsetX(offsetX),
+          offsetY(offsetY),
+          outputType(Reprojection::OutputPoints),
+          numStripes(1),
+          stripeLists(nullptr)
+    {
+        // d = raw*scale + offset; the scale is folded into disparity
+        // terms, and offset into per-row terms
+        for (int i = 0; i < 4; i++) {
+            disparityTerms[i] = static_cast<float>(Q.at<float>(i, 2)*format.scale);
+            rowOffsetTerms[i] = static_cast<float>(Q.at<float>(i, 2)*format.offset);
+        }
+
+        // Raw threshold corresponding to zero disparity
+        threshold = static_cast<float>(-format.offset/format.scale);
+    }
+
+    void setDenseOutput (cv::Mat &output, int type)
+    {
+        dense = output;
+        outputType = type;
+        stripeLists = nullptr;
+    }
+
+    void setListOutput (std::vector< std::vector<cv::Vec4f> > &lists, int stripes)
+    {
+        stripeLists = &lists;
+        numStripes = stripes;
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        if (!stripeLists) {
+            // Dense output; range is in rows. Reduced-precision types
+            // are produced via a temporary row buffer
+            std::vector<float> rowBuffer;
+            if (outputType == Reprojection::OutputPointsHalf) {
+                rowBuffer.resize(3*disparity.cols);
+            } else if (outputType == Reprojection::OutputDepthMillimeters) {
+                rowBuffer.resize(disparity.cols);
+            }
+
+            for (int y = range.start; y < range.end; y++) {
+                switch (outputType) {
+                    case Reprojection::OutputPoints: {
+                        processRow(y, dense.ptr<float>(y), false);
+                        break;
+                    }
+                    case Reprojection::OutputPointsHalf: {
+                        processRow(y, rowBuffer.data(), false);
+
+                        cv::Mat rowFloat(1, 3*disparity.cols, CV_32F, rowBuffer.data());
+                        cv::Mat rowHalf(1, 3*disparity.cols, CV_16S, dense.ptr<short>(y));
+                        cv::convertFp16(rowFloat, rowHalf); // Writes into existing buffer
+                        break;
+                    }
+                    case Reprojection::OutputDepth: {
+                        processRow(y, dense.ptr<float>(y), true);
+                        break;
+                    }
+                    case Reprojection::OutputDepthMillimeters: {
+                        processRow(y, rowBuffer.data(), true);
+                        convertDepthRowToMillimeters(rowBuffer.data(), dense.ptr<unsigned short>(y), disparity.cols);
+                        break;
+                    }
+                }
+            }
+        } else {
+            // List output; range is in stripes
+            std::vector<float> rowBuffer(3*disparity.cols);
+
+            for (int stripe = range.start; stripe < range.end; stripe++) {
+                std::vector<cv::Vec4f> &list = (*stripeLists)[stripe];
+                list.clear();
+
+                int y0 = (disparity.rows * stripe) / numStripes;
+                int y1 = (disparity.rows * (stripe + 1)) / numStripes;
+
+                for (int y = y0; y < y1; y++) {
+                    float *row = rowBuffer.data();
+                    processRow(y, row, false);
+
+                    for (int x = 0; x < disparity.cols; x++) {
+                        const float *point = row + 3*x;
+                        if (point[2] == point[2]) { // Not NaN
+                            list.push_back(Reprojection::makeListPoint(point[0], point[1], point[2], y*disparity.cols + x));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+protected:
+    void processRow (int y, float *output, bool depthOnly) const
+    {
+        switch (disparity.depth()) {
+            case CV_8U: {
+                processRow(disparity.ptr<unsigned char>(y), y, output, depthOnly);
+                break;
+            }
+            case CV_16S: {
+                processRow(disparity.ptr<short>(y), y, output, depthOnly);
+                break;
+            }
+            case CV_32F: {
+                processRow(disparity.ptr<float>(y), y, output, depthOnly);
+                break;
+            }
+        }
+    }
+
+    template <typename TYPE>
+    void processRow (const TYPE *disparityPtr, int y, float *output, bool depthOnly) const
+    {
+        const float rowTerms[4] = {
+            rowTable.at<float>(0, y + offsetY) + rowOffsetTerms[0],
+            rowTable.at<float>(1, y + offsetY) + rowOffsetTerms[1],
+            rowTable.at<float>(2, y + offsetY) + rowOffsetTerms[2],
+            rowTable.at<float>(3, y + offsetY) + rowOffsetTerms[3],
+        };
+
+        const float *columnX = columnTable.ptr<float>(0) + offsetX;
+        const float *columnY = columnTable.ptr<float>(1) + offsetX;
+        const float *columnZ = columnTable.ptr<float>(2) + offsetX;
+        const float *columnW = columnTable.ptr<float>(3) + offsetX;
+
+        if (depthOnly) {
+            reprojectDepthRow(disparityPtr, output, disparity.cols, columnZ, columnW, rowTerms, disparityTerms, threshold);
+        } else {
+            reprojectRow(disparityPtr, output, disparity.cols, columnX, columnY, columnZ, columnW, rowTerms, disparityTerms, threshold);
+        }
+    }
+
+protected:
+    const cv::Mat &disparity;
+    const cv::Mat &columnTable;
+    const cv::Mat &rowTable;
+    int offsetX;
+    int offsetY;
+
+    float disparityTerms[4];
+    float rowOffsetTerms[4];
+    float threshold;
+
+    cv::Mat dense;
+    int outputType;
+
+    int numStripes;
+    std::vector< std::vector<cv::Vec4f> > *stripeLists;
+};
+
+
+// Converts dense points image into the requested output type
+static void convertPointsToOutput (const cv::Mat &points, cv::Mat &output, int outputType)
+{
+    switch (outputType) {
+        case Reprojection::OutputPoints: {
+            output = points;
+            break;
+        }
+        case Reprojection::OutputPointList: {
+            // Compact list of valid points
+            std::vector<cv::Vec4f> validPoints;
+            validPoints.reserve(points.rows*points.cols);
+
+            for (int y = 0; y < points.rows; y++) {
+                const cv::Vec3f *pointsPtr = points.ptr<cv::Vec3f>(y);
+                for (int x = 0; x < points.cols; x++) {
+                    const cv::Vec3f &xyz = pointsPtr[x];
+                    if (std::isfinite(xyz[0]) && std::isfinite(xyz[1]) && std::isfinite(xyz[2])) {
+                        validPoints.push_back(Reprojection::makeListPoint(xyz[0], xyz[1], xyz[2], y*points.cols + x));
+                    }
+                }
+            }
+
+            cv::Mat(validPoints, true).copyTo(output);
+            break;
+        }
+        case Reprojection::OutputPointsHalf: {
+            cv::convertFp16(points, output);
+            break;
+        }
+        case Reprojection::OutputDepth: {
+            cv::extractChannel(points, output, 2);
+            break;
+        }
+        case Reprojection::OutputDepthMillimeters: {
+            cv::Mat depth;
+            cv::extractChannel(points, depth, 2);
+
+            output.create(depth.rows, depth.cols, CV_16UC1);
+            for (int y = 0; y < depth.rows; y++) {
+                convertDepthRowToMillimeters(depth.ptr<float>(y), output.ptr<unsigned short>(y), depth.cols);
+            }
+            break;
+        }
+    }
+}
+
+
 ReprojectionPrivate::ReprojectionPrivate (Reprojection *parent)
     : q_ptr(parent)
 {
     // Create list of supported methods
     supportedMethods.append(Reprojection::MethodOpenCvCpu);
+    supportedMethods.append(Reprojection::MethodToolboxCpu);
 #ifdef HAVE_OPENCV_CUDASTEREO
     try {
         if (cv::cuda::getCudaEnabledDeviceCount()) {
@@ -50,8 +411,202 @@ ReprojectionPrivate::ReprojectionPrivate (Reprojection *parent)
     }
 #endif
 
-    // Default method: OpenCV CPU
-    reprojectionMethod = Reprojection::MethodOpenCvCpu;
+    // Default method: toolbox CPU
+    reprojectionMethod = Reprojection::MethodToolboxCpu;
+
+    // Default output: dense points
+    outputType = Reprojection::OutputPoints;
+}
+
+
+// *********************************************************************
+// *                      Reprojection functions                       *
+// *********************************************************************
+cv::Mat ReprojectionPrivate::getOffsetReprojectionMatrix (int offsetX, int offsetY, double disparityScale) const
+{
+    cv::Mat matrix = getMatrix();
+
+    if (!offsetX && !offsetY && disparityScale == 1.0) {
+        return matrix;
+    }
+
+    // Shifting the pixel coordinates by the ROI offset is equivalent
+    // to multiplying the reprojection matrix by the translation; in
+    // the same way, scaling of raw disparity is equivalent to scaling
+    // the disparity column
+    cv::Mat T = cv::Mat::eye(4, 4, CV_32F);
+    T.at<float>(0, 3) = offsetX;
+    T.at<float>(1, 3) = offsetY;
+    T.at<float>(2, 2) = disparityScale;
+
+    return matrix * T;
+}
+
+void ReprojectionPrivate::prepareOpenCvDisparity (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &filteredDisparity, double &disparityScale) const
+{
+    // Negative disparities are filtered out before reprojection. The
+    // scale of raw disparity is folded into reprojection matrix, while
+    // formats with offset are converted to float
+    if (format.offset == 0.0) {
+        filteredDisparity = cv::max(disparity, 0);
+        disparityScale = format.scale;
+    } else {
+        Utils::convertDisparityToFloat(disparity, format, filteredDisparity);
+        filteredDisparity = cv::max(filteredDisparity, 0);
+        disparityScale = 1.0;
+    }
+}
+
+void ReprojectionPrivate::reprojectOpenCvCpu (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const
+{
+    // Stock OpenCV method; ROI offset is handled by modifying the
+    // reprojection matrix
+    cv::Mat filteredDisparity;
+    double disparityScale;
+    prepareOpenCvDisparity(disparity, format, filteredDisparity, disparityScale);
+
+    cv::reprojectImageTo3D(filteredDisparity, points, getOffsetReprojectionMatrix(offsetX, offsetY, disparityScale), false, CV_32F);
+}
+
+void ReprojectionPrivate::reprojectOpenCvCuda (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const
+{
+#ifdef HAVE_OPENCV_CUDASTEREO
+    // OpenCV CUDA method; ROI offset is handled by modifying the
+    // reprojection matrix
+    cv::Mat filteredDisparity;
+    double disparityScale;
+    prepareOpenCvDisparity(disparity, format, filteredDisparity, disparityScale);
+
+    cv::cuda::GpuMat gpu_disparity, gpu_points;
+    gpu_disparity.upload(filteredDisparity);
+    cv::cuda::reprojectImageTo3D(gpu_disparity, gpu_points, getOffsetReprojectionMatrix(offsetX, offsetY, disparityScale), 3);
+    gpu_points.download(points);
+#else
+    points = cv::Mat();
+#endif
+}
+
+
+// Column ray table: Q(:,0)*x
+static cv::Mat buildColumnTable (const cv::Mat &Q, int width)
+{
+    cv::Mat table(4, width, CV_32F);
+    for (int i = 0; i < 4; i++) {
+        float *ptr = table.ptr<float>(i);
+        float q = Q.at<float>(i, 0);
+        for (int x = 0; x < width; x++) {
+            ptr[x] = q*x;
+        }
+    }
+    return table;
+}
+
+// Row ray table: Q(:,1)*y + Q(:,3)
+static cv::Mat buildRowTable (const cv::Mat &Q, int height)
+{
+    cv::Mat table(4, height, CV_32F);
+    for (int i = 0; i < 4; i++) {
+        float *ptr = table.ptr<float>(i);
+        float q = Q.at<float>(i, 1);
+        float c = Q.at<float>(i, 3);
+        for (int y = 0; y < height; y++) {
+            ptr[y] = q*y + c;
+        }
+    }
+    return table;
+}
+
+cv::Mat ReprojectionPrivate::getMatrix () const
+{
+    QMutexLocker locker(&mutex);
+    return Q;
+}
+
+void ReprojectionPrivate::getRayTables (int width, int height, cv::Mat &matrix, cv::Mat &columnTable, cv::Mat &rowTable) const
+{
+    QMutexLocker locker(&mutex);
+
+    matrix = Q;
+    if (Q.rows != 4 || Q.cols != 4) {
+        columnTable = cv::Mat();
+        rowTable = cv::Mat();
+        return;
+    }
+
+    if (rayColumnTable.cols < width) {
+        rayColumnTable = buildColumnTable(Q, width);
+    }
+    if (rayRowTable.cols < height) {
+        rayRowTable = buildRowTable(Q, height);
+    }
+
+    columnTable = rayColumnTable;
+    rowTable = rayRowTable;
+}
+
+void ReprojectionPrivate::reprojectToolboxCpu (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const
+{
+    // Ray tables that cover the image area
+    cv::Mat matrix, columnTable, rowTable;
+    getRayTables(disparity.cols + offsetX, disparity.rows + offsetY, matrix, columnTable, rowTable);
+    if (columnTable.empty()) {
+        points = cv::Mat();
+        return;
+    }
+
+    // Disparity format; the kernel handles 8-bit, 16-bit and float
+    // disparities natively, others are converted to float
+    cv::Mat input = disparity;
+    if (input.depth() != CV_8U && input.depth() != CV_16S && input.depth() != CV_32F) {
+        disparity.convertTo(input, CV_32F);
+    }
+
+    ReprojectionBody body(input, format, columnTable, rowTable, matrix, offsetX, offsetY);
+
+    if (outputType == Reprojection::OutputPointList) {
+        // Each stripe of rows builds its own list of valid points
+        int numStripes = std::min(input.rows, std::max(1, cv::getNumThreads()) * 4);
+        std::vector< std::vector<cv::Vec4f> > lists(numStripes);
+
+        body.setListOutput(lists, numStripes);
+        cv::parallel_for_(cv::Range(0, numStripes), body);
+
+        // Concatenate
+        int numPoints = 0;
+        for (const std::vector<cv::Vec4f> &list : lists) {
+            numPoints += list.size();
+        }
+
+        points.create(numPoints, 1, CV_32FC4);
+
+        cv::Vec4f *ptr = points.ptr<cv::Vec4f>();
+        for (const std::vector<cv::Vec4f> &list : lists) {
+            ptr = std::copy(list.begin(), list.end(), ptr);
+        }
+    } else {
+        // Dense output
+        switch (outputType) {
+            case Reprojection::OutputPoints: {
+                points.create(input.rows, input.cols, CV_32FC3);
+                break;
+            }
+            case Reprojection::OutputPointsHalf: {
+                points.create(input.rows, input.cols, CV_16SC3);
+                break;
+            }
+            case Reprojection::OutputDepth: {
+                points.create(input.rows, input.cols, CV_32FC1);
+                break;
+            }
+            case Reprojection::OutputDepthMillimeters: {
+                points.create(input.rows, input.cols, CV_16UC1);
+                break;
+            }
+        }
+
+        body.setDenseOutput(points, outputType);
+        cv::parallel_for_(cv::Range(0, input.rows), body);
+    }
 }
 
 
@@ -103,6 +658,36 @@ const QList<int> &Reprojection::getSupportedReprojectionMethods () const
 }
 
 
+// *********************************************************************
+// *                            Output type                            *
+// *********************************************************************
+void Reprojection::setOutputType (int type)
+{
+    Q_D(Reprojection);
+
+    if (type == d->outputType) {
+        return;
+    }
+
+    // Validate
+    if (type < OutputPoints || type > OutputDepthMillimeters) {
+        d->outputType = OutputPoints;
+        emit error(QString("Reprojection output type %1 not supported!").arg(type));
+    } else {
+        d->outputType = type;
+    }
+
+    // Emit in any case
+    emit outputTypeChanged(d->outputType);
+}
+
+int Reprojection::getOutputType () const
+{
+    Q_D(const Reprojection);
+    return d->outputType;
+}
+
+
 // *********************************************************************
 // *                        Reprojection matrix                        *
 // *********************************************************************
@@ -113,61 +698,161 @@ void Reprojection::setReprojectionMatrix (const cv::Mat &Q)
     // By default, OpenCV stereo calibration produces reprojection
     // matrix that is 4x4 CV_64F... however, GPU reprojection code
     // requires it to be 4x4 CV_32F. For performance reasons, we do
-    // the conversion here
+    // the conversion here. The result is stored in a new buffer,
+    // because the previous matrix may still be in use by an ongoing
+    // reprojection
+    cv::Mat matrix;
     if (Q.type() == CV_64F) {
-        Q.convertTo(d->Q, CV_32F); // Convert: CV_64F -> CV_32F
+        Q.convertTo(matrix, CV_32F); // Convert: CV_64F -> CV_32F
     } else {
-        Q.copyTo(d->Q); // Copy
+        matrix = Q.clone(); // Copy
     }
 
+    QMutexLocker locker(&d->mutex);
+
+    d->Q = matrix;
+
+    // Invalidate ray tables
+    d->rayColumnTable = cv::Mat();
+    d->rayRowTable = cv::Mat();
+
+    locker.unlock();
+
     emit reprojectionMatrixChanged();
 }
 
-const cv::Mat &Reprojection::getReprojectionMatrix () const
+cv::Mat Reprojection::getReprojectionMatrix () const
 {
     Q_D(const Reprojection);
-    return d->Q;
+    return d->getMatrix();
 }
 
 
 // *********************************************************************
 // *                           Reprojection                            *
 // *********************************************************************
-void Reprojection::reprojectDisparity (const cv::Mat &disparity, cv::Mat &points) const
+void Reprojection::reprojectDisparity (const cv::Mat &disparity, cv::Mat &points, int offsetX, int offsetY) const
+{
+    reprojectDisparity(disparity, DisparityFormat(), points, offsetX, offsetY);
+}
+
+void Reprojection::reprojectDisparity (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const
 {
     Q_D(const Reprojection);
 
     // Validate reprojection matrix
-    if (d->Q.rows != 4 || d->Q.cols != 4) {
+    cv::Mat matrix = d->getMatrix();
+    if (matrix.rows != 4 || matrix.cols != 4) {
         points = cv::Mat();
         return;
     }
 
-    // Filter out negative disparities before reprojection
-    cv::Mat filteredDisparity = cv::max(disparity, 0);
-
     // Choose reprojection method
     switch (d->reprojectionMethod) {
+        case MethodToolboxCpu: {
+            // Handles both output types natively
+            d->reprojectToolboxCpu(disparity, format, points, offsetX, offsetY);
+            return;
+        }
         case MethodOpenCvCpu: {
-            // Stock OpenCV method; does not handle ROI offset
-            cv::reprojectImageTo3D(filteredDisparity, points, d->Q, false, CV_32F);
+            d->reprojectOpenCvCpu(disparity, format, points, offsetX, offsetY);
             break;
         }
-#ifdef HAVE_OPENCV_CUDASTEREO
         case MethodOpenCvCuda: {
-            // OpenCV CUDA method; does not handle ROI offset
-            cv::cuda::GpuMat gpu_disparity, gpu_points;
-            gpu_disparity.upload(filteredDisparity);
-            cv::cuda::reprojectImageTo3D(gpu_disparity, gpu_points, d->Q, 3);
-            gpu_points.download(points);
+            d->reprojectOpenCvCuda(disparity, format, points, offsetX, offsetY);
             break;
         }
-#endif
         default: {
             points = cv::Mat();
+            return;
+        }
+    }
+
+    // Stock methods produce dense points; convert if necessary
+    if (d->outputType != OutputPoints && !points.empty()) {
+        cv::Mat output;
+        convertPointsToOutput(points, output, d->outputType);
+        points = output;
+    }
+}
+
+
+void Reprojection::convertToPoints (const cv::Mat &output, cv::Mat &points, int offsetX, int offsetY) const
+{
+    Q_D(const Reprojection);
+    convertToPoints(output, d->getMatrix(), points, offsetX, offsetY);
+}
+
+void Reprojection::convertToPoints (const cv::Mat &output, const cv::Mat &Q, cv::Mat &points, int offsetX, int offsetY)
+{
+
+    switch (output.type()) {
+        case CV_32FC3:
+        case CV_32FC4: {
+            // Dense points or point list; nothing to do
+            points = output;
+            return;
+        }
+        case CV_16SC3: {
+            // Half-precision points; convert via temporary, in case
+            // output and points are the same matrix
+            cv::Mat result;
+            cv::convertFp16(output, result);
+            points = result;
+            return;
+        }
+        case CV_32FC1:
+        case CV_16UC1: {
+            // Depth; handled below
             break;
         }
+        default: {
+            throw Exception(QStringLiteral("Unhandled reprojection output format %1!").arg(output.type()));
+        }
     }
+
+    // Validate reprojection matrix
+    if (Q.rows != 4 || Q.cols != 4 || Q.type() != CV_32F) {
+        throw Exception(QStringLiteral("Reprojection matrix is not set!"));
+    }
+
+    // With reprojection matrix of a rectified pair, the depth does not
+    // depend on the image coordinates (Q(2,:) = [0 0 0 f]), and the
+    // homogeneous coordinate W equals f/Z. Hence, X = (Q(0,0)*x +
+    // Q(0,1)*y + Q(0,3))*Z/f, and similarly for Y
+    const float f = Q.at<float>(2, 3);
+
+    // Ray tables are built locally; their cost is negligible compared
+    // to the per-pixel conversion
+    const cv::Mat columnTable = buildColumnTable(Q, output.cols + offsetX);
+    const cv::Mat rowTable = buildRowTable(Q, output.rows + offsetY);
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    cv::Mat result(output.rows, output.cols, CV_32FC3);
+    for (int y = 0; y < output.rows; y++) {
+        const float *columnX = columnTable.ptr<float>(0) + offsetX;
+        const float *columnY = columnTable.ptr<float>(1) + offsetX;
+        const float rowX = rowTable.at<float>(0, y + offsetY);
+        const float rowY = rowTable.at<float>(1, y + offsetY);
+
+        cv::Vec3f *resultPtr = result.ptr<cv::Vec3f>(y);
+
+        for (int x = 0; x < output.cols; x++) {
+            float z;
+            if (output.type() == CV_32FC1) {
+                z = output.at<float>(y, x);
+            } else {
+                unsigned short mm = output.at<unsigned short>(y, x);
+                z = mm ? mm : nan;
+            }
+
+            float scale = z / f;
+            resultPtr[x] = cv::Vec3f((columnX[x] + rowX) * scale, (columnY[x] + rowY) * scale, z);
+        }
+    }
+
+    points = result;
 }
 
 
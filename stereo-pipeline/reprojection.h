@@ -21,10 +21,13 @@
 #define MVL_STEREO_TOOLBOX__PIPELINE__REPROJECTION_H
 
 #include <stereo-pipeline/export.h>
+#include <stereo-pipeline/disparity_format.h>
 
 #include <QtCore>
 #include <opencv2/core.hpp>
 
+#include <cstring>
+
 
 namespace MVL {
 namespace StereoToolbox {
@@ -47,19 +50,76 @@ public:
     enum {
         MethodOpenCvCpu,
         MethodOpenCvCuda,
+        MethodToolboxCpu,
+    };
+
+    // Output types:
+    //  - OutputPoints: dense CV_32FC3 image of points, with invalid
+    //    points set to NaN
+    //  - OutputPointList: compact Nx1 CV_32FC4 list of valid points;
+    //    the fourth channel holds the linear index (y*cols + x) of
+    //    the corresponding pixel in the disparity image, stored as a
+    //    32-bit integer (see getListPointIndex())
+    //  - OutputPointsHalf: dense CV_16SC3 image of half-precision
+    //    points (see cv::convertFp16)
+    //  - OutputDepth: dense CV_32FC1 depth (Z) image, with invalid
+    //    depths set to NaN
+    //  - OutputDepthMillimeters: dense CV_16UC1 depth image, assuming
+    //    the calibration is in millimeters; 0 denotes invalid depth
+    enum {
+        OutputPoints,
+        OutputPointList,
+        OutputPointsHalf,
+        OutputDepth,
+        OutputDepthMillimeters,
     };
 
     void setReprojectionMethod (int method);
     int getReprojectionMethod () const;
     const QList<int> &getSupportedReprojectionMethods () const;
 
-    void setReprojectionMatrix (const cv::Mat &Q);
-    const cv::Mat &getReprojectionMatrix () const;
+    void setOutputType (int type);
+    int getOutputType () const;
 
-    void reprojectDisparity (const cv::Mat &disparity, cv::Mat &points) const;
+    void setReprojectionMatrix (const cv::Mat &Q);
+    cv::Mat getReprojectionMatrix () const;
+
+    // The offset denotes the position of disparity image's top-left
+    // pixel within the (rectified) image for which the reprojection
+    // matrix was computed
+    void reprojectDisparity (const cv::Mat &disparity, cv::Mat &points, int offsetX = 0, int offsetY = 0) const;
+
+    // Reprojection of disparity in its native (e.g., fixed-point)
+    // format, without prior conversion to float
+    void reprojectDisparity (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX = 0, int offsetY = 0) const;
+
+    // Converts output of any type to float points (dense CV_32FC3 or
+    // CV_32FC4 list), for consumers that require all coordinates
+    void convertToPoints (const cv::Mat &output, cv::Mat &points, int offsetX = 0, int offsetY = 0) const;
+
+    // Same as above, using the given (CV_32F) reprojection matrix; for
+    // consumers that do not have access to the reprojection object
+    static void convertToPoints (const cv::Mat &output, const cv::Mat &Q, cv::Mat &points, int offsetX = 0, int offsetY = 0);
+
+    // Point list entries; the pixel index is stored bit-wise in the
+    // fourth channel, so that it is exact regardless of image size
+    static inline cv::Vec4f makeListPoint (float x, float y, float z, int index)
+    {
+        cv::Vec4f point(x, y, z, 0.0f);
+        std::memcpy(&point[3], &index, sizeof(index));
+        return point;
+    }
+
+    static inline int getListPointIndex (const cv::Vec4f &point)
+    {
+        int index;
+        std::memcpy(&index, &point[3], sizeof(index));
+        return index;
+    }
 
 signals:
     void reprojectionMethodChanged (int method);
+    void outputTypeChanged (int type);
     void reprojectionMatrixChanged ();
 
     void error (const QString &message);
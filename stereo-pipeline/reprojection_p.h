@@ -35,11 +35,44 @@ class ReprojectionPrivate
 
     ReprojectionPrivate (Reprojection *parent);
 
+protected:
+    // Thread-safe snapshot of the reprojection matrix
+    cv::Mat getMatrix () const;
+
+    // Thread-safe snapshot of the reprojection matrix and of the ray
+    // tables that cover at least the given image area
+    void getRayTables (int width, int height, cv::Mat &matrix, cv::Mat &columnTable, cv::Mat &rowTable) const;
+
+    void reprojectOpenCvCpu (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const;
+    void reprojectOpenCvCuda (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const;
+    void reprojectToolboxCpu (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &points, int offsetX, int offsetY) const;
+
+    void prepareOpenCvDisparity (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &filteredDisparity, double &disparityScale) const;
+    cv::Mat getOffsetReprojectionMatrix (int offsetX, int offsetY, double disparityScale = 1.0) const;
+
 protected:
     cv::Mat Q;
 
     QList<int> supportedMethods;
     int reprojectionMethod;
+
+    int outputType;
+
+    // Ray look-up tables for toolbox CPU method. Since the reprojection
+    // is affine in pixel coordinates, the per-pixel ray coefficients
+    // are separable into per-column (Q(:,0)*x) and per-row
+    // (Q(:,1)*y + Q(:,3)) terms. The tables are stored as 4xN matrices
+    // (one row per homogeneous coordinate), and are invalidated when
+    // the reprojection matrix changes; they are (re)built only when
+    // they need to cover larger image area.
+    //
+    // The matrix and the tables are accessed from both the worker and
+    // GUI thread, and are guarded by the mutex. They are never modified
+    // in place, but replaced with new buffers, so snapshots taken under
+    // the mutex remain valid after it is released
+    mutable QMutex mutex;
+    mutable cv::Mat rayColumnTable;
+    mutable cv::Mat rayRowTable;
 };
 
 
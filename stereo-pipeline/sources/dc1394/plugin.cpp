@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceDC1394 {
 
 
-class Plugin : public QObject, public PluginFactory
+class SourceDC1394Plugin : public QObject, public PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.DC1394")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.DC1394" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
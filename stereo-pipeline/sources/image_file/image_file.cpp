@@ -35,8 +35,25 @@ ImageFile::ImageFile (QObject *parent)
     isRemote = false;
     waitingForReply = false;
 
+    contentSize = -1;
+
     network = new QNetworkAccessManager(this);
     connect(network, &QNetworkAccessManager::finished, this, &ImageFile::processRemoteReply);
+
+    watchEnabled = false;
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &ImageFile::handleWatchedPathChange);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &ImageFile::handleWatchedPathChange);
+
+    // Writing a file usually triggers several notifications; the
+    // change is reported once they settle
+    watchTimer = new QTimer(this);
+    watchTimer->setSingleShot(true);
+    watchTimer->setInterval(100);
+    connect(watchTimer, &QTimer::timeout, this, [this] () {
+        updateWatchedPaths(); // Re-add the file if it was replaced
+        emit fileChanged();
+    });
 }
 
 ImageFile::~ImageFile ()
@@ -58,6 +75,12 @@ void ImageFile::setImageFileOrUrl (const QString &name, bool remote)
     // Set
     fileNameOrUrl = name;
     isRemote = remote;
+
+    // New image is always loaded
+    resetContent();
+    updateWatchedPaths();
+
+    emit sourceChanged();
 }
 
 
@@ -68,6 +91,8 @@ void ImageFile::imageLoadingError (const QString &message)
     frameBuffer = cv::Mat();
     frameBufferLock.unlock();
 
+    resetContent();
+
     // Emit error
     qWarning() << qPrintable(message);
     emit error(message);
@@ -91,15 +116,35 @@ void ImageFile::refreshImage ()
 
 void ImageFile::loadLocalImage ()
 {
-    try {
-        // Load both images and amit the change signal
-        QWriteLocker locker(&frameBufferLock);
-        frameBuffer = cv::imread(fileNameOrUrl.toStdString(), cv::IMREAD_ANYCOLOR);
-    } catch (const std::exception &e) {
-        imageLoadingError(QStringLiteral("Error while loading images: %1").arg(QString::fromStdString(e.what())));
+    // Skip reading if file has not been modified
+    QFileInfo fileInfo(fileNameOrUrl);
+    if (fileInfo.exists() && fileInfo.size() == contentSize && fileInfo.lastModified() == contentModified) {
+        emit imageUnchanged();
+        return;
     }
 
-    emit imageReady();
+    QFile file(fileNameOrUrl);
+    if (!file.open(QIODevice::ReadOnly)) {
+        imageLoadingError(QStringLiteral("Error while loading image: failed to open '%1'").arg(fileNameOrUrl));
+        emit imageReady();
+        return;
+    }
+
+    QByteArray data = file.readAll();
+    file.close();
+
+    // Modification time is recorded only after the content is hashed,
+    // so a file that is modified again in the meantime is re-read
+    bool changed = updateContent(data);
+
+    contentSize = fileInfo.size();
+    contentModified = fileInfo.lastModified();
+
+    if (changed) {
+        emit imageReady();
+    } else {
+        emit imageUnchanged();
+    }
 }
 
 void ImageFile::loadRemoteImage ()
@@ -124,18 +169,97 @@ void ImageFile::processRemoteReply (QNetworkReply *reply)
         QByteArray payload = reply->readAll();
         reply->deleteLater();
 
-        // Set output image, and decode
-        try {
-            QWriteLocker locker(&frameBufferLock);
-            cv::imdecode(cv::Mat(1, payload.size(), CV_8UC1, payload.data()), cv::IMREAD_ANYCOLOR, &frameBuffer);
-        } catch (const std::exception &e) {
-            imageLoadingError(QStringLiteral("Error while decoding retrieved image: %1").arg(QString::fromStdString(e.what())));
+        if (!updateContent(payload)) {
+            emit imageUnchanged();
+            return;
         }
     }
 
     emit imageReady();
 }
 
+bool ImageFile::updateContent (const QByteArray &data)
+{
+    // Compare to previously-loaded content
+    QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    if (hash == contentHash) {
+        return false;
+    }
+
+    // Decode into new image, as the previous one may still be in use
+    cv::Mat image;
+    try {
+        image = cv::imdecode(cv::Mat(1, data.size(), CV_8UC1, const_cast<char *>(data.constData())), cv::IMREAD_ANYCOLOR);
+    } catch (const std::exception &e) {
+        imageLoadingError(QStringLiteral("Error while decoding image: %1").arg(QString::fromStdString(e.what())));
+        return true;
+    }
+
+    QWriteLocker locker(&frameBufferLock);
+    frameBuffer = image;
+    locker.unlock();
+
+    contentHash = hash;
+
+    return true;
+}
+
+void ImageFile::resetContent ()
+{
+    contentSize = -1;
+    contentModified = QDateTime();
+    contentHash.clear();
+}
+
+
+// *********************************************************************
+// *                           File watching                           *
+// *********************************************************************
+void ImageFile::setWatchState (bool enable)
+{
+    if (watchEnabled == enable) {
+        return;
+    }
+
+    watchEnabled = enable;
+    updateWatchedPaths();
+}
+
+bool ImageFile::getWatchState () const
+{
+    return watchEnabled;
+}
+
+void ImageFile::updateWatchedPaths ()
+{
+    QStringList paths;
+    if (watchEnabled && !isRemote && !fileNameOrUrl.isEmpty()) {
+        QFileInfo fileInfo(fileNameOrUrl);
+        paths.append(fileInfo.absolutePath());
+        if (fileInfo.exists()) {
+            paths.append(fileInfo.absoluteFilePath());
+        }
+    }
+
+    // Update only if necessary, to avoid re-creating the watches
+    QStringList watchedPaths = watcher->files() + watcher->directories();
+    for (const QString &path : watchedPaths) {
+        if (!paths.contains(path)) {
+            watcher->removePath(path);
+        }
+    }
+    for (const QString &path : paths) {
+        if (!watchedPaths.contains(path)) {
+            watcher->addPath(path);
+        }
+    }
+}
+
+void ImageFile::handleWatchedPathChange ()
+{
+    watchTimer->start();
+}
+
 
 // *********************************************************************
 // *                           Image access                            *
@@ -156,6 +280,11 @@ const QString &ImageFile::getImageFilename ()
     return fileNameOrUrl;
 }
 
+bool ImageFile::isRemoteImage () const
+{
+    return isRemote;
+}
+
 int ImageFile::getImageWidth ()
 {
     QReadLocker locker(&frameBufferLock);
@@ -31,6 +31,11 @@ namespace Pipeline {
 namespace SourceImageFile {
 
 
+// Image loaded from a local file or a remote URL. Re-loading is
+// skipped if the content has not changed (based on size and
+// modification time of a local file, and on hash of the file content
+// or the retrieved payload), in which case imageUnchanged() is emitted
+// instead of imageReady(). Local files can also be watched for changes
 class ImageFile : public QObject
 {
     Q_OBJECT
@@ -42,6 +47,7 @@ public:
     QWidget *createConfigWidget (QWidget *parent = nullptr);
 
     const QString &getImageFilename ();
+    bool isRemoteImage () const;
     int getImageWidth ();
     int getImageHeight ();
     int getImageChannels ();
@@ -53,6 +59,10 @@ public:
 
     void refreshImage ();
 
+    // Watching has effect only on local files
+    void setWatchState (bool enable);
+    bool getWatchState () const;
+
 protected:
     void imageLoadingError (const QString &message);
     void loadLocalImage ();
@@ -60,10 +70,23 @@ protected:
 
     void processRemoteReply (QNetworkReply *reply);
 
+    bool updateContent (const QByteArray &data);
+    void resetContent ();
+
+    void updateWatchedPaths ();
+    void handleWatchedPathChange ();
+
 signals:
     void imageReady ();
+    void imageUnchanged ();
     void error (const QString message);
 
+    // Emitted when the watched file is modified
+    void fileChanged ();
+
+    // Emitted when the file name/URL or the remote flag is set
+    void sourceChanged ();
+
 protected:
     QString fileNameOrUrl;
     bool isRemote;
@@ -71,6 +94,17 @@ protected:
     QNetworkAccessManager *network;
     bool waitingForReply;
 
+    // Loaded content
+    qint64 contentSize;
+    QDateTime contentModified;
+    QByteArray contentHash;
+
+    // File watching; the parent directory is watched as well, because
+    // files are often replaced rather than modified in-place
+    bool watchEnabled;
+    QFileSystemWatcher *watcher;
+    QTimer *watchTimer;
+
     // Frame buffer
     QReadWriteLock frameBufferLock;
     cv::Mat frameBuffer;
@@ -0,0 +1,295 @@
+/*
+ * Image File Source: image sequence
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "image_sequence.h"
+
+#include <stereo-pipeline/exception.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceImageFile {
+
+
+// Compares strings with embedded numbers by their numeric value, so
+// that e.g., image2.png precedes image10.png
+static bool naturalLessThan (const QString &str1, const QString &str2)
+{
+    int i = 0, j = 0;
+
+    while (i < str1.size() && j < str2.size()) {
+        if (str1[i].isDigit() && str2[j].isDigit()) {
+            int start1 = i, start2 = j;
+            while (i < str1.size() && str1[i].isDigit()) i++;
+            while (j < str2.size() && str2[j].isDigit()) j++;
+
+            qulonglong number1 = str1.midRef(start1, i - start1).toULongLong();
+            qulonglong number2 = str2.midRef(start2, j - start2).toULongLong();
+            if (number1 != number2) {
+                return number1 < number2;
+            }
+        } else {
+            if (str1[i] != str2[j]) {
+                return str1[i] < str2[j];
+            }
+            i++;
+            j++;
+        }
+    }
+
+    return (str1.size() - i) < (str2.size() - j);
+}
+
+static QStringList findFiles (const QString &pattern)
+{
+    QFileInfo patternInfo(pattern);
+    QDir dir = patternInfo.dir();
+
+    QStringList filenames = dir.entryList(QStringList(patternInfo.fileName()), QDir::Files);
+    std::sort(filenames.begin(), filenames.end(), naturalLessThan);
+
+    for (QString &filename : filenames) {
+        filename = dir.filePath(filename);
+    }
+
+    return filenames;
+}
+
+
+ImageSequence::ImageSequence (QObject *parent)
+    : QObject(parent),
+      cache(512*1024),
+      generation(0)
+{
+    prefetchDepth = 2*decodePool.maxThreadCount();
+}
+
+ImageSequence::~ImageSequence ()
+{
+    clear();
+    decodePool.waitForDone();
+}
+
+
+// *********************************************************************
+// *                             Sequence                              *
+// *********************************************************************
+void ImageSequence::setPatterns (const QString &leftPattern, const QString &rightPattern)
+{
+    QStringList filenamesLeft = findFiles(leftPattern);
+    QStringList filenamesRight = findFiles(rightPattern);
+
+    if (filenamesLeft.isEmpty()) {
+        throw Exception(QStringLiteral("No files match pattern '%1'!").arg(leftPattern));
+    }
+    if (filenamesLeft.size() != filenamesRight.size()) {
+        throw Exception(QStringLiteral("Number of left (%1) and right (%2) images differs!").arg(filenamesLeft.size()).arg(filenamesRight.size()));
+    }
+
+    QVector<QPair<QString, QString>> newPairs;
+    for (int i = 0; i < filenamesLeft.size(); i++) {
+        newPairs.append(qMakePair(filenamesLeft[i], filenamesRight[i]));
+    }
+
+    setPairs(newPairs);
+}
+
+void ImageSequence::setListFile (const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        throw Exception(QStringLiteral("Failed to open list file '%1'!").arg(filename));
+    }
+
+    QDir dir = QFileInfo(filename).dir();
+    QVector<QPair<QString, QString>> newPairs;
+
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        QString line = stream.readLine().trimmed();
+        lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        QStringList entries = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if (entries.size() != 2) {
+            throw Exception(QStringLiteral("Invalid entry in list file '%1', line %2!").arg(filename).arg(lineNumber));
+        }
+
+        newPairs.append(qMakePair(dir.filePath(entries[0]), dir.filePath(entries[1])));
+    }
+
+    if (newPairs.isEmpty()) {
+        throw Exception(QStringLiteral("List file '%1' contains no image pairs!").arg(filename));
+    }
+
+    setPairs(newPairs);
+}
+
+void ImageSequence::clear ()
+{
+    setPairs(QVector<QPair<QString, QString>>());
+}
+
+void ImageSequence::setPairs (const QVector<QPair<QString, QString>> &newPairs)
+{
+    // Outstanding jobs are not waited for; their results are discarded
+    QMutexLocker locker(&mutex);
+
+    decodePool.clear();
+    generation++;
+
+    pairs = newPairs;
+    cache.clear();
+    pending.clear();
+    requested.clear();
+    ready.clear();
+}
+
+int ImageSequence::getLength () const
+{
+    return pairs.size();
+}
+
+
+void ImageSequence::setCacheSize (int megabytes)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(qMax(megabytes, 0)*1024);
+}
+
+int ImageSequence::getCacheSize () const
+{
+    QMutexLocker locker(&mutex);
+    return cache.maxCost()/1024;
+}
+
+void ImageSequence::setPrefetchDepth (int depth)
+{
+    QMutexLocker locker(&mutex);
+    prefetchDepth = qMax(depth, 0);
+}
+
+int ImageSequence::getPrefetchDepth () const
+{
+    QMutexLocker locker(&mutex);
+    return prefetchDepth;
+}
+
+
+// *********************************************************************
+// *                             Decoding                              *
+// *********************************************************************
+bool ImageSequence::getPair (int index, cv::Mat &left, cv::Mat &right)
+{
+    QMutexLocker locker(&mutex);
+
+    if (index < 0 || index >= pairs.size()) {
+        return false;
+    }
+
+    // Schedule requested pair (if necessary) and the ones that follow
+    for (int i = index; i <= index + prefetchDepth && i < pairs.size(); i++) {
+        scheduleDecode(i);
+    }
+
+    if (ready.contains(index)) {
+        ImagePair pair = ready.take(index);
+        left = pair.left;
+        right = pair.right;
+        return true;
+    }
+
+    ImagePair *pair = cache.object(index);
+    if (!pair) {
+        requested.insert(index);
+        return false;
+    }
+
+    left = pair->left;
+    right = pair->right;
+
+    return true;
+}
+
+void ImageSequence::scheduleDecode (int index)
+{
+    if (pending.contains(index) || ready.contains(index) || cache.contains(index)) {
+        return;
+    }
+
+    pending.insert(index);
+    QtConcurrent::run(&decodePool, this, &ImageSequence::decodeFunction, index, pairs[index].first, pairs[index].second, generation);
+}
+
+void ImageSequence::decodeFunction (int index, const QString &filenameLeft, const QString &filenameRight, int decodeGeneration)
+{
+    ImagePair *pair = new ImagePair();
+    QString errorMessage;
+
+    try {
+        pair->left = cv::imread(filenameLeft.toStdString(), cv::IMREAD_ANYCOLOR);
+        pair->right = cv::imread(filenameRight.toStdString(), cv::IMREAD_ANYCOLOR);
+
+        if (pair->left.empty() || pair->right.empty()) {
+            errorMessage = QStringLiteral("Failed to load image pair #%1 ('%2', '%3')").arg(index + 1).arg(filenameLeft).arg(filenameRight);
+        }
+    } catch (const std::exception &e) {
+        errorMessage = QStringLiteral("Error while loading image pair #%1: %2").arg(index + 1).arg(QString::fromStdString(e.what()));
+    }
+
+    // Failed pairs are stored as well (with empty images), so that
+    // playback can continue
+    QMutexLocker locker(&mutex);
+
+    if (decodeGeneration != generation) {
+        delete pair;
+        return;
+    }
+
+    pending.remove(index);
+
+    if (requested.remove(index)) {
+        ready.insert(index, *pair);
+    }
+
+    int cost = (pair->left.total()*pair->left.elemSize() + pair->right.total()*pair->right.elemSize())/1024;
+    cache.insert(index, pair, qMax(cost, 1)); // Takes ownership
+
+    locker.unlock();
+
+    if (!errorMessage.isEmpty()) {
+        qWarning() << qPrintable(errorMessage);
+        emit error(errorMessage);
+    }
+
+    emit pairDecoded(index);
+}
+
+
+} // SourceImageFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,123 @@
+/*
+ * Image File Source: image sequence
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__IMAGE_FILE__IMAGE_SEQUENCE_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__IMAGE_FILE__IMAGE_SEQUENCE_H
+
+#include <QtConcurrent>
+#include <opencv2/core.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceImageFile {
+
+
+// Sequence of image pairs, decoded ahead of use by a pool of worker
+// threads. Decoded pairs are kept in a cache with limited memory
+// budget, which allows stepping back and forth without re-decoding.
+// Decoded images are never modified, so they can be shared without
+// copying
+class ImageSequence : public QObject
+{
+    Q_OBJECT
+
+public:
+    ImageSequence (QObject *parent = nullptr);
+    virtual ~ImageSequence ();
+
+    // Pairs the files matching left and right wildcard pattern (e.g.,
+    // /data/left/*.png), in natural sort order; throws an Exception if
+    // no files match or if the numbers of matched files differ
+    void setPatterns (const QString &leftPattern, const QString &rightPattern);
+
+    // Reads pairs from a text file, with left and right filename on
+    // each line (separated by whitespace); relative filenames are
+    // relative to the list file. Empty lines and lines starting with #
+    // are ignored. Throws an Exception on failure
+    void setListFile (const QString &filename);
+
+    void clear ();
+
+    int getLength () const;
+
+    // Decoded-pair cache budget, in megabytes
+    void setCacheSize (int megabytes);
+    int getCacheSize () const;
+
+    // Number of pairs that are decoded ahead of the requested one
+    void setPrefetchDepth (int depth);
+    int getPrefetchDepth () const;
+
+    // Returns the pair, if it is already decoded; otherwise, false is
+    // returned and pairDecoded() is emitted once it becomes available.
+    // In either case, decoding of subsequent pairs is scheduled
+    bool getPair (int index, cv::Mat &left, cv::Mat &right);
+
+protected:
+    void setPairs (const QVector<QPair<QString, QString>> &newPairs);
+
+    // Must be called with mutex locked
+    void scheduleDecode (int index);
+
+    void decodeFunction (int index, const QString &filenameLeft, const QString &filenameRight, int decodeGeneration);
+
+signals:
+    // Emitted from the worker thread
+    void pairDecoded (int index);
+    void error (const QString message);
+
+protected:
+    QVector<QPair<QString, QString>> pairs;
+
+    // Decoded pairs (under mutex); cost is in kilobytes
+    struct ImagePair
+    {
+        cv::Mat left;
+        cv::Mat right;
+    };
+
+    mutable QMutex mutex;
+    QCache<int, ImagePair> cache;
+    QSet<int> pending;
+
+    // Pairs that were requested before being decoded are kept outside
+    // of the cache until retrieved, so they cannot be evicted by the
+    // prefetched ones
+    QSet<int> requested;
+    QHash<int, ImagePair> ready;
+
+    // Incremented whenever sequence changes, so that results of
+    // outstanding decode jobs can be discarded
+    int generation;
+
+    int prefetchDepth;
+
+    QThreadPool decodePool;
+};
+
+
+} // SourceImageFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceImageFile {
 
 
-class Plugin : public QObject, PluginFactory
+class SourceImageFilePlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.ImageFilePair")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.ImageFilePair" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
@@ -20,6 +20,7 @@
 #include "source.h"
 #include "source_widget.h"
 #include "image_file.h"
+#include "image_sequence.h"
 
 
 namespace MVL {
@@ -29,19 +30,58 @@ namespace SourceImageFile {
 
 
 Source::Source (QObject *parent)
-    : QObject(parent), ImagePairSource()
+    : QObject(parent), ImagePairSource(),
+      playbackFramerate(25),
+      sequencePosition(-1),
+      pendingPosition(-1),
+      playing(false),
+      maxSpeed(false),
+      imagesConsumed(true)
 {
+    refreshEnabled = false;
     refreshPeriod = 1000;
     refreshTimer = new QTimer(this);
     connect(refreshTimer, &QTimer::timeout, this, &Source::periodicRefresh);
 
     leftImageReady = rightImageReady = false;
+    imagesModified = false;
 
     leftImageFile = new ImageFile(this);
-    connect(leftImageFile, &ImageFile::imageReady, this, &Source::synchronizeFrames);
+    connect(leftImageFile, &ImageFile::imageReady, this, [this] () {
+        leftImageReady = true;
+        imagesModified = true;
+        synchronizeFrames();
+    });
+    connect(leftImageFile, &ImageFile::imageUnchanged, this, [this] () {
+        leftImageReady = true;
+        synchronizeFrames();
+    });
+    connect(leftImageFile, &ImageFile::fileChanged, this, &Source::periodicRefresh);
+    connect(leftImageFile, &ImageFile::sourceChanged, this, &Source::updateRefreshTimer);
 
     rightImageFile = new ImageFile(this);
-    connect(rightImageFile, &ImageFile::imageReady, this, &Source::synchronizeFrames);
+    connect(rightImageFile, &ImageFile::imageReady, this, [this] () {
+        rightImageReady = true;
+        imagesModified = true;
+        synchronizeFrames();
+    });
+    connect(rightImageFile, &ImageFile::imageUnchanged, this, [this] () {
+        rightImageReady = true;
+        synchronizeFrames();
+    });
+    connect(rightImageFile, &ImageFile::fileChanged, this, &Source::periodicRefresh);
+    connect(rightImageFile, &ImageFile::sourceChanged, this, &Source::updateRefreshTimer);
+
+    sequence = new ImageSequence(this);
+    connect(sequence, &ImageSequence::pairDecoded, this, &Source::handlePairDecoded, Qt::QueuedConnection);
+    connect(sequence, &ImageSequence::error, this, &Source::error, Qt::QueuedConnection);
+
+    playbackTimer = new QTimer(this);
+    playbackTimer->setTimerType(Qt::PreciseTimer);
+    connect(playbackTimer, &QTimer::timeout, this, &Source::playbackFunction);
+
+    // getImages() may be called from any thread
+    connect(this, &Source::imagesRetrieved, this, &Source::handleImagesRetrieved, Qt::QueuedConnection);
 }
 
 Source::~Source ()
@@ -59,16 +99,20 @@ QString Source::getShortName () const
 
 void Source::getImages (cv::Mat &left, cv::Mat &right) const
 {
-    // Copy images under lock
+    // Images are never modified, so they can be shared without copying
     QReadLocker locker(&imagesLock);
-    imageLeft.copyTo(left);
-    imageRight.copyTo(right);
+    left = imageLeft;
+    right = imageRight;
+    locker.unlock();
+
+    emit const_cast<Source *>(this)->imagesRetrieved();
 }
 
 void Source::stopSource ()
 {
-    // Stop periodic refresh
+    // Stop periodic refresh and playback
     setPeriodicRefreshState(false);
+    stopPlayback();
 }
 
 QWidget *Source::createConfigWidget (QWidget *parent)
@@ -82,9 +126,16 @@ QWidget *Source::createConfigWidget (QWidget *parent)
 // *********************************************************************
 void Source::loadImagePair (const QString &left, const QString &right, bool remote)
 {
-    // Loading images stops the periodic update
+    // Loading images stops the periodic update and leaves sequence mode
     setPeriodicRefreshState(false);
 
+    if (sequence->getLength()) {
+        stopPlayback();
+        sequence->clear();
+        sequencePosition = pendingPosition = -1;
+        emit sequenceChanged(0);
+    }
+
     // Set images
     leftImageFile->setImageFileOrUrl(left, remote);
     rightImageFile->setImageFileOrUrl(right, remote);
@@ -110,15 +161,19 @@ ImageFile *Source::getRightImageFile ()
 // *********************************************************************
 void Source::setPeriodicRefreshState (bool enable)
 {
-    if (enable == refreshTimer->isActive()) {
+    if (enable == refreshEnabled) {
         return;
     }
 
+    refreshEnabled = enable;
+
+    // Local files are watched for changes; only remote images are polled
+    leftImageFile->setWatchState(enable);
+    rightImageFile->setWatchState(enable);
+
+    updateRefreshTimer();
     if (enable) {
-        refreshTimer->start(refreshPeriod);
         periodicRefresh();
-    } else {
-        refreshTimer->stop();
     }
 
     emit periodicRefreshStateChanged(enable);
@@ -126,7 +181,7 @@ void Source::setPeriodicRefreshState (bool enable)
 
 bool Source::getPeriodicRefreshState () const
 {
-    return refreshTimer->isActive();
+    return refreshEnabled;
 }
 
 int Source::getRefreshPeriod () const
@@ -151,6 +206,19 @@ void Source::setRefreshPeriod (int newPeriod)
 }
 
 
+// Re-evaluated whenever refresh is toggled or either image changes, as
+// images may switch between local and remote
+void Source::updateRefreshTimer ()
+{
+    if (refreshEnabled && (leftImageFile->isRemoteImage() || rightImageFile->isRemoteImage())) {
+        if (!refreshTimer->isActive()) {
+            refreshTimer->start(refreshPeriod);
+        }
+    } else {
+        refreshTimer->stop();
+    }
+}
+
 void Source::periodicRefresh ()
 {
     // Clear both
@@ -165,29 +233,34 @@ void Source::periodicRefresh ()
 
 void Source::synchronizeFrames ()
 {
-    if (QObject::sender() == leftImageFile) {
-        leftImageReady = true;
-    } else if (QObject::sender() == rightImageFile) {
-        rightImageReady = true;
-    }
-
     bool requireLeft = !leftImageFile->getImageFilename().isEmpty();
     bool requireRight = !rightImageFile->getImageFilename().isEmpty();
 
     if (((!requireLeft || leftImageReady) && (!requireRight || rightImageReady))) {
-        QWriteLocker locker(&imagesLock);
+        // Neither image has changed since the last emitted pair
+        if (!imagesModified) {
+            if (requireLeft && requireRight) {
+                leftImageReady = false;
+                rightImageReady = false;
+            }
+            return;
+        }
+
+        imagesModified = false;
+
+        // Copy into new images, as the previous ones may be shared
+        cv::Mat newImageLeft, newImageRight;
 
         if (requireLeft) {
-            leftImageFile->copyFrame(imageLeft);
-        } else {
-            imageLeft = cv::Mat();
+            leftImageFile->copyFrame(newImageLeft);
         }
         if (requireRight) {
-            rightImageFile->copyFrame(imageRight);
-        } else {
-            imageRight = cv::Mat();
+            rightImageFile->copyFrame(newImageRight);
         }
 
+        QWriteLocker locker(&imagesLock);
+        imageLeft = newImageLeft;
+        imageRight = newImageRight;
         locker.unlock();
 
         // Reset only if both left and right image are valid (otherwise
@@ -202,6 +275,214 @@ void Source::synchronizeFrames ()
 }
 
 
+// *********************************************************************
+// *                          Image sequence                           *
+// *********************************************************************
+void Source::loadImageSequence (const QString &leftPattern, const QString &rightPattern)
+{
+    stopPlayback();
+
+    try {
+        sequence->setPatterns(leftPattern, rightPattern);
+    } catch (const std::exception &e) {
+        emit error(QString::fromStdString(e.what()));
+        return;
+    }
+
+    startSequence();
+}
+
+void Source::loadImageSequenceList (const QString &filename)
+{
+    stopPlayback();
+
+    try {
+        sequence->setListFile(filename);
+    } catch (const std::exception &e) {
+        emit error(QString::fromStdString(e.what()));
+        return;
+    }
+
+    startSequence();
+}
+
+void Source::startSequence ()
+{
+    // Sequence replaces individual image files
+    setPeriodicRefreshState(false);
+    leftImageFile->setImageFileOrUrl(QString(), false);
+    rightImageFile->setImageFileOrUrl(QString(), false);
+
+    sequencePosition = pendingPosition = -1;
+
+    emit sequenceChanged(sequence->getLength());
+
+    setSequencePosition(0);
+}
+
+int Source::getSequenceLength () const
+{
+    return sequence->getLength();
+}
+
+void Source::setSequencePosition (int index)
+{
+    if (index < 0 || index >= sequence->getLength()) {
+        return;
+    }
+
+    pendingPosition = index;
+    deliverPendingPair();
+}
+
+
+void Source::startPlayback ()
+{
+    if (!sequence->getLength()) {
+        stopPlayback();
+        return;
+    }
+
+    // Restart at the end of sequence
+    if (sequencePosition >= sequence->getLength() - 1) {
+        setSequencePosition(0);
+    }
+
+    // In max-speed mode, the timer ensures that playback continues even
+    // if a pair is dropped without being retrieved
+    playbackTimer->start(1000/playbackFramerate);
+
+    playing = true;
+
+    if (maxSpeed && imagesConsumed) {
+        playbackFunction();
+    }
+
+    emit playbackStateChanged(true);
+}
+
+void Source::stopPlayback ()
+{
+    playbackTimer->stop();
+    playing = false;
+
+    emit playbackStateChanged(false);
+}
+
+void Source::setPlaybackFramerate (double framerate)
+{
+    if (framerate <= 0 || playbackFramerate == framerate) {
+        return;
+    }
+
+    playbackFramerate = framerate;
+
+    if (playbackTimer->isActive()) {
+        playbackTimer->start(1000/playbackFramerate);
+    }
+
+    emit playbackFramerateChanged(playbackFramerate);
+}
+
+double Source::getPlaybackFramerate () const
+{
+    return playbackFramerate;
+}
+
+void Source::setMaxSpeed (bool enabled)
+{
+    if (maxSpeed == enabled) {
+        return;
+    }
+
+    maxSpeed = enabled;
+
+    if (playing && maxSpeed && imagesConsumed) {
+        playbackFunction();
+    }
+
+    emit maxSpeedChanged(maxSpeed);
+}
+
+bool Source::getMaxSpeed () const
+{
+    return maxSpeed;
+}
+
+void Source::setCacheSize (int megabytes)
+{
+    if (sequence->getCacheSize() == megabytes) {
+        return;
+    }
+
+    sequence->setCacheSize(megabytes);
+
+    emit cacheSizeChanged(megabytes);
+}
+
+int Source::getCacheSize () const
+{
+    return sequence->getCacheSize();
+}
+
+
+void Source::playbackFunction ()
+{
+    // Previous pair has not been decoded yet
+    if (pendingPosition >= 0) {
+        return;
+    }
+
+    if (sequencePosition + 1 >= sequence->getLength()) {
+        stopPlayback();
+        return;
+    }
+
+    pendingPosition = sequencePosition + 1;
+    deliverPendingPair();
+}
+
+void Source::handlePairDecoded (int index)
+{
+    if (index == pendingPosition) {
+        deliverPendingPair();
+    }
+}
+
+void Source::handleImagesRetrieved ()
+{
+    imagesConsumed = true;
+
+    if (playing && maxSpeed) {
+        playbackFunction();
+        playbackTimer->start(); // Restart the timeout
+    }
+}
+
+bool Source::deliverPendingPair ()
+{
+    cv::Mat left, right;
+    if (!sequence->getPair(pendingPosition, left, right)) {
+        return false; // Delivered once decoded
+    }
+
+    sequencePosition = pendingPosition;
+    pendingPosition = -1;
+
+    QWriteLocker locker(&imagesLock);
+    imageLeft = left;
+    imageRight = right;
+    locker.unlock();
+
+    imagesConsumed = false;
+
+    emit sequencePositionChanged(sequencePosition + 1, sequence->getLength());
+    emit imagesChanged();
+
+    return true;
+}
+
+
 } // SourceImageFile
 } // Pipeline
 } // StereoToolbox
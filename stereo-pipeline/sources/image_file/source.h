@@ -32,6 +32,7 @@ namespace SourceImageFile {
 
 
 class ImageFile;
+class ImageSequence;
 
 class Source : public QObject, public ImagePairSource
 {
@@ -58,28 +59,81 @@ public:
     void setPeriodicRefreshState (bool enable);
     void setRefreshPeriod (int newPeriod);
 
+    // Image sequence; see ImageSequence for pattern and list file format
+    void loadImageSequence (const QString &leftPattern, const QString &rightPattern);
+    void loadImageSequenceList (const QString &filename);
+
+    int getSequenceLength () const;
+    void setSequencePosition (int index);
+
+    void startPlayback ();
+    void stopPlayback ();
+
+    void setPlaybackFramerate (double framerate);
+    double getPlaybackFramerate () const;
+
+    // In max-speed mode, next pair is emitted as soon as the previous
+    // one has been retrieved, but no slower than at playback framerate
+    void setMaxSpeed (bool enabled);
+    bool getMaxSpeed () const;
+
+    // Memory budget of the decoded-pair cache, in megabytes
+    void setCacheSize (int megabytes);
+    int getCacheSize () const;
+
 protected:
+    void updateRefreshTimer ();
     void periodicRefresh ();
     void synchronizeFrames ();
 
+    void startSequence ();
+    void playbackFunction ();
+    void handlePairDecoded (int index);
+    void handleImagesRetrieved ();
+    bool deliverPendingPair ();
+
 signals:
     void periodicRefreshStateChanged (bool enabled);
     void refreshPeriodChanged (int period);
 
+    void sequenceChanged (int length);
+    void sequencePositionChanged (int position, int length);
+    void playbackStateChanged (bool playing);
+    void playbackFramerateChanged (double framerate);
+    void maxSpeedChanged (bool enabled);
+    void cacheSizeChanged (int megabytes);
+
+    // Internal: emitted from getImages() to notify the source's thread
+    void imagesRetrieved ();
+
     // Signals from interface
     void imagesChanged () override;
     void error (QString message) override;
 
 protected:
-    QTimer *refreshTimer;
+    bool refreshEnabled;
+    QTimer *refreshTimer; // Only for remote images
     int refreshPeriod;
 
     ImageFile *leftImageFile;
     ImageFile *rightImageFile;
 
     bool leftImageReady, rightImageReady;
+    bool imagesModified; // Since the last emitted pair
+
+    // Image sequence and its playback
+    ImageSequence *sequence;
+
+    QTimer *playbackTimer;
+    double playbackFramerate;
+
+    int sequencePosition;
+    int pendingPosition; // Pair to be emitted once decoded; -1 if none
+    bool playing;
+    bool maxSpeed;
+    bool imagesConsumed; // Last emitted pair was retrieved
 
-    // Images
+    // Images; these are never modified, only replaced
     mutable QReadWriteLock imagesLock;
 
     cv::Mat imageLeft;
@@ -84,7 +84,7 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
     layout->addRow(button);
 
     // Periodic refresh
-    tooltip = "Enable/disable perodic refresh";
+    tooltip = "Enable/disable automatic refresh; local files are re-loaded when modified, while remote images are polled with refresh period";
 
     button = new QPushButton("Periodic refresh", this);
     button->setToolTip(tooltip);
@@ -95,7 +95,7 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
     layout->addRow(button);
 
     // Refresh period
-    tooltip = "Refresh period for periodic refresh";
+    tooltip = "Refresh period for periodic refresh of remote images";
 
     label = new QLabel("Refresh period", this);
     label->setToolTip(tooltip);
@@ -117,6 +117,163 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
 
     layout->addRow(line);
 
+    // *** Image sequence ***
+    label = new QLabel("<b>Image sequence</b>", this);
+    label->setAlignment(Qt::AlignCenter);
+    layout->addRow(label);
+
+    // Patterns
+    tooltip = "Wildcard pattern for left images of the sequence (e.g., /data/left/*.png).";
+
+    label = new QLabel("Left pattern", this);
+    label->setToolTip(tooltip);
+
+    lineEditLeftPattern = new QLineEdit(this);
+    lineEditLeftPattern->setToolTip(tooltip);
+
+    layout->addRow(label, lineEditLeftPattern);
+
+    tooltip = "Wildcard pattern for right images of the sequence (e.g., /data/right/*.png).";
+
+    label = new QLabel("Right pattern", this);
+    label->setToolTip(tooltip);
+
+    lineEditRightPattern = new QLineEdit(this);
+    lineEditRightPattern->setToolTip(tooltip);
+
+    layout->addRow(label, lineEditRightPattern);
+
+    tooltip = "Load image sequence from files matching the patterns.";
+
+    button = new QPushButton("Load sequence", this);
+    button->setToolTip(tooltip);
+    connect(button, &QPushButton::clicked, this, [this] () {
+        emit requestSequenceLoad(lineEditLeftPattern->text(), lineEditRightPattern->text());
+    });
+    connect(this, &SourceWidget::requestSequenceLoad, source, &Source::loadImageSequence, Qt::QueuedConnection);
+
+    layout->addRow(button);
+
+    tooltip = "Load image sequence from list file, with left and right image filename on each line.";
+
+    button = new QPushButton("Load sequence list file", this);
+    button->setToolTip(tooltip);
+    connect(button, &QPushButton::clicked, this, [this] () {
+        QString filename = QFileDialog::getOpenFileName(this, "Load image sequence list file", QString(), "Text files (*.txt);; All files (*.*)");
+        if (!filename.isEmpty()) {
+            emit requestSequenceListLoad(filename);
+        }
+    });
+    connect(this, &SourceWidget::requestSequenceListLoad, source, &Source::loadImageSequenceList, Qt::QueuedConnection);
+
+    layout->addRow(button);
+
+    // Playback
+    widgetSequence = new QWidget(this);
+    QFormLayout *layoutSequence = new QFormLayout(widgetSequence);
+    layoutSequence->setContentsMargins(0, 0, 0, 0);
+
+    tooltip = "Start/pause playback.";
+
+    button = new QPushButton("Play", this);
+    button->setToolTip(tooltip);
+    button->setCheckable(true);
+    connect(button, &QPushButton::toggled, source, [this] (bool active) {
+        if (active) {
+            this->source->startPlayback();
+        } else {
+            this->source->stopPlayback();
+        }
+    }, Qt::QueuedConnection);
+    connect(source, &Source::playbackStateChanged, button, &QPushButton::setChecked, Qt::QueuedConnection);
+
+    layoutSequence->addRow(button);
+
+    // Position
+    tooltip = "Current image pair.";
+
+    label = new QLabel("Pair", this);
+    label->setToolTip(tooltip);
+
+    spinBoxPosition = new QSpinBox(this);
+    spinBoxPosition->setToolTip(tooltip);
+    spinBoxPosition->setKeyboardTracking(false);
+    connect(spinBoxPosition, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), source, [this] (int value) {
+        this->source->setSequencePosition(value - 1);
+    }, Qt::QueuedConnection);
+
+    layoutSequence->addRow(label, spinBoxPosition);
+
+    sliderPosition = new QSlider(Qt::Horizontal, this);
+    sliderPosition->setSingleStep(1);
+    sliderPosition->setPageStep(10);
+    sliderPosition->setTracking(false);
+    connect(sliderPosition, &QSlider::valueChanged, source, [this] (int value) {
+        this->source->setSequencePosition(value - 1);
+    }, Qt::QueuedConnection);
+
+    layoutSequence->addRow(sliderPosition);
+
+    // Framerate
+    tooltip = "Playback framerate.";
+
+    label = new QLabel("Framerate", this);
+    label->setToolTip(tooltip);
+
+    QDoubleSpinBox *spinBoxD = new QDoubleSpinBox(this);
+    spinBoxD->setToolTip(tooltip);
+    spinBoxD->setKeyboardTracking(false);
+    spinBoxD->setRange(0.1, 1000.0);
+    spinBoxD->setDecimals(1);
+    spinBoxD->setSuffix(" fps");
+    spinBoxD->setValue(source->getPlaybackFramerate());
+    connect(spinBoxD, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), source, &Source::setPlaybackFramerate, Qt::QueuedConnection);
+    connect(source, &Source::playbackFramerateChanged, spinBoxD, &QDoubleSpinBox::setValue, Qt::QueuedConnection);
+
+    layoutSequence->addRow(label, spinBoxD);
+
+    // Max speed
+    tooltip = "Emit image pairs as fast as the pipeline can process them, instead of at playback framerate.";
+
+    QCheckBox *checkBox = new QCheckBox("Max speed", this);
+    checkBox->setToolTip(tooltip);
+    checkBox->setChecked(source->getMaxSpeed());
+    connect(checkBox, &QCheckBox::toggled, source, &Source::setMaxSpeed, Qt::QueuedConnection);
+    connect(source, &Source::maxSpeedChanged, checkBox, &QCheckBox::setChecked, Qt::QueuedConnection);
+
+    layoutSequence->addRow(checkBox);
+
+    // Cache size
+    tooltip = "Memory budget for decoded image pairs, which allow instant stepping back and forth.";
+
+    label = new QLabel("Pair cache", this);
+    label->setToolTip(tooltip);
+
+    spinBox = new QSpinBox(this);
+    spinBox->setToolTip(tooltip);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(0, 16384);
+    spinBox->setSingleStep(64);
+    spinBox->setSuffix(" MB");
+    spinBox->setValue(source->getCacheSize());
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), source, &Source::setCacheSize, Qt::QueuedConnection);
+    connect(source, &Source::cacheSizeChanged, spinBox, &QSpinBox::setValue, Qt::QueuedConnection);
+
+    layoutSequence->addRow(label, spinBox);
+
+    layout->addRow(widgetSequence);
+
+    connect(source, &Source::sequenceChanged, this, &SourceWidget::updateSequence, Qt::QueuedConnection);
+    connect(source, &Source::sequencePositionChanged, this, &SourceWidget::updateSequencePosition, Qt::QueuedConnection);
+
+    updateSequence(source->getSequenceLength());
+
+    // Separator
+    line = new QFrame(this);
+    line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
+
+    layout->addRow(line);
+
     // Image sources
     QHBoxLayout *boxImages = new QHBoxLayout();
     layout->addRow(boxImages);
@@ -130,6 +287,34 @@ SourceWidget::~SourceWidget ()
 }
 
 
+void SourceWidget::updateSequence (int length)
+{
+    widgetSequence->setEnabled(length > 0);
+
+    spinBoxPosition->blockSignals(true);
+    spinBoxPosition->setRange(0, length);
+    spinBoxPosition->setSuffix(QString(" / %1").arg(length));
+    spinBoxPosition->blockSignals(false);
+
+    sliderPosition->blockSignals(true);
+    sliderPosition->setRange(0, length);
+    sliderPosition->blockSignals(false);
+}
+
+void SourceWidget::updateSequencePosition (int position, int length)
+{
+    Q_UNUSED(length);
+
+    spinBoxPosition->blockSignals(true);
+    spinBoxPosition->setValue(position);
+    spinBoxPosition->blockSignals(false);
+
+    sliderPosition->blockSignals(true);
+    sliderPosition->setValue(position);
+    sliderPosition->blockSignals(false);
+}
+
+
 QWidget *SourceWidget::createImageFrame (bool left)
 {
     QFrame *imageFrame;
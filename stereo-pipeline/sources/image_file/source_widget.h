@@ -41,12 +41,24 @@ public:
 
 signals:
     void requestImageLoad (QString filenameLeft, QString filenameRight);
+    void requestSequenceLoad (const QString &leftPattern, const QString &rightPattern);
+    void requestSequenceListLoad (const QString &filename);
 
 protected:
     QWidget *createImageFrame (bool left);
 
+    void updateSequence (int length);
+    void updateSequencePosition (int position, int length);
+
 protected:
     Source *source;
+
+    QLineEdit *lineEditLeftPattern;
+    QLineEdit *lineEditRightPattern;
+
+    QWidget *widgetSequence;
+    QSpinBox *spinBoxPosition;
+    QSlider *sliderPosition;
 };
 
 
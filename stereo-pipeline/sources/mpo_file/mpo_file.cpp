@@ -76,7 +76,7 @@ protected:
     MpFile * const q_ptr;
 
 protected:
-    static QByteArray getMpoMarker (QFile &file, quint32 &markerOffset);
+    static QByteArray getMpoMarker (QIODevice &file, quint32 &markerOffset);
 
     static bool determineMarkerByteOrder (const QByteArray &data);
 
@@ -91,6 +91,13 @@ protected:
 protected:
     QString filename; // Filename
 
+    // File contents; memory-mapped if possible, otherwise read into
+    // the buffer
+    QFile file;
+    QByteArray fileBuffer;
+    const char *fileData;
+    qint64 fileSize;
+
     QList<MpImageInfo> imageEntries; // MPO Image entries
 
     int referenceImage; // Index of the reference image
@@ -99,6 +106,8 @@ protected:
 
 MpFilePrivate::MpFilePrivate (MpFile *parent)
     : q_ptr(parent),
+      fileData(nullptr),
+      fileSize(0),
       referenceImage(-1)
 {
 }
@@ -140,7 +149,7 @@ const MpImageInfo &MpFile::getImageInfo (int idx) const
     return d->imageEntries[idx];
 }
 
-cv::Mat MpFile::loadImage (int idx)
+cv::Mat MpFile::loadImage (int idx, int flags) const
 {
     Q_D(const MpFile);
 
@@ -152,22 +161,12 @@ cv::Mat MpFile::loadImage (int idx)
 
     const MpImageInfo &entry = d->imageEntries[idx];
 
-    // Open file
-    QFile file(d->filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return image;
-    }
-
-    // Seek to position in file and read the image
-    file.seek(entry.dataOffset);
-
-    QByteArray buffer(entry.dataSize, 0);
-    if (file.read(buffer.data(), buffer.size()) != buffer.size()) {
+    if (!d->fileData || static_cast<qint64>(entry.dataOffset) + entry.dataSize > d->fileSize) {
         return image;
     }
 
-    // Decode
-    return cv::imdecode(cv::Mat(buffer.size(), 1, CV_8U, buffer.data()), cv::IMREAD_ANYCOLOR);
+    // Decode directly from file data
+    return cv::imdecode(cv::Mat(entry.dataSize, 1, CV_8U, const_cast<char *>(d->fileData + entry.dataOffset)), flags);
 }
 
 
@@ -183,18 +182,37 @@ void MpFile::loadFile (const QString &filename)
     d->referenceImage = -1;
     d->filename = filename;
 
-    // Open file
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
+    d->file.close(); // Also unmaps the data
+    d->fileBuffer.clear();
+    d->fileData = nullptr;
+    d->fileSize = 0;
+
+    // Open file and map it into memory; if mapping is not possible,
+    // read it whole
+    d->file.setFileName(filename);
+    if (!d->file.open(QIODevice::ReadOnly)) {
         throw Exception(QStringLiteral("Failed to open file %1 for reading!").arg(filename));
     }
 
+    d->fileSize = d->file.size();
+    d->fileData = reinterpret_cast<const char *>(d->file.map(0, d->fileSize));
+    if (!d->fileData) {
+        d->fileBuffer = d->file.readAll();
+        d->fileData = d->fileBuffer.constData();
+        d->fileSize = d->fileBuffer.size();
+    }
+
+    // Parse from memory
+    QBuffer buffer;
+    buffer.setData(QByteArray::fromRawData(d->fileData, d->fileSize));
+    buffer.open(QIODevice::ReadOnly);
+
     // Get the first MPO marker
     quint32 mpoMarkerDataOffset = 0; // Input/output parameter
     QByteArray mpoMarkerData;
 
     try {
-        mpoMarkerData = d->getMpoMarker(file, mpoMarkerDataOffset);
+        mpoMarkerData = d->getMpoMarker(buffer, mpoMarkerDataOffset);
     } catch (const std::exception &e) {
         throw Exception(QStringLiteral("Invalid MPO file - parser error"), e);
     }
@@ -237,7 +255,7 @@ void MpFile::loadFile (const QString &filename)
 
         qCDebug(debugMpo) << "Retrieving attributes for image" << i << "from file offset" << mpoMarkerDataOffset;
         try {
-            mpoMarkerData = d->getMpoMarker(file, mpoMarkerDataOffset);
+            mpoMarkerData = d->getMpoMarker(buffer, mpoMarkerDataOffset);
         }  catch (const std::exception &e) {
             qCDebug(debugMpo).nospace() << "Failed to retrieve MPO marker data for image " << i << ": " << QString::fromStdString(e.what());
             continue;
@@ -277,7 +295,7 @@ enum MarkerType
 // Attempts to locate MPO marker in the file from the specified offset
 // on. Returns the buffer containing the marker data, and stores the
 // offset at which the marker data was located.
-QByteArray MpFilePrivate::getMpoMarker (QFile &file, quint32 &markerOffset)
+QByteArray MpFilePrivate::getMpoMarker (QIODevice &file, quint32 &markerOffset)
 {
     // Seek to designated marker offset
     file.seek(markerOffset);
@@ -23,6 +23,7 @@
 
 #include <QtCore>
 #include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
 
 
 namespace Mpo {
@@ -126,8 +127,10 @@ public:
     // Retrieve information about the specified image
     const MpImageInfo &getImageInfo (int idx) const;
 
-    // Load image with the given index
-    cv::Mat loadImage (int idx);
+    // Load image with the given index, decoding it with the given
+    // cv::imread() flags. Decodes directly from the memory-mapped file,
+    // and can be called concurrently from multiple threads
+    cv::Mat loadImage (int idx, int flags = cv::IMREAD_ANYCOLOR) const;
 };
 
 
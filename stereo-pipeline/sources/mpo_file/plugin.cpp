@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceMpoFile {
 
 
-class Plugin : public QObject, PluginFactory
+class SourceMpoFilePlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.MpoFile")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.MpoFile" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
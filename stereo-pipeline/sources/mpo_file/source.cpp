@@ -32,12 +32,20 @@ namespace SourceMpoFile {
 
 
 Source::Source (QObject *parent)
-    : QObject(parent), ImagePairSource()
+    : QObject(parent), ImagePairSource(),
+      previewScale(1),
+      playlistPosition(-1),
+      prefetchIndex(-1),
+      prefetchFlags(0)
 {
+    playbackTimer = new QTimer(this);
+    playbackTimer->setInterval(1000);
+    connect(playbackTimer, &QTimer::timeout, this, &Source::playbackFunction);
 }
 
 Source::~Source ()
 {
+    prefetchFuture.waitForFinished();
 }
 
 
@@ -51,15 +59,15 @@ QString Source::getShortName () const
 
 void Source::getImages (cv::Mat &left, cv::Mat &right) const
 {
-    // Copy images under lock
+    // Images are never modified, so they can be shared without copying
     QReadLocker locker(&imagesLock);
-    imageLeft.copyTo(left);
-    imageRight.copyTo(right);
+    left = imageLeft;
+    right = imageRight;
 }
 
 void Source::stopSource ()
 {
-    // No-op
+    stopPlayback();
 }
 
 QWidget *Source::createConfigWidget (QWidget *parent)
@@ -71,7 +79,7 @@ QWidget *Source::createConfigWidget (QWidget *parent)
 // *********************************************************************
 // *                             MPO file                              *
 // *********************************************************************
-static void loadDisparityMpo (const QString &filename, cv::Mat &imageLeft, cv::Mat &imageRight)
+static void loadDisparityMpo (const QString &filename, int flags, cv::Mat &imageLeft, cv::Mat &imageRight)
 {
     // Load MPO file
     Mpo::MpFile mpo(filename);
@@ -155,33 +163,219 @@ static void loadDisparityMpo (const QString &filename, cv::Mat &imageLeft, cv::M
         idxLeft = disparityImages[otherIdx].idx;
     }
 
-    imageLeft = mpo.loadImage(idxLeft);
-    imageRight = mpo.loadImage(idxRight);
-}
+    // Decode both images concurrently
+    QFuture<cv::Mat> futureRight = QtConcurrent::run([&mpo, idxRight, flags] () {
+        return mpo.loadImage(idxRight, flags);
+    });
 
+    imageLeft = mpo.loadImage(idxLeft, flags);
+    imageRight = futureRight.result();
 
-void Source::openMpoFile (const QString &filename)
+    if (imageLeft.empty() || imageRight.empty()) {
+        throw Exception(QStringLiteral("Failed to decode images!"));
+    }
+}
+
+Source::LoadedPair Source::loadPair (const QString &filename, int flags)
 {
-    // Load disparity image pair from MPO
-    cv::Mat tmpLeft, tmpRight;
+    // May run in a worker thread, so errors are returned instead of thrown
+    LoadedPair pair;
     try {
-        loadDisparityMpo(filename, tmpLeft, tmpRight);
+        loadDisparityMpo(filename, flags, pair.left, pair.right);
     } catch (const std::exception &e) {
-        emit error(QStringLiteral("Failed to load disparity MP file: %1").arg(QString::fromStdString(e.what())));
+        pair.left = cv::Mat();
+        pair.right = cv::Mat();
+        pair.errorMessage = QStringLiteral("Failed to load disparity MP file: %1").arg(QString::fromStdString(e.what()));
+    }
+    return pair;
+}
+
+int Source::getDecodeFlags () const
+{
+    switch (previewScale) {
+        case 2: {
+            return cv::IMREAD_REDUCED_GRAYSCALE_2;
+        }
+        case 4: {
+            return cv::IMREAD_REDUCED_GRAYSCALE_4;
+        }
+        case 8: {
+            return cv::IMREAD_REDUCED_GRAYSCALE_8;
+        }
+        default: {
+            return cv::IMREAD_ANYCOLOR;
+        }
+    }
+}
+
+
+void Source::openMpoFile (const QString &filename)
+{
+    setPlaylist(QStringList(filename));
+}
+
+void Source::openMpoDirectory (const QString &directory)
+{
+    QDir dir(directory);
+
+    QStringList filenames = dir.entryList(QStringList() << "*.mpo" << "*.MPO", QDir::Files, QDir::Name);
+    if (filenames.isEmpty()) {
+        emit error(QStringLiteral("No MPO files found in directory '%1'!").arg(directory));
         return;
     }
 
-    // Set images
-    QWriteLocker locker(&imagesLock);
+    for (QString &filename : filenames) {
+        filename = dir.filePath(filename);
+    }
 
-    tmpLeft.copyTo(imageLeft);
-    tmpRight.copyTo(imageRight);
+    setPlaylist(filenames);
+}
+
+void Source::setPlaylist (const QStringList &filenames)
+{
+    stopPlayback();
+
+    // Discard prefetched pair
+    prefetchFuture.waitForFinished();
+    prefetchIndex = -1;
+
+    playlist = filenames;
+    playlistPosition = -1;
+
+    emit playlistChanged(playlist.size());
+
+    setPlaylistPosition(0);
+}
+
+int Source::getPlaylistLength () const
+{
+    return playlist.size();
+}
+
+void Source::setPlaylistPosition (int index)
+{
+    if (index < 0 || index >= playlist.size()) {
+        return;
+    }
 
+    // Use prefetched pair, if available, or load the pair now
+    LoadedPair pair;
+    if (prefetchIndex == index && prefetchFlags == getDecodeFlags()) {
+        pair = prefetchFuture.result();
+    } else {
+        prefetchFuture.waitForFinished();
+        pair = loadPair(playlist[index], getDecodeFlags());
+    }
+    prefetchIndex = -1;
+
+    playlistPosition = index;
+
+    // Start loading the next pair while this one is being processed
+    if (playlist.size() > 1) {
+        schedulePrefetch((index + 1) % playlist.size());
+    }
+
+    emit playlistPositionChanged(playlistPosition + 1, playlist.size());
+
+    if (!pair.errorMessage.isEmpty()) {
+        emit error(pair.errorMessage);
+        return;
+    }
+
+    // Set images
+    QWriteLocker locker(&imagesLock);
+    imageLeft = pair.left;
+    imageRight = pair.right;
     locker.unlock();
 
     emit imagesChanged();
 }
 
+void Source::schedulePrefetch (int index)
+{
+    if (index < 0 || index >= playlist.size()) {
+        return;
+    }
+
+    prefetchIndex = index;
+    prefetchFlags = getDecodeFlags();
+    prefetchFuture = QtConcurrent::run(&Source::loadPair, playlist[index], prefetchFlags);
+}
+
+
+// *********************************************************************
+// *                             Playback                              *
+// *********************************************************************
+void Source::startPlayback ()
+{
+    if (playlist.size() < 2) {
+        stopPlayback();
+        return;
+    }
+
+    playbackTimer->start();
+
+    emit playbackStateChanged(true);
+}
+
+void Source::stopPlayback ()
+{
+    playbackTimer->stop();
+
+    emit playbackStateChanged(false);
+}
+
+void Source::setPlaybackPeriod (int period)
+{
+    if (period <= 0 || playbackTimer->interval() == period) {
+        return;
+    }
+
+    playbackTimer->setInterval(period); // Restarts active timer
+
+    emit playbackPeriodChanged(period);
+}
+
+int Source::getPlaybackPeriod () const
+{
+    return playbackTimer->interval();
+}
+
+void Source::playbackFunction ()
+{
+    // Wrap around at the end of the playlist
+    setPlaylistPosition((playlistPosition + 1) % playlist.size());
+}
+
+
+// *********************************************************************
+// *                          Preview scale                            *
+// *********************************************************************
+void Source::setPreviewScale (int scale)
+{
+    if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+        return;
+    }
+
+    if (previewScale == scale) {
+        return;
+    }
+
+    previewScale = scale;
+
+    emit previewScaleChanged(previewScale);
+
+    // Reload current pair with new scale
+    if (playlistPosition >= 0) {
+        setPlaylistPosition(playlistPosition);
+    }
+}
+
+int Source::getPreviewScale () const
+{
+    return previewScale;
+}
+
 
 } // SourceMpoFile
 } // Pipeline
@@ -20,6 +20,8 @@
 #ifndef MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__MPO_FILE__SOURCE_H
 #define MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__MPO_FILE__SOURCE_H
 
+#include <QtConcurrent>
+
 #include <stereo-pipeline/image_pair_source.h>
 
 
@@ -45,17 +47,69 @@ public:
 
     void openMpoFile (const QString &filename);
 
+    // Plays all MPO files in the directory, in order of their names
+    void openMpoDirectory (const QString &directory);
+
+    int getPlaylistLength () const;
+    void setPlaylistPosition (int index);
+
+    void startPlayback ();
+    void stopPlayback ();
+
+    void setPlaybackPeriod (int period);
+    int getPlaybackPeriod () const;
+
+    // Preview scale of 2, 4 or 8 decodes reduced-resolution grayscale
+    // images, which is considerably faster for large images; 1 decodes
+    // full-resolution images
+    void setPreviewScale (int scale);
+    int getPreviewScale () const;
+
+protected:
+    struct LoadedPair {
+        cv::Mat left;
+        cv::Mat right;
+        QString errorMessage;
+    };
+
+    static LoadedPair loadPair (const QString &filename, int flags);
+    int getDecodeFlags () const;
+
+    void setPlaylist (const QStringList &filenames);
+    void schedulePrefetch (int index);
+
+    void playbackFunction ();
+
 signals:
     // Signals from interface
     void imagesChanged () override;
     void error (QString message) override;
 
+    void playlistChanged (int length);
+    void playlistPositionChanged (int position, int length);
+    void playbackStateChanged (bool playing);
+    void playbackPeriodChanged (int period);
+    void previewScaleChanged (int scale);
+
 protected:
-    // Images
+    // Images; these are never modified, only replaced
     mutable QReadWriteLock imagesLock;
 
     cv::Mat imageLeft;
     cv::Mat imageRight;
+
+    int previewScale;
+
+    // Playlist
+    QStringList playlist;
+    int playlistPosition;
+
+    // Next file is loaded while the current one is being processed
+    QFuture<LoadedPair> prefetchFuture;
+    int prefetchIndex;
+    int prefetchFlags;
+
+    QTimer *playbackTimer;
 };
 
 
@@ -100,6 +100,111 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
 
     layout->addLayout(hbox);
 
+    // MPO directory
+    tooltip = "Play all MPO files from a directory.";
+
+    button = new QPushButton("Open directory", this);
+    button->setToolTip(tooltip);
+    connect(button, &QPushButton::clicked, this, [this] () {
+        QString directory = QFileDialog::getExistingDirectory(this, "Select directory with MPO files");
+        if (!directory.isEmpty()) {
+            emit mpoDirectoryLoadRequested(directory);
+        }
+    });
+    connect(this, &SourceWidget::mpoDirectoryLoadRequested, source, &Source::openMpoDirectory, Qt::QueuedConnection);
+
+    layout->addWidget(button);
+
+    // Preview scale
+    hbox = new QHBoxLayout();
+    hbox->setContentsMargins(0, 0, 0, 0);
+
+    tooltip = "Decode reduced-resolution grayscale images for faster preview of large images.";
+
+    label = new QLabel("Decoding: ", this);
+    label->setToolTip(tooltip);
+
+    hbox->addWidget(label);
+
+    QComboBox *comboBox = new QComboBox(this);
+    comboBox->setToolTip(tooltip);
+    comboBox->addItem("Full resolution", 1);
+    comboBox->addItem("Preview (1/2, grayscale)", 2);
+    comboBox->addItem("Preview (1/4, grayscale)", 4);
+    comboBox->addItem("Preview (1/8, grayscale)", 8);
+    comboBox->setCurrentIndex(comboBox->findData(source->getPreviewScale()));
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), this, [this, comboBox] (int index) {
+        emit previewScaleChangeRequested(comboBox->itemData(index).toInt());
+    });
+    connect(this, &SourceWidget::previewScaleChangeRequested, source, &Source::setPreviewScale, Qt::QueuedConnection);
+    connect(source, &Source::previewScaleChanged, comboBox, [comboBox] (int scale) {
+        comboBox->setCurrentIndex(comboBox->findData(scale));
+    }, Qt::QueuedConnection);
+
+    hbox->addWidget(comboBox, 1);
+
+    layout->addLayout(hbox);
+
+    // Playlist
+    widgetPlaylist = new QWidget(this);
+    QVBoxLayout *layoutPlaylist = new QVBoxLayout(widgetPlaylist);
+    layoutPlaylist->setContentsMargins(0, 0, 0, 0);
+
+    tooltip = "Start/pause playback of MPO files in the directory.";
+
+    button = new QPushButton("Play", this);
+    button->setToolTip(tooltip);
+    button->setCheckable(true);
+    connect(button, &QPushButton::toggled, source, [this] (bool active) {
+        if (active) {
+            this->source->startPlayback();
+        } else {
+            this->source->stopPlayback();
+        }
+    }, Qt::QueuedConnection);
+    connect(source, &Source::playbackStateChanged, button, &QPushButton::setChecked, Qt::QueuedConnection);
+
+    layoutPlaylist->addWidget(button);
+
+    hbox = new QHBoxLayout();
+    hbox->setContentsMargins(0, 0, 0, 0);
+
+    label = new QLabel("File: ", this);
+    hbox->addWidget(label);
+
+    spinBoxPosition = new QSpinBox(this);
+    spinBoxPosition->setKeyboardTracking(false);
+    connect(spinBoxPosition, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), source, [this] (int value) {
+        this->source->setPlaylistPosition(value - 1);
+    }, Qt::QueuedConnection);
+    hbox->addWidget(spinBoxPosition, 1);
+
+    tooltip = "Time between consecutive files during playback.";
+
+    label = new QLabel("Period: ", this);
+    label->setToolTip(tooltip);
+    hbox->addWidget(label);
+
+    QSpinBox *spinBox = new QSpinBox(this);
+    spinBox->setToolTip(tooltip);
+    spinBox->setKeyboardTracking(false);
+    spinBox->setRange(1, 60000);
+    spinBox->setSingleStep(100);
+    spinBox->setSuffix(" ms");
+    spinBox->setValue(source->getPlaybackPeriod());
+    connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), source, &Source::setPlaybackPeriod, Qt::QueuedConnection);
+    connect(source, &Source::playbackPeriodChanged, spinBox, &QSpinBox::setValue, Qt::QueuedConnection);
+    hbox->addWidget(spinBox, 1);
+
+    layoutPlaylist->addLayout(hbox);
+
+    layout->addWidget(widgetPlaylist);
+
+    connect(source, &Source::playlistChanged, this, &SourceWidget::updatePlaylist, Qt::QueuedConnection);
+    connect(source, &Source::playlistPositionChanged, this, &SourceWidget::updatePlaylistPosition, Qt::QueuedConnection);
+
+    updatePlaylist(source->getPlaylistLength());
+
     layout->addStretch(1);
 }
 
@@ -108,6 +213,26 @@ SourceWidget::~SourceWidget ()
 }
 
 
+void SourceWidget::updatePlaylist (int length)
+{
+    widgetPlaylist->setVisible(length > 1);
+
+    spinBoxPosition->blockSignals(true);
+    spinBoxPosition->setRange(1, qMax(length, 1));
+    spinBoxPosition->setSuffix(QString(" / %1").arg(length));
+    spinBoxPosition->blockSignals(false);
+}
+
+void SourceWidget::updatePlaylistPosition (int position, int length)
+{
+    Q_UNUSED(length);
+
+    spinBoxPosition->blockSignals(true);
+    spinBoxPosition->setValue(position);
+    spinBoxPosition->blockSignals(false);
+}
+
+
 } // SourceMpoFile
 } // Pipeline
 } // StereoToolbox
@@ -39,14 +39,23 @@ public:
     SourceWidget (Source *source, QWidget *parent = nullptr);
     virtual ~SourceWidget ();
 
+protected:
+    void updatePlaylist (int length);
+    void updatePlaylistPosition (int position, int length);
+
 signals:
     void mpoFileLoadRequested (const QString &filename);
+    void mpoDirectoryLoadRequested (const QString &directory);
+    void previewScaleChangeRequested (int scale);
 
 protected:
     Source *source;
 
     QLineEdit *lineEditMpoFile;
 
+    QWidget *widgetPlaylist;
+    QSpinBox *spinBoxPosition;
+
     QString mpoFilename;
 };
 
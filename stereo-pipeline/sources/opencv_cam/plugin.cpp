@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceOpenCvCam {
 
 
-class Plugin : public QObject, PluginFactory
+class SourceOpenCvCamPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.OpenCvCam")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.OpenCvCam" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceUnicap {
 
 
-class Plugin : public QObject, PluginFactory
+class SourceUnicapPlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.Unicap")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.Unicap" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
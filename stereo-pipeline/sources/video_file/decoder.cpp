@@ -0,0 +1,445 @@
+/*
+ * Video File Source: decoder
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "decoder.h"
+
+#include <stereo-pipeline/exception.h>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceVideoFile {
+
+
+// Non-sequential access to a frame decodes at most this many preceding
+// frames (which are cached); without the frame index, this is also the
+// distance to the frame that decoding is started from
+static const int MaxSeekSegment = 64;
+static const int DefaultSeekSegment = 16;
+
+
+Decoder::Decoder (QObject *parent)
+    : QObject(parent),
+      width(0),
+      height(0),
+      framerate(0),
+      length(0),
+      bufferSize(8),
+      nextFrame(0),
+      endOfStream(true),
+      cache(256*1024),
+      decodeActive(0),
+      videoPosition(-1)
+{
+    connect(&indexWatcher, &QFutureWatcher<FrameIndex>::finished, this, &Decoder::handleIndexingFinished);
+}
+
+Decoder::~Decoder ()
+{
+    close();
+}
+
+
+// *********************************************************************
+// *                               Video                               *
+// *********************************************************************
+void Decoder::open (const QString &newFilename)
+{
+    close();
+
+    try {
+        video.open(newFilename.toStdString());
+    } catch (const std::exception &e) {
+        throw Exception(QStringLiteral("Error while opening video '%1': %2").arg(newFilename).arg(QString::fromStdString(e.what())));
+    }
+
+    if (!video.isOpened()) {
+        throw Exception(QStringLiteral("Failed to open video '%1'").arg(newFilename));
+    }
+
+    filename = newFilename;
+
+    width = video.get(cv::CAP_PROP_FRAME_WIDTH);
+    height = video.get(cv::CAP_PROP_FRAME_HEIGHT);
+    framerate = video.get(cv::CAP_PROP_FPS);
+    length = video.get(cv::CAP_PROP_FRAME_COUNT);
+
+    nextFrame = 0;
+    videoPosition = 0;
+    endOfStream = false;
+
+    startDecoding();
+    startIndexing();
+}
+
+void Decoder::close ()
+{
+    stopIndexing();
+    stopDecoding();
+
+    video.release();
+    filename.clear();
+
+    QMutexLocker locker(&mutex);
+
+    frames.clear();
+    cache.clear();
+    frameIndex = FrameIndex();
+
+    width = height = length = 0;
+    framerate = 0;
+    nextFrame = 0;
+    videoPosition = -1;
+    endOfStream = true;
+}
+
+bool Decoder::isOpened () const
+{
+    return video.isOpened();
+}
+
+
+int Decoder::getWidth () const
+{
+    return width;
+}
+
+int Decoder::getHeight () const
+{
+    return height;
+}
+
+double Decoder::getFramerate () const
+{
+    return framerate;
+}
+
+int Decoder::getLength () const
+{
+    return length;
+}
+
+
+void Decoder::setBufferSize (int newSize)
+{
+    QMutexLocker locker(&mutex);
+    bufferSize = qMax(newSize, 1);
+    bufferNotFull.wakeAll();
+}
+
+int Decoder::getBufferSize () const
+{
+    QMutexLocker locker(&mutex);
+    return bufferSize;
+}
+
+
+void Decoder::setCacheSize (int megabytes)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(qMax(megabytes, 0)*1024);
+}
+
+int Decoder::getCacheSize () const
+{
+    QMutexLocker locker(&mutex);
+    return cache.maxCost()/1024;
+}
+
+
+int Decoder::getNumKeyframes () const
+{
+    QMutexLocker locker(&mutex);
+    return frameIndex.isValid() ? frameIndex.getNumKeyframes() : -1;
+}
+
+
+void Decoder::seek (int frame)
+{
+    if (!video.isOpened()) {
+        return;
+    }
+
+    stopDecoding();
+
+    // Buffer and cache are shared with the consumer
+    QMutexLocker locker(&mutex);
+
+    frames.clear();
+    nextFrame = qMax(frame, 0);
+    endOfStream = false;
+
+    // Cached frame is available immediately; the video itself is
+    // re-positioned by the decoding thread, if necessary
+    Frame cachedFrame;
+    if (lookupFrame(nextFrame, cachedFrame)) {
+        frames.enqueue(cachedFrame);
+        nextFrame++;
+    }
+
+    locker.unlock();
+
+    startDecoding();
+}
+
+
+// *********************************************************************
+// *                           Frame buffer                            *
+// *********************************************************************
+bool Decoder::takeFrame (Frame &frame)
+{
+    QMutexLocker locker(&mutex);
+
+    if (frames.isEmpty()) {
+        return false;
+    }
+
+    frame = frames.dequeue();
+    bufferNotFull.wakeAll();
+
+    return true;
+}
+
+bool Decoder::peekFrame (Frame &frame) const
+{
+    QMutexLocker locker(&mutex);
+
+    if (frames.isEmpty()) {
+        return false;
+    }
+
+    frame = frames.head();
+
+    return true;
+}
+
+bool Decoder::atEnd () const
+{
+    QMutexLocker locker(&mutex);
+    return endOfStream && frames.isEmpty();
+}
+
+
+bool Decoder::lookupFrame (int index, Frame &frame)
+{
+    Frame *cachedFrame = cache.object(index);
+    if (!cachedFrame) {
+        return false;
+    }
+
+    frame = *cachedFrame;
+    return true;
+}
+
+void Decoder::cacheFrame (const Frame &frame)
+{
+    int cost = qMax<int>(frame.image.total()*frame.image.elemSize()/1024, 1);
+    cache.insert(frame.index, new Frame(frame), cost);
+}
+
+int Decoder::getSeekStartFrame (int frame) const
+{
+    if (frameIndex.isValid()) {
+        return qMax(frameIndex.getKeyframe(frame), frame - MaxSeekSegment);
+    } else {
+        return qMax(0, frame - DefaultSeekSegment);
+    }
+}
+
+
+// *********************************************************************
+// *                          Decoding thread                          *
+// *********************************************************************
+void Decoder::startDecoding ()
+{
+    decodeActive.storeRelease(1);
+
+    QFuture<void> future = QtConcurrent::run(this, &Decoder::decodeFunction);
+    decodeWatcher.setFuture(future);
+}
+
+void Decoder::stopDecoding ()
+{
+    if (decodeWatcher.isRunning()) {
+        // Flag is cleared under mutex, so that the wake-up cannot be
+        // missed by the decoding thread
+        mutex.lock();
+        decodeActive.storeRelease(0);
+        bufferNotFull.wakeAll();
+        mutex.unlock();
+
+        // Make sure decoding thread finishes
+        decodeWatcher.waitForFinished();
+    }
+}
+
+void Decoder::decodeFunction ()
+{
+    QMutexLocker locker(&mutex);
+
+    while (decodeActive.loadAcquire()) {
+        // Wait for free space in the buffer
+        if (frames.size() >= bufferSize) {
+            bufferNotFull.wait(&mutex);
+            continue;
+        }
+
+        Frame frame;
+        int targetFrame = nextFrame;
+
+        // Cached frames need not be decoded
+        if (lookupFrame(targetFrame, frame)) {
+            frames.enqueue(frame);
+            nextFrame++;
+
+            locker.unlock();
+            emit frameAvailable();
+            locker.relock();
+            continue;
+        }
+
+        // Non-sequential access; continue decoding from the current
+        // position if it lies in the segment that would be decoded anyway,
+        // otherwise seek
+        int position = videoPosition;
+        int startFrame = -1;
+
+        if (position != targetFrame) {
+            startFrame = getSeekStartFrame(targetFrame);
+            if (position >= startFrame && position < targetFrame) {
+                startFrame = -1;
+            }
+        }
+
+        locker.unlock();
+
+        if (startFrame >= 0) {
+            video.set(cv::CAP_PROP_POS_FRAMES, startFrame);
+            position = startFrame;
+        }
+
+        // Decode (and cache) frames up to and including the target one.
+        // Every frame is decoded into a new image; previously-decoded
+        // ones may still be in use by the consumer
+        bool decoded = true;
+        while (position <= targetFrame && decodeActive.loadAcquire()) {
+            Frame decodedFrame;
+            decoded = video.read(decodedFrame.image);
+            if (!decoded) {
+                break;
+            }
+
+            decodedFrame.index = position++;
+            decodedFrame.timestamp = video.get(cv::CAP_PROP_POS_MSEC);
+
+            locker.relock();
+            cacheFrame(decodedFrame);
+            locker.unlock();
+
+            if (decodedFrame.index == targetFrame) {
+                frame = decodedFrame;
+            }
+        }
+
+        locker.relock();
+
+        videoPosition = decoded ? position : -1;
+
+        if (!decoded) {
+            endOfStream = true;
+            decodeActive.storeRelease(0);
+        } else if (!frame.image.empty()) {
+            frames.enqueue(frame);
+            nextFrame++;
+        } else {
+            continue; // Aborted
+        }
+
+        locker.unlock();
+        emit frameAvailable();
+        locker.relock();
+    }
+}
+
+
+// *********************************************************************
+// *                          Indexing thread                          *
+// *********************************************************************
+void Decoder::startIndexing ()
+{
+    // Re-use the stored index, if it is up-to-date
+    FrameIndex storedIndex;
+    if (storedIndex.load(filename)) {
+        QMutexLocker locker(&mutex);
+        frameIndex = storedIndex;
+        length = frameIndex.getLength();
+        locker.unlock();
+
+        emit frameIndexChanged();
+        return;
+    }
+
+    indexAbort.store(0);
+
+    QString indexedFilename = filename;
+    QFuture<FrameIndex> future = QtConcurrent::run([this, indexedFilename] () {
+        FrameIndex index;
+        index.build(indexedFilename, indexAbort);
+        return index;
+    });
+    indexWatcher.setFuture(future);
+}
+
+void Decoder::stopIndexing ()
+{
+    if (indexWatcher.isRunning()) {
+        indexAbort.store(1);
+        indexWatcher.waitForFinished();
+    }
+}
+
+void Decoder::handleIndexingFinished ()
+{
+    if (indexAbort.load()) {
+        return;
+    }
+
+    FrameIndex index = indexWatcher.result();
+    if (!index.isValid()) {
+        return;
+    }
+
+    if (!index.save(filename)) {
+        qInfo() << qPrintable(QStringLiteral("Could not store frame index for video '%1'").arg(filename));
+    }
+
+    QMutexLocker locker(&mutex);
+    frameIndex = index;
+    length = frameIndex.getLength(); // Exact, unlike the reported frame count
+    locker.unlock();
+
+    emit frameIndexChanged();
+}
+
+
+} // SourceVideoFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,165 @@
+/*
+ * Video File Source: decoder
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__DECODER_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__DECODER_H
+
+#include "frame_index.h"
+
+#include <QtConcurrent>
+
+#include <opencv2/videoio.hpp>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceVideoFile {
+
+
+// Decoded video frame
+struct Frame
+{
+    cv::Mat image;
+    int index; // Zero-based frame number
+    double timestamp; // Presentation timestamp, in milliseconds
+};
+
+
+// Decodes video frames in a background thread, ahead of playback, into
+// a bounded buffer. Every frame is decoded into a newly-allocated image,
+// so frames that have been taken from the buffer are never modified by
+// the decoder and can be shared without copying.
+//
+// Recently-decoded frames are kept in a cache with limited memory
+// budget. On non-sequential access, the decoder seeks to the preceding
+// keyframe (as given by the frame index, which is built in background
+// when the video is opened) and caches all frames it decodes up to the
+// requested one, so that subsequent stepping in either direction does
+// not require seeking again
+class Decoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    Decoder (QObject *parent = nullptr);
+    virtual ~Decoder ();
+
+    // Opens the video and starts decoding from its first frame; throws
+    // an Exception on failure
+    void open (const QString &filename);
+    void close ();
+    bool isOpened () const;
+
+    // Video properties are read when the video is opened, so that they
+    // can be accessed without interfering with the decoding thread
+    int getWidth () const;
+    int getHeight () const;
+    double getFramerate () const;
+    int getLength () const;
+
+    void setBufferSize (int frames);
+    int getBufferSize () const;
+
+    // Decoded-frame cache budget, in megabytes
+    void setCacheSize (int megabytes);
+    int getCacheSize () const;
+
+    // Number of keyframes in the frame index; -1 if index is not
+    // available (yet)
+    int getNumKeyframes () const;
+
+    // Restarts decoding at the given frame; buffered frames are discarded
+    void seek (int frame);
+
+    // Takes the next decoded frame from the buffer; returns false if
+    // no frame is available (yet)
+    bool takeFrame (Frame &frame);
+
+    // Returns the next decoded frame without taking it from the buffer
+    bool peekFrame (Frame &frame) const;
+
+    // End of stream was reached and all decoded frames have been taken
+    bool atEnd () const;
+
+protected:
+    void startDecoding ();
+    void stopDecoding ();
+
+    void decodeFunction ();
+
+    // Must be called with mutex locked
+    bool lookupFrame (int index, Frame &frame);
+    void cacheFrame (const Frame &frame);
+    int getSeekStartFrame (int frame) const;
+
+    void startIndexing ();
+    void stopIndexing ();
+    void handleIndexingFinished ();
+
+signals:
+    // Emitted from the decoding thread whenever a frame is added to the
+    // buffer or the end of stream is reached
+    void frameAvailable ();
+
+    void frameIndexChanged ();
+
+protected:
+    cv::VideoCapture video;
+    QString filename;
+
+    int width;
+    int height;
+    double framerate;
+    int length;
+
+    // Frame buffer
+    mutable QMutex mutex;
+    QWaitCondition bufferNotFull;
+
+    QQueue<Frame> frames;
+    int bufferSize;
+    int nextFrame;
+    bool endOfStream;
+
+    // Decoded-frame cache (under mutex); cost is in kilobytes
+    QCache<int, Frame> cache;
+
+    // Frame index (under mutex)
+    FrameIndex frameIndex;
+
+    // Decoding thread; the flag is polled by the decoding thread while
+    // decoding without holding the mutex
+    QAtomicInt decodeActive;
+    int videoPosition; // Frame that will be decoded next; -1 if unknown
+    QFutureWatcher<void> decodeWatcher;
+
+    // Indexing thread
+    QAtomicInt indexAbort;
+    QFutureWatcher<FrameIndex> indexWatcher;
+};
+
+
+} // SourceVideoFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Video File Source: frame index
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "frame_index.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceVideoFile {
+
+
+FrameIndex::FrameIndex ()
+    : valid(false),
+      fileSize(0),
+      fileModified(0)
+{
+}
+
+
+bool FrameIndex::isValid () const
+{
+    return valid;
+}
+
+int FrameIndex::getLength () const
+{
+    return timestamps.size();
+}
+
+int FrameIndex::getNumKeyframes () const
+{
+    return keyframes.size();
+}
+
+int FrameIndex::getKeyframe (int frame) const
+{
+    // Keyframes are sorted; find the first one after the given frame
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), frame);
+    if (it == keyframes.begin()) {
+        return 0;
+    }
+    return *(--it);
+}
+
+double FrameIndex::getTimestamp (int frame) const
+{
+    if (frame < 0 || frame >= static_cast<int>(timestamps.size())) {
+        return -1;
+    }
+    return timestamps[frame];
+}
+
+
+// *********************************************************************
+// *                             Building                              *
+// *********************************************************************
+bool FrameIndex::build (const QString &filename, const QAtomicInt &abort)
+{
+    valid = false;
+    keyframes.clear();
+    timestamps.clear();
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+    QFileInfo fileInfo(filename);
+    fileSize = fileInfo.size();
+    fileModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    cv::VideoCapture video;
+    try {
+        video.open(filename.toStdString(), cv::CAP_FFMPEG);
+
+        // Switch to raw stream; grab() then only reads the packets
+        if (!video.isOpened() || !video.set(cv::CAP_PROP_FORMAT, -1)) {
+            return false;
+        }
+
+        while (!abort.load() && video.grab()) {
+            if (video.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0) {
+                keyframes.push_back(timestamps.size());
+            }
+            timestamps.push_back(video.get(cv::CAP_PROP_POS_MSEC));
+        }
+    } catch (const std::exception &e) {
+        qWarning() << qPrintable(QStringLiteral("Failed to index video '%1': %2").arg(filename).arg(QString::fromStdString(e.what())));
+        return false;
+    }
+
+    if (abort.load() || timestamps.empty()) {
+        keyframes.clear();
+        timestamps.clear();
+        return false;
+    }
+
+    valid = true;
+    return true;
+#else
+    Q_UNUSED(filename);
+    Q_UNUSED(abort);
+    return false;
+#endif
+}
+
+
+// *********************************************************************
+// *                              Storage                              *
+// *********************************************************************
+QString FrameIndex::getIndexFilename (const QString &filename)
+{
+    return filename + QStringLiteral(".index.yml");
+}
+
+bool FrameIndex::load (const QString &filename)
+{
+    valid = false;
+    keyframes.clear();
+    timestamps.clear();
+
+    QString indexFilename = getIndexFilename(filename);
+    if (!QFileInfo::exists(indexFilename)) {
+        return false;
+    }
+
+    QFileInfo fileInfo(filename);
+
+    try {
+        cv::FileStorage storage(indexFilename.toStdString(), cv::FileStorage::READ);
+        if (!storage.isOpened()) {
+            return false;
+        }
+
+        cv::String storedType;
+        storage["DataType"] >> storedType;
+        if (storedType != "VideoFrameIndex") {
+            return false;
+        }
+
+        // Index is valid only for unchanged video file
+        storage["FileSize"] >> fileSize;
+        storage["FileModified"] >> fileModified;
+        if (fileSize != fileInfo.size() || fileModified != fileInfo.lastModified().toMSecsSinceEpoch()) {
+            return false;
+        }
+
+        storage["Keyframes"] >> keyframes;
+        storage["Timestamps"] >> timestamps;
+    } catch (const std::exception &) {
+        keyframes.clear();
+        timestamps.clear();
+        return false;
+    }
+
+    valid = !timestamps.empty();
+    return valid;
+}
+
+bool FrameIndex::save (const QString &filename) const
+{
+    if (!valid) {
+        return false;
+    }
+
+    try {
+        cv::FileStorage storage(getIndexFilename(filename).toStdString(), cv::FileStorage::WRITE);
+        if (!storage.isOpened()) {
+            return false;
+        }
+
+        storage << "DataType" << "VideoFrameIndex";
+        storage << "FileSize" << fileSize;
+        storage << "FileModified" << fileModified;
+        storage << "Keyframes" << keyframes;
+        storage << "Timestamps" << timestamps;
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+
+} // SourceVideoFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
@@ -0,0 +1,82 @@
+/*
+ * Video File Source: frame index
+ * Copyright (C) 2017 Rok Mandeljc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__FRAME_INDEX_H
+#define MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__FRAME_INDEX_H
+
+#include <QtCore>
+
+#include <vector>
+
+
+namespace MVL {
+namespace StereoToolbox {
+namespace Pipeline {
+namespace SourceVideoFile {
+
+
+// Keyframe positions and presentation timestamps of all frames in a
+// video. The index is built by reading the encoded stream without
+// decoding it (requires OpenCV 4.6 or newer with the FFmpeg backend),
+// and is stored next to the video file, from where it is re-used for
+// as long as the video file remains unchanged
+class FrameIndex
+{
+public:
+    FrameIndex ();
+
+    bool isValid () const;
+
+    int getLength () const;
+    int getNumKeyframes () const;
+
+    // Last keyframe at or before the given frame
+    int getKeyframe (int frame) const;
+
+    // Presentation timestamp, in milliseconds
+    double getTimestamp (int frame) const;
+
+    // Builds the index for the given video; returns false if the index
+    // cannot be built or if building was aborted
+    bool build (const QString &filename, const QAtomicInt &abort);
+
+    bool load (const QString &filename);
+    bool save (const QString &filename) const;
+
+    static QString getIndexFilename (const QString &filename);
+
+protected:
+    bool valid;
+
+    // Video file the index belongs to
+    double fileSize;
+    double fileModified;
+
+    std::vector<int> keyframes;
+    std::vector<double> timestamps;
+};
+
+
+} // SourceVideoFile
+} // Pipeline
+} // StereoToolbox
+} // MVL
+
+
+#endif
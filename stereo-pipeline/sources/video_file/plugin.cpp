@@ -27,10 +27,10 @@ namespace Pipeline {
 namespace SourceVideoFile {
 
 
-class Plugin : public QObject, PluginFactory
+class SourceVideoFilePlugin : public QObject, PluginFactory
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.VideoFile")
+    Q_PLUGIN_METADATA(IID "mvl-stereo-toolbox.Plugin.Source.VideoFile" FILE "plugin.json")
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::PluginFactory)
 
     PluginType getPluginType () const override {
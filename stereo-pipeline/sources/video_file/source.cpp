@@ -19,6 +19,9 @@
 
 #include "source.h"
 #include "source_widget.h"
+#include "decoder.h"
+
+#include <stereo-pipeline/exception.h>
 
 
 namespace MVL {
@@ -28,10 +31,30 @@ namespace SourceVideoFile {
 
 
 Source::Source (QObject *parent)
-    : QObject(parent), ImagePairSource()
+    : QObject(parent), ImagePairSource(),
+      frameLayout(LayoutSideBySide),
+      playing(false),
+      maxSpeed(false),
+      framePending(false),
+      imagesConsumed(true)
 {
+    decoder = new Decoder(this);
+    decoderRight = new Decoder(this);
+
+    for (Decoder *videoDecoder : { decoder, decoderRight }) {
+        connect(videoDecoder, &Decoder::frameAvailable, this, &Source::handleFrameAvailable, Qt::QueuedConnection);
+        connect(videoDecoder, &Decoder::frameIndexChanged, this, [this] () {
+            // Index provides exact video length
+            emit videoFileChanged(true);
+        });
+    }
+
     playbackTimer = new QTimer(this);
+    playbackTimer->setTimerType(Qt::PreciseTimer);
     connect(playbackTimer, &QTimer::timeout, this, &Source::playbackFunction);
+
+    // getImages() may be called from any thread
+    connect(this, &Source::imagesRetrieved, this, &Source::handleImagesRetrieved, Qt::QueuedConnection);
 }
 
 Source::~Source ()
@@ -49,10 +72,14 @@ QString Source::getShortName () const
 
 void Source::getImages (cv::Mat &left, cv::Mat &right) const
 {
-    // Copy images under lock
+    // Decoded frames are never modified, so the views can be shared
+    // without copying
     QReadLocker locker(&imagesLock);
-    imageLeft.copyTo(left);
-    imageRight.copyTo(right);
+    left = imageLeft;
+    right = imageRight;
+    locker.unlock();
+
+    emit const_cast<Source *>(this)->imagesRetrieved();
 }
 
 void Source::stopSource ()
@@ -69,66 +96,80 @@ QWidget *Source::createConfigWidget (QWidget *parent)
 // *********************************************************************
 // *                            Video file                             *
 // *********************************************************************
-void Source::openVideoFile (const QString &filename)
+void Source::openVideoFile (const QString &filename, const QString &filenameRight)
 {
     // Make sure playback is stopped
     stopPlayback();
 
-    // Close previously-opened video
-    video.release();
+    // Close previously-opened video(s)
+    decoder->close();
+    decoderRight->close();
 
     // Clear the frames
     QWriteLocker locker(&imagesLock);
     imageLeft = cv::Mat();
     imageRight = cv::Mat();
+    currentFrame = cv::Mat();
     locker.unlock();
 
     emit imagesChanged();
 
     // If filename is empty, do nothing
-    if (filename.isEmpty()) {
+    if (filename.isEmpty() || (frameLayout == LayoutSeparateFiles && filenameRight.isEmpty())) {
         emit videoFileChanged(false);
         return;
     }
 
-    // Open video file
+    // Open video file(s); this also starts decoding their first frames
     try {
-        video.open(filename.toStdString());
+        decoder->open(filename);
+
+        if (frameLayout == LayoutSeparateFiles) {
+            decoderRight->open(filenameRight);
+
+            if (decoderRight->getWidth() != decoder->getWidth() || decoderRight->getHeight() != decoder->getHeight()) {
+                throw Exception(QStringLiteral("Left and right video have different frame sizes (%1x%2 vs. %3x%4)!").arg(decoder->getWidth()).arg(decoder->getHeight()).arg(decoderRight->getWidth()).arg(decoderRight->getHeight()));
+            }
+        }
     } catch (const std::exception &e) {
-        emit error(QStringLiteral("Error while opening video '%1': %2").arg(filename).arg(QString::fromStdString(e.what())));
-        emit videoFileChanged(false);
-        return;
-    }
+        decoder->close();
+        decoderRight->close();
 
-    // Make sure video was indeed opened
-    if (!video.isOpened()) {
-        emit error(QStringLiteral("Failed to open video '%1'").arg(filename));
+        emit error(QString::fromStdString(e.what()));
         emit videoFileChanged(false);
         return;
     }
 
     emit videoFileChanged(true);
-    emit videoPositionChanged(video.get(cv::CAP_PROP_POS_FRAMES), video.get(cv::CAP_PROP_FRAME_COUNT));
+    emit videoPositionChanged(0, getVideoLength());
 }
 
 int Source::getVideoWidth ()
 {
-    return video.get(cv::CAP_PROP_FRAME_WIDTH);
+    return decoder->getWidth();
 }
 
 int Source::getVideoHeight ()
 {
-    return video.get(cv::CAP_PROP_FRAME_HEIGHT);
+    return decoder->getHeight();
 }
 
 float Source::getVideoFramerate ()
 {
-    return video.get(cv::CAP_PROP_FPS);
+    return decoder->getFramerate();
 }
 
 int Source::getVideoLength ()
 {
-    return video.get(cv::CAP_PROP_FRAME_COUNT);
+    if (frameLayout == LayoutSeparateFiles) {
+        return qMin(decoder->getLength(), decoderRight->getLength());
+    }
+    return decoder->getLength();
+}
+
+int Source::getVideoKeyframes ()
+{
+    return decoder->getNumKeyframes();
 }
 
 
@@ -138,59 +179,237 @@ int Source::getVideoLength ()
 void Source::stopPlayback ()
 {
     playbackTimer->stop();
+
+    playing = false;
+    framePending = false;
+
     emit playbackStateChanged(false);
 }
 
 void Source::startPlayback ()
 {
     // Make sure video is open
-    if (!video.isOpened()) {
+    if (!decoder->isOpened()) {
         stopPlayback();
         return;
     }
 
-    // Start playback timer with specified FPS
+    // Start playback timer with specified FPS; in max-speed mode, the
+    // timer ensures that playback continues even if a frame is dropped
+    // without being retrieved
     float fps = getVideoFramerate();
     if (!fps) {
         fps = 25;
     }
     playbackTimer->start(1000/fps);
 
+    playing = true;
+
+    if (maxSpeed && imagesConsumed) {
+        framePending = !deliverFrame();
+    }
+
     emit playbackStateChanged(true);
 }
 
 void Source::setVideoPosition (int frame)
 {
-    video.set(cv::CAP_PROP_POS_FRAMES, frame);
+    decoder->seek(frame);
+    if (frameLayout == LayoutSeparateFiles) {
+        decoderRight->seek(frame);
+    }
 
-    // Get frame
-    playbackFunction();
+    // Get frame, once it is decoded
+    framePending = !deliverFrame();
 }
 
+void Source::setMaxSpeed (bool enabled)
+{
+    if (maxSpeed == enabled) {
+        return;
+    }
 
-void Source::playbackFunction ()
+    maxSpeed = enabled;
+
+    if (playing && maxSpeed && imagesConsumed) {
+        framePending = !deliverFrame();
+    }
+
+    emit maxSpeedChanged(maxSpeed);
+}
+
+bool Source::getMaxSpeed () const
 {
-    // Grab next frame
-    cv::Mat frame;
+    return maxSpeed;
+}
 
-    if (!video.grab()) {
-        stopPlayback();
+void Source::setCacheSize (int megabytes)
+{
+    if (decoder->getCacheSize() == megabytes) {
+        return;
+    }
+
+    decoder->setCacheSize(megabytes);
+    decoderRight->setCacheSize(megabytes);
+
+    emit cacheSizeChanged(megabytes);
+}
+
+int Source::getCacheSize () const
+{
+    return decoder->getCacheSize();
+}
+
+
+// *********************************************************************
+// *                           Frame layout                            *
+// *********************************************************************
+void Source::setFrameLayout (int layout)
+{
+    if (frameLayout == layout) {
         return;
     }
 
-    // Decode frame
-    video.retrieve(frame);
-    emit videoPositionChanged(video.get(cv::CAP_PROP_POS_FRAMES), video.get(cv::CAP_PROP_FRAME_COUNT));
+    bool separateFiles = (frameLayout == LayoutSeparateFiles) != (layout == LayoutSeparateFiles);
+
+    frameLayout = layout;
+
+    if (separateFiles) {
+        // Video needs to be re-opened
+        openVideoFile(QString());
+    } else if (!currentFrame.empty()) {
+        // Re-split current frame
+        QWriteLocker locker(&imagesLock);
+        splitFrame(currentFrame, imageLeft, imageRight);
+        locker.unlock();
+
+        emit imagesChanged();
+    }
+
+    emit frameLayoutChanged(frameLayout);
+}
+
+int Source::getFrameLayout () const
+{
+    return frameLayout;
+}
+
+void Source::splitFrame (const cv::Mat &frame, cv::Mat &left, cv::Mat &right) const
+{
+    switch (frameLayout) {
+        case LayoutTopBottom: {
+            left = frame.rowRange(0, frame.rows/2);
+            right = frame.rowRange(frame.rows/2, frame.rows/2*2);
+            break;
+        }
+        case LayoutRowInterleaved: {
+            // Reshaping into half as many rows puts each pair of rows
+            // into a single one, with the even row in its left and the
+            // odd row in its right half
+            cv::Mat pairs = frame.rowRange(0, frame.rows/2*2);
+            if (!pairs.isContinuous()) {
+                pairs = pairs.clone();
+            }
+            pairs = pairs.reshape(0, frame.rows/2);
+
+            left = pairs.colRange(0, frame.cols);
+            right = pairs.colRange(frame.cols, frame.cols*2);
+            break;
+        }
+        case LayoutSideBySide:
+        default: {
+            left = frame.colRange(0, frame.cols/2);
+            right = frame.colRange(frame.cols/2, frame.cols/2*2);
+            break;
+        }
+    }
+}
+
 
-    // Update images
+void Source::playbackFunction ()
+{
+    // If the decoder lags behind, the frame is emitted as soon as it
+    // becomes available
+    framePending = !deliverFrame();
+}
+
+void Source::handleFrameAvailable ()
+{
+    if (framePending) {
+        framePending = !deliverFrame();
+    }
+}
+
+void Source::handleImagesRetrieved ()
+{
+    imagesConsumed = true;
+
+    if (playing && maxSpeed) {
+        framePending = !deliverFrame();
+        playbackTimer->start(); // Restart the timeout
+    }
+}
+
+bool Source::deliverFrame ()
+{
+    Frame frame;
+    Frame frameRight;
+
+    bool separateFiles = frameLayout == LayoutSeparateFiles;
+    bool available = separateFiles ? takeFramePair(frame, frameRight) : decoder->takeFrame(frame);
+
+    if (!available) {
+        if (playing && (decoder->atEnd() || (separateFiles && decoderRight->atEnd()))) {
+            stopPlayback();
+        }
+        return false;
+    }
+
+    // Split frame into views
     QWriteLocker locker(&imagesLock);
 
-    frame(cv::Rect(0, 0, frame.cols/2, frame.rows)).copyTo(imageLeft);
-    frame(cv::Rect(frame.cols/2, 0, frame.cols/2, frame.rows)).copyTo(imageRight);
+    if (separateFiles) {
+        imageLeft = frame.image;
+        imageRight = frameRight.image;
+    } else {
+        currentFrame = frame.image;
+        splitFrame(currentFrame, imageLeft, imageRight);
+    }
 
     locker.unlock();
 
+    imagesConsumed = false;
+
+    emit videoPositionChanged(frame.index + 1, getVideoLength());
     emit imagesChanged();
+
+    return true;
+}
+
+bool Source::takeFramePair (Frame &frameLeft, Frame &frameRight)
+{
+    // Frames are paired by their presentation timestamps; a frame that
+    // has no counterpart in the other video (e.g., due to a frame drop
+    // during recording) is skipped
+    float fps = getVideoFramerate();
+    double tolerance = 500.0 / (fps ? fps : 25);
+
+    forever {
+        if (!decoder->peekFrame(frameLeft) || !decoderRight->peekFrame(frameRight)) {
+            return false;
+        }
+
+        double difference = frameLeft.timestamp - frameRight.timestamp;
+        if (difference < -tolerance) {
+            decoder->takeFrame(frameLeft);
+        } else if (difference > tolerance) {
+            decoderRight->takeFrame(frameRight);
+        } else {
+            decoder->takeFrame(frameLeft);
+            decoderRight->takeFrame(frameRight);
+            return true;
+        }
+    }
 }
 
 
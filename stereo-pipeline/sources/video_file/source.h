@@ -20,11 +20,11 @@
 #ifndef MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__SOURCE_H
 #define MVL_STEREO_TOOLBOX__PIPELINE__SOURCES__VIDEO_FILE__SOURCE_H
 
-#include <QtConcurrent>
+#include <QtCore>
 
 #include <stereo-pipeline/image_pair_source.h>
 
-#include <opencv2/videoio.hpp>
+#include <opencv2/core.hpp>
 
 
 namespace MVL {
@@ -33,12 +33,23 @@ namespace Pipeline {
 namespace SourceVideoFile {
 
 
+class Decoder;
+struct Frame;
+
 class Source : public QObject, public ImagePairSource
 {
     Q_OBJECT
     Q_INTERFACES(MVL::StereoToolbox::Pipeline::ImagePairSource)
 
 public:
+    // Arrangement of left and right images in the video
+    enum FrameLayout {
+        LayoutSideBySide,
+        LayoutTopBottom,
+        LayoutRowInterleaved, // Left image in even, right in odd rows
+        LayoutSeparateFiles,
+    };
+
     Source (QObject *parent = nullptr);
     virtual ~Source ();
 
@@ -51,16 +62,39 @@ public:
     int getVideoHeight ();
     float getVideoFramerate ();
     int getVideoLength ();
+    int getVideoKeyframes ();
 
     void stopPlayback ();
     void startPlayback ();
 
     void setVideoPosition (int frame);
 
-    void openVideoFile (const QString &filename);
+    // In max-speed mode, frames are emitted as soon as the previous
+    // one has been retrieved, but no slower than at video's framerate
+    void setMaxSpeed (bool enabled);
+    bool getMaxSpeed () const;
+
+    // Memory budget of the decoded-frame cache, in megabytes (per
+    // video file)
+    void setCacheSize (int megabytes);
+    int getCacheSize () const;
+
+    // Changing between single-file and separate-files layout closes
+    // the video
+    void setFrameLayout (int layout);
+    int getFrameLayout () const;
+
+    // Right video file is used only with separate-files layout
+    void openVideoFile (const QString &filename, const QString &filenameRight = QString());
 
 protected:
     void playbackFunction ();
+    void handleFrameAvailable ();
+    void handleImagesRetrieved ();
+
+    bool deliverFrame ();
+    bool takeFramePair (Frame &frameLeft, Frame &frameRight);
+    void splitFrame (const cv::Mat &frame, cv::Mat &left, cv::Mat &right) const;
 
 signals:
     // Signals from interface
@@ -70,18 +104,37 @@ signals:
     void playbackStateChanged (bool playing);
     void videoFileChanged (bool available);
     void videoPositionChanged (int position, int length);
+    void maxSpeedChanged (bool enabled);
+    void cacheSizeChanged (int megabytes);
+    void frameLayoutChanged (int layout);
+
+    // Internal: emitted from getImages() to notify the source's thread
+    void imagesRetrieved ();
 
 protected:
-    // Images
+    // Images; views into decoded frames, which are never modified
     mutable QReadWriteLock imagesLock;
 
     cv::Mat imageLeft;
     cv::Mat imageRight;
 
-    cv::VideoCapture video;
+    // Last single-file frame, for re-splitting on layout change
+    cv::Mat currentFrame;
+
+    int frameLayout;
 
-    // Playback thread
+    // Video decoders; the second one is used only with separate files,
+    // in which case both decode concurrently
+    Decoder *decoder;
+    Decoder *decoderRight;
+
+    // Playback
     QTimer *playbackTimer;
+
+    bool playing;
+    bool maxSpeed;
+    bool framePending; // Frame is due, but was not decoded yet
+    bool imagesConsumed; // Last emitted frame was retrieved
 };
 
 
@@ -62,11 +62,57 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
 
     QVBoxLayout *layout = new QVBoxLayout(scrollArea->widget());
 
+    // Frame layout
+    hbox = new QHBoxLayout();
+    hbox->setContentsMargins(0, 0, 0, 0);
+
+    tooltip = "Arrangement of left and right images in the video.";
+
+    label = new QLabel("Layout: ", this);
+    label->setToolTip(tooltip);
+
+    hbox->addWidget(label);
+
+    comboBoxLayout = new QComboBox(this);
+    comboBoxLayout->setToolTip(tooltip);
+    comboBoxLayout->addItem("Side-by-side", Source::LayoutSideBySide);
+    comboBoxLayout->setItemData(0, "Left image in left and right image in right half of the frame.", Qt::ToolTipRole);
+    comboBoxLayout->addItem("Top-bottom", Source::LayoutTopBottom);
+    comboBoxLayout->setItemData(1, "Left image in top and right image in bottom half of the frame.", Qt::ToolTipRole);
+    comboBoxLayout->addItem("Row-interleaved", Source::LayoutRowInterleaved);
+    comboBoxLayout->setItemData(2, "Left image in even and right image in odd rows of the frame.", Qt::ToolTipRole);
+    comboBoxLayout->addItem("Separate files", Source::LayoutSeparateFiles);
+    comboBoxLayout->setItemData(3, "Left and right images in separate video files, synchronized by frame timestamps.", Qt::ToolTipRole);
+    comboBoxLayout->setCurrentIndex(comboBoxLayout->findData(source->getFrameLayout()));
+
+    connect(comboBoxLayout, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), this, [this] (int index) {
+        int layout = comboBoxLayout->itemData(index).toInt();
+        bool separateFiles = (layout == Source::LayoutSeparateFiles);
+
+        widgetVideoFileRight->setVisible(separateFiles);
+
+        emit frameLayoutChangeRequested(layout);
+
+        // Changing to/from separate files closes the video; re-open it
+        if (separateFiles != videoFilesSeparate) {
+            videoFilesSeparate = separateFiles;
+            emit videoFileLoadRequested(videoFilename, videoFilenameRight);
+        }
+    });
+    connect(this, &SourceWidget::frameLayoutChangeRequested, source, &Source::setFrameLayout, Qt::QueuedConnection);
+    connect(source, &Source::frameLayoutChanged, comboBoxLayout, [this] (int layout) {
+        comboBoxLayout->setCurrentIndex(comboBoxLayout->findData(layout));
+    });
+
+    hbox->addWidget(comboBoxLayout, 1);
+
+    layout->addLayout(hbox);
+
     // Video file
     hbox = new QHBoxLayout();
     hbox->setContentsMargins(0, 0, 0, 0);
 
-    tooltip = "Video file path or URL.";
+    tooltip = "Video file path or URL; in case of separate files, the left video.";
 
     label = new QLabel("Video file: ", this);
     label->setToolTip(tooltip);
@@ -79,7 +125,7 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
     connect(lineEditVideoFile, &QLineEdit::returnPressed, this, [this] () {
         if (lineEditVideoFile->text() != videoFilename) {
             videoFilename = lineEditVideoFile->text();
-            emit videoFileLoadRequested(videoFilename);
+            emit videoFileLoadRequested(videoFilename, videoFilenameRight);
         }
     });
     connect(this, &SourceWidget::videoFileLoadRequested, source, &Source::openVideoFile, Qt::QueuedConnection); // A two-piece connection due to different thread affinity
@@ -92,7 +138,7 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
         if (!filename.isEmpty()) {
             videoFilename = filename;
             lineEditVideoFile->setText(videoFilename);
-            emit videoFileLoadRequested(videoFilename); // Use same type of connection as above
+            emit videoFileLoadRequested(videoFilename, videoFilenameRight); // Use same type of connection as above
         }
     });
 
@@ -100,6 +146,47 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
 
     layout->addLayout(hbox);
 
+    // Right video file
+    widgetVideoFileRight = new QWidget(this);
+    hbox = new QHBoxLayout(widgetVideoFileRight);
+    hbox->setContentsMargins(0, 0, 0, 0);
+
+    tooltip = "Right video file path or URL.";
+
+    label = new QLabel("Right video file: ", this);
+    label->setToolTip(tooltip);
+
+    hbox->addWidget(label);
+
+    lineEdit = new QLineEdit(this);
+    lineEditVideoFileRight = lineEdit;
+
+    connect(lineEditVideoFileRight, &QLineEdit::returnPressed, this, [this] () {
+        if (lineEditVideoFileRight->text() != videoFilenameRight) {
+            videoFilenameRight = lineEditVideoFileRight->text();
+            emit videoFileLoadRequested(videoFilename, videoFilenameRight);
+        }
+    });
+
+    hbox->addWidget(lineEdit);
+
+    button = new QPushButton("Browse");
+    connect(button, &QPushButton::clicked, this, [this] () {
+        QString filename = QFileDialog::getOpenFileName(this, "Select right video file", QString(), "Video files (*.avi *.mp4 *.mkv *.mpeg *.mpg);; All files (*.*)");
+        if (!filename.isEmpty()) {
+            videoFilenameRight = filename;
+            lineEditVideoFileRight->setText(videoFilenameRight);
+            emit videoFileLoadRequested(videoFilename, videoFilenameRight);
+        }
+    });
+
+    hbox->addWidget(button);
+
+    videoFilesSeparate = (source->getFrameLayout() == Source::LayoutSeparateFiles);
+    widgetVideoFileRight->setVisible(videoFilesSeparate);
+
+    layout->addWidget(widgetVideoFileRight);
+
      // Separator
     line = new QFrame(this);
     line->setFrameStyle(QFrame::HLine | QFrame::Sunken);
@@ -136,6 +223,38 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
 
     layoutVideo->addWidget(button);
 
+    // Max speed
+    tooltip = "Emit frames as fast as the pipeline can process them, instead of at video's framerate.";
+
+    checkBoxMaxSpeed = new QCheckBox("Max speed", this);
+    checkBoxMaxSpeed->setToolTip(tooltip);
+    checkBoxMaxSpeed->setChecked(source->getMaxSpeed());
+    connect(checkBoxMaxSpeed, &QCheckBox::toggled, source, &Source::setMaxSpeed, Qt::QueuedConnection);
+    connect(source, &Source::maxSpeedChanged, checkBoxMaxSpeed, &QCheckBox::setChecked);
+
+    layoutVideo->addWidget(checkBoxMaxSpeed);
+
+    // Cache size
+    hbox = new QHBoxLayout();
+
+    tooltip = "Memory budget for recently-decoded frames, which allow instant stepping back and forth.";
+
+    label = new QLabel("Frame cache: ", this);
+    label->setToolTip(tooltip);
+    hbox->addWidget(label);
+
+    spinBoxCacheSize = new QSpinBox(this);
+    spinBoxCacheSize->setToolTip(tooltip);
+    spinBoxCacheSize->setRange(0, 16384);
+    spinBoxCacheSize->setSingleStep(64);
+    spinBoxCacheSize->setSuffix(" MB");
+    spinBoxCacheSize->setValue(source->getCacheSize());
+    connect(spinBoxCacheSize, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), source, &Source::setCacheSize, Qt::QueuedConnection);
+    connect(source, &Source::cacheSizeChanged, spinBoxCacheSize, &QSpinBox::setValue);
+    hbox->addWidget(spinBoxCacheSize);
+
+    layoutVideo->addLayout(hbox);
+
     // Position
     hbox = new QHBoxLayout();
 
@@ -193,6 +312,9 @@ SourceWidget::SourceWidget (Source *source, QWidget *parent)
     labelVideoLength = new QLabel(this);
     layoutVideo->addWidget(labelVideoLength);
 
+    labelVideoKeyframes = new QLabel(this);
+    layoutVideo->addWidget(labelVideoKeyframes);
+
     // Init
     connect(source, &Source::videoFileChanged, this, &SourceWidget::updateVideoInfo, Qt::QueuedConnection);
     connect(source, &Source::videoPositionChanged, this, &SourceWidget::updateVideoPosition, Qt::QueuedConnection);
@@ -224,12 +346,20 @@ void SourceWidget::updateVideoInfo (bool available)
         labelVideoResolution->setText(QString("<b>Resolution:</b> %1x%2").arg(width).arg(height));
         labelVideoFramerate->setText(QString("<b>Framerate:</b> %1").arg(framerate));
         labelVideoLength->setText(QString("<b>Length:</b> %1").arg(length));
+
+        int keyframes = source->getVideoKeyframes();
+        if (keyframes >= 0) {
+            labelVideoKeyframes->setText(QString("<b>Keyframes:</b> %1").arg(keyframes));
+        } else {
+            labelVideoKeyframes->setText("<b>Keyframes:</b> N/A");
+        }
     } else {
         widgetVideo->hide();
 
         labelVideoResolution->setText("<b>Resolution:</b> N/A");
         labelVideoFramerate->setText("<b>Framerate:</b> N/A");
         labelVideoLength->setText("<b>Length:</b> N/A");
+        labelVideoKeyframes->setText("<b>Keyframes:</b> N/A");
     }
 
     pushButtonPlayPause->setEnabled(available);
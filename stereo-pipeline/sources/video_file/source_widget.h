@@ -44,24 +44,35 @@ protected:
     void updateVideoPosition (int frame, int length);
 
 signals:
-    void videoFileLoadRequested (const QString &filename);
+    void videoFileLoadRequested (const QString &filename, const QString &filenameRight);
+    void frameLayoutChangeRequested (int layout);
 
 protected:
     Source *source;
 
+    QComboBox *comboBoxLayout;
+
     QLineEdit *lineEditVideoFile;
 
+    QWidget *widgetVideoFileRight;
+    QLineEdit *lineEditVideoFileRight;
+
     QWidget *widgetVideo;
     QLabel *labelVideoResolution;
     QLabel *labelVideoFramerate;
     QLabel *labelVideoLength;
+    QLabel *labelVideoKeyframes;
 
     QPushButton *pushButtonPlayPause;
+    QCheckBox *checkBoxMaxSpeed;
+    QSpinBox *spinBoxCacheSize;
     QSpinBox *spinBoxFrame;
     QTimeEdit *timeEditPosition;
     QSlider *sliderPosition;
 
     QString videoFilename;
+    QString videoFilenameRight;
+    bool videoFilesSeparate;
 };
 
 
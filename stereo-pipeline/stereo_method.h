@@ -24,6 +24,8 @@
 
 #include <opencv2/core.hpp>
 
+#include <stereo-pipeline/disparity_format.h>
+
 
 namespace MVL {
 namespace StereoToolbox {
@@ -41,6 +43,16 @@ public:
     // Disparity image computation
     virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities) = 0;
 
+    // Format of the disparity image produced by the last call to
+    // computeDisparity(). Methods should output disparity in their
+    // native representation (e.g., fixed-point CV_16S) and describe
+    // it here, instead of converting it to float; methods producing
+    // floating-point disparities need not override this
+    virtual DisparityFormat getDisparityFormat () const
+    {
+        return DisparityFormat();
+    }
+
     // Parameter import/export
     virtual void loadParameters (const QString &filename) = 0;
 
@@ -52,12 +64,140 @@ public:
 };
 
 
+// Version 2 of stereo method interface. In addition to the basic
+// interface, it allows the pipeline to query method's capabilities
+// and preferred input type, to preallocate internal buffers ahead of
+// the first frame, and to have disparity computed directly into
+// caller-provided buffers. Methods implementing it should list both
+// interfaces in Q_INTERFACES, so that they remain usable through the
+// basic interface as well
+class StereoMethod2 : public StereoMethod
+{
+public:
+    enum Capability {
+        // computeDisparity() may be called concurrently from multiple
+        // threads (e.g., on different image bands)
+        CapabilityThreadSafe = 0x01,
+        // Method can be applied to image sub-regions (i.e., it does
+        // not assume full-frame input)
+        CapabilityRegionOfInterest = 0x02,
+        // prepare() preallocates all internal buffers, so processing
+        // of frames of prepared size does not allocate memory
+        CapabilityPreallocation = 0x04,
+        // computeDisparityInRange() honors the given search range, and
+        // getDisparityRange() reports the configured one
+        CapabilityDisparityRange = 0x08,
+        // createInstance() provides independent instances, which can
+        // process horizontal image bands in parallel
+        CapabilityBandParallel = 0x10,
+        // computeDisparityPair() provides the right-image disparity
+        // as a by-product of matching; only reported while the regular
+        // output of computeDisparity() is the left-image disparity
+        CapabilityRightDisparity = 0x20,
+        // Post-processing (e.g., speckle filtering) is separable from
+        // matching: with raw output enabled, computeDisparity*() skip
+        // it, and postProcessDisparity() applies it. Changes of
+        // post-processing parameters are then signalled by method's
+        // postProcessingParameterChanged() signal, which such methods
+        // must declare, instead of parameterChanged()
+        CapabilityPostProcessing = 0x40,
+    };
+
+    // Bitwise combination of Capability flags
+    virtual int getCapabilities () const = 0;
+
+    // Preferred type of input images (e.g., CV_8UC1), or -1 if method
+    // has no preference; the pipeline converts input images to this
+    // type before passing them to the method
+    virtual int getPreferredInputType () const = 0;
+
+    // Prepares method for images of given size and type; called ahead
+    // of the first frame, and whenever input size or type changes
+    virtual void prepare (const cv::Size &imageSize, int imageType) = 0;
+
+    // Disparity image computation into caller-provided buffer. The
+    // buffer is reused between frames, so the method should write into
+    // it (cv::Mat::create() being no-op when size and type match), and
+    // must not keep references to it. Disparity format is returned
+    // alongside the image
+    virtual void computeDisparity (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int &numDisparities, DisparityFormat &format) = 0;
+
+    // Disparity image computation with search range that overrides the
+    // configured one, without changing method's parameters (e.g., for
+    // matching image tiles with restricted disparity ranges). The
+    // number of disparities is a multiple of 16. Methods that do not
+    // report CapabilityDisparityRange ignore the given range
+    virtual void computeDisparityInRange (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparity, int minDisparity, int numDisparities, DisparityFormat &format)
+    {
+        Q_UNUSED(minDisparity);
+        computeDisparity(img1, img2, disparity, numDisparities, format);
+    }
+
+    // Configured disparity search range; only for methods with
+    // CapabilityDisparityRange
+    virtual void getDisparityRange (int &minDisparity, int &numDisparities) const
+    {
+        minDisparity = 0;
+        numDisparities = 0;
+    }
+
+    // Disparity image computation for both images; right disparity is
+    // given in right image coordinates, in the same format as the left
+    // one. Methods that do not report CapabilityRightDisparity return
+    // an empty right disparity
+    virtual void computeDisparityPair (const cv::Mat &img1, const cv::Mat &img2, cv::Mat &disparityLeft, cv::Mat &disparityRight, int &numDisparities, DisparityFormat &format)
+    {
+        computeDisparity(img1, img2, disparityLeft, numDisparities, format);
+        disparityRight.release();
+    }
+
+    // Creates an independent instance of the method with the same
+    // parameters (caller takes ownership); only for methods with
+    // CapabilityBandParallel
+    virtual QObject *createInstance () const
+    {
+        return nullptr;
+    }
+
+    // Raw output; only for methods with CapabilityPostProcessing.
+    // Instances created by createInstance() inherit the setting
+    virtual void setRawOutput (bool enable)
+    {
+        Q_UNUSED(enable);
+    }
+
+    // Applies post-processing to disparity computed with raw output
+    // enabled; the format is the one reported for raw disparity, and
+    // is preserved by post-processing
+    virtual void postProcessDisparity (const cv::Mat &rawDisparity, const DisparityFormat &format, cv::Mat &disparity)
+    {
+        Q_UNUSED(format);
+        rawDisparity.copyTo(disparity);
+    }
+
+    using StereoMethod::computeDisparity;
+};
+
+
+// Interface for methods that wrap another stereo method (e.g., to run
+// it in a coarse-to-fine manner). The application provides the list of
+// available stereo method objects, from which the wrapped method is
+// then chosen
+class StereoMethodWrapper
+{
+public:
+    virtual void setAvailableMethods (const QList<QObject *> &methods) = 0;
+};
+
+
 } // Pipeline
 } // StereoToolbox
 } // MVL
 
 
-Q_DECLARE_INTERFACE(MVL::StereoToolbox::Pipeline::StereoMethod, "MVL_Stereo_Toolbox.StereoMethod/1.0")
+Q_DECLARE_INTERFACE(MVL::StereoToolbox::Pipeline::StereoMethod, "MVL_Stereo_Toolbox.StereoMethod/1.1")
+Q_DECLARE_INTERFACE(MVL::StereoToolbox::Pipeline::StereoMethod2, "MVL_Stereo_Toolbox.StereoMethod/2.5")
+Q_DECLARE_INTERFACE(MVL::StereoToolbox::Pipeline::StereoMethodWrapper, "MVL_Stereo_Toolbox.StereoMethodWrapper/1.0")
 
 
 #endif
@@ -19,7 +19,18 @@
 
 
 #include "utils.h"
+#include "disparity_visualization.h"
 #include "exception.h"
+#include "reprojection.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
 
 
 namespace MVL {
@@ -69,6 +80,16 @@ static QDataStream &operator << (QDataStream &stream, const cv::Mat &matrix)
                     stream << entry;
                     break;
                 }
+                case CV_16UC1: {
+                    const unsigned short &entry = matrix.at<unsigned short>(y, x);
+                    stream << entry;
+                    break;
+                }
+                case CV_16SC3: {
+                    const cv::Vec3s &entry = matrix.at<cv::Vec3s>(y, x);
+                    stream << entry[0] << entry[1] << entry[2];
+                    break;
+                }
                 case CV_32SC1: {
                     const int &entry = matrix.at<int>(y, x);
                     stream << entry;
@@ -84,6 +105,12 @@ static QDataStream &operator << (QDataStream &stream, const cv::Mat &matrix)
                     stream << entry[0] << entry[1] << entry[2];
                     break;
                 }
+                case CV_32FC4: {
+                    // Point list; the fourth channel holds an integer
+                    const cv::Vec4f &entry = matrix.at<cv::Vec4f>(y, x);
+                    stream << entry[0] << entry[1] << entry[2] << (qint32)Reprojection::getListPointIndex(entry);
+                    break;
+                }
                 default: {
                     throw Exception(QStringLiteral("Unhandled matrix format %1!").arg(matrix.type()));
                 }
@@ -156,6 +183,18 @@ static QDataStream &operator >> (QDataStream &stream, cv::Mat &matrix)
                     stream >> entry;
                     break;
                 }
+                case CV_16UC1: {
+                    unsigned short &entry = matrix.at<unsigned short>(y, x);
+                    stream >> entry;
+                    break;
+                }
+                case CV_16SC3: {
+                    cv::Vec3s &entry = matrix.at<cv::Vec3s>(y, x);
+                    stream >> entry[0];
+                    stream >> entry[1];
+                    stream >> entry[2];
+                    break;
+                }
                 case CV_32SC1: {
                     int &entry = matrix.at<int>(y, x);
                     stream >> entry;
@@ -173,6 +212,17 @@ static QDataStream &operator >> (QDataStream &stream, cv::Mat &matrix)
                     stream >> entry[2];
                     break;
                 }
+                case CV_32FC4: {
+                    // Point list; the fourth channel holds an integer
+                    cv::Vec4f &entry = matrix.at<cv::Vec4f>(y, x);
+                    qint32 index;
+                    stream >> entry[0];
+                    stream >> entry[1];
+                    stream >> entry[2];
+                    stream >> index;
+                    entry = Reprojection::makeListPoint(entry[0], entry[1], entry[2], index);
+                    break;
+                }
                 default: {
                     throw Exception(QStringLiteral("Unhandled matrix format %1!").arg(matrix.type()));
                 }
@@ -226,105 +276,222 @@ void readMatrixFromBinaryFile (cv::Mat &matrix, const QString &fileName)
 // *********************************************************************
 // *                 Additional visualization functions                *
 // *********************************************************************
-template <typename TYPE>
-void __createColorCodedDisparityCpu (const cv::Mat &disparity, cv::Mat &image, int numLevels)
-{
-    unsigned int H;
-    const float S = 1;
-    const float V = 1;
-
-    unsigned int hi;
-    float f, p, q, t;
-
-    float x, y, z;
-    unsigned char b, g, r;
-
-    for (int i = 0; i < disparity.rows; i++) {
-        const TYPE *disparity_ptr = disparity.ptr<TYPE>(i);
-        for (int j = 0; j < disparity.cols; j++) {
-            H = ((numLevels - disparity_ptr[j]) * 240)/numLevels;
-
-            hi = (H/60) % 6;
-            f = H/60.f - H/60;
-            p = V * (1 - S);
-            q = V * (1 - f * S);
-            t = V * (1 - (1 - f) * S);
-
-            switch (hi) {
-                case 0: {
-                    // R = V, G = t, B = p
-                    x = p;
-                    y = t;
-                    z = V;
-                    break;
-                }
-                case 1: {
-                    // R = q, G = V, B = p
-                    x = p;
-                    y = V;
-                    z = q;
-                    break;
-                }
-                case 2: {
-                    // R = p, G = V, B = t
-                    x = t;
-                    y = V;
-                    z = p;
+#if CV_SIMD128
+static inline cv::v_float32x4 loadDisparity4 (const unsigned char *ptr)
+{
+    return cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(ptr)));
+}
+
+static inline cv::v_float32x4 loadDisparity4 (const short *ptr)
+{
+    return cv::v_cvt_f32(cv::v_load_expand(ptr));
+}
+
+static inline cv::v_float32x4 loadDisparity4 (const int *ptr)
+{
+    return cv::v_cvt_f32(cv::v_load(ptr));
+}
+
+static inline cv::v_float32x4 loadDisparity4 (const float *ptr)
+{
+    return cv::v_load(ptr);
+}
+#endif
+
+// Applies the color table to rows of disparity image. Table index
+// is computed as floor((d*scale + offset)*steps + 1.5), clamped to
+// the valid range; negative (invalid) and NaN disparities thus map to
+// the first (black) entry, without any per-pixel branching
+class DisparityColorTableBody : public cv::ParallelLoopBody
+{
+public:
+    DisparityColorTableBody (const cv::Mat &disparity, const cv::Mat &table, float indexScale, float indexOffset, cv::Mat &image)
+        : disparity(disparity),
+          table(table.ptr<cv::Vec3b>()),
+          indexScale(indexScale),
+          indexOffset(indexOffset),
+          maxIndex(static_cast<float>(table.cols - 1)),
+          image(image)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        for (int y = range.start; y < range.end; y++) {
+            cv::Vec3b *imagePtr = image.ptr<cv::Vec3b>(y);
+
+            switch (disparity.depth()) {
+                case CV_8U: {
+                    processRow(disparity.ptr<unsigned char>(y), imagePtr);
                     break;
                 }
-                case 3: {
-                    // R = p, G = q, B = V
-                    x = V;
-                    y = q;
-                    z = p;
+                case CV_16S: {
+                    processRow(disparity.ptr<short>(y), imagePtr);
                     break;
                 }
-                case 4: {
-                    // R = t, G = p, B = V
-                    x = V;
-                    y = p;
-                    z = t;
+                case CV_32S: {
+                    processRow(disparity.ptr<int>(y), imagePtr);
                     break;
                 }
-                case 5: {
-                    // R = V, G = p, B = q
-                    x = q;
-                    y = p;
-                    z = V;
+                case CV_32F: {
+                    processRow(disparity.ptr<float>(y), imagePtr);
                     break;
                 }
             }
+        }
+    }
+
+protected:
+    template <typename TYPE>
+    void processRow (const TYPE *disparityPtr, cv::Vec3b *imagePtr) const
+    {
+        int x = 0;
+
+#if CV_SIMD128
+        const cv::v_float32x4 vScale = cv::v_setall_f32(indexScale);
+        const cv::v_float32x4 vOffset = cv::v_setall_f32(indexOffset);
+        const cv::v_float32x4 vZero = cv::v_setzero_f32();
+        const cv::v_float32x4 vMax = cv::v_setall_f32(maxIndex);
+
+        int indices[4];
+
+        for (; x <= disparity.cols - 4; x += 4) {
+            cv::v_float32x4 d = loadDisparity4(disparityPtr + x);
+            cv::v_float32x4 f = d*vScale + vOffset;
+            f = cv::v_min(cv::v_max(f, vZero), vMax); // NaN -> 0
 
-            b = cv::saturate_cast<unsigned char>(x*255);
-            g = cv::saturate_cast<unsigned char>(y*255);
-            r = cv::saturate_cast<unsigned char>(z*255);
+            cv::v_store(indices, cv::v_trunc(f));
 
-            image.at<cv::Vec3b>(i, j) = cv::Vec3b(b, g, r);
+            imagePtr[x] = table[indices[0]];
+            imagePtr[x + 1] = table[indices[1]];
+            imagePtr[x + 2] = table[indices[2]];
+            imagePtr[x + 3] = table[indices[3]];
+        }
+#endif
+
+        for (; x < disparity.cols; x++) {
+            float f = static_cast<float>(disparityPtr[x])*indexScale + indexOffset;
+            f = std::min(std::max(0.0f, f), maxIndex); // NaN -> 0
+            imagePtr[x] = table[static_cast<int>(f)];
         }
     }
-}
 
-void createColorCodedDisparityCpu (const cv::Mat &disparity, cv::Mat &image, int numLevels)
+protected:
+    const cv::Mat &disparity;
+    const cv::Vec3b *table;
+    float indexScale;
+    float indexOffset;
+    float maxIndex;
+    cv::Mat &image;
+};
+
+
+void createDisparityColorTable (int numLevels, int colormap, cv::Mat &table, int &stepsPerLevel)
 {
-    image.create(disparity.rows, disparity.cols, CV_8UC3);
+    numLevels = std::max(numLevels, 1);
 
-    switch (disparity.type()) {
-        case CV_8UC1: {
-            return __createColorCodedDisparityCpu<unsigned char>(disparity, image, numLevels);
+    // Sub-pixel resolution of the table; keep it reasonably small so
+    // that it stays in cache
+    stepsPerLevel = std::max(1, std::min(16, 65536 / numLevels));
+
+    const int numEntries = numLevels*stepsPerLevel + 1;
+
+    // Colors for disparities 0, 1/steps, ..., numLevels
+    cv::Mat colors;
+
+    switch (colormap) {
+        case DisparityVisualization::ColormapHue: {
+            // Hue ramp; from blue (240 degrees) at zero disparity to red
+            // at maximum disparity, with full saturation and value
+            cv::Mat hsv(1, numEntries, CV_32FC3);
+            for (int i = 0; i < numEntries; i++) {
+                float d = static_cast<float>(i) / stepsPerLevel;
+                hsv.at<cv::Vec3f>(i) = cv::Vec3f((numLevels - d)*240.0f/numLevels, 1.0f, 1.0f);
+            }
+
+            cv::cvtColor(hsv, colors, cv::COLOR_HSV2BGR);
+            colors.convertTo(colors, CV_8U, 255.0);
+
+            break;
         }
-        case CV_16SC1: {
-            return __createColorCodedDisparityCpu<short>(disparity, image, numLevels);
+        case DisparityVisualization::ColormapJet:
+        case DisparityVisualization::ColormapHot:
+        case DisparityVisualization::ColormapRainbow:
+        case DisparityVisualization::ColormapParula: {
+            // OpenCV color maps, applied to 8-bit ramp
+            cv::Mat ramp(1, numEntries, CV_8U);
+            for (int i = 0; i < numEntries; i++) {
+                ramp.at<unsigned char>(i) = cv::saturate_cast<unsigned char>(i*255.0/(numEntries - 1));
+            }
+
+            int cvColormap;
+            switch (colormap) {
+                case DisparityVisualization::ColormapJet: cvColormap = cv::COLORMAP_JET; break;
+                case DisparityVisualization::ColormapHot: cvColormap = cv::COLORMAP_HOT; break;
+                case DisparityVisualization::ColormapRainbow: cvColormap = cv::COLORMAP_RAINBOW; break;
+                default: cvColormap = cv::COLORMAP_PARULA; break;
+            }
+
+            cv::applyColorMap(ramp, colors, cvColormap);
+
+            break;
         }
-        case CV_32SC1: {
-            return __createColorCodedDisparityCpu<int>(disparity, image, numLevels);
+        default: {
+            throw Exception(QStringLiteral("Unhandled color map %1!").arg(colormap));
         }
+    }
+
+    // First entry is reserved for invalid disparities
+    table.create(1, numEntries + 1, CV_8UC3);
+    table.at<cv::Vec3b>(0) = cv::Vec3b(0, 0, 0);
+    colors.copyTo(table.colRange(1, numEntries + 1));
+}
+
+void applyDisparityColorTable (const cv::Mat &disparity, const DisparityFormat &format, const cv::Mat &table, int stepsPerLevel, cv::Mat &image)
+{
+    switch (disparity.type()) {
+        case CV_8UC1:
+        case CV_16SC1:
+        case CV_32SC1:
         case CV_32FC1: {
-            return __createColorCodedDisparityCpu<float>(disparity, image, numLevels);
+            break;
         }
         default: {
             throw Exception(QStringLiteral("Unhandled disparity format %1!").arg(disparity.type()));
         }
     }
+
+    image.create(disparity.rows, disparity.cols, CV_8UC3);
+
+    const float indexScale = static_cast<float>(format.scale*stepsPerLevel);
+    const float indexOffset = static_cast<float>(format.offset*stepsPerLevel + 1.5);
+
+    cv::parallel_for_(cv::Range(0, disparity.rows), DisparityColorTableBody(disparity, table, indexScale, indexOffset, image));
+}
+
+void createColorCodedDisparityCpu (const cv::Mat &disparity, cv::Mat &image, int numLevels)
+{
+    cv::Mat table;
+    int stepsPerLevel;
+
+    createDisparityColorTable(numLevels, DisparityVisualization::ColormapHue, table, stepsPerLevel);
+    applyDisparityColorTable(disparity, DisparityFormat(), table, stepsPerLevel, image);
+}
+
+void convertDisparityToFloat (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &floatDisparity)
+{
+    if (disparity.empty()) {
+        floatDisparity = cv::Mat();
+        return;
+    }
+
+    // Fast path: already in the requested format
+    if (disparity.type() == CV_32FC1 && format.isIdentity()) {
+        disparity.copyTo(floatDisparity);
+        return;
+    }
+
+    disparity.convertTo(floatDisparity, CV_32F, format.scale, format.offset);
 }
 
 void createAnaglyph (const cv::Mat &left, const cv::Mat &right, cv::Mat &anaglyph)
@@ -352,26 +519,659 @@ void createAnaglyph (const cv::Mat &left, const cv::Mat &right, cv::Mat &anaglyp
 }
 
 
+// *********************************************************************
+// *                     Restricted-range matching                     *
+// *********************************************************************
+void computeTileDisparityRanges (const cv::Mat &estimate, const cv::Size &imageSize, int tileSize, int margin, double minValidFraction, int minDisparity, int numDisparities, cv::Mat &ranges)
+{
+    const int tilesX = (imageSize.width + tileSize - 1) / tileSize;
+    const int tilesY = (imageSize.height + tileSize - 1) / tileSize;
+    const int maxDisparity = minDisparity + numDisparities; // Exclusive
+
+    ranges.create(tilesY, tilesX, CV_32SC2);
+
+    // Without estimate, search over the full range
+    if (estimate.empty()) {
+        ranges.setTo(cv::Scalar(minDisparity, numDisparities));
+        return;
+    }
+
+    CV_Assert(estimate.type() == CV_32FC1);
+
+    const double scaleX = static_cast<double>(estimate.cols) / imageSize.width;
+    const double scaleY = static_cast<double>(estimate.rows) / imageSize.height;
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            // Tile region in the estimate, extended by one pixel to
+            // account for interpolation
+            const int x0 = std::max(static_cast<int>(std::floor(tx*tileSize*scaleX)) - 1, 0);
+            const int y0 = std::max(static_cast<int>(std::floor(ty*tileSize*scaleY)) - 1, 0);
+            const int x1 = std::min(static_cast<int>(std::ceil(std::min((tx + 1)*tileSize, imageSize.width)*scaleX)) + 1, estimate.cols);
+            const int y1 = std::min(static_cast<int>(std::ceil(std::min((ty + 1)*tileSize, imageSize.height)*scaleY)) + 1, estimate.rows);
+
+            float lo = FLT_MAX;
+            float hi = -FLT_MAX;
+            int numValid = 0;
+
+            for (int y = y0; y < y1; y++) {
+                const float *estimateRow = estimate.ptr<float>(y);
+                for (int x = x0; x < x1; x++) {
+                    const float d = estimateRow[x];
+                    if (d >= minDisparity && d < maxDisparity) {
+                        lo = std::min(lo, d);
+                        hi = std::max(hi, d);
+                        numValid++;
+                    }
+                }
+            }
+
+            cv::Vec2i &range = ranges.at<cv::Vec2i>(ty, tx);
+
+            if (!numValid || numValid < minValidFraction*(x1 - x0)*(y1 - y0)) {
+                range = cv::Vec2i(minDisparity, numDisparities);
+                continue;
+            }
+
+            // Extend by margin, round number of disparities up to a
+            // multiple of 16, and keep the range within the full one
+            int rangeMin = std::max(static_cast<int>(std::floor(lo)) - margin, minDisparity);
+            const int rangeMax = std::min(static_cast<int>(std::ceil(hi)) + margin + 1, maxDisparity);
+            const int rangeNum = std::min((rangeMax - rangeMin + 15) & -16, numDisparities);
+            rangeMin = std::min(rangeMin, maxDisparity - rangeNum);
+
+            range = cv::Vec2i(rangeMin, rangeNum);
+        }
+    }
+}
+
+// Horizontally adjacent tiles are matched together, as a strip with the
+// union of their ranges, if that does not increase the amount of work.
+// Each matched region carries context around the tiles (border, and the
+// maximum disparity on the left), which may well exceed the tile itself;
+// merging amortizes the context over larger areas
+struct TileStrip
+{
+    cv::Rect area; // Tiles, in image coordinates
+    cv::Rect region; // Matched region, including the context
+    int minDisparity;
+    int numDisparities;
+};
+
+static TileStrip createTileStrip (const cv::Rect &area, int minDisparity, int numDisparities, int tileBorder, const cv::Size &imageSize)
+{
+    // Matched region: tiles, extended by the border, and to the left by
+    // the maximum disparity, so that the matches of all pixels lie
+    // within it
+    const int left = std::max(area.x - std::max(minDisparity + numDisparities, 0) - tileBorder, 0);
+    const int top = std::max(area.y - tileBorder, 0);
+    const int right = std::min(area.x + area.width + tileBorder, imageSize.width);
+    const int bottom = std::min(area.y + area.height + tileBorder, imageSize.height);
+
+    return { area, cv::Rect(left, top, right - left, bottom - top), minDisparity, numDisparities };
+}
+
+static double getTileStripWork (const TileStrip &strip)
+{
+    return static_cast<double>(strip.region.area())*strip.numDisparities;
+}
+
+static void planTileStrips (const cv::Mat &ranges, const cv::Size &imageSize, int tileSize, int tileBorder, std::vector<TileStrip> &strips)
+{
+    strips.clear();
+
+    for (int ty = 0; ty < ranges.rows; ty++) {
+        TileStrip current;
+
+        for (int tx = 0; tx < ranges.cols; tx++) {
+            const cv::Vec2i &range = ranges.at<cv::Vec2i>(ty, tx);
+            const cv::Rect tile(tx*tileSize, ty*tileSize, std::min(tileSize, imageSize.width - tx*tileSize), std::min(tileSize, imageSize.height - ty*tileSize));
+            const TileStrip single = createTileStrip(tile, range[0], range[1], tileBorder, imageSize);
+
+            if (tx == 0) {
+                current = single;
+                continue;
+            }
+
+            // Union of ranges; number of disparities remains multiple
+            // of 16 if both are
+            const int unionMin = std::min(current.minDisparity, range[0]);
+            const int unionMax = std::max(current.minDisparity + current.numDisparities, range[0] + range[1]);
+            const int unionNum = (unionMax - unionMin + 15) & -16;
+            const TileStrip merged = createTileStrip(current.area | tile, unionMin, unionNum, tileBorder, imageSize);
+
+            if (getTileStripWork(merged) <= getTileStripWork(current) + getTileStripWork(single)) {
+                current = merged;
+            } else {
+                strips.push_back(current);
+                current = single;
+            }
+        }
+
+        if (ranges.cols) {
+            strips.push_back(current);
+        }
+    }
+}
+
+
+double getTileSearchFraction (const cv::Mat &ranges, const cv::Size &imageSize, int tileSize, int tileBorder, int numDisparities)
+{
+    std::vector<TileStrip> strips;
+    planTileStrips(ranges, imageSize, tileSize, tileBorder, strips);
+
+    // Work actually performed, including the context of matched regions,
+    // relative to single full-range search over the whole image; may
+    // exceed one
+    double searched = 0;
+    for (const TileStrip &strip : strips) {
+        searched += getTileStripWork(strip);
+    }
+
+    return searched / (static_cast<double>(imageSize.area())*numDisparities);
+}
+
+void computeDisparityInTiles (StereoMethod2 *method, const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, int minDisparity, cv::Mat &disparity, DisparityFormat &format)
+{
+    std::vector<TileStrip> strips;
+    planTileStrips(ranges, img1.size(), tileSize, tileBorder, strips);
+
+    cv::Mat tileDisparity;
+    cv::Mat invalidMask;
+    double invalidValue = 0;
+    bool first = true;
+
+    for (const TileStrip &strip : strips) {
+        const cv::Rect &area = strip.area;
+        const cv::Rect &region = strip.region;
+
+        DisparityFormat tileFormat;
+        method->computeDisparityInRange(img1(region), img2(region), tileDisparity, strip.minDisparity, strip.numDisparities, tileFormat);
+
+        // Output type and format are given by the first strip
+        if (first) {
+            disparity.create(img1.size(), tileDisparity.type());
+            format = tileFormat;
+            invalidValue = (minDisparity - 1 - format.offset) / format.scale;
+            first = false;
+        }
+
+        const cv::Mat source = tileDisparity(cv::Rect(area.x - region.x, area.y - region.y, area.width, area.height));
+        cv::Mat target = disparity(area);
+
+        if (tileFormat == format) {
+            source.copyTo(target);
+        } else {
+            source.convertTo(target, disparity.type(), tileFormat.scale / format.scale, (tileFormat.offset - format.offset) / format.scale);
+        }
+
+        // Disparities below strip's minimum (which includes method's
+        // own invalid value) are invalid
+        cv::compare(source, cv::Scalar((strip.minDisparity - tileFormat.offset) / tileFormat.scale), invalidMask, cv::CMP_LT);
+        target.setTo(cv::Scalar(invalidValue), invalidMask);
+    }
+}
+
+void computeMirroredTileDisparityRanges (const cv::Mat &ranges, const cv::Size &imageSize, int tileSize, int minDisparity, int numDisparities, cv::Mat &mirroredRanges)
+{
+    CV_Assert(ranges.type() == CV_32SC2);
+
+    const int maxDisparity = minDisparity + numDisparities; // Exclusive
+
+    mirroredRanges.create(ranges.size(), CV_32SC2);
+
+    for (int ty = 0; ty < ranges.rows; ty++) {
+        const cv::Vec2i *rangesRow = ranges.ptr<cv::Vec2i>(ty);
+        cv::Vec2i *mirroredRow = mirroredRanges.ptr<cv::Vec2i>(ty);
+
+        for (int tx = 0; tx < ranges.cols; tx++) {
+            // Columns of the flipped tile in the (unflipped) right image
+            const int x1 = imageSize.width - tx*tileSize; // Exclusive
+            const int x0 = std::max(x1 - tileSize, 0);
+
+            // Start with the left tiles at the same position, and extend
+            // the union until it covers all tiles that the tile's pixels
+            // may map to under the united range
+            int first = x0 / tileSize;
+            int last = (x1 - 1) / tileSize;
+            int lo = maxDisparity;
+            int hi = minDisparity; // Exclusive
+
+            forever {
+                for (int k = first; k <= last; k++) {
+                    lo = std::min(lo, rangesRow[k][0]);
+                    hi = std::max(hi, rangesRow[k][0] + rangesRow[k][1]);
+                }
+
+                const int newFirst = std::min(std::max(x0 + lo, 0), imageSize.width - 1) / tileSize;
+                const int newLast = std::min(std::max(x1 - 1 + hi - 1, 0), imageSize.width - 1) / tileSize;
+
+                if (newFirst >= first && newLast <= last) {
+                    break;
+                }
+
+                first = std::min(first, newFirst);
+                last = std::max(last, newLast);
+            }
+
+            // Same rounding and clamping as in computeTileDisparityRanges()
+            hi = std::min(hi, maxDisparity);
+            const int rangeNum = std::min((hi - lo + 15) & -16, numDisparities);
+            const int rangeMin = std::max(std::min(lo, maxDisparity - rangeNum), minDisparity);
+
+            mirroredRow[tx] = cv::Vec2i(rangeMin, rangeNum);
+        }
+    }
+}
+
+
+// *********************************************************************
+// *                     Left-right consistency check                  *
+// *********************************************************************
+// Checks rows of left disparity against the right disparity; both are
+// in float format. Matched positions and the checks are computed four
+// pixels at a time, only the look-up of right disparities is scalar
+class ConsistencyCheckBody : public cv::ParallelLoopBody
+{
+public:
+    ConsistencyCheckBody (const cv::Mat &left, const cv::Mat &right, float maxDifference, cv::Mat &invalidMask, cv::Mat &confidence)
+        : left(left),
+          right(right),
+          maxDifference(maxDifference),
+          invalidMask(invalidMask),
+          confidence(confidence)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const float confidenceScale = 1.0f / (maxDifference + 1.0f);
+
+        for (int y = range.start; y < range.end; y++) {
+            const float *leftPtr = left.ptr<float>(y);
+            const float *rightPtr = right.ptr<float>(y);
+            unsigned char *maskPtr = invalidMask.ptr<unsigned char>(y);
+            float *confidencePtr = confidence.ptr<float>(y);
+
+            int x = 0;
+
+#if CV_SIMD128
+            const cv::v_float32x4 vZero = cv::v_setzero_f32();
+            const cv::v_float32x4 vOne = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vMaxDifference = cv::v_setall_f32(maxDifference);
+            const cv::v_float32x4 vConfidenceScale = cv::v_setall_f32(confidenceScale);
+            const cv::v_float32x4 vStep(0.0f, 1.0f, 2.0f, 3.0f);
+
+            int positions[4];
+            float matched[4];
+            int valid[4];
+
+            for (; x <= left.cols - 4; x += 4) {
+                cv::v_float32x4 d = cv::v_load(leftPtr + x);
+
+                // Matched positions in the right image (NaN maps out of
+                // the image)
+                cv::v_store(positions, cv::v_round(cv::v_setall_f32(static_cast<float>(x)) + vStep - d));
+                for (int k = 0; k < 4; k++) {
+                    matched[k] = (positions[k] >= 0 && positions[k] < right.cols) ? rightPtr[positions[k]] : -1.0f;
+                }
+
+                cv::v_float32x4 m = cv::v_load(matched);
+                cv::v_float32x4 difference = cv::v_absdiff(d, m);
+                cv::v_float32x4 mask = (d >= vZero) & (m >= vZero) & (difference <= vMaxDifference);
+
+                cv::v_store(confidencePtr + x, (vOne - difference*vConfidenceScale) & mask);
+                cv::v_store(valid, cv::v_reinterpret_as_s32(mask));
+
+                for (int k = 0; k < 4; k++) {
+                    maskPtr[x + k] = valid[k] ? 0 : 255;
+                }
+            }
+#endif
+
+            for (; x < left.cols; x++) {
+                const float d = leftPtr[x];
+                maskPtr[x] = 255;
+                confidencePtr[x] = 0.0f;
+
+                if (!(d >= 0.0f)) {
+                    continue; // Invalid or NaN
+                }
+
+                const int position = cvRound(x - d);
+                if (position < 0 || position >= right.cols || rightPtr[position] < 0.0f) {
+                    continue;
+                }
+
+                const float difference = std::abs(d - rightPtr[position]);
+                if (difference <= maxDifference) {
+                    maskPtr[x] = 0;
+                    confidencePtr[x] = 1.0f - difference*confidenceScale;
+                }
+            }
+        }
+    }
+
+protected:
+    const cv::Mat &left;
+    const cv::Mat &right;
+    float maxDifference;
+    cv::Mat &invalidMask;
+    cv::Mat &confidence;
+};
+
+void checkLeftRightConsistency (const cv::Mat &disparityLeft, const cv::Mat &disparityRight, const DisparityFormat &format, float maxDifference, cv::Mat &invalidMask, cv::Mat &confidence)
+{
+    if (disparityLeft.size() != disparityRight.size()) {
+        throw Exception(QStringLiteral("Left and right disparity images must be of same size!"));
+    }
+
+    cv::Mat left, right;
+    convertDisparityToFloat(disparityLeft, format, left);
+    convertDisparityToFloat(disparityRight, format, right);
+
+    invalidMask.create(left.size(), CV_8UC1);
+    confidence.create(left.size(), CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, left.rows), ConsistencyCheckBody(left, right, maxDifference, invalidMask, confidence));
+}
+
+
+// *********************************************************************
+// *                          Speckle filter                           *
+// *********************************************************************
+// Union-find over linear pixel indices; roots point to themselves
+static inline int findSpeckleRoot (std::vector<int> &parent, int index)
+{
+    while (parent[index] != index) {
+        parent[index] = parent[parent[index]]; // Path halving
+        index = parent[index];
+    }
+    return index;
+}
+
+static inline int findSpeckleRootConst (const std::vector<int> &parent, int index)
+{
+    while (parent[index] != index) {
+        index = parent[index];
+    }
+    return index;
+}
+
+// First pass: connected components of each stripe of rows are labeled
+// independently; as links never leave the stripe, stripes can be
+// processed concurrently. Component sizes are stored at their roots
+template <typename T>
+class SpeckleLabelBody : public cv::ParallelLoopBody
+{
+    typedef typename cv::DataType<T>::work_type WorkType;
+
+public:
+    SpeckleLabelBody (const cv::Mat &disparity, T newValue, WorkType maxDiff, int numStripes, std::vector<int> &parent, std::vector<int> &sizes)
+        : disparity(disparity),
+          newValue(newValue),
+          maxDiff(maxDiff),
+          numStripes(numStripes),
+          parent(parent),
+          sizes(sizes)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = disparity.cols;
+
+        for (int stripe = range.start; stripe < range.end; stripe++) {
+            const int y0 = (disparity.rows * stripe) / numStripes;
+            const int y1 = (disparity.rows * (stripe + 1)) / numStripes;
+
+            for (int y = y0; y < y1; y++) {
+                const T *row = disparity.ptr<T>(y);
+                const T *rowAbove = (y > y0) ? disparity.ptr<T>(y - 1) : nullptr;
+
+                for (int x = 0; x < width; x++) {
+                    const int index = y*width + x;
+                    parent[index] = index;
+
+                    const T value = row[x];
+                    if (value == newValue) {
+                        continue;
+                    }
+
+                    if (x > 0 && row[x - 1] != newValue && std::abs(static_cast<WorkType>(value) - static_cast<WorkType>(row[x - 1])) <= maxDiff) {
+                        link(index - 1, index);
+                    }
+                    if (rowAbove && rowAbove[x] != newValue && std::abs(static_cast<WorkType>(value) - static_cast<WorkType>(rowAbove[x])) <= maxDiff) {
+                        link(index - width, index);
+                    }
+                }
+            }
+
+            // Flatten the trees, and accumulate component sizes
+            std::fill(sizes.begin() + y0*width, sizes.begin() + y1*width, 0);
+            for (int y = y0; y < y1; y++) {
+                const T *row = disparity.ptr<T>(y);
+                for (int x = 0; x < width; x++) {
+                    const int index = y*width + x;
+                    const int root = findSpeckleRoot(parent, index);
+                    parent[index] = root;
+                    if (row[x] != newValue) {
+                        sizes[root]++;
+                    }
+                }
+            }
+        }
+    }
+
+protected:
+    void link (int a, int b) const
+    {
+        const int rootA = findSpeckleRoot(parent, a);
+        const int rootB = findSpeckleRoot(parent, b);
+
+        // Lower index becomes the root
+        if (rootA < rootB) {
+            parent[rootB] = rootA;
+        } else if (rootB < rootA) {
+            parent[rootA] = rootB;
+        }
+    }
+
+    const cv::Mat &disparity;
+    T newValue;
+    WorkType maxDiff;
+    int numStripes;
+    std::vector<int> &parent;
+    std::vector<int> &sizes;
+};
+
+// Final pass: pixels of small components are invalidated. The forest
+// is only read, so stripes can again be processed concurrently
+template <typename T>
+class SpeckleApplyBody : public cv::ParallelLoopBody
+{
+public:
+    SpeckleApplyBody (cv::Mat &disparity, T newValue, int maxSpeckleSize, int numStripes, const std::vector<int> &parent, const std::vector<int> &sizes)
+        : disparity(disparity),
+          newValue(newValue),
+          maxSpeckleSize(maxSpeckleSize),
+          numStripes(numStripes),
+          parent(parent),
+          sizes(sizes)
+    {
+    }
+
+    virtual void operator() (const cv::Range &range) const override
+    {
+        const int width = disparity.cols;
+
+        for (int stripe = range.start; stripe < range.end; stripe++) {
+            const int y0 = (disparity.rows * stripe) / numStripes;
+            const int y1 = (disparity.rows * (stripe + 1)) / numStripes;
+
+            for (int y = y0; y < y1; y++) {
+                T *row = disparity.ptr<T>(y);
+                for (int x = 0; x < width; x++) {
+                    if (row[x] != newValue && sizes[findSpeckleRootConst(parent, y*width + x)] <= maxSpeckleSize) {
+                        row[x] = newValue;
+                    }
+                }
+            }
+        }
+    }
+
+protected:
+    cv::Mat &disparity;
+    T newValue;
+    int maxSpeckleSize;
+    int numStripes;
+    const std::vector<int> &parent;
+    const std::vector<int> &sizes;
+};
+
+template <typename T>
+static void filterSpecklesImpl (cv::Mat &disparity, double newValue, int maxSpeckleSize, double maxDiff)
+{
+    typedef typename cv::DataType<T>::work_type WorkType;
+
+    const T value = cv::saturate_cast<T>(newValue);
+    const WorkType diff = cv::saturate_cast<WorkType>(maxDiff);
+
+    const int width = disparity.cols;
+    const int numThreads = std::max(1, cv::getNumThreads());
+    const int numStripes = std::min(disparity.rows, numThreads * 2);
+
+    std::vector<int> parent(disparity.total());
+    std::vector<int> sizes(disparity.total());
+
+    // Label stripes
+    cv::parallel_for_(cv::Range(0, numStripes), SpeckleLabelBody<T>(disparity, value, diff, numStripes, parent, sizes));
+
+    // Merge components across stripe borders (union by size); this
+    // only touches the border rows, and is done sequentially
+    for (int stripe = 1; stripe < numStripes; stripe++) {
+        const int y = (disparity.rows * stripe) / numStripes;
+        const T *row = disparity.ptr<T>(y);
+        const T *rowAbove = disparity.ptr<T>(y - 1);
+
+        for (int x = 0; x < width; x++) {
+            if (row[x] == value || rowAbove[x] == value || std::abs(static_cast<WorkType>(row[x]) - static_cast<WorkType>(rowAbove[x])) > diff) {
+                continue;
+            }
+
+            int rootA = findSpeckleRoot(parent, y*width + x);
+            int rootB = findSpeckleRoot(parent, (y - 1)*width + x);
+            if (rootA == rootB) {
+                continue;
+            }
+            if (sizes[rootA] < sizes[rootB]) {
+                std::swap(rootA, rootB);
+            }
+            parent[rootB] = rootA;
+            sizes[rootA] += sizes[rootB];
+        }
+    }
+
+    // Invalidate small components
+    cv::parallel_for_(cv::Range(0, numStripes), SpeckleApplyBody<T>(disparity, value, maxSpeckleSize, numStripes, parent, sizes));
+}
+
+void filterSpeckles (cv::Mat &disparity, double newValue, int maxSpeckleSize, double maxDiff)
+{
+    if (disparity.empty() || maxSpeckleSize <= 0) {
+        return;
+    }
+
+    switch (disparity.type()) {
+        case CV_8UC1: {
+            filterSpecklesImpl<unsigned char>(disparity, newValue, maxSpeckleSize, maxDiff);
+            break;
+        }
+        case CV_16SC1: {
+            filterSpecklesImpl<short>(disparity, newValue, maxSpeckleSize, maxDiff);
+            break;
+        }
+        case CV_32FC1: {
+            filterSpecklesImpl<float>(disparity, newValue, maxSpeckleSize, maxDiff);
+            break;
+        }
+        default: {
+            throw Exception(QStringLiteral("Speckle filter: unhandled disparity format %1!").arg(disparity.type()));
+        }
+    }
+}
+
+
 // *********************************************************************
 // *                          PCD file export                          *
 // *********************************************************************
-void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, const QString &fileName, bool binary)
+static float getPcdPointColor (const cv::Mat &image, int index)
 {
-    // Validate input data
-    if (image.rows*image.cols != points.rows*points.cols) {
-        throw Exception(QStringLiteral("Size mismatch between image and points matrices!"));
+    // Convert RGB/gray to PCL floating-point representation
+    union {
+        unsigned int i;
+        float f;
+    } rgb;
+
+    int y = index / image.cols;
+    int x = index % image.cols;
+
+    if (image.channels() == 3) {
+        const cv::Vec3b &bgr = image.at<cv::Vec3b>(y, x);
+
+        rgb.i = static_cast<unsigned int>(bgr[2]) << 16 |
+                static_cast<unsigned int>(bgr[1]) << 8 |
+                static_cast<unsigned int>(bgr[0]);
+    } else {
+        const unsigned char &gray = image.at<unsigned char>(y, x);
+
+        rgb.i = static_cast<unsigned int>(gray) << 16 |
+                static_cast<unsigned int>(gray) << 8 |
+                static_cast<unsigned int>(gray);
     }
 
-    // Count valid points
-    int validPoints = 0;
-    for (int y = 0; y < points.rows; y++) {
-        const cv::Vec3f *pointsPtr = points.ptr<cv::Vec3f>(y);
-        for (int x = 0; x < points.cols; x++) {
-            const cv::Vec3f &xyz = pointsPtr[x];
-            if (std::isfinite(xyz[2])) {
-                validPoints++;
+    return rgb.f;
+}
+
+void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, const QString &fileName, bool binary)
+{
+    // Gather valid points; the points may be given either as a dense
+    // CV_32FC3 image, or as a compact CV_32FC4 list, in which the
+    // fourth channel holds the linear index of the corresponding pixel
+    std::vector<cv::Vec4f> validPoints;
+
+    if (points.type() == CV_32FC4) {
+        validPoints.reserve(points.rows*points.cols);
+        for (int y = 0; y < points.rows; y++) {
+            const cv::Vec4f *pointsPtr = points.ptr<cv::Vec4f>(y);
+            for (int x = 0; x < points.cols; x++) {
+                const cv::Vec4f &entry = pointsPtr[x];
+                if (std::isfinite(entry[2])) {
+                    const int index = Reprojection::getListPointIndex(entry);
+                    if (index < 0 || index >= image.rows*image.cols) {
+                        throw Exception(QStringLiteral("Point list refers to pixel outside of image!"));
+                    }
+                    validPoints.push_back(entry);
+                }
+            }
+        }
+    } else if (points.type() == CV_32FC3) {
+        // Validate input data
+        if (image.rows*image.cols != points.rows*points.cols) {
+            throw Exception(QStringLiteral("Size mismatch between image and points matrices!"));
+        }
+
+        for (int y = 0; y < points.rows; y++) {
+            const cv::Vec3f *pointsPtr = points.ptr<cv::Vec3f>(y);
+            for (int x = 0; x < points.cols; x++) {
+                const cv::Vec3f &xyz = pointsPtr[x];
+                if (std::isfinite(xyz[2])) {
+                    validPoints.push_back(Reprojection::makeListPoint(xyz[0], xyz[1], xyz[2], y*points.cols + x));
+                }
             }
         }
+    } else {
+        throw Exception(QStringLiteral("Unhandled points format %1!").arg(points.type()));
     }
 
     // Open file
@@ -381,6 +1181,7 @@ void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, cons
     }
 
     // Prepare ASCII header
+    int numPoints = static_cast<int>(validPoints.size());
     QString header = QString(
         "# .PCD v0.7 - Point Cloud Data file format\n"
         "VERSION 0.7\n"
@@ -392,7 +1193,7 @@ void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, cons
         "HEIGHT %2\n"
         "VIEWPOINT 0 0 0 1 0 0 0\n"
         "POINTS %3\n"
-        "DATA %4\n").arg(validPoints).arg(1).arg(validPoints).arg(binary ? "binary" : "ascii");
+        "DATA %4\n").arg(numPoints).arg(1).arg(numPoints).arg(binary ? "binary" : "ascii");
 
     if (binary) {
         QDataStream stream(&file);
@@ -404,78 +1205,23 @@ void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, cons
         QByteArray headerBytes = header.toLatin1();
         stream.writeRawData(headerBytes.data(), headerBytes.size());
 
-        for (int y = 0; y < image.rows; y++) {
-            const cv::Vec3f *pointsPtr = points.ptr<cv::Vec3f>(y);
-            for (int x = 0; x < image.cols; x++) {
-                const cv::Vec3f &xyz = pointsPtr[x];
+        for (const cv::Vec4f &entry : validPoints) {
+            float rgb = getPcdPointColor(image, Reprojection::getListPointIndex(entry));
 
-                if (!std::isfinite(xyz[2])) {
-                    continue;
-                }
-
-                // Convert RGB/gray to PCL floating-point representation
-                union {
-                    unsigned int i;
-                    float f;
-                } rgb;
-
-                if (image.channels() == 3) {
-                    const cv::Vec3b &bgr = image.at<cv::Vec3b>(y, x);
-
-                    rgb.i = static_cast<unsigned int>(bgr[2]) << 16 |
-                            static_cast<unsigned int>(bgr[1]) << 8 |
-                            static_cast<unsigned int>(bgr[0]);
-                } else {
-                    const unsigned char &gray = image.at<unsigned char>(y, x);
-
-                    rgb.i = static_cast<unsigned int>(gray) << 16 |
-                            static_cast<unsigned int>(gray) << 8 |
-                            static_cast<unsigned int>(gray);
-                }
-
-                // Store
-                stream << xyz[0] << xyz[1] << xyz[2] << rgb.f;
-            }
+            // Store
+            stream << entry[0] << entry[1] << entry[2] << rgb;
         }
-
     } else {
         QTextStream stream(&file);
         stream.setRealNumberPrecision(8);
 
         stream << header;
 
-        for (int y = 0; y < image.rows; y++) {
-            const cv::Vec3f *pointsPtr = points.ptr<cv::Vec3f>(y);
-            for (int x = 0; x < image.cols; x++) {
-                const cv::Vec3f &xyz = pointsPtr[x];
+        for (const cv::Vec4f &entry : validPoints) {
+            float rgb = getPcdPointColor(image, Reprojection::getListPointIndex(entry));
 
-                if (!std::isfinite(xyz[2])) {
-                    continue;
-                }
-
-                // Convert RGB/gray to PCL floating-point representation
-                union {
-                    unsigned int i;
-                    float f;
-                } rgb;
-
-                if (image.channels() == 3) {
-                    const cv::Vec3b &bgr = image.at<cv::Vec3b>(y, x);
-
-                    rgb.i = static_cast<unsigned int>(bgr[2]) << 16 |
-                            static_cast<unsigned int>(bgr[1]) << 8 |
-                            static_cast<unsigned int>(bgr[0]);
-                } else {
-                    const unsigned char &gray = image.at<unsigned char>(y, x);
-
-                    rgb.i = static_cast<unsigned int>(gray) << 16 |
-                            static_cast<unsigned int>(gray) << 8 |
-                            static_cast<unsigned int>(gray);
-                }
-
-                // Store
-                stream << xyz[0] << " " << xyz[1] << " " << xyz[2] << " " << rgb.f << "\n";
-            }
+            // Store
+            stream << entry[0] << " " << entry[1] << " " << entry[2] << " " << rgb << "\n";
         }
     }
 }
@@ -21,6 +21,8 @@
 #define MVL_STEREO_TOOLBOX__PIPELINE__UTILS_H
 
 #include <stereo-pipeline/export.h>
+#include <stereo-pipeline/disparity_format.h>
+#include <stereo-pipeline/stereo_method.h>
 
 #include <QtCore>
 #include <opencv2/core.hpp>
@@ -41,8 +43,61 @@ MVL_STEREO_PIPELINE_EXPORT void readMatrixFromBinaryFile (cv::Mat &matrix, const
 
 // Additional visualization
 MVL_STEREO_PIPELINE_EXPORT void createColorCodedDisparityCpu (const cv::Mat &disparity, cv::Mat &image, int numLevels);
+
+// Color look-up table for disparity visualization; the table has
+// numLevels*stepsPerLevel + 2 entries, the first one (black) being
+// reserved for invalid (negative) disparities. Colormap is one of
+// DisparityVisualization::Colormap* values
+MVL_STEREO_PIPELINE_EXPORT void createDisparityColorTable (int numLevels, int colormap, cv::Mat &table, int &stepsPerLevel);
+MVL_STEREO_PIPELINE_EXPORT void applyDisparityColorTable (const cv::Mat &disparity, const DisparityFormat &format, const cv::Mat &table, int stepsPerLevel, cv::Mat &image);
 MVL_STEREO_PIPELINE_EXPORT void createAnaglyph (const cv::Mat &left, const cv::Mat &right, cv::Mat &anaglyph);
 
+// Conversion of disparity in native (e.g., fixed-point) format to
+// CV_32F; invalid disparities remain negative
+MVL_STEREO_PIPELINE_EXPORT void convertDisparityToFloat (const cv::Mat &disparity, const DisparityFormat &format, cv::Mat &floatDisparity);
+
+// Restricted-range matching: per-tile disparity search ranges are
+// derived from a disparity estimate (e.g., from a coarser pyramid level
+// or from the previous frame), and the method is then run on each tile
+// with its own range. Ranges are stored in a CV_32SC2 matrix with one
+// (minDisparity, numDisparities) element per tile. The estimate is a
+// CV_32F disparity image of arbitrary size, in units of full-resolution
+// disparity; tiles for which the fraction of valid estimates is below
+// given threshold are assigned the full range. Horizontally adjacent
+// tiles are matched together (with the union of their ranges) whenever
+// that reduces the work, since each matched region includes context
+// around the tiles. The search fraction is the work actually performed
+// (pixels times disparities, including the context) relative to the
+// full-range search over the whole image
+MVL_STEREO_PIPELINE_EXPORT void computeTileDisparityRanges (const cv::Mat &estimate, const cv::Size &imageSize, int tileSize, int margin, double minValidFraction, int minDisparity, int numDisparities, cv::Mat &ranges);
+MVL_STEREO_PIPELINE_EXPORT double getTileSearchFraction (const cv::Mat &ranges, const cv::Size &imageSize, int tileSize, int tileBorder, int numDisparities);
+MVL_STEREO_PIPELINE_EXPORT void computeDisparityInTiles (StereoMethod2 *method, const cv::Mat &img1, const cv::Mat &img2, const cv::Mat &ranges, int tileSize, int tileBorder, int minDisparity, cv::Mat &disparity, DisparityFormat &format);
+
+// Per-tile ranges for matching the horizontally flipped and swapped
+// pair (i.e., for right-image disparity), derived from the left-image
+// ones. Right pixel x corresponds to left pixel x + d, so each tile
+// takes the union of ranges of left tiles that its pixels may map to.
+// The result is given in the tile grid of the flipped image
+MVL_STEREO_PIPELINE_EXPORT void computeMirroredTileDisparityRanges (const cv::Mat &ranges, const cv::Size &imageSize, int tileSize, int minDisparity, int numDisparities, cv::Mat &mirroredRanges);
+
+// Left-right consistency check: each valid left disparity is compared
+// against the right disparity (given in right image coordinates) at the
+// matched position. Pixels whose disparities differ by more than given
+// threshold, or whose match is invalid or outside the image, are marked
+// in the invalidation mask (CV_8U, 255 for invalid pixels). Confidence
+// map (CV_32F) decreases linearly from 1 at zero difference to 0 just
+// above the threshold, and is zero for invalid pixels
+MVL_STEREO_PIPELINE_EXPORT void checkLeftRightConsistency (const cv::Mat &disparityLeft, const cv::Mat &disparityRight, const DisparityFormat &format, float maxDifference, cv::Mat &invalidMask, cv::Mat &confidence);
+
+// Parallel speckle filter, equivalent to cv::filterSpeckles(): pixels
+// belonging to 4-connected components of at most maxSpeckleSize pixels
+// are set to newValue, where neighbouring pixels are connected if their
+// (raw) values differ by at most maxDiff. Pixels equal to newValue are
+// treated as invalid. Stripes of rows are labeled in parallel, and
+// their components are merged across stripe borders. Supports CV_8U,
+// CV_16S and CV_32F disparity
+MVL_STEREO_PIPELINE_EXPORT void filterSpeckles (cv::Mat &disparity, double newValue, int maxSpeckleSize, double maxDiff);
+
 // Point-cloud export to PCD file
 MVL_STEREO_PIPELINE_EXPORT void writePointCloudToPcdFile (const cv::Mat &image, const cv::Mat &points, const QString &fileName, bool binary = true);
 
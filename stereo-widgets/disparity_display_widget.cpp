@@ -29,7 +29,9 @@ namespace Widgets {
 
 
 DisparityDisplayWidgetPrivate::DisparityDisplayWidgetPrivate (DisparityDisplayWidget *parent)
-    : ImageDisplayWidgetPrivate(parent)
+    : ImageDisplayWidgetPrivate(parent),
+      disparityScale(1.0),
+      disparityOffset(0.0)
 {
 }
 
@@ -54,11 +56,13 @@ void DisparityDisplayWidget::mouseMoveEvent (QMouseEvent *event)
 }
 
 
-void DisparityDisplayWidget::setDisparity (const cv::Mat &disparity)
+void DisparityDisplayWidget::setDisparity (const cv::Mat &disparity, double scale, double offset)
 {
     Q_D(DisparityDisplayWidget);
 
     disparity.copyTo(d->disparity);
+    d->disparityScale = scale;
+    d->disparityOffset = offset;
     emit disparityUnderMouseChanged(getDisparityAtPixel(mapFromGlobal(QCursor::pos())));
 }
 
@@ -96,13 +100,13 @@ float DisparityDisplayWidget::getDisparityAtPixel (const QPoint &pos)
     if (x >= 0 && y >= 0 && x < d->disparity.cols && y < d->disparity.rows) {
         switch (d->disparity.type()) {
             case CV_8U: {
-                return d->disparity.at<unsigned char>(y, x);
+                return d->disparity.at<unsigned char>(y, x)*d->disparityScale + d->disparityOffset;
             }
             case CV_16S: {
-                return d->disparity.at<short>(y, x);
+                return d->disparity.at<short>(y, x)*d->disparityScale + d->disparityOffset;
             }
             case CV_32F: {
-                return d->disparity.at<float>(y, x);
+                return d->disparity.at<float>(y, x)*d->disparityScale + d->disparityOffset;
             }
             default: {
                 qWarning() << "Unhandled disparity type:" << d->disparity.type() << "!";
@@ -41,7 +41,9 @@ public:
     DisparityDisplayWidget (const QString &text = QString(), QWidget *parent = nullptr);
     virtual ~DisparityDisplayWidget ();
 
-    void setDisparity (const cv::Mat &disparity);
+    // Disparity may be given in its native (e.g., fixed-point) format;
+    // the actual value is computed as raw*scale + offset
+    void setDisparity (const cv::Mat &disparity, double scale = 1.0, double offset = 0.0);
 
 protected:
     virtual void mouseMoveEvent (QMouseEvent *event) override;
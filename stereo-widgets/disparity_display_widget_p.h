@@ -38,6 +38,8 @@ protected:
 
 protected:
     cv::Mat disparity;
+    double disparityScale;
+    double disparityOffset;
 };
 
 
@@ -29,10 +29,33 @@ namespace Widgets {
 
 
 ImagePairDisplayWidgetPrivate::ImagePairDisplayWidgetPrivate (ImagePairDisplayWidget *parent)
-    : ImageDisplayWidgetPrivate(parent), displayPair(true)
+    : ImageDisplayWidgetPrivate(parent), displayPair(true),
+      regionSelection(false),
+      selecting(false)
 {
 }
 
+QPoint ImagePairDisplayWidgetPrivate::mapToLeftImage (const QPoint &position) const
+{
+    Q_Q(const ImagePairDisplayWidget);
+
+    // Same layout as in paintEvent()
+    int w = imageLeft.cols + imageRight.cols;
+    int h = qMax(imageLeft.rows, imageRight.rows);
+
+    double scale = qMin((double)q->width() / w, (double)q->height() / h);
+
+    w *= scale;
+    h *= scale;
+
+    int ih = imageLeft.rows * scale;
+
+    int x = (position.x() - (q->width() - w)/2) / scale;
+    int y = (position.y() - (q->height() - h)/2 - (h - ih)/2) / scale;
+
+    return QPoint(qBound(0, x, imageLeft.cols), qBound(0, y, imageLeft.rows));
+}
+
 
 ImagePairDisplayWidget::ImagePairDisplayWidget (const QString &text, QWidget *parent)
     : ImageDisplayWidget(new ImagePairDisplayWidgetPrivate(this), text, parent)
@@ -58,6 +81,87 @@ void ImagePairDisplayWidget::setImagePairROI (const cv::Rect &roiLeft, const cv:
 }
 
 
+void ImagePairDisplayWidget::setImagePairRegions (const std::vector<cv::Rect> &regions)
+{
+    Q_D(ImagePairDisplayWidget);
+
+    // Store regions
+    d->regions = regions;
+
+    // Refresh
+    update();
+}
+
+
+// *********************************************************************
+// *                    Interactive region selection                   *
+// *********************************************************************
+void ImagePairDisplayWidget::setRegionSelectionEnabled (bool enable)
+{
+    Q_D(ImagePairDisplayWidget);
+
+    d->regionSelection = enable;
+    d->selecting = false;
+
+    setCursor(enable ? Qt::CrossCursor : Qt::ArrowCursor);
+
+    update();
+}
+
+bool ImagePairDisplayWidget::getRegionSelectionEnabled () const
+{
+    Q_D(const ImagePairDisplayWidget);
+    return d->regionSelection;
+}
+
+void ImagePairDisplayWidget::mousePressEvent (QMouseEvent *event)
+{
+    Q_D(ImagePairDisplayWidget);
+
+    if (!d->regionSelection || !d->displayPair || d->imageLeft.empty() || d->imageRight.empty() || event->button() != Qt::LeftButton) {
+        return ImageDisplayWidget::mousePressEvent(event);
+    }
+
+    d->selecting = true;
+    d->selectionStart = d->selectionEnd = d->mapToLeftImage(event->pos());
+
+    update();
+}
+
+void ImagePairDisplayWidget::mouseMoveEvent (QMouseEvent *event)
+{
+    Q_D(ImagePairDisplayWidget);
+
+    if (!d->selecting) {
+        return ImageDisplayWidget::mouseMoveEvent(event);
+    }
+
+    d->selectionEnd = d->mapToLeftImage(event->pos());
+
+    update();
+}
+
+void ImagePairDisplayWidget::mouseReleaseEvent (QMouseEvent *event)
+{
+    Q_D(ImagePairDisplayWidget);
+
+    if (!d->selecting || event->button() != Qt::LeftButton) {
+        return ImageDisplayWidget::mouseReleaseEvent(event);
+    }
+
+    d->selecting = false;
+    d->selectionEnd = d->mapToLeftImage(event->pos());
+
+    // Ignore clicks without actual selection
+    QRect region = QRect(d->selectionStart, d->selectionEnd).normalized();
+    if (region.width() > 1 && region.height() > 1) {
+        emit regionSelected(region);
+    }
+
+    update();
+}
+
+
 void ImagePairDisplayWidget::setImage (const cv::Mat &image)
 {
     Q_D(ImagePairDisplayWidget);
@@ -141,6 +245,18 @@ void ImagePairDisplayWidget::paintEvent (QPaintEvent *event)
             painter.drawRect(d->roiLeft.x*scale, d->roiLeft.y*scale, d->roiLeft.width*scale, d->roiLeft.height*scale);
         }
 
+        // Regions and region being selected
+        painter.setPen(QPen(Qt::yellow, 2));
+        for (const cv::Rect &region : d->regions) {
+            painter.drawRect(region.x*scale, (h - ih)/2 + region.y*scale, region.width*scale, region.height*scale);
+        }
+
+        if (d->selecting) {
+            QRect region = QRect(d->selectionStart, d->selectionEnd).normalized();
+            painter.setPen(QPen(Qt::yellow, 1, Qt::DashLine));
+            painter.drawRect(region.x()*scale, (h - ih)/2 + region.y()*scale, region.width()*scale, region.height()*scale);
+        }
+
         // Move to right image
         painter.translate(iw, 0);
 
@@ -46,8 +46,23 @@ public:
     void setImagePairROI (const cv::Rect &roiLeft, const cv::Rect &roiRight);
     void setImagePair (const cv::Mat &left, const cv::Mat &right);
 
+    // Regions drawn over the left image, in image coordinates
+    void setImagePairRegions (const std::vector<cv::Rect> &regions);
+
+    // Interactive selection of regions by dragging the mouse over the
+    // left image; each selection is reported via regionSelected()
+    void setRegionSelectionEnabled (bool enable);
+    bool getRegionSelectionEnabled () const;
+
 protected:
     virtual void paintEvent (QPaintEvent *event) override;
+
+    virtual void mousePressEvent (QMouseEvent *event) override;
+    virtual void mouseMoveEvent (QMouseEvent *event) override;
+    virtual void mouseReleaseEvent (QMouseEvent *event) override;
+
+signals:
+    void regionSelected (const QRect &region);
 };
 
 
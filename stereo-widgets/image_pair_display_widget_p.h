@@ -36,12 +36,23 @@ class ImagePairDisplayWidgetPrivate : public ImageDisplayWidgetPrivate
 protected:
     ImagePairDisplayWidgetPrivate (ImagePairDisplayWidget *parent);
 
+    // Maps widget position to left image coordinates
+    QPoint mapToLeftImage (const QPoint &position) const;
+
 protected:
     bool displayPair;
 
     cv::Rect roiLeft;
     cv::Rect roiRight;
 
+    std::vector<cv::Rect> regions;
+
+    // Interactive region selection
+    bool regionSelection;
+    bool selecting;
+    QPoint selectionStart;
+    QPoint selectionEnd;
+
     cv::Mat imageLeft;
     cv::Mat imageRight;
 
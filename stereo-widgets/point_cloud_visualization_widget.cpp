@@ -20,6 +20,8 @@
 #include "point_cloud_visualization_widget.h"
 #include "point_cloud_visualization_widget_p.h"
 
+#include <cstring>
+
 
 #ifndef GL_MULTISAMPLE
 #define GL_MULTISAMPLE  0x809D
@@ -442,7 +444,12 @@ void PointCloudVisualizationWidgetPrivate::uploadPointCloud ()
         return;
     }
 
-    if (image.rows != points.rows || image.cols != points.cols) {
+    // Points are either a dense CV_32FC3 image of the same size as the
+    // image, or a compact CV_32FC4 list in which the fourth channel is
+    // the linear index of the corresponding pixel (a 32-bit integer)
+    bool pointList = (points.type() == CV_32FC4);
+
+    if (!pointList && (image.rows != points.rows || image.cols != points.cols)) {
         freshData = false;
         return;
     }
@@ -464,7 +471,38 @@ void PointCloudVisualizationWidgetPrivate::uploadPointCloud ()
     numPoints = 0;
 
     // Fill
-    if (image.channels() == 3) {
+    if (pointList) {
+        // Compact list of valid points
+        const int numPixels = image.rows*image.cols;
+
+        for (int i = 0; i < points.rows*points.cols; i++) {
+            const cv::Vec4f &entry = points.at<cv::Vec4f>(i);
+            int index;
+            std::memcpy(&index, &entry[3], sizeof(index)); // Stored bit-wise as integer
+
+            if (index < 0 || index >= numPixels || !std::isfinite(entry[2])) {
+                continue;
+            }
+
+            *ptr++ = entry[0]/1000.0;
+            *ptr++ = entry[1]/1000.0;
+            *ptr++ = entry[2]/1000.0;
+
+            if (image.channels() == 3) {
+                const cv::Vec3b &bgr = image.at<cv::Vec3b>(index / image.cols, index % image.cols);
+                *ptr++ = bgr[2]/255.0f;
+                *ptr++ = bgr[1]/255.0f;
+                *ptr++ = bgr[0]/255.0f;
+            } else {
+                const unsigned char &gray = image.at<unsigned char>(index / image.cols, index % image.cols);
+                *ptr++ = gray/255.0f;
+                *ptr++ = gray/255.0f;
+                *ptr++ = gray/255.0f;
+            }
+
+            numPoints++;
+        }
+    } else if (image.channels() == 3) {
         // Three-channel (BGR) image
         for (int y = 0; y < image.rows; y++) {
             const cv::Vec3b *imagePtr = image.ptr<cv::Vec3b>(y);
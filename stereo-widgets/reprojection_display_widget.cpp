@@ -20,12 +20,25 @@
 #include "reprojection_display_widget.h"
 #include "reprojection_display_widget_p.h"
 
+#include <algorithm>
+#include <cstring>
+
 
 namespace MVL {
 namespace StereoToolbox {
 namespace Widgets {
 
 
+// Pixel index of point list entry; stored bit-wise as a 32-bit integer
+// in the fourth channel (see Pipeline::Reprojection::OutputPointList)
+static inline int getPointIndex (const cv::Vec4f &point)
+{
+    int index;
+    std::memcpy(&index, &point[3], sizeof(index));
+    return index;
+}
+
+
 ReprojectionDisplayWidgetPrivate::ReprojectionDisplayWidgetPrivate (ReprojectionDisplayWidget *parent)
     : ImageDisplayWidgetPrivate(parent)
 {
@@ -69,15 +82,17 @@ QVector3D ReprojectionDisplayWidget::getCoordinatesAtPixel (const QPoint &pos)
         return QVector3D();
     }
 
-    // Validate dimensions
-    if (d->image.cols != d->points.cols || d->image.rows != d->points.rows) {
+    // Validate dimensions; compact point lists (CV_32FC4) are looked
+    // up via pixel index, so only dense points need to match the image
+    bool pointList = (d->points.type() == CV_32FC4);
+    if (!pointList && (d->image.cols != d->points.cols || d->image.rows != d->points.rows)) {
         return QVector3D();
     }
 
     // This part is same as in base class's display... it computes
     // display scaling and vertical/horizontal offsets
-    int w = d->points.cols;
-    int h = d->points.rows;
+    int w = d->image.cols;
+    int h = d->image.rows;
 
     double scale = qMin((double)width() / w, (double)height() / h);
 
@@ -90,9 +105,44 @@ QVector3D ReprojectionDisplayWidget::getCoordinatesAtPixel (const QPoint &pos)
     int x = round(xd / scale);
     int y = round(yd / scale);
 
-    if (x >= 0 && y >= 0 && x < d->points.cols && y < d->points.rows) {
-        const cv::Vec3f &entry = d->points.at<cv::Vec3f>(y, x);
-        return QVector3D(entry[0], entry[1], entry[2]);
+    if (x < 0 || y < 0 || x >= d->image.cols || y >= d->image.rows) {
+        return QVector3D();
+    }
+
+    if (pointList) {
+        // Point lists are ordered by pixel index, so we can do a
+        // binary search
+        const cv::Vec4f *begin = d->points.ptr<cv::Vec4f>();
+        const cv::Vec4f *end = begin + d->points.rows*d->points.cols;
+        int index = y*d->image.cols + x;
+
+        const cv::Vec4f *entry = std::lower_bound(begin, end, index, [] (const cv::Vec4f &point, int value) {
+            return getPointIndex(point) < value;
+        });
+
+        if (entry != end && getPointIndex(*entry) == index) {
+            return QVector3D((*entry)[0], (*entry)[1], (*entry)[2]);
+        }
+    } else {
+        // Dense output; depth-only types yield only the Z coordinate
+        switch (d->points.type()) {
+            case CV_32FC3: {
+                const cv::Vec3f &entry = d->points.at<cv::Vec3f>(y, x);
+                return QVector3D(entry[0], entry[1], entry[2]);
+            }
+            case CV_16SC3: {
+                cv::Mat entry;
+                cv::convertFp16(d->points(cv::Rect(x, y, 1, 1)), entry);
+                const cv::Vec3f &xyz = entry.at<cv::Vec3f>(0, 0);
+                return QVector3D(xyz[0], xyz[1], xyz[2]);
+            }
+            case CV_32FC1: {
+                return QVector3D(0, 0, d->points.at<float>(y, x));
+            }
+            case CV_16UC1: {
+                return QVector3D(0, 0, d->points.at<unsigned short>(y, x));
+            }
+        }
     }
 
     return QVector3D();
@@ -46,6 +46,7 @@ public:
 protected:
     virtual void mouseMoveEvent (QMouseEvent *event) override;
 
+    // For depth-only points, only Z coordinate is valid
     QVector3D getCoordinatesAtPixel (const QPoint &pos);
 
 signals:
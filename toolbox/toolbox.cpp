@@ -281,33 +281,23 @@ void Toolbox::clearError ()
 // *********************************************************************
 void Toolbox::loadPlugins ()
 {
+    // Only plugins are sorted here; windows create objects on demand,
+    // so that plugin libraries are loaded only when actually used
     for (QObject *plugin : plugin_manager->getAvailablePlugins()) {
         Pipeline::PluginFactory *factory = qobject_cast<Pipeline::PluginFactory *>(plugin);
-        QObject *object = nullptr;
 
-        // Create object
-        try {
-            object = factory->createObject(this);
-        } catch (...) {
-            continue;
-        }
-
-        // Insert object into corresponding list
-        if (object) {
-            switch (factory->getPluginType()) {
-                case Pipeline::PluginFactory::PluginStereoMethod: {
-                    stereoMethods.append(object);
-                    break;
-                }
-                case Pipeline::PluginFactory::PluginImagePairSource: {
-                    imagePairSources.append(object);
-                    break;
-                }
-                default: {
-                    // Unhandled object; delete it
-                    object->deleteLater();
-                    break;
-                }
+        switch (factory->getPluginType()) {
+            case Pipeline::PluginFactory::PluginStereoMethod: {
+                stereoMethods.append(plugin);
+                break;
+            }
+            case Pipeline::PluginFactory::PluginImagePairSource: {
+                imagePairSources.append(plugin);
+                break;
+            }
+            default: {
+                // Unhandled plugin type
+                break;
             }
         }
     }
@@ -83,8 +83,8 @@ protected:
     Pipeline::Pipeline *pipeline;
 
     Pipeline::PluginManager *plugin_manager;
-    QList<QObject *> imagePairSources;
-    QList<QObject *> stereoMethods;
+    QList<QObject *> imagePairSources; // Plugins
+    QList<QObject *> stereoMethods; // Plugins
 };
 
 
@@ -20,6 +20,7 @@
 #include "window_image_pair_source.h"
 
 #include <stereo-pipeline/pipeline.h>
+#include <stereo-pipeline/plugin_factory.h>
 #include <stereo-pipeline/image_pair_source.h>
 #include <stereo-pipeline/utils.h>
 #include <stereo-widgets/image_display_widget.h>
@@ -33,10 +34,10 @@ namespace StereoToolbox {
 namespace GUI {
 
 
-WindowImagePairSource::WindowImagePairSource (Pipeline::Pipeline *pipeline, QList<QObject *> &sources, QWidget *parent)
+WindowImagePairSource::WindowImagePairSource (Pipeline::Pipeline *pipeline, QList<QObject *> &plugins, QWidget *parent)
     : QWidget(parent, Qt::Window),
       pipeline(pipeline),
-      sources(sources),
+      plugins(plugins),
       leftInfo({ false, 0, 0, 0 }),
       rightInfo({ false, 0, 0, 0 }),
       numDroppedFrames(0),
@@ -141,10 +142,17 @@ WindowImagePairSource::WindowImagePairSource (Pipeline::Pipeline *pipeline, QLis
         updateStatusBar();
     });
 
-    // Create config tabs
-    for (QObject *sourceObject : sources) {
-        Pipeline::ImagePairSource *source = qobject_cast<Pipeline::ImagePairSource * >(sourceObject);
-        tabWidget->addTab(source->createConfigWidget(this), source->getShortName());
+    // Create config tabs; pages are populated once the source is created
+    for (QObject *plugin : plugins) {
+        Pipeline::PluginFactory *factory = qobject_cast<Pipeline::PluginFactory *>(plugin);
+
+        QWidget *page = new QWidget(this);
+        QVBoxLayout *pageLayout = new QVBoxLayout(page);
+        pageLayout->setContentsMargins(0, 0, 0, 0);
+
+        sources.append(nullptr);
+        configPages.append(page);
+        tabWidget->addTab(page, factory->getShortName());
     }
 
     // Method selection
@@ -210,7 +218,50 @@ void WindowImagePairSource::setSource (int idx)
         return;
     }
 
-    pipeline->setImagePairSource(sources[idx]);
+    QObject *source = getSource(idx);
+    if (!source) {
+        return; // Error is shown on source's page
+    }
+
+    pipeline->setImagePairSource(source);
+}
+
+QObject *WindowImagePairSource::getSource (int idx)
+{
+    // Already created (or failed to)
+    if (configPages[idx]->layout()->count()) {
+        return sources[idx];
+    }
+
+    Pipeline::PluginFactory *factory = qobject_cast<Pipeline::PluginFactory *>(plugins[idx]);
+    QString message;
+
+    // Sources are owned by the pipeline, which outlives this window
+    try {
+        sources[idx] = factory->createObject(pipeline);
+    } catch (const std::exception &e) {
+        message = QString::fromStdString(e.what());
+    } catch (...) {
+        message = "Unhandled exception type!";
+    }
+
+    Pipeline::ImagePairSource *source = qobject_cast<Pipeline::ImagePairSource *>(sources[idx]);
+    if (source) {
+        configPages[idx]->layout()->addWidget(source->createConfigWidget(configPages[idx]));
+    } else {
+        if (sources[idx]) {
+            delete sources[idx];
+            sources[idx] = nullptr;
+            message = "Plugin does not provide an image pair source!";
+        }
+
+        QLabel *label = new QLabel(QString("Failed to create source:\n%1").arg(message), configPages[idx]);
+        label->setAlignment(Qt::AlignCenter);
+        label->setWordWrap(true);
+        configPages[idx]->layout()->addWidget(label);
+    }
+
+    return sources[idx];
 }
 
 
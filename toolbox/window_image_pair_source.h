@@ -43,11 +43,12 @@ class WindowImagePairSource : public QWidget
     Q_OBJECT
 
 public:
-    WindowImagePairSource (Pipeline::Pipeline *pipeline, QList<QObject *> &sources, QWidget *parent = nullptr);
+    WindowImagePairSource (Pipeline::Pipeline *pipeline, QList<QObject *> &plugins, QWidget *parent = nullptr);
     virtual ~WindowImagePairSource ();
 
 protected:
     void setSource (int idx);
+    QObject *getSource (int idx);
 
     void saveImages ();
     void snapshotImages ();
@@ -59,7 +60,13 @@ protected:
 protected:
     // Pipeline
     Pipeline::Pipeline *pipeline;
+    QList<QObject *> plugins;
+
+    // Sources are created (and their plugins loaded) on first use; the
+    // corresponding config page is populated with source's config
+    // widget, or with the error message if creation failed
     QList<QObject *> sources;
+    QList<QWidget *> configPages;
 
     struct {
         bool valid;
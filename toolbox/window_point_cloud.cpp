@@ -20,6 +20,8 @@
 #include "window_point_cloud.h"
 
 #include <stereo-pipeline/pipeline.h>
+#include <stereo-pipeline/point_cloud_filter.h>
+#include <stereo-pipeline/reprojection.h>
 #include <stereo-pipeline/utils.h>
 #include <stereo-widgets/point_cloud_visualization_widget.h>
 
@@ -56,10 +58,69 @@ WindowPointCloud::WindowPointCloud (Pipeline::Pipeline *pipeline, QWidget *paren
 
     buttonsLayout->addStretch();
 
+    // Point-cloud filter
+    Pipeline::PointCloudFilter *filter = pipeline->getPointCloudFilter();
+
+    checkBoxFilter = new QCheckBox("Filter", this);
+    checkBoxFilter->setToolTip("Crop and decimate the point cloud.");
+    checkBoxFilter->setChecked(pipeline->getPointCloudFilterState());
+    connect(checkBoxFilter, &QCheckBox::toggled, pipeline, &Pipeline::Pipeline::setPointCloudFilterState);
+    connect(pipeline, &Pipeline::Pipeline::pointCloudFilterStateChanged, this, [this] (bool active) {
+        checkBoxFilter->blockSignals(true);
+        checkBoxFilter->setChecked(active);
+        checkBoxFilter->blockSignals(false);
+
+        updatePoints();
+    });
+    buttonsLayout->addWidget(checkBoxFilter);
+
+    comboBoxDecimation = new QComboBox(this);
+    comboBoxDecimation->setToolTip("Point-cloud decimation method.");
+    comboBoxDecimation->addItem("No decimation", Pipeline::PointCloudFilter::DecimationNone);
+    comboBoxDecimation->addItem("Stride", Pipeline::PointCloudFilter::DecimationStride);
+    comboBoxDecimation->addItem("Voxel grid", Pipeline::PointCloudFilter::DecimationVoxelGrid);
+    comboBoxDecimation->setCurrentIndex(comboBoxDecimation->findData(filter->getDecimationMethod()));
+    connect(comboBoxDecimation, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), filter, [this, filter] (int index) {
+        filter->setDecimationMethod(comboBoxDecimation->itemData(index).toInt());
+    });
+    buttonsLayout->addWidget(comboBoxDecimation);
+
+    spinBoxVoxelSize = new QDoubleSpinBox(this);
+    spinBoxVoxelSize->setToolTip("Voxel size for voxel-grid decimation.");
+    spinBoxVoxelSize->setRange(0.1, 10000.0);
+    spinBoxVoxelSize->setDecimals(1);
+    spinBoxVoxelSize->setSuffix(" mm");
+    spinBoxVoxelSize->setValue(filter->getVoxelSize());
+    connect(spinBoxVoxelSize, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), filter, &Pipeline::PointCloudFilter::setVoxelSize);
+    buttonsLayout->addWidget(spinBoxVoxelSize);
+
+    spinBoxFarDistance = new QDoubleSpinBox(this);
+    spinBoxFarDistance->setToolTip("Maximum distance of points; 0 disables the limit.");
+    spinBoxFarDistance->setRange(0.0, 1000000.0);
+    spinBoxFarDistance->setDecimals(0);
+    spinBoxFarDistance->setSuffix(" mm");
+    spinBoxFarDistance->setSpecialValueText("No far limit");
+    spinBoxFarDistance->setValue(filter->getFarDistance());
+    connect(spinBoxFarDistance, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), filter, &Pipeline::PointCloudFilter::setFarDistance);
+    buttonsLayout->addWidget(spinBoxFarDistance);
+
+    spinBoxMaxPoints = new QSpinBox(this);
+    spinBoxMaxPoints->setToolTip("Upper bound on number of points; 0 disables the limit.");
+    spinBoxMaxPoints->setRange(0, 100000000);
+    spinBoxMaxPoints->setSingleStep(10000);
+    spinBoxMaxPoints->setSpecialValueText("No limit");
+    spinBoxMaxPoints->setValue(filter->getMaxPoints());
+    connect(spinBoxMaxPoints, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), filter, &Pipeline::PointCloudFilter::setMaxPoints);
+    buttonsLayout->addWidget(spinBoxMaxPoints);
+
     // Point cloud visualization widget
     visualizationWidget = new Widgets::PointCloudVisualizationWidget(this);
     layout->addWidget(visualizationWidget);
 
+    // Status bar
+    statusBar = new QStatusBar(this);
+    layout->addWidget(statusBar);
+
     // In case of a continuous video stream, this assumes that the
     // framerate is high enough that receiving a newer image before
     // the point cloud is computed does not cause noticeable artifacts...
@@ -69,8 +130,14 @@ WindowPointCloud::WindowPointCloud (Pipeline::Pipeline *pipeline, QWidget *paren
     });
 
     connect(pipeline, &Pipeline::Pipeline::pointsChanged, this, [this] () {
-        cv::Mat points = this->pipeline->getPoints();
-        visualizationWidget->setPoints(points);
+        if (!this->pipeline->getPointCloudFilterState()) {
+            updatePoints();
+        }
+    });
+    connect(pipeline, &Pipeline::Pipeline::pointCloudChanged, this, [this] () {
+        if (this->pipeline->getPointCloudFilterState()) {
+            updatePoints();
+        }
     });
 }
 
@@ -79,10 +146,49 @@ WindowPointCloud::~WindowPointCloud ()
 }
 
 
+cv::Mat WindowPointCloud::getCurrentPoints () const
+{
+    // Filtered point cloud is already in compact point-list format
+    if (pipeline->getPointCloudFilterState()) {
+        return pipeline->getPointCloud();
+    }
+
+    // Expand depth-only and reduced-precision outputs
+    cv::Mat points;
+    cv::Point offset;
+    pipeline->getPoints(points, offset);
+    pipeline->getReprojection()->convertToPoints(points, points, offset.x, offset.y);
+
+    return points;
+}
+
+void WindowPointCloud::updatePoints ()
+{
+    // Errors are shown in the status bar; a message box for every frame
+    // would be too intrusive
+    cv::Mat points;
+    try {
+        points = getCurrentPoints();
+        statusBar->clearMessage();
+    } catch (const std::exception &e) {
+        statusBar->showMessage(QStringLiteral("Failed to obtain point cloud: %1").arg(QString::fromStdString(e.what())));
+    } catch (...) {
+        statusBar->showMessage(QStringLiteral("Failed to obtain point cloud: unhandled exception type!"));
+    }
+    visualizationWidget->setPoints(points);
+}
+
+
 void WindowPointCloud::savePointCloud ()
 {
     // Create a snapshot of current point cloud
-    cv::Mat points = pipeline->getPoints();
+    cv::Mat points;
+    try {
+        points = getCurrentPoints();
+    } catch (const std::exception &e) {
+        QMessageBox::warning(this, "Error", QStringLiteral("Failed to obtain point cloud: %1").arg(QString::fromStdString(e.what())));
+        return;
+    }
     cv::Mat image = pipeline->getLeftRectifiedImage();
 
     // Make sure images are actually available
@@ -21,6 +21,7 @@
 #define MVL_STEREO_TOOLBOX__TOOLBOX__WINDOW_POINT_CLOUD_H
 
 #include <QtWidgets>
+#include <opencv2/core.hpp>
 
 
 namespace MVL {
@@ -50,6 +51,11 @@ public:
 protected:
     void savePointCloud ();
 
+    // Returns filtered point cloud if filter is active, and reprojected
+    // points otherwise
+    cv::Mat getCurrentPoints () const;
+    void updatePoints ();
+
 protected:
     // Pipeline
     Pipeline::Pipeline *pipeline;
@@ -59,6 +65,14 @@ protected:
 
     QPushButton *pushButtonSavePointCloud;
 
+    QCheckBox *checkBoxFilter;
+    QComboBox *comboBoxDecimation;
+    QDoubleSpinBox *spinBoxVoxelSize;
+    QDoubleSpinBox *spinBoxFarDistance;
+    QSpinBox *spinBoxMaxPoints;
+
+    QStatusBar *statusBar;
+
     QString lastSavedFile;
 };
 
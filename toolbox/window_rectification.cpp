@@ -52,6 +52,7 @@ WindowRectification::WindowRectification (Pipeline::Pipeline *pipeline, QWidget
     QGridLayout *buttonsLayout = new QGridLayout();
     buttonsLayout->setContentsMargins(0, 0, 0, 0);
     QPushButton *pushButton;
+    QHBoxLayout *box;
 
     layout->addLayout(buttonsLayout, 0, 0, 1, 2);
 
@@ -90,11 +91,33 @@ WindowRectification::WindowRectification (Pipeline::Pipeline *pipeline, QWidget
     buttonsLayout->addWidget(pushButton, 0, 3, 1, 1);
     pushButtonRectificationSettings = pushButton;
 
+    // Regions of interest
+    box = new QHBoxLayout();
+    box->setContentsMargins(0, 0, 0, 0);
+    box->setSpacing(2);
+    buttonsLayout->addLayout(box, 1, 3, 1, 1);
+
+    pushButton = new QPushButton("Select ROI");
+    pushButton->setToolTip("Select regions of interest by dragging the mouse over the left rectified image. Only these regions\n"
+                           "(extended by the disparity margin) are rectified and processed by the stereo method.");
+    pushButton->setCheckable(true);
+    connect(pushButton, &QPushButton::toggled, this, [this] (bool checked) {
+        displayPair->setRegionSelectionEnabled(checked);
+    });
+    box->addWidget(pushButton);
+    pushButtonSelectRegions = pushButton;
+
+    pushButton = new QPushButton("Clear ROI");
+    pushButton->setToolTip("Clear regions of interest and process whole images.");
+    connect(pushButton, &QPushButton::clicked, pipeline, &Pipeline::Pipeline::clearRegionsOfInterest);
+    box->addWidget(pushButton);
+    pushButtonClearRegions = pushButton;
+
     // Spacer
     buttonsLayout->addItem(new QSpacerItem(100, 100, QSizePolicy::Expanding, QSizePolicy::Expanding), 0, 4, 2, 1);
 
     // Visualization type
-    QHBoxLayout *box = new QHBoxLayout();
+    box = new QHBoxLayout();
     box->setContentsMargins(0, 0, 0, 0);
     box->setSpacing(2);
     buttonsLayout->addLayout(box, 0, 5, 1, 1);
@@ -126,6 +149,8 @@ WindowRectification::WindowRectification (Pipeline::Pipeline *pipeline, QWidget
     displayPair->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     layout->addWidget(displayPair, 1, 0);
 
+    connect(displayPair, &Widgets::ImagePairDisplayWidget::regionSelected, this, &WindowRectification::addRegionOfInterest);
+
     // Status bar
     statusBar = new QStatusBar(this);
     layout->addWidget(statusBar, 2, 0, 1, 2);
@@ -140,6 +165,7 @@ WindowRectification::WindowRectification (Pipeline::Pipeline *pipeline, QWidget
 
     // Pipeline
     connect(pipeline, &Pipeline::Pipeline::rectifiedImagesChanged, this, &WindowRectification::updateImage);
+    connect(pipeline, &Pipeline::Pipeline::regionsOfInterestChanged, this, &WindowRectification::updateButtonsState);
 
     // Rectification settings dialog
     dialogSettings = new RectificationSettingsDialog(this);
@@ -207,7 +233,15 @@ void WindowRectification::updateImage ()
     int visualizationType = comboBoxVisualizationMethod->itemData(comboBoxVisualizationMethod->currentIndex()).toInt();
 
     if (visualizationType == VisualizationImagePair) {
-        // Image pair
+        // Image pair, with regions of interest relative to the
+        // displayed area
+        cv::Point offset = pipeline->getRectifiedImageBounds().tl();
+        std::vector<cv::Rect> regions = pipeline->getRegionsOfInterest();
+        for (cv::Rect &region : regions) {
+            region -= offset;
+        }
+
+        displayPair->setImagePairRegions(regions);
         displayPair->setImagePair(imageL, imageR);
     } else if (visualizationType == VisualizationAnaglyph) {
         // Anaglyph
@@ -229,6 +263,23 @@ void WindowRectification::updateButtonsState ()
         pushButtonClear->setEnabled(false);
         pushButtonExport->setEnabled(false);
     }
+
+    pushButtonClearRegions->setEnabled(!pipeline->getRegionsOfInterest().empty());
+}
+
+
+// *********************************************************************
+// *                        Regions of interest                        *
+// *********************************************************************
+void WindowRectification::addRegionOfInterest (const QRect &region)
+{
+    // Selection is made on displayed images, which cover only the
+    // bounding box of current regions
+    cv::Point offset = pipeline->getRectifiedImageBounds().tl();
+
+    std::vector<cv::Rect> regions = pipeline->getRegionsOfInterest();
+    regions.push_back(cv::Rect(region.x() + offset.x, region.y() + offset.y, region.width(), region.height()));
+    pipeline->setRegionsOfInterest(regions);
 }
 
 
@@ -65,6 +65,8 @@ protected:
 
     void saveImages ();
 
+    void addRegionOfInterest (const QRect &region);
+
     void updateImage ();
     void updateStatusBar ();
     void updateButtonsState ();
@@ -84,6 +86,8 @@ protected:
     QPushButton *pushButtonClear;
     QPushButton *pushButtonRectificationSettings;
     QPushButton *pushButtonSaveImages;
+    QPushButton *pushButtonSelectRegions;
+    QPushButton *pushButtonClearRegions;
 
     QComboBox *comboBoxVisualizationMethod;
 
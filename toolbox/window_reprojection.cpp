@@ -121,7 +121,35 @@ WindowReprojection::WindowReprojection (Pipeline::Pipeline *pipeline, QWidget *p
     });
 
     fillReprojectionMethods();
-    comboBoxReprojectionMethod->setCurrentIndex(reprojection->getReprojectionMethod());
+    comboBoxReprojectionMethod->setCurrentIndex(comboBoxReprojectionMethod->findData(reprojection->getReprojectionMethod()));
+
+    buttonsLayout->addStretch();
+
+    // Output type
+    box = new QHBoxLayout();
+    box->setContentsMargins(0, 0, 0, 0);
+    box->setSpacing(2);
+    buttonsLayout->addLayout(box);
+
+    label = new QLabel("Output: ", this);
+    label->setToolTip("Format of reprojected points.");
+    box->addWidget(label);
+
+    comboBox = new QComboBox(this);
+    box->addWidget(comboBox);
+    comboBoxOutputType = comboBox;
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this] (int index) {
+        reprojection->setOutputType(comboBoxOutputType->itemData(index).toInt());
+    });
+    connect(reprojection, &Pipeline::Reprojection::outputTypeChanged, this, [this] (int type) {
+        comboBoxOutputType->blockSignals(true);
+        comboBoxOutputType->setCurrentIndex(comboBoxOutputType->findData(type));
+        comboBoxOutputType->blockSignals(false);
+    });
+
+    fillOutputTypes();
+    comboBoxOutputType->setCurrentIndex(comboBoxOutputType->findData(reprojection->getOutputType()));
 
     buttonsLayout->addStretch();
 
@@ -141,8 +169,11 @@ WindowReprojection::WindowReprojection (Pipeline::Pipeline *pipeline, QWidget *p
     layout->addWidget(displayReprojectedImage);
 
     connect(displayReprojectedImage, &Widgets::ReprojectionDisplayWidget::coordinatesUnderMouseChanged, this, [this] (const QVector3D coordinates) {
+        int outputType = reprojection->getOutputType();
         if (coordinates.isNull()) {
             labelCoordinates->setText("");
+        } else if (outputType == Pipeline::Reprojection::OutputDepth || outputType == Pipeline::Reprojection::OutputDepthMillimeters) {
+            labelCoordinates->setText(QString("Z: %1").arg(coordinates.z()/1000, 0, 'f', 2));
         } else {
             labelCoordinates->setText(QString("XYZ: %1, %2, %3").arg(coordinates.x()/1000, 0, 'f', 2).arg(coordinates.y()/1000, 0, 'f', 2).arg(coordinates.z()/1000, 0, 'f', 2));
         }
@@ -239,6 +270,7 @@ void WindowReprojection::fillReprojectionMethods ()
         const char *text;
         const char *tooltip;
     } methods[] = {
+        { Pipeline::Reprojection::MethodToolboxCpu, "Toolbox CPU", "Multi-threaded, vectorized CPU method with cached ray tables." },
         { Pipeline::Reprojection::MethodOpenCvCpu, "OpenCV CPU", "Stock OpenCV CPU method." },
         { Pipeline::Reprojection::MethodOpenCvCuda, "OpenCV CUDA", "Stock OpenCV CUDA method." },
     };
@@ -255,6 +287,27 @@ void WindowReprojection::fillReprojectionMethods ()
 }
 
 
+void WindowReprojection::fillOutputTypes ()
+{
+    static const struct {
+        int id;
+        const char *text;
+        const char *tooltip;
+    } types[] = {
+        { Pipeline::Reprojection::OutputPoints, "Points", "Dense image of 3-D points (CV_32FC3); invalid points are set to NaN." },
+        { Pipeline::Reprojection::OutputPointList, "Point list", "Compact list of valid 3-D points and their pixel indices (CV_32FC4)." },
+        { Pipeline::Reprojection::OutputPointsHalf, "Points (half)", "Dense image of half-precision 3-D points (CV_16SC3)." },
+        { Pipeline::Reprojection::OutputDepth, "Depth", "Dense depth image (CV_32FC1); invalid depths are set to NaN." },
+        { Pipeline::Reprojection::OutputDepthMillimeters, "Depth (mm)", "Dense 16-bit depth image in millimeters (CV_16UC1); invalid depths are set to 0." },
+    };
+
+    for (unsigned int i = 0; i < sizeof(types)/sizeof(types[0]); i++) {
+        comboBoxOutputType->addItem(types[i].text, types[i].id);
+        comboBoxOutputType->setItemData(i, types[i].tooltip, Qt::ToolTipRole);
+    }
+}
+
+
 // *********************************************************************
 // *                     Save reprojection result                      *
 // *********************************************************************
@@ -50,6 +50,7 @@ protected:
     void saveReprojectionResult ();
 
     void fillReprojectionMethods ();
+    void fillOutputTypes ();
 
     void updateStatusBar ();
 
@@ -69,6 +70,7 @@ protected:
     // GUI
     QComboBox *comboBoxImage;
     QComboBox *comboBoxReprojectionMethod;
+    QComboBox *comboBoxOutputType;
     QPushButton *pushButtonSaveReprojection;
 
     Widgets::ReprojectionDisplayWidget *displayReprojectedImage;
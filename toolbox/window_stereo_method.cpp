@@ -20,6 +20,7 @@
 #include "window_stereo_method.h"
 
 #include <stereo-pipeline/pipeline.h>
+#include <stereo-pipeline/plugin_factory.h>
 #include <stereo-pipeline/stereo_method.h>
 #include <stereo-pipeline/disparity_visualization.h>
 #include <stereo-pipeline/utils.h>
@@ -34,10 +35,10 @@ namespace StereoToolbox {
 namespace GUI {
 
 
-WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObject *> &methods, QWidget *parent)
+WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObject *> &plugins, QWidget *parent)
     : QWidget(parent, Qt::Window),
       pipeline(pipeline),
-      methods(methods),
+      plugins(plugins),
       visualization(pipeline->getVisualization()),
       disparityInfo({ false, 0, 0, 0 }),
       numDroppedFrames(0),
@@ -111,6 +112,28 @@ WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObj
     fillVisualizationMethods();
     visualization->setVisualizationMethod(Pipeline::DisparityVisualization::MethodGrayscale); // Set grayscale as default
 
+    // Color map (CPU color visualization)
+    comboBox = new QComboBox(this);
+    comboBox->setToolTip("Color map for CPU color visualization");
+    box->addWidget(comboBox);
+    comboBoxColormap = comboBox;
+
+    connect(comboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this] (int index) {
+        visualization->setColormap(comboBoxColormap->itemData(index).toInt());
+    });
+    connect(visualization, &Pipeline::DisparityVisualization::colormapChanged, this, [this] (int colormap) {
+        comboBoxColormap->blockSignals(true);
+        comboBoxColormap->setCurrentIndex(comboBoxColormap->findData(colormap));
+        comboBoxColormap->blockSignals(false);
+    });
+    connect(visualization, &Pipeline::DisparityVisualization::visualizationMethodChanged, this, [this] (int method) {
+        comboBoxColormap->setEnabled(method == Pipeline::DisparityVisualization::MethodColorCpu);
+    });
+
+    fillColormaps();
+    comboBoxColormap->setCurrentIndex(comboBoxColormap->findData(visualization->getColormap()));
+    comboBoxColormap->setEnabled(visualization->getVisualizationMethod() == Pipeline::DisparityVisualization::MethodColorCpu);
+
     buttonsLayout->addStretch();
 
     // Splitter - disparity image and methods
@@ -146,14 +169,59 @@ WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObj
     labelDisparity = new QLabel(statusBar);
     statusBar->addPermanentWidget(labelDisparity);
 
-    // Create config tabs
+    // Temporal prediction
+    checkBoxTemporalPrediction = new QCheckBox("Temporal prediction", statusBar);
+    checkBoxTemporalPrediction->setToolTip("Restrict the disparity search to ranges predicted from previous frame.\n"
+                                           "Full search is performed on scene cuts and periodic key frames. Requires\n"
+                                           "a method that supports restricted disparity search range.");
+    checkBoxTemporalPrediction->setChecked(pipeline->getStereoMethodTemporalPrediction());
+    connect(checkBoxTemporalPrediction, &QCheckBox::toggled, pipeline, &Pipeline::Pipeline::setStereoMethodTemporalPrediction);
+    connect(pipeline, &Pipeline::Pipeline::stereoMethodTemporalPredictionChanged, checkBoxTemporalPrediction, &QCheckBox::setChecked);
+    statusBar->addPermanentWidget(checkBoxTemporalPrediction);
+
+    // Band-parallel execution
+    checkBoxBandParallel = new QCheckBox("Band-parallel", statusBar);
+    checkBoxBandParallel->setToolTip("Split the image pair into overlapping horizontal bands, and process them in parallel\n"
+                                     "using separate instances of the method. Requires a method that supports band-parallel\n"
+                                     "execution (e.g., single-threaded methods such as ELAS).");
+    checkBoxBandParallel->setChecked(pipeline->getStereoMethodBandParallel());
+    connect(checkBoxBandParallel, &QCheckBox::toggled, pipeline, &Pipeline::Pipeline::setStereoMethodBandParallel);
+    connect(pipeline, &Pipeline::Pipeline::stereoMethodBandParallelChanged, checkBoxBandParallel, &QCheckBox::setChecked);
+    statusBar->addPermanentWidget(checkBoxBandParallel);
+
+    // Left-right consistency check
+    checkBoxConsistencyCheck = new QCheckBox("LR check", statusBar);
+    checkBoxConsistencyCheck->setToolTip("Invalidate pixels whose left and right disparities are inconsistent. Right disparity\n"
+                                         "is provided by the method, or computed by matching the flipped image pair.");
+    checkBoxConsistencyCheck->setChecked(pipeline->getStereoMethodConsistencyCheck());
+    connect(checkBoxConsistencyCheck, &QCheckBox::toggled, pipeline, &Pipeline::Pipeline::setStereoMethodConsistencyCheck);
+    connect(pipeline, &Pipeline::Pipeline::stereoMethodConsistencyCheckChanged, checkBoxConsistencyCheck, &QCheckBox::setChecked);
+    statusBar->addPermanentWidget(checkBoxConsistencyCheck);
+
+    // Disparity post-filter
+    checkBoxDisparityFilter = new QCheckBox("Post-filter", statusBar);
+    checkBoxDisparityFilter->setToolTip("Apply edge-aware filtering to the disparity, using the left rectified image as guide.\n"
+                                        "Filtered disparity is used for visualization and reprojection.");
+    checkBoxDisparityFilter->setChecked(pipeline->getDisparityFilterState());
+    connect(checkBoxDisparityFilter, &QCheckBox::toggled, pipeline, &Pipeline::Pipeline::setDisparityFilterState);
+    connect(pipeline, &Pipeline::Pipeline::disparityFilterStateChanged, checkBoxDisparityFilter, &QCheckBox::setChecked);
+    statusBar->addPermanentWidget(checkBoxDisparityFilter);
+
+    // Create config tabs; pages are populated once the method is created
     int defaultMethodIdx = 0;
-    for (int i = 0; i < methods.size(); i++) {
-        Pipeline::StereoMethod *method = qobject_cast<Pipeline::StereoMethod * >(methods[i]);
-        tabWidget->addTab(method->createConfigWidget(this), method->getShortName());
+    for (int i = 0; i < plugins.size(); i++) {
+        Pipeline::PluginFactory *factory = qobject_cast<Pipeline::PluginFactory *>(plugins[i]);
+
+        QWidget *page = new QWidget(this);
+        QVBoxLayout *pageLayout = new QVBoxLayout(page);
+        pageLayout->setContentsMargins(0, 0, 0, 0);
+
+        methods.append(nullptr);
+        configPages.append(page);
+        tabWidget->addTab(page, factory->getShortName());
 
         // Set BM as default method
-        if (method->getShortName() == "BM") {
+        if (factory->getShortName() == "BM") {
             defaultMethodIdx = i;
         }
     }
@@ -171,10 +239,13 @@ WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObj
     });
 
     connect(pipeline, &Pipeline::Pipeline::disparityChanged, this, [this] () {
-        cv::Mat disparity = this->pipeline->getDisparity();
+        cv::Mat disparity;
+        int numDisparityLevels;
+        Pipeline::DisparityFormat format;
+        this->pipeline->getDisparity(disparity, numDisparityLevels, format);
 
-        // Disparity
-        displayDisparityImage->setDisparity(disparity);
+        // Disparity (in its native format)
+        displayDisparityImage->setDisparity(disparity, format.scale, format.offset);
 
         // If image is valid, update info for status bar
         if (!disparity.empty()) {
@@ -195,6 +266,8 @@ WindowStereoMethod::WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObj
     connect(pipeline, &Pipeline::Pipeline::error, this, [this] (int errorType, const QString &message) {
         if (errorType == Pipeline::Pipeline::ErrorStereoMethod) {
             QMessageBox::warning(this, "Stereo Method Error", message);
+        } else if (errorType == Pipeline::Pipeline::ErrorDisparityFilter) {
+            QMessageBox::warning(this, "Disparity Filter Error", message);
         } else if (errorType == Pipeline::Pipeline::ErrorVisualization) {
             QMessageBox::warning(this, "Visualization Error", message);
         }
@@ -222,7 +295,84 @@ void WindowStereoMethod::setMethod (int idx)
         return;
     }
 
-    pipeline->setStereoMethod(methods[idx]);
+    QObject *method = getMethod(idx);
+    if (!method) {
+        return; // Error is shown on method's page
+    }
+
+    pipeline->setStereoMethod(method);
+}
+
+QObject *WindowStereoMethod::getMethod (int idx)
+{
+    // Already created (or failed to)
+    if (configPages[idx]->layout()->count()) {
+        return methods[idx];
+    }
+
+    createMethod(idx);
+
+    // Wrappers are given all the methods they can wrap, so these need
+    // to be created as well
+    if (qobject_cast<Pipeline::StereoMethodWrapper *>(methods[idx])) {
+        for (int i = 0; i < methods.size(); i++) {
+            if (!methods[i] && !configPages[i]->layout()->count()) {
+                createMethod(i);
+            }
+        }
+
+        QList<QObject *> wrappableMethods;
+        for (QObject *method : methods) {
+            if (method && !qobject_cast<Pipeline::StereoMethodWrapper *>(method)) {
+                wrappableMethods.append(method);
+            }
+        }
+
+        for (QObject *method : methods) {
+            Pipeline::StereoMethodWrapper *wrapper = qobject_cast<Pipeline::StereoMethodWrapper *>(method);
+            if (wrapper) {
+                wrapper->setAvailableMethods(wrappableMethods);
+            }
+        }
+    }
+
+    // Config widgets of newly-created methods
+    for (int i = 0; i < methods.size(); i++) {
+        if (methods[i] && !configPages[i]->layout()->count()) {
+            Pipeline::StereoMethod *method = qobject_cast<Pipeline::StereoMethod *>(methods[i]);
+            configPages[i]->layout()->addWidget(method->createConfigWidget(configPages[i]));
+        }
+    }
+
+    return methods[idx];
+}
+
+void WindowStereoMethod::createMethod (int idx)
+{
+    Pipeline::PluginFactory *factory = qobject_cast<Pipeline::PluginFactory *>(plugins[idx]);
+    QString message;
+
+    // Methods are owned by the pipeline, which outlives this window
+    try {
+        methods[idx] = factory->createObject(pipeline);
+    } catch (const std::exception &e) {
+        message = QString::fromStdString(e.what());
+    } catch (...) {
+        message = "Unhandled exception type!";
+    }
+
+    if (methods[idx] && !qobject_cast<Pipeline::StereoMethod *>(methods[idx])) {
+        delete methods[idx];
+        methods[idx] = nullptr;
+        message = "Plugin does not provide a stereo method!";
+    }
+
+    if (!methods[idx]) {
+        QLabel *label = new QLabel(QString("Failed to create method:\n%1").arg(message), configPages[idx]);
+        label->setAlignment(Qt::AlignCenter);
+        label->setWordWrap(true);
+        configPages[idx]->layout()->addWidget(label);
+    }
 }
 
 
@@ -237,6 +387,11 @@ void WindowStereoMethod::updateStatusBar ()
             .arg(numDroppedFrames)
             .arg(pipeline->getStereoMethodTime())
         );
+
+        // Evaluated fraction of search space, with temporal prediction
+        if (pipeline->getStereoMethodTemporalPrediction()) {
+            statusBar->showMessage(statusBar->currentMessage() + QString(" Search: %1%.").arg(100*pipeline->getStereoMethodSearchFraction(), 0, 'f', 1));
+        }
     } else {
         statusBar->showMessage(QString("Disparity not available."));
     }
@@ -252,8 +407,10 @@ void WindowStereoMethod::saveImage ()
     // Make snapshot of image - because it can take a while to get
     // the filename...
     cv::Mat disparity, visualization;
+    int numDisparityLevels;
+    Pipeline::DisparityFormat format;
 
-    disparity = pipeline->getDisparity();
+    pipeline->getDisparity(disparity, numDisparityLevels, format);
     visualization = pipeline->getDisparityVisualization();
 
     if (disparity.empty()) {
@@ -285,17 +442,24 @@ void WindowStereoMethod::saveImage ()
 
         // Create file
         if (ext == "xml" || ext == "yml" || ext == "yaml" || ext == "xml.gz" || ext == "yml.gz" || ext == "yaml.gz") {
-            // Save raw disparity in OpenCV storage format
+            // Save raw disparity in OpenCV storage format, along with
+            // its format descriptor
             try {
                 cv::FileStorage fs(fileName.toStdString(), cv::FileStorage::WRITE);
                 fs << "disparity" << disparity;
+                fs << "disparityScale" << format.scale;
+                fs << "disparityOffset" << format.offset;
             } catch (const std::exception &e) {
                 QMessageBox::warning(this, "Error", QStringLiteral("Failed to save matrix: %1").arg(QString::fromStdString(e.what())));
             }
         } else if (ext == "bin") {
-            // Save raw disparity in custom binary matrix format
+            // Save disparity in custom binary matrix format; since the
+            // format has no place for the descriptor, explicitly convert
+            // disparity to float
             try {
-                Pipeline::Utils::writeMatrixToBinaryFile(disparity, fileName);
+                cv::Mat floatDisparity;
+                Pipeline::Utils::convertDisparityToFloat(disparity, format, floatDisparity);
+                Pipeline::Utils::writeMatrixToBinaryFile(floatDisparity, fileName);
             } catch (const std::exception &e) {
                 QMessageBox::warning(this, "Error", QStringLiteral("Failed to save binary file: %1").arg(QString::fromStdString(e.what())));
             }
@@ -373,6 +537,25 @@ void WindowStereoMethod::fillVisualizationMethods ()
 }
 
 
+void WindowStereoMethod::fillColormaps ()
+{
+    static const struct {
+        int id;
+        const char *text;
+    } colormaps[] = {
+        { Pipeline::DisparityVisualization::ColormapHue, "Hue" },
+        { Pipeline::DisparityVisualization::ColormapJet, "Jet" },
+        { Pipeline::DisparityVisualization::ColormapHot, "Hot" },
+        { Pipeline::DisparityVisualization::ColormapRainbow, "Rainbow" },
+        { Pipeline::DisparityVisualization::ColormapParula, "Parula" },
+    };
+
+    for (unsigned int i = 0; i < sizeof(colormaps)/sizeof(colormaps[0]); i++) {
+        comboBoxColormap->addItem(colormaps[i].text, colormaps[i].id);
+    }
+}
+
+
 } // GUI
 } // StereoToolbox
 } // MVL
@@ -44,25 +44,35 @@ class WindowStereoMethod : public QWidget
     Q_OBJECT
 
 public:
-    WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObject *> &methods, QWidget *parent = nullptr);
+    WindowStereoMethod (Pipeline::Pipeline *pipeline, QList<QObject *> &plugins, QWidget *parent = nullptr);
     virtual ~WindowStereoMethod ();
 
 protected:
     void setMethod (int idx);
 
+    QObject *getMethod (int idx);
+    void createMethod (int idx);
+
     void saveImage ();
 
     void importParameters ();
     void exportParameters ();
 
     void fillVisualizationMethods ();
+    void fillColormaps ();
 
     void updateStatusBar ();
 
 protected:
     // Pipeline
     Pipeline::Pipeline *pipeline;
+    QList<QObject *> plugins;
+
+    // Methods are created (and their plugins loaded) on first use; the
+    // corresponding config page is populated with method's config
+    // widget, or with the error message if creation failed
     QList<QObject *> methods;
+    QList<QWidget *> configPages;
     Pipeline::DisparityVisualization *visualization;
 
     // Status bar info
@@ -79,11 +89,16 @@ protected:
     QPushButton *pushButtonExportParameters;
     QPushButton *pushButtonImportParameters;
     QComboBox *comboBoxVisualizationMethod;
+    QComboBox *comboBoxColormap;
     QPushButton *pushButtonSaveImage;
 
     Widgets::DisparityDisplayWidget *displayDisparityImage;
 
     QLabel *labelDisparity;
+    QCheckBox *checkBoxTemporalPrediction;
+    QCheckBox *checkBoxBandParallel;
+    QCheckBox *checkBoxConsistencyCheck;
+    QCheckBox *checkBoxDisparityFilter;
     QStatusBar *statusBar;
 
     QString lastSavedFile;